@@ -0,0 +1,130 @@
+#include "../include/Aggregate.h"
+#include "../include/Parallel.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <numeric>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+using namespace minidb;
+
+namespace {
+
+// 每项测试的行数
+constexpr size_t kRows = 4 * 1024 * 1024;
+
+// 按批产生预先生成的两列：分组列和值列
+class GeneratedBatches : public BatchOperator {
+public:
+    GeneratedBatches(const std::vector<int32_t>& keys, const std::vector<int32_t>& values)
+        : keys_(keys), values_(values) {}
+    
+    bool next(RowBatch& batch) override {
+        if (position_ >= keys_.size()) {
+            return false;
+        }
+        size_t count = std::min(kBatchSize, keys_.size() - position_);
+        batch.columns.resize(2);
+        batch.columns[0].ints.assign(keys_.begin() + position_, keys_.begin() + position_ + count);
+        batch.columns[1].ints.assign(values_.begin() + position_, values_.begin() + position_ + count);
+        batch.size = count;
+        batch.selection.resize(count);
+        std::iota(batch.selection.begin(), batch.selection.end(), 0);
+        position_ += count;
+        return true;
+    }
+
+private:
+    const std::vector<int32_t>& keys_;
+    const std::vector<int32_t>& values_;
+    size_t position_ = 0;
+};
+
+// 运行fn一次，返回每秒处理的行数
+template <typename Fn>
+double measure(Fn&& fn) {
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return static_cast<double>(kRows) / elapsed;
+}
+
+} // namespace
+
+int main() {
+    // SELECT k, count(*), sum(v), max(v) ... GROUP BY k
+    std::vector<AggregateSpec> aggregates(3);
+    aggregates[0].function = AggregateFunction::COUNT;
+    aggregates[1].function = AggregateFunction::SUM;
+    aggregates[1].column = 1;
+    aggregates[2].function = AggregateFunction::MAX;
+    aggregates[2].column = 1;
+    
+    // 至少用两个线程，单核机器上也检查部分结果的合并
+    size_t threads = std::max<size_t>(2, hardwareThreads());
+    std::printf("%-12s%-28s%12s\n", "分组数", "方法", "百万行/秒");
+    
+    std::mt19937 rng(42);
+    for (int32_t groups : {16, 1024, 65536, 1048576}) {
+        std::uniform_int_distribution<int32_t> keyDist(0, groups - 1);
+        std::uniform_int_distribution<int32_t> valueDist(0, 999);
+        std::vector<int32_t> keys(kRows);
+        std::vector<int32_t> values(kRows);
+        for (size_t i = 0; i < kRows; ++i) {
+            keys[i] = keyDist(rng);
+            values[i] = valueDist(rng);
+        }
+        
+        // 对照：逐行在std::unordered_map中累加，再按分组列排序得到结果
+        struct Sums {
+            int64_t count = 0;
+            int64_t sum = 0;
+            int32_t max = INT32_MIN;
+        };
+        std::vector<Record> expected;
+        double baseline = measure([&] {
+            std::unordered_map<int32_t, Sums> map;
+            GeneratedBatches input(keys, values);
+            RowBatch batch;
+            while (input.next(batch)) {
+                for (uint16_t i : batch.selection) {
+                    Sums& sums = map[batch.columns[0].ints[i]];
+                    ++sums.count;
+                    sums.sum += batch.columns[1].ints[i];
+                    sums.max = std::max(sums.max, batch.columns[1].ints[i]);
+                }
+            }
+            std::vector<std::pair<int32_t, Sums>> sorted(map.begin(), map.end());
+            std::sort(sorted.begin(), sorted.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+            for (const auto& [key, sums] : sorted) {
+                expected.push_back({key, static_cast<int>(sums.count), std::to_string(sums.sum), sums.max});
+            }
+        });
+        std::printf("%-12d%-28s%12.1f\n", groups, "unordered_map", baseline / 1e6);
+        
+        // 单线程和多线程的哈希聚合，结果必须与对照相同
+        for (size_t workers : {size_t(1), threads}) {
+            std::vector<HashAggregator> partials(workers, HashAggregator({0}, {DataType::INT}, aggregates));
+            std::vector<Record> result;
+            double rate = measure([&] {
+                GeneratedBatches input(keys, values);
+                parallelConsume(input, workers, [&](size_t worker, const RowBatch& batch) {
+                    partials[worker].consume(batch);
+                });
+                for (size_t i = 1; i < partials.size(); ++i) {
+                    partials.front().merge(partials[i]);
+                }
+                result = partials.front().finish();
+            });
+            std::string name = "HashAggregator " + std::to_string(workers) + " 线程";
+            std::printf("%-12d%-28s%12.1f\n", groups, name.c_str(), rate / 1e6);
+            if (result != expected) {
+                std::printf("结果不一致\n");
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
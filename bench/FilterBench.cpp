@@ -0,0 +1,104 @@
+#include "../include/FilterKernels.h"
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace minidb;
+
+namespace {
+
+// 每批的行数与每项测试的最短时间
+constexpr size_t kRows = 1024;
+constexpr double kMinSeconds = 0.2;
+
+// 一项测试：条件的文字形式和对应的比较
+struct Case {
+    const char* text;
+    std::vector<std::pair<Operator, int>> compares;
+};
+
+// 反复运行fn直到超过最短时间，返回每秒处理的行数
+template <typename Fn>
+double measure(Fn&& fn) {
+    using Clock = std::chrono::steady_clock;
+    size_t rows = 0;
+    size_t sink = 0;
+    auto start = Clock::now();
+    double elapsed = 0;
+    while (elapsed < kMinSeconds) {
+        for (int i = 0; i < 256; ++i) {
+            sink += fn();
+            rows += kRows;
+        }
+        elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+    }
+    if (sink == static_cast<size_t>(-1)) {
+        std::printf("\n");
+    }
+    return static_cast<double>(rows) / elapsed;
+}
+
+} // namespace
+
+int main() {
+    // 0到999均匀分布的INT列
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> dist(0, 999);
+    std::vector<int32_t> values(kRows);
+    std::vector<Value> boxed(kRows);
+    for (size_t i = 0; i < kRows; ++i) {
+        values[i] = dist(rng);
+        boxed[i] = values[i];
+    }
+    
+    const std::vector<Case> cases = {
+        {"v = 500", {{Operator::EQUAL, 500}}},
+        {"v != 500", {{Operator::NOT_EQUAL, 500}}},
+        {"v < 100", {{Operator::LESS_THAN, 100}}},
+        {"v > 500", {{Operator::GREATER_THAN, 500}}},
+        {"v between 250 and 750", {{Operator::GREATER_EQUAL, 250}, {Operator::LESS_EQUAL, 750}}},
+    };
+    
+    SimdLevel detected = detectSimdLevel();
+    std::printf("CPU支持的最高指令集：%s\n", simdLevelName(detected));
+    std::printf("%-24s%-16s%12s\n", "条件", "过滤核", "百万行/秒");
+    
+    std::vector<uint16_t> selection(kRows + kSelectionPadding);
+    for (const Case& c : cases) {
+        // 逐行调用compareValues：扫描原来的判断方式
+        double generic = measure([&] {
+            size_t kept = 0;
+            for (size_t i = 0; i < kRows; ++i) {
+                bool match = true;
+                for (const auto& [op, constant] : c.compares) {
+                    match = match && compareValues(boxed[i], Value(constant), op);
+                }
+                selection[kept] = static_cast<uint16_t>(i);
+                kept += match ? 1 : 0;
+            }
+            return kept;
+        });
+        std::printf("%-24s%-16s%12.1f\n", c.text, "compareValues", generic / 1e6);
+        
+        IntRange range;
+        for (const auto& [op, constant] : c.compares) {
+            if (op == Operator::NOT_EQUAL) {
+                range = IntRange::fromCompare(op, constant);
+            } else {
+                range.intersect(IntRange::fromCompare(op, constant));
+            }
+        }
+        for (SimdLevel level : {SimdLevel::SCALAR, SimdLevel::SSE4, SimdLevel::AVX2}) {
+            if (level > detected) {
+                continue;
+            }
+            double rate = measure([&] {
+                return selectIntRange(level, values.data(), kRows, range, selection.data());
+            });
+            std::printf("%-24s%-16s%12.1f\n", c.text, simdLevelName(level), rate / 1e6);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,99 @@
+#include "../include/RowFilter.h"
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace minidb;
+
+namespace {
+
+// 行数与每项测试的最短时间
+constexpr size_t kRows = 4096;
+constexpr double kMinSeconds = 0.2;
+
+// 反复运行fn直到超过最短时间，返回每秒判断的行数
+template <typename Fn>
+double measure(Fn&& fn) {
+    using Clock = std::chrono::steady_clock;
+    size_t rows = 0;
+    size_t sink = 0;
+    auto start = Clock::now();
+    double elapsed = 0;
+    while (elapsed < kMinSeconds) {
+        for (int i = 0; i < 16; ++i) {
+            sink += fn();
+            rows += kRows;
+        }
+        elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+    }
+    if (sink == static_cast<size_t>(-1)) {
+        std::printf("\n");
+    }
+    return static_cast<double>(rows) / elapsed;
+}
+
+Predicate compare(size_t column, Operator op, Value value) {
+    return Predicate::compare(column, op, std::move(value));
+}
+
+} // namespace
+
+int main() {
+    // score在STRING列之后，只能逐列计算偏移
+    const std::vector<ColumnDef> columns = {
+        {"id", DataType::INT, true},
+        {"age", DataType::INT},
+        {"name", DataType::STRING},
+        {"score", DataType::INT},
+    };
+    
+    std::mt19937 rng(42);
+    std::vector<std::string> tuples;
+    tuples.reserve(kRows);
+    for (size_t i = 0; i < kRows; ++i) {
+        Record record = {static_cast<int>(i), static_cast<int>(rng() % 100),
+                         "n" + std::to_string(rng() % 1000), static_cast<int>(rng() % 1000)};
+        tuples.push_back(encodeTuple(record, columns));
+    }
+    
+    using Kind = Predicate::Kind;
+    const std::vector<std::pair<const char*, Predicate>> cases = {
+        {"age = 30", compare(1, Operator::EQUAL, 30)},
+        {"age < 50", compare(1, Operator::LESS_THAN, 50)},
+        {"score > 500", compare(3, Operator::GREATER_THAN, 500)},
+        {"name = 'n500'", compare(2, Operator::EQUAL, std::string("n500"))},
+        {"age between 20 and 40", Predicate::combine(Kind::AND, {compare(1, Operator::GREATER_EQUAL, 20),
+                                                                 compare(1, Operator::LESS_EQUAL, 40)})},
+        {"age < 50 and name < 'n5'", Predicate::combine(Kind::AND, {compare(1, Operator::LESS_THAN, 50),
+                                                                    compare(2, Operator::LESS_THAN, std::string("n5"))})},
+        {"age = 1 or score < 100", Predicate::combine(Kind::OR, {compare(1, Operator::EQUAL, 1),
+                                                                 compare(3, Operator::LESS_THAN, 100)})},
+    };
+    
+    std::printf("%-28s%16s%16s%8s\n", "条件", "通用（百万行/秒）", "特化（百万行/秒）", "倍数");
+    for (const auto& [text, where] : cases) {
+        // 通用路径：每个比较都检查值的类型并按操作符分派
+        double generic = measure([&] {
+            size_t count = 0;
+            for (const auto& tuple : tuples) {
+                count += where.matches(TupleView(tuple, columns)) ? 1 : 0;
+            }
+            return count;
+        });
+        
+        // 特化路径：每次查询编译一次，循环中直接调用具体的函数对象
+        double specialized = measure([&] {
+            size_t count = 0;
+            RowFilter::compile(where, columns).dispatch([&](const auto& matches) {
+                for (const auto& tuple : tuples) {
+                    count += matches(TupleView(tuple, columns)) ? 1 : 0;
+                }
+            });
+            return count;
+        });
+        std::printf("%-28s%16.1f%16.1f%8.2f\n", text, generic / 1e6, specialized / 1e6, specialized / generic);
+    }
+    return 0;
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "Types.h"
+#include "Executor.h"
+#include "Sort.h"
+
+namespace minidb {
+
+// 一个聚合函数：column为它作用的列在输入中的位置（COUNT(*)没有列），type为该列的类型
+struct AggregateSpec {
+    AggregateFunction function = AggregateFunction::COUNT;
+    std::optional<size_t> column;
+    DataType type = DataType::INT;
+};
+
+// 聚合函数的名字（小写），用于结果的列名和EXPLAIN
+const char* aggregateName(AggregateFunction function);
+
+// 哈希聚合：按分组列把输入的行分组，逐组累加各聚合函数。分组放在开放定址（线性探测）的哈希表中，
+// 一个槽只有8字节：只有一个INT分组列时为该列的值和分组号，探测时不再访问别处；否则为哈希值的低32位
+// 和分组号，哈希值相同时再比较分组列的编码。各组的累加状态按分组号连续存放，批中的行先全部找到分组，
+// 再按聚合函数逐列累加。一个聚合器只能由一个线程使用，多个线程各自累加一部分输入，最后用merge合并
+class HashAggregator {
+public:
+    // groupColumns和groupTypes为分组列在输入中的位置和类型；没有分组列时所有行属于同一组，
+    // 输入为空时也有这一组
+    HashAggregator(std::vector<size_t> groupColumns, std::vector<DataType> groupTypes,
+                   std::vector<AggregateSpec> aggregates);
+    
+    // 累加批中选中的行
+    void consume(const RowBatch& batch);
+    
+    // 累加一行
+    void consume(const Record& row);
+    
+    // 合并另一个聚合器的部分结果，两者的分组列和聚合函数必须相同
+    void merge(const HashAggregator& other);
+    
+    // 分组个数
+    size_t groupCount() const { return hashes_.size(); }
+    
+    // 每组一行：各分组列的值接着各聚合函数的值，按分组列排序。COUNT为INT；SUM和AVG可能超出INT的
+    // 范围，以数字文本给出（AVG保留两位小数）；MIN和MAX与列类型相同；组中没有行时后四者为NULL。
+    // 给出order时再按其中的各键（列为结果中的位置）排序，SUM和AVG按数值比较
+    std::vector<Record> finish(const std::vector<SortKey>& order = {}) const;
+
+private:
+    // 一组中一个聚合函数的累加状态
+    struct State {
+        int64_t count = 0;
+        int64_t sum = 0;
+        int32_t min = INT32_MAX;
+        int32_t max = INT32_MIN;
+    };
+    
+    // 哈希表的槽：tag为INT分组列的值或哈希值的低32位，group为kEmpty时为空
+    struct Slot {
+        uint32_t tag = 0;
+        uint32_t group = kEmpty;
+    };
+    
+    static constexpr uint32_t kEmpty = UINT32_MAX;
+    
+    std::vector<size_t> groupColumns_;
+    std::vector<ColumnDef> groupDefs_;
+    std::vector<AggregateSpec> aggregates_;
+    
+    // 只有一个INT分组列
+    bool intKey_ = false;
+    
+    // 开放定址的哈希表，槽数为2的幂，由哈希值的高位定位，分组数超过四分之一时加倍：
+    // 槽很小，较低的装载率使大多数查找一次命中
+    std::vector<Slot> slots_;
+    uint64_t mask_ = 0;
+    unsigned shift_ = 0;
+    
+    // 各组分组列的编码（格式与encodeTuple相同）依次存放在keys_中，第g组从keyOffsets_[g]到keyOffsets_[g + 1]；
+    // hashes_为各组的哈希值，加倍时用于重新放置
+    std::string keys_;
+    std::vector<size_t> keyOffsets_;
+    std::vector<uint64_t> hashes_;
+    
+    // 第g组的第a个聚合函数的状态为states_[g * aggregates_.size() + a]；STRING列的MIN和MAX
+    // 的当前值在texts_中的同一位置，没有这样的聚合函数时texts_为空
+    std::vector<State> states_;
+    std::vector<std::string> texts_;
+    bool hasText_ = false;
+    
+    // 累加一批时各行的分组号，以及编码分组列的缓冲区
+    std::vector<uint32_t> groupIds_;
+    std::string key_;
+    
+    // 第g组分组列的编码
+    std::string_view groupKey(uint32_t group) const {
+        return std::string_view(keys_).substr(keyOffsets_[group], keyOffsets_[group + 1] - keyOffsets_[group]);
+    }
+    
+    // 找到分组列编码为key的组，没有时新建
+    uint32_t findOrInsert(std::string_view key);
+    
+    // 只有一个INT分组列时，找到该列为value的组，没有时新建
+    uint32_t findOrInsert(int32_t value);
+    
+    // 新建一组
+    uint32_t insertGroup(Slot& slot, uint32_t tag, std::string_view key, uint64_t hash);
+    
+    // 槽数加倍，重新放置所有组
+    void grow();
+    
+    // 对批中选中的每一行调用fn(该行所在组的第aggregate个状态, 行在批中的位置)
+    template <typename Fn>
+    void forEachSelected(const RowBatch& batch, size_t aggregate, Fn&& fn);
+};
+
+} // namespace minidb
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include <cstdint>
+#include "Types.h"
+
+namespace minidb {
+
+// 分块布隆过滤器：每个值只落在一个32字节的块中，在块的8个32位字中各置1位，
+// 一次查找只访问一条缓存行。不支持删除，删除的值只计数，过多时由调用方重建
+class BloomFilter {
+public:
+    BloomFilter() { reset(0); }
+    
+    // 清空并按预计的值个数分配空间（每个值约10位）
+    void reset(size_t expectedValues);
+    
+    // 加入一个值
+    void add(const Value& value);
+    
+    // 值可能存在时返回true；返回false时一定不存在
+    bool mayContain(const Value& value) const;
+    
+    // 记录一个已删除的值（位不会被清除）
+    void markRemoved() { ++removed_; }
+    
+    // 加入的值超过容量或已删除的值过多，误判率升高，需要重建
+    bool needsRebuild() const;
+    
+    // 当前容量（值的个数）
+    size_t capacity() const { return capacity_; }
+
+private:
+    using Block = std::array<uint32_t, 8>;
+    
+    std::vector<Block> blocks_;
+    size_t capacity_ = 0;
+    size_t added_ = 0;
+    size_t removed_ = 0;
+    
+    // 值的64位哈希：高32位选择块，低32位决定块内的8个位
+    static uint64_t hash(const Value& value);
+    
+    // 块内每个字中要置的位
+    static Block mask(uint32_t hash);
+};
+
+} // namespace minidb
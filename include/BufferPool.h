@@ -0,0 +1,184 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <unordered_map>
+#include <filesystem>
+#include "Page.h"
+#include "WAL.h"
+
+namespace minidb {
+
+// 页文件：按页读写的磁盘文件，页号从0开始
+class PageFile {
+public:
+    explicit PageFile(const std::filesystem::path& path);
+    ~PageFile();
+    
+    // 打开文件（不存在时创建）
+    bool open();
+    
+    // 关闭文件，缓冲池中属于该文件的页会被丢弃
+    void close();
+    
+    // 获取文件路径
+    const std::filesystem::path& getPath() const { return path_; }
+    
+    // 获取页数（包括已分配但尚未写回的页）
+    uint32_t getPageCount() const { return pageCount_; }
+    
+    // 分配一个新页，返回页号
+    uint32_t allocatePage() { return pageCount_++; }
+    
+    // 清空文件，缓冲池中属于该文件的页会被丢弃
+    bool truncate();
+    
+    // 保证页数不小于给定值（日志重放时使用）
+    void ensurePageCount(uint32_t count);
+    
+    // 读取一页，超出文件末尾的页读出全0
+    bool readPage(uint32_t pageId, char* buffer) const;
+    
+    // 写入一页
+    bool writePage(uint32_t pageId, const char* buffer);
+    
+    // 获取文件映射区中的一页（只读），页不在文件中或未启用映射时返回空；
+    // 返回的指针在下一次调用本函数之前有效
+    const char* mappedPage(uint32_t pageId);
+    
+    // 将文件内容刷到磁盘
+    bool sync();
+    
+    // 设置写回数据页之前需要先落盘的日志
+    void setWAL(std::shared_ptr<WAL> wal) { wal_ = std::move(wal); }
+
+private:
+    std::filesystem::path path_;
+    int fd_ = -1;
+    uint32_t pageCount_ = 0;
+    size_t fileSize_ = 0;
+    const char* map_ = nullptr;
+    size_t mapSize_ = 0;
+    std::shared_ptr<WAL> wal_;
+    
+    // 按当前文件大小重新建立映射（只映射完整的页）
+    bool remap();
+    
+    // 解除映射
+    void unmap();
+};
+
+// 缓冲池中的一个页帧
+struct Frame {
+    PageFile* file = nullptr;
+    uint32_t pageId = 0;
+    std::unique_ptr<char[]> data;
+    int pinCount = 0;
+    bool dirty = false;
+    bool referenced = false;
+};
+
+// 页句柄：持有期间页被固定在缓冲池中，析构时自动释放
+class PageGuard {
+public:
+    PageGuard() = default;
+    explicit PageGuard(Frame* frame) : frame_(frame) {}
+    ~PageGuard() { release(); }
+    
+    PageGuard(const PageGuard&) = delete;
+    PageGuard& operator=(const PageGuard&) = delete;
+    PageGuard(PageGuard&& other) noexcept : frame_(other.frame_) { other.frame_ = nullptr; }
+    PageGuard& operator=(PageGuard&& other) noexcept;
+    
+    explicit operator bool() const { return frame_ != nullptr; }
+    
+    // 页数据
+    char* data() { return frame_->data.get(); }
+    const char* data() const { return frame_->data.get(); }
+    
+    // 页号
+    uint32_t getPageId() const { return frame_->pageId; }
+    
+    // 标记页已修改
+    void markDirty() { frame_->dirty = true; }
+    
+    // 提前释放页
+    void release();
+
+private:
+    Frame* frame_ = nullptr;
+};
+
+// 缓冲池：所有表共享，按CLOCK算法在内存预算内淘汰页
+class BufferPool {
+public:
+    static BufferPool& getInstance();
+    
+    // 获取一页（不在缓冲池中时从文件读入）
+    PageGuard fetchPage(PageFile& file, uint32_t pageId);
+    
+    // 只读访问一页：页已在缓冲池中时固定并使用缓存（可能是脏页），
+    // 否则直接返回文件映射区中的页，不读入缓冲池；guard持有可能的固定
+    const char* readPage(PageFile& file, uint32_t pageId, PageGuard& guard);
+    
+    // 写回某个文件的所有脏页
+    bool flushFile(PageFile& file);
+    
+    // 丢弃某个文件在缓冲池中的所有页（不写回）
+    void discardFile(PageFile& file);
+    
+    // 设置缓冲池容量（页数）
+    void setCapacity(size_t pages);
+    
+    // 获取缓冲池容量（页数）
+    size_t getCapacity() const { return capacity_; }
+    
+    // 获取当前缓存的页数
+    size_t getCachedPageCount() const { return pageTable_.size(); }
+    
+    // 设置只读访问是否直接读取文件映射区
+    void setMmapReads(bool enabled) { mmapReads_ = enabled; }
+    
+    // 只读访问是否直接读取文件映射区
+    bool isMmapReads() const { return mmapReads_; }
+
+private:
+    BufferPool();
+    ~BufferPool();
+    
+    // 禁止拷贝和移动
+    BufferPool(const BufferPool&) = delete;
+    BufferPool& operator=(const BufferPool&) = delete;
+    BufferPool(BufferPool&&) = delete;
+    BufferPool& operator=(BufferPool&&) = delete;
+    
+    struct PageKey {
+        PageFile* file;
+        uint32_t pageId;
+        bool operator==(const PageKey& other) const {
+            return file == other.file && pageId == other.pageId;
+        }
+    };
+    
+    struct PageKeyHash {
+        size_t operator()(const PageKey& key) const {
+            return std::hash<PageFile*>()(key.file) ^ (static_cast<size_t>(key.pageId) * 0x9E3779B97F4A7C15ull);
+        }
+    };
+    
+    size_t capacity_;
+    std::vector<std::unique_ptr<Frame>> frames_;
+    std::vector<size_t> freeFrames_;
+    std::unordered_map<PageKey, size_t, PageKeyHash> pageTable_;
+    size_t clockHand_ = 0;
+    bool mmapReads_ = true;
+    
+    // 找一个可用的页帧，必要时淘汰一页
+    std::optional<size_t> acquireFrame();
+    
+    // 淘汰一页，脏页先写回
+    bool evict(size_t frameIndex);
+};
+
+} // namespace minidb
\ No newline at end of file
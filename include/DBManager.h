@@ -5,9 +5,13 @@
 #include <memory>
 #include <filesystem>
 #include "Database.h"
+#include "Parallel.h"
 
 namespace minidb {
 
+// 查询执行的默认内存预算
+constexpr size_t kDefaultWorkMemory = 64 * 1024 * 1024;
+
 class DBManager {
 public:
     static DBManager& getInstance();
@@ -32,6 +36,24 @@ public:
     
     // 加载所有数据库
     bool loadDatabases();
+    
+    // 设置所有数据库的日志刷盘策略
+    void setWalSyncMode(WALSyncMode mode);
+    
+    // 获取日志刷盘策略
+    WALSyncMode getWalSyncMode() const { return walSyncMode_; }
+    
+    // 设置查询执行时在内存中保存中间数据（如哈希连接的哈希表）的预算，超出时写出到临时文件
+    void setWorkMemory(size_t bytes) { workMemory_ = bytes; }
+    
+    // 获取查询执行的内存预算
+    size_t getWorkMemory() const { return workMemory_; }
+    
+    // 设置一个查询最多使用的工作线程数（并行扫描、聚合和建立索引时的排序），默认为硬件线程数
+    void setParallelWorkers(size_t workers) { parallelWorkers_ = workers; }
+    
+    // 获取一个查询最多使用的工作线程数
+    size_t getParallelWorkers() const { return parallelWorkers_; }
 
 private:
     DBManager();
@@ -46,6 +68,9 @@ private:
     std::filesystem::path dataPath_;
     std::unordered_map<std::string, std::shared_ptr<Database>> databases_;
     std::string currentDbName_;
+    WALSyncMode walSyncMode_ = WALSyncMode::NORMAL;
+    size_t workMemory_ = kDefaultWorkMemory;
+    size_t parallelWorkers_ = hardwareThreads();
 };
 
 } // namespace minidb 
\ No newline at end of file
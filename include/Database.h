@@ -2,9 +2,11 @@
 
 #include <string>
 #include <unordered_map>
+#include <set>
 #include <memory>
 #include <filesystem>
 #include "Table.h"
+#include "WAL.h"
 
 namespace minidb {
 
@@ -12,29 +14,60 @@ class Database {
 public:
     explicit Database(const std::string& name);
     ~Database();
-
+    
     // 获取数据库名称
     std::string getName() const { return name_; }
-
+    
     // 创建表
     bool createTable(const std::string& tableName, const std::vector<ColumnDef>& columns);
     
     // 删除表
     bool dropTable(const std::string& tableName);
     
-    // 获取表
+    // 在表的一列或多列上创建二级索引，includeNames为只保存在索引中的包含列
+    bool createIndex(const std::string& tableName, const std::string& indexName,
+                     const std::vector<std::string>& colNames, IndexType type = IndexType::BTREE,
+                     const std::vector<std::string>& includeNames = {});
+    
+    // 删除表上的二级索引
+    bool dropIndex(const std::string& tableName, const std::string& indexName);
+    
+    // 获取表，首次访问时才打开表文件
     std::shared_ptr<Table> getTable(const std::string& tableName);
     
-    // 加载数据库中的表
+    // 加载数据库目录（只读取表名，不打开表文件）
     bool loadTables();
     
-    // 保存数据库状态
+    // 保存数据库目录
     bool saveMetadata() const;
+    
+    // 写出检查点：保存所有有修改的表并清空日志
+    bool checkpoint();
+    
+    // 日志超过阈值时写出检查点
+    bool maybeCheckpoint();
+    
+    // 设置日志刷盘策略
+    void setSyncMode(WALSyncMode mode) { wal_->setSyncMode(mode); }
 
 private:
     std::string name_;
     std::filesystem::path dbPath_;
+    std::set<std::string> catalog_;
     std::unordered_map<std::string, std::shared_ptr<Table>> tables_;
+    std::unordered_map<std::string, uint64_t> lastUsed_;
+    uint64_t useClock_ = 0;
+    std::shared_ptr<WAL> wal_;
+    bool recovered_ = false;
+    
+    // 打开目录中的表并加入已打开的表
+    std::shared_ptr<Table> openTable(const std::string& tableName);
+    
+    // 重放日志（首次使用数据库时执行一次）
+    bool recover();
+    
+    // 已打开的表过多时关闭最久未使用的表
+    void releaseColdTables();
 };
 
 } // namespace minidb 
\ No newline at end of file
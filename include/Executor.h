@@ -0,0 +1,201 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string_view>
+#include "Types.h"
+#include "HeapFile.h"
+#include "Predicate.h"
+
+namespace minidb {
+
+// 扫描每批读取的行数（读满整页，一批可能略多）
+constexpr size_t kBatchSize = 1024;
+
+// 一批最多的行数：最后一页的行全部放入同一批，超出kBatchSize的行数不会多于一页中的槽数
+constexpr size_t kMaxBatchRows = kBatchSize + kPageSize / sizeof(SlottedPage::Slot);
+
+// 并行扫描时每个页块的页数
+constexpr uint32_t kMorselPages = 32;
+
+// 一批中STRING列的内容占用的缓冲区大小；剩余空间不足一页时结束该批，缓冲区不会重新分配
+constexpr size_t kBatchArenaSize = 64 * kPageSize;
+
+// 列向量：一批中某一列的值，按行在批中的位置存放，只有前size个有效（空间按最多的行数
+// 一次分配，扫描时直接写入）。INT列使用ints，STRING列使用strings
+struct ColumnVector {
+    DataType type = DataType::INT;
+    bool loaded = false;
+    std::vector<int32_t> ints;
+    std::vector<std::string_view> strings;
+};
+
+// 一批行：行号和需要的列各自连续存放（前size个有效），选择向量按升序给出批中仍然满足条件的行的位置。
+// 过滤只缩小选择向量，不移动列向量中的值；STRING列引用批内的缓冲区，
+// 批中的数据在下一次调用产生该批的算子之前有效
+struct RowBatch {
+    size_t size = 0;
+    std::vector<RowId> rowIds;
+    std::vector<ColumnVector> columns;
+    std::vector<uint16_t> selection;
+    std::unique_ptr<char[]> arena;
+    size_t arenaUsed = 0;
+    
+    // 清空批，保留已分配的空间
+    void clear();
+    
+    // 把选中的行按列的顺序转换为记录，追加到result中
+    void appendRecords(std::vector<Record>& result) const;
+};
+
+// 按批拉取的算子：每次调用next产生下一批，没有更多的行时返回false
+class BatchOperator {
+public:
+    virtual ~BatchOperator() = default;
+    
+    // 产生下一批
+    virtual bool next(RowBatch& batch) = 0;
+};
+
+// 把元组中需要的列解码到批中，按表的列位置存放，没有用到的列为空
+class TupleDecoder {
+public:
+    TupleDecoder(const std::vector<ColumnDef>& columns, const std::vector<size_t>& needed);
+    
+    // 清空批并按表的列准备列向量
+    void reset(RowBatch& batch) const;
+    
+    // 批中还能放下一个元组：行数不超过kBatchSize，缓冲区剩余的空间放得下一页
+    bool hasRoom(const RowBatch& batch) const;
+    
+    // 把一个元组追加到批中，STRING列的内容复制到批的缓冲区（页可能在之后被换出或重新映射）
+    void append(std::string_view tuple, RowId rowId, RowBatch& batch) const;
+
+private:
+    const std::vector<ColumnDef>& columns_;
+    std::vector<uint8_t> needed_;
+    size_t columnCount_ = 0;
+};
+
+// 扫描：按页顺序读取表文件中的存活行，只解码需要的列，跳过skipPage返回true的页；
+// 产生的批按表的列位置存放各列，没有用到的列为空
+class ScanOperator : public BatchOperator {
+public:
+    ScanOperator(HeapFile& heap, const std::vector<ColumnDef>& columns, const std::vector<size_t>& needed,
+                 std::function<bool(uint32_t)> skipPage = nullptr);
+    
+    bool next(RowBatch& batch) override;
+
+private:
+    HeapFile& heap_;
+    TupleDecoder decoder_;
+    std::function<bool(uint32_t)> skipPage_;
+    uint32_t nextPage_ = 1;
+    
+    // 把一页中的存活行追加到批中
+    void readPage(const SlottedPage& page, uint32_t pageId, RowBatch& batch);
+};
+
+// 按行号读取：按给出的顺序读取索引查找得到的行，已不存在的行跳过；产生的批与ScanOperator相同
+class FetchOperator : public BatchOperator {
+public:
+    FetchOperator(HeapFile& heap, const std::vector<ColumnDef>& columns, const std::vector<size_t>& needed,
+                  std::vector<RowId> rowIds);
+    
+    bool next(RowBatch& batch) override;
+
+private:
+    HeapFile& heap_;
+    TupleDecoder decoder_;
+    std::vector<RowId> rowIds_;
+    size_t position_ = 0;
+};
+
+// 过滤：在列向量上判断条件，把选择向量缩小为满足条件的行；跳过没有行满足条件的批
+class FilterOperator : public BatchOperator {
+public:
+    FilterOperator(std::unique_ptr<BatchOperator> child, const Predicate& where);
+    
+    bool next(RowBatch& batch) override;
+
+private:
+    std::unique_ptr<BatchOperator> child_;
+    const Predicate& where_;
+};
+
+// 投影：按给出的列位置（不能重复）重新排列各列，去掉其余的列
+class ProjectOperator : public BatchOperator {
+public:
+    ProjectOperator(std::unique_ptr<BatchOperator> child, std::vector<size_t> columns);
+    
+    bool next(RowBatch& batch) override;
+
+private:
+    std::unique_ptr<BatchOperator> child_;
+    std::vector<size_t> columns_;
+    RowBatch input_;
+};
+
+// 限制行数：选够limit行之后不再从子算子拉取
+class LimitOperator : public BatchOperator {
+public:
+    LimitOperator(std::unique_ptr<BatchOperator> child, size_t limit);
+    
+    bool next(RowBatch& batch) override;
+
+private:
+    std::unique_ptr<BatchOperator> child_;
+    size_t remaining_;
+};
+
+// 按页块并行扫描表文件：数据页按kMorselPages页切分为页块，工作线程从共享的计数器按页的顺序依次领取页块，
+// 各自解码、过滤和处理块中的行。缓冲池不是线程安全的，读页在锁内进行：领取页块后加锁一次，把块中要读的页
+// 都复制到线程自己的缓冲区后立即释放，之后的处理都在锁外
+class MorselScan {
+public:
+    // 与ScanOperator相同：只解码needed中的列，跳过skipPage返回true的页（skipPage会在多个线程中同时调用）
+    MorselScan(HeapFile& heap, const std::vector<ColumnDef>& columns, const std::vector<size_t>& needed,
+               std::function<bool(uint32_t)> skipPage = nullptr);
+    
+    // 页块数
+    size_t getMorselCount() const { return morselCount_; }
+    
+    // 在threads个工作线程上扫描所有页块：每个线程用makePlan在自己的扫描算子上建立之后的算子（如过滤和投影），
+    // 把每个页块产生的各批依次交给consume(工作线程序号, 页块序号, 批)，同一个页块的各批按页的顺序交给同一个线程。
+    // 页块序号按页的顺序编号，按页块序号拼接各块的结果即为顺序扫描的结果；异常在所有线程结束后重新抛出
+    void run(size_t threads,
+             const std::function<std::unique_ptr<BatchOperator>(std::unique_ptr<BatchOperator>)>& makePlan,
+             const std::function<void(size_t worker, size_t morsel, const RowBatch& batch)>& consume);
+
+private:
+    friend class MorselOperator;
+    
+    HeapFile& heap_;
+    const std::vector<ColumnDef>& columns_;
+    std::vector<size_t> needed_;
+    std::function<bool(uint32_t)> skipPage_;
+    uint32_t pageCount_;
+    size_t morselCount_;
+    std::atomic<size_t> nextMorsel_{0};
+    std::mutex readMutex_;
+    
+    // 把[first, end)中的页依次复制到buffer中（每页kPageSize字节），复制了的页号按顺序放入pages；
+    // skipPage返回true的页以及不存在、未初始化或其中的元组都已删除的页不复制。整个页块只加锁一次
+    void copyPages(uint32_t first, uint32_t end, char* buffer, std::vector<uint32_t>& pages);
+};
+
+// 把算子产生的批分给threads个线程处理：调用线程拉取批，工作线程各自对收到的批调用
+// consume(工作线程序号, 批)，同一个序号的调用总在同一个线程中。各批的空间在线程之间轮流使用，
+// 不重新分配；consume抛出的异常在所有线程结束后重新抛出。threads不大于1时在调用线程中依次处理
+void parallelConsume(BatchOperator& input, size_t threads,
+                     const std::function<void(size_t worker, const RowBatch& batch)>& consume);
+
+// 在批上判断条件：把selection（升序）缩小为其中满足条件的行，AND和OR按子条件的顺序求值，
+// 已经确定结果的行不再判断后面的子条件
+void filterBatch(const Predicate& where, const RowBatch& batch, std::vector<uint16_t>& selection);
+
+} // namespace minidb
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include "Types.h"
+
+namespace minidb {
+
+// 过滤核使用的指令集
+enum class SimdLevel {
+    SCALAR,
+    SSE4,
+    AVX2
+};
+
+// 过滤核每次写入8个位置，选择向量在count之外还要留出的空间
+constexpr size_t kSelectionPadding = 8;
+
+// INT列上的区间条件：值在[lower, upper]内，inside为false时为不在该区间内。
+// 所有INT比较都可以写成区间：= 为[c, c]，!= 为不在[c, c]内，< 为[最小值, c - 1]，依此类推
+struct IntRange {
+    int32_t lower = std::numeric_limits<int32_t>::min();
+    int32_t upper = std::numeric_limits<int32_t>::max();
+    bool inside = true;
+    
+    // 由 列 op 值 得到区间，不可能成立的比较（如 < 最小值）得到空区间
+    static IntRange fromCompare(Operator op, int32_t value);
+    
+    // 与另一个区间求交，两者都必须是inside的区间
+    void intersect(const IntRange& other);
+};
+
+// 当前CPU支持的指令集，由CPUID判断一次
+SimdLevel detectSimdLevel();
+
+// 指令集的名字
+const char* simdLevelName(SimdLevel level);
+
+// 选出values[0, count)中满足区间条件的位置，按升序写入selection，返回个数。
+// count不能超过65536，selection至少要有count + kSelectionPadding个位置；按detectSimdLevel选用过滤核
+size_t selectIntRange(const int32_t* values, size_t count, const IntRange& range, uint16_t* selection);
+
+// 同上，使用指定的指令集（不能高于detectSimdLevel的结果），用于基准测试
+size_t selectIntRange(SimdLevel level, const int32_t* values, size_t count, const IntRange& range,
+                      uint16_t* selection);
+
+} // namespace minidb
@@ -0,0 +1,138 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <optional>
+#include <functional>
+#include <filesystem>
+#include "Types.h"
+#include "Page.h"
+#include "BufferPool.h"
+
+namespace minidb {
+
+// 将一行编码为元组：INT为4字节，STRING为2字节长度加内容
+std::string encodeTuple(const Record& record, const std::vector<ColumnDef>& columns);
+
+// 将元组解码为一行
+Record decodeTuple(std::string_view tuple, const std::vector<ColumnDef>& columns);
+
+// 元组视图：直接引用页内数据，按需解码单列，不复制整行
+class TupleView {
+public:
+    TupleView(std::string_view tuple, const std::vector<ColumnDef>& columns)
+        : tuple_(tuple), columns_(columns) {}
+    
+    // 获取INT列的值
+    int getInt(size_t colIndex) const;
+    
+    // 获取STRING列的值，引用页内数据
+    std::string_view getString(size_t colIndex) const;
+    
+    // 获取某一列的值（STRING列会复制）
+    Value getValue(size_t colIndex) const;
+    
+    // 检查某一列是否满足条件
+    bool matches(size_t colIndex, Operator op, const Value& value) const;
+    
+    // 解码整行
+    Record toRecord() const { return decodeTuple(tuple_, columns_); }
+    
+    // 元组的原始内容
+    std::string_view getTuple() const { return tuple_; }
+
+private:
+    std::string_view tuple_;
+    const std::vector<ColumnDef>& columns_;
+    
+    // 计算某一列在元组中的偏移
+    size_t columnOffset(size_t colIndex) const;
+};
+
+// 堆文件：第0页保存表结构等元数据，之后每页都是槽式页
+class HeapFile {
+public:
+    explicit HeapFile(const std::filesystem::path& path);
+    ~HeapFile() = default;
+    
+    // 判断文件是否为堆文件格式
+    static bool isHeapFile(const std::filesystem::path& path);
+    
+    // 创建新的堆文件
+    bool create(const std::vector<ColumnDef>& columns);
+    
+    // 打开已有的堆文件，读出表结构、二级索引定义和检查点LSN
+    bool open(std::vector<ColumnDef>& columns, std::vector<IndexDef>& indexes, uint64_t& checkpointLsn);
+    
+    // 是否已打开
+    bool isOpen() const { return open_; }
+    
+    // 写入元数据页
+    bool writeHeader(const std::vector<ColumnDef>& columns, const std::vector<IndexDef>& indexes,
+                     uint64_t checkpointLsn);
+    
+    // 写回所有脏页并落盘
+    bool flush();
+    
+    // 设置预写日志
+    void setWAL(std::shared_ptr<WAL> wal) { file_.setWAL(std::move(wal)); }
+    
+    // 一行编码后允许的最大长度：每行必须放在一个数据页中
+    static constexpr size_t maxTupleSize() { return SlottedPage::maxTupleSize(); }
+    
+    // 为给定长度的新元组选择插入位置（不修改页内容）
+    std::optional<RowId> reserveInsert(size_t tupleSize);
+    
+    // 在指定位置插入元组；页LSN不小于lsn时说明已经应用过，返回false
+    bool insertAt(RowId rowId, std::string_view tuple, uint64_t lsn);
+    
+    // 删除元组；页LSN大于lsn时跳过
+    bool erase(RowId rowId, uint64_t lsn);
+    
+    // 原地更新元组；页LSN大于lsn时跳过
+    bool update(RowId rowId, std::string_view tuple, uint64_t lsn);
+    
+    // 是否可以原地把元组更新为给定长度；reserved为同一页上其他待更新的元组已经预留的字节数
+    bool canUpdate(RowId rowId, size_t tupleSize, size_t reserved = 0);
+    
+    // 读取并解码一行
+    std::optional<Record> get(RowId rowId, const std::vector<ColumnDef>& columns);
+    
+    // 只读访问一行，元组在回调期间有效；行不存在时返回false
+    bool read(RowId rowId, const std::function<void(std::string_view)>& visitor);
+    
+    // 按页顺序遍历所有存活元组，元组在回调期间有效
+    void scan(const std::function<void(RowId, std::string_view)>& visitor);
+    
+    // 同上，但跳过skipPage返回true的页，这些页不会被读取
+    void scan(const std::function<bool(uint32_t pageId)>& skipPage,
+              const std::function<void(RowId, std::string_view)>& visitor);
+    
+    // 只读访问一个数据页：返回页的槽式页视图，其中的元组在guard释放前有效；
+    // 页不存在、未初始化或其中的元组都已删除时返回空
+    std::optional<SlottedPage> readDataPage(uint32_t pageId, PageGuard& guard);
+    
+    // 重新统计存活行数和已删除行数（日志重放后使用）
+    void recount();
+    
+    // 获取存活行数
+    size_t getRowCount() const { return rowCount_; }
+    
+    // 获取已删除但尚未回收的行数
+    size_t getDeletedCount() const { return deletedCount_; }
+    
+    // 获取数据页数
+    uint32_t getDataPageCount() const;
+
+private:
+    PageFile file_;
+    bool open_ = false;
+    size_t rowCount_ = 0;
+    size_t deletedCount_ = 0;
+    
+    // 获取一个数据页，未初始化的页会被初始化
+    PageGuard fetchDataPage(uint32_t pageId);
+};
+
+} // namespace minidb
\ No newline at end of file
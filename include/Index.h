@@ -1,58 +1,278 @@
 #pragma once
 
-#include <map>
 #include <string>
+#include <string_view>
 #include <vector>
-#include <fstream>
+#include <functional>
+#include <utility>
 #include <filesystem>
+#include <cstdint>
 #include "Types.h"
+#include "BufferPool.h"
 
 namespace minidb {
 
-// 索引基类
+// 把索引键的各列依次编码为保持顺序的字节串，两个编码可以直接用memcmp比较，也用于哈希
+std::string encodeIndexKey(const IndexKey& key);
+
+// 解码encodeIndexKey的结果
+IndexKey decodeIndexKey(std::string_view bytes);
+
+// 索引键编码后的长度
+size_t encodedKeySize(const IndexKey& key);
+
+// 索引项访问函数：行号，键的各列，包含列；返回false时停止查找
+using IndexEntryVisitor = std::function<bool(size_t rowId, const IndexKey& key, const Record& included)>;
+
+// 批量建立索引时的一项：键，行号，包含列
+struct IndexBuildEntry {
+    IndexKey key;
+    size_t rowId;
+    Record included;
+};
+
+// 索引基类：索引文件路径在构造时指定
 class Index {
 public:
     virtual ~Index() = default;
     
-    // 插入索引
-    virtual bool insert(const Value& key, size_t rowId) = 0;
+    // 插入索引，included为索引中额外保存的包含列的值
+    virtual bool insert(const IndexKey& key, size_t rowId, const Record& included) = 0;
+    
+    // 删除索引项（同一个键可能对应多行，按行号区分）
+    virtual bool remove(const IndexKey& key, size_t rowId) = 0;
+    
+    // 查找索引：key可以只包含前几列，按这几列的字典序与op比较
+    virtual std::vector<size_t> find(const IndexKey& key, Operator op) = 0;
     
-    // 删除索引
-    virtual bool remove(const Value& key) = 0;
+    // 与find相同的查找，但把每项的键和包含列交给visitor，用于只读索引的查询；visitor返回false时停止
+    virtual bool scan(const IndexKey& key, Operator op, const IndexEntryVisitor& visitor) = 0;
     
-    // 查找索引
-    virtual std::vector<size_t> find(const Value& key, Operator op) = 0;
+    // 区间查找：键的前几列与lower按lowerOp（EQUAL、GREATER_THAN或GREATER_EQUAL）比较、
+    // 与upper按upperOp（LESS_THAN或LESS_EQUAL）比较都成立的项
+    virtual std::vector<size_t> findRange(const IndexKey& lower, Operator lowerOp,
+                                          const IndexKey& upper, Operator upperOp) = 0;
     
-    // 保存索引
-    virtual bool save(const std::filesystem::path& indexPath) const = 0;
+    // 与findRange相同的查找，把每项的键和包含列交给visitor
+    virtual bool scanRange(const IndexKey& lower, Operator lowerOp, const IndexKey& upper, Operator upperOp,
+                           const IndexEntryVisitor& visitor) = 0;
     
-    // 加载索引
-    virtual bool load(const std::filesystem::path& indexPath) = 0;
+    // 按键的顺序（descending时按逆序）访问所有索引项的行号，visitor返回false时停止；
+    // 索引中的项没有顺序时不访问任何项并返回false
+    virtual bool scanOrdered(bool descending, const std::function<bool(size_t rowId)>& visitor) = 0;
+    
+    // 索引项是否按键排列，可以用scanOrdered按键的顺序访问
+    virtual bool isOrdered() const = 0;
+    
+    // 是否能为该键和包含列建立索引（例如过长时不能）
+    virtual bool supportsKey(const IndexKey& key, const Record& included) const = 0;
+    
+    // 是否支持用前keyColumns列、以该操作符查找
+    virtual bool supportsLookup(size_t keyColumns, Operator op) const = 0;
+    
+    // 清空索引（重建前使用）
+    virtual bool clear() = 0;
+    
+    // 清空索引后用全部索引项一次建立索引，比逐项插入快；entries的顺序可能被打乱
+    virtual bool build(std::vector<IndexBuildEntry>& entries) = 0;
+    
+    // 写回修改并落盘
+    virtual bool save() = 0;
+    
+    // 打开已有的索引文件，文件不存在、格式不对或上次修改后未保存时返回false
+    virtual bool load() = 0;
 };
 
-// 二叉树索引实现
+// B+树索引：每个节点是缓冲池中的一页，叶子节点按（键，行号）顺序链接，允许重复键
 class BTreeIndex : public Index {
 public:
-    BTreeIndex() = default;
+    explicit BTreeIndex(const std::filesystem::path& indexPath);
     ~BTreeIndex() = default;
     
-    // 插入索引
-    bool insert(const Value& key, size_t rowId) override;
+    // 插入索引，包含列保存在叶子单元中
+    bool insert(const IndexKey& key, size_t rowId, const Record& included) override;
+    
+    // 删除索引项
+    bool remove(const IndexKey& key, size_t rowId) override;
+    
+    // 查找索引：等值查找和范围查找都先下降到叶子，再沿叶子链表扫描
+    std::vector<size_t> find(const IndexKey& key, Operator op) override;
+    
+    // 与find相同的查找，从叶子中解码键和包含列
+    bool scan(const IndexKey& key, Operator op, const IndexEntryVisitor& visitor) override;
+    
+    // 区间查找：下降到下界处的叶子，扫描到超过上界为止
+    std::vector<size_t> findRange(const IndexKey& lower, Operator lowerOp,
+                                  const IndexKey& upper, Operator upperOp) override;
+    
+    // 与findRange相同的查找，从叶子中解码键和包含列
+    bool scanRange(const IndexKey& lower, Operator lowerOp, const IndexKey& upper, Operator upperOp,
+                   const IndexEntryVisitor& visitor) override;
+    
+    // 升序沿叶子链表扫描；叶子没有指向左兄弟的链接，降序从根开始按逆序深度优先访问各子节点
+    bool scanOrdered(bool descending, const std::function<bool(size_t rowId)>& visitor) override;
+    
+    // 叶子中的项按（键，行号）排列
+    bool isOrdered() const override { return true; }
+    
+    // 编码后的键和包含列不超过kMaxKeySize时才能建立索引
+    bool supportsKey(const IndexKey& key, const Record& included) const override;
+    
+    // 支持按任意前缀进行等值查找和范围查找，不支持不等于
+    bool supportsLookup(size_t, Operator op) const override { return op != Operator::NOT_EQUAL; }
+    
+    // 清空索引
+    bool clear() override;
+    
+    // 并行排序所有索引项后自底向上建树：依次填满叶子，再逐层建立内部节点
+    bool build(std::vector<IndexBuildEntry>& entries) override;
+    
+    // 写回修改并落盘
+    bool save() override;
+    
+    // 打开已有的索引文件
+    bool load() override;
+    
+    // 单个键和包含列编码后的最大长度，保证每个节点至少能放下3个键
+    static constexpr size_t kMaxKeySize = 1024;
+
+private:
+    PageFile file_;
+    uint32_t rootPage_ = 0;
+    uint64_t entryCount_ = 0;
+    bool open_ = false;
+    bool modified_ = false;
+    
+    // 从根节点下降到可能包含索引项的叶子，path记录经过的内部节点
+    uint32_t findLeaf(std::string_view entry, std::vector<uint32_t>* path);
+    
+    // 定位到叶子中第一个不小于entry的位置
+    std::pair<uint32_t, size_t> seek(std::string_view entry);
+    
+    // 最左边的叶子
+    uint32_t leftmostLeaf();
+    
+    // 在节点的pos处插入单元，放不下时分裂节点并把分隔项插入父节点
+    bool insertCell(uint32_t pageId, size_t pos, std::string_view cell, std::vector<uint32_t>& path);
     
-    // 删除索引
-    bool remove(const Value& key) override;
+    // 按条件查找，把匹配项的编码后的键、行号和包含列交给visitor；upper不为空时是区间查找，
+    // 扫描到前缀不满足 upperOp upper 为止，visitor返回false时提前停止
+    void lookup(const IndexKey& key, Operator op, const IndexKey* upper, Operator upperOp,
+                const std::function<bool(std::string_view key, size_t rowId, std::string_view included)>& visitor);
     
-    // 查找索引
-    std::vector<size_t> find(const Value& key, Operator op) override;
+    // 从叶子的pos处开始沿链表扫描，visitor返回false时停止
+    void scanLeaves(uint32_t pageId, size_t pos,
+                    const std::function<bool(std::string_view key, size_t rowId, std::string_view included)>& visitor);
     
-    // 保存索引
-    bool save(const std::filesystem::path& indexPath) const override;
+    // 按逆序访问以pageId为根的子树中的各项，visitor返回false时停止并返回false
+    bool scanReverse(uint32_t pageId, const std::function<bool(size_t rowId)>& visitor);
     
-    // 加载索引
-    bool load(const std::filesystem::path& indexPath) override;
+    // 自底向上建树时的一个节点：页号和节点中的第一个索引项
+    struct BuiltNode {
+        uint32_t pageId;
+        std::string firstEntry;
+    };
+    
+    // 用已排序的单元依次填充新节点，返回每个节点；内部节点的单元为下一层节点的分隔项
+    bool buildLevel(bool isLeaf, const std::vector<std::string_view>& cells, std::vector<BuiltNode>& nodes);
+    
+    // 写入元数据页
+    bool writeMeta(bool clean);
+    
+    // 保存之后第一次修改前，先把元数据页标记为未保存并落盘
+    bool markModified();
+};
+
+// 哈希索引：开放定址（线性探测）的哈希表，只支持给出所有列的等值查找。
+// 槽中保存预先计算的哈希值、行号和键，探测时先比较哈希值，单列INT键直接存在槽内，
+// 其他键编码后存在连续的键区中。整个表在内存中，保存时整体写入索引文件
+class HashIndex : public Index {
+public:
+    HashIndex(const std::filesystem::path& indexPath, size_t keyColumns);
+    ~HashIndex() = default;
+    
+    // 插入索引项，键和行号都相同的项已存在时不再插入；哈希索引不保存包含列
+    bool insert(const IndexKey& key, size_t rowId, const Record& included) override;
+    
+    // 删除索引项，用向后移动代替墓碑
+    bool remove(const IndexKey& key, size_t rowId) override;
+    
+    // 等值查找，其他操作符或只给出部分列时返回空结果
+    std::vector<size_t> find(const IndexKey& key, Operator op) override;
+    
+    // 与find相同的查找，把键交给visitor（没有包含列）
+    bool scan(const IndexKey& key, Operator op, const IndexEntryVisitor& visitor) override;
+    
+    // 不支持区间查找，返回空结果
+    std::vector<size_t> findRange(const IndexKey&, Operator, const IndexKey&, Operator) override { return {}; }
+    
+    // 不支持区间查找，不访问任何项
+    bool scanRange(const IndexKey&, Operator, const IndexKey&, Operator, const IndexEntryVisitor&) override {
+        return false;
+    }
+    
+    // 哈希表中的项没有顺序，不访问任何项
+    bool scanOrdered(bool, const std::function<bool(size_t)>&) override { return false; }
+    
+    // 项没有顺序
+    bool isOrdered() const override { return false; }
+    
+    // 任何键都可以建立索引，包含列不保存
+    bool supportsKey(const IndexKey&, const Record&) const override { return true; }
+    
+    // 只支持给出所有列的等值查找
+    bool supportsLookup(size_t keyColumns, Operator op) const override {
+        return op == Operator::EQUAL && keyColumns == keyColumns_;
+    }
+    
+    // 清空索引
+    bool clear() override;
+    
+    // 按项数一次分配足够的槽，直接放入所有项
+    bool build(std::vector<IndexBuildEntry>& entries) override;
+    
+    // 把整个哈希表写入临时文件，落盘后替换索引文件
+    bool save() override;
+    
+    // 读入索引文件并重建哈希表
+    bool load() override;
 
 private:
-    std::map<Value, size_t> indexMap_; // 简化实现，使用map代替B树
+    // 槽：rowId为kEmptySlot时表示空槽；keyLength为kIntKey时keyOffset中存放单列INT键，
+    // 否则键区中keyOffset处是encodeIndexKey编码后的键
+    struct Slot {
+        uint64_t hash;
+        uint64_t rowId;
+        uint32_t keyOffset;
+        uint32_t keyLength;
+    };
+    
+    static constexpr uint64_t kEmptySlot = UINT64_MAX;
+    static constexpr uint32_t kIntKey = UINT32_MAX;
+    
+    std::filesystem::path indexPath_;
+    size_t keyColumns_;
+    std::vector<Slot> slots_;
+    std::string keys_;
+    size_t entryCount_ = 0;
+    size_t garbageBytes_ = 0;
+    bool open_ = false;
+    bool modified_ = false;
+    
+    // 为键生成槽（不含行号），非内联的键编码到keyBytes中
+    Slot makeSlot(const IndexKey& key, std::string& keyBytes) const;
+    
+    // 槽中的键是否与probe中的键相同
+    bool keyEquals(const Slot& slot, const Slot& probe, std::string_view keyBytes) const;
+    
+    // 把槽放入哈希表（不检查是否已存在），非内联的键复制到键区
+    void place(Slot slot, std::string_view keyBytes);
+    
+    // 扩容或整理键区后重新放入所有项
+    void rehash(size_t capacity);
+    
+    // 保存之后第一次修改前，先把索引文件标记为未保存并落盘
+    bool markModified();
 };
 
-} // namespace minidb 
\ No newline at end of file
+} // namespace minidb
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <optional>
+#include "Types.h"
+#include "Table.h"
+#include "Predicate.h"
+
+namespace minidb {
+
+// 连接方法
+enum class JoinMethod {
+    HASH,               // 哈希连接：在估计行数较少的一侧上建哈希表，逐行用另一侧探测
+    INDEX_NESTED_LOOP   // 索引嵌套循环连接：逐行用外侧的连接列值在内侧连接列上的索引中查找
+};
+
+// 连接的一侧：表、连接列、下推到这一侧的条件（按表中的列位置编译）、需要取出的列
+// （连接列排在最前），以及计划器为这一侧选出的访问路径
+struct JoinSide {
+    Table* table = nullptr;
+    size_t key = 0;
+    Predicate where;
+    std::vector<size_t> needed;
+    AccessPath path;
+};
+
+// 连接计划：inner为哈希连接中建哈希表的一侧，或索引嵌套循环连接中被查找的一侧（0为左表，1为右表）
+struct JoinPlan {
+    JoinMethod method = JoinMethod::HASH;
+    size_t inner = 1;
+    size_t index = 0;       // 索引嵌套循环连接使用的内侧索引
+    bool spill = false;     // 估计哈希表超出内存预算，需要分区写出到临时文件
+    double rows = 0;        // 估计的结果行数
+    double cost = 0;        // 估计的代价，单位与访问路径相同
+};
+
+// 两表等值连接 左表.leftKey = 右表.rightKey。连接后的一行是左表的各列接着右表的各列，WHERE条件
+// 和输出列都按这个位置给出。只涉及一侧的合取项下推到该侧的访问路径中（连接列上的比较同时用于
+// 两侧），其余合取项在连接后的行上判断
+class JoinExecutor {
+public:
+    JoinExecutor(Table& left, size_t leftKey, Table& right, size_t rightKey, const Predicate& where,
+                 const std::vector<size_t>& output);
+    
+    // 列出所有候选计划，按代价从小到大排列，第一项就是选中的计划；memoryBudget为哈希表的内存预算
+    std::vector<JoinPlan> candidatePlans(size_t memoryBudget);
+    
+    // 按candidatePlans给出的计划执行连接，返回输出列；limit为最多返回的行数。哈希表超出memoryBudget时，
+    // 两侧的行按连接列的哈希值分区写出到临时文件，再逐个分区连接
+    std::vector<Record> execute(const JoinPlan& plan, size_t memoryBudget, std::optional<size_t> limit);
+    
+    // 计划的文字描述，用于EXPLAIN
+    std::string describe(const JoinPlan& plan) const;
+    
+    // 第side侧（0为左表，1为右表）
+    const JoinSide& getSide(size_t side) const { return sides_[side]; }
+    
+    // 连接后才能判断的条件（按连接后的列位置）
+    const Predicate& getResidual() const { return residual_; }
+
+private:
+    JoinSide sides_[2];
+    Predicate residual_;
+    std::vector<size_t> output_;
+    
+    // 连接后的一行中右表各列的起始位置
+    size_t rightOffset_ = 0;
+    
+    // 估计哈希表中一行占用的字节数
+    double rowBytes(size_t side) const;
+};
+
+} // namespace minidb
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string_view>
+#include <optional>
+
+namespace minidb {
+
+// 页大小
+constexpr size_t kPageSize = 4096;
+
+// 行号：高位为页号，低16位为槽号
+using RowId = size_t;
+
+inline RowId makeRowId(uint32_t pageId, uint16_t slot) {
+    return (static_cast<RowId>(pageId) << 16) | slot;
+}
+
+inline uint32_t rowIdPage(RowId rowId) {
+    return static_cast<uint32_t>(rowId >> 16);
+}
+
+inline uint16_t rowIdSlot(RowId rowId) {
+    return static_cast<uint16_t>(rowId & 0xFFFF);
+}
+
+// 槽式页：页头之后是向后增长的槽目录，元组数据从页尾向前增长
+//
+// | PageHeader | Slot 0 | Slot 1 | ... | 空闲空间 | ... | 元组1 | 元组0 |
+class SlottedPage {
+public:
+    struct Header {
+        uint64_t lsn;        // 最后一次修改该页的日志LSN
+        uint16_t slotCount;  // 槽目录长度（包括已删除的槽）
+        uint16_t freeEnd;    // 元组数据区的起始偏移
+        uint16_t liveCount;  // 未删除的元组数
+        uint16_t reserved;
+    };
+    
+    struct Slot {
+        uint16_t offset;
+        uint16_t length;     // 0表示该槽已删除
+    };
+    
+    explicit SlottedPage(char* data) : data_(data) {}
+    
+    // 页数据
+    const char* data() const { return data_; }
+    
+    // 初始化为空页
+    void init();
+    
+    // 是否已初始化（文件末尾之外读到的页全为0）
+    bool isInitialized() const { return header()->freeEnd != 0; }
+    
+    // 获取/设置页LSN
+    uint64_t getLsn() const { return header()->lsn; }
+    void setLsn(uint64_t lsn) { header()->lsn = lsn; }
+    
+    // 槽目录长度与存活元组数
+    uint16_t getSlotCount() const { return header()->slotCount; }
+    uint16_t getLiveCount() const { return header()->liveCount; }
+    
+    // 插入新元组需要的空间是否足够（包括新槽）
+    bool canInsert(size_t length) const;
+    
+    // 在下一个槽位插入元组，返回槽号
+    std::optional<uint16_t> insert(std::string_view tuple);
+    
+    // 在指定槽位插入元组（日志重放），槽号必须是下一个槽位
+    bool insertAt(uint16_t slot, std::string_view tuple);
+    
+    // 读取元组，已删除或不存在的槽返回空
+    std::optional<std::string_view> get(uint16_t slot) const;
+    
+    // 删除元组
+    bool erase(uint16_t slot);
+    
+    // 原地替换元组，空间不足时返回false且不修改页
+    bool update(uint16_t slot, std::string_view tuple);
+    
+    // 是否可以原地把元组替换为给定长度；reserved为同一页上其他待更新的元组已经预留的字节数
+    bool canUpdate(uint16_t slot, size_t length, size_t reserved = 0) const;
+    
+    // 单个元组允许的最大长度
+    static constexpr size_t maxTupleSize() {
+        return kPageSize - sizeof(Header) - sizeof(Slot);
+    }
+
+private:
+    char* data_;
+    
+    Header* header() { return reinterpret_cast<Header*>(data_); }
+    const Header* header() const { return reinterpret_cast<const Header*>(data_); }
+    Slot* slots() { return reinterpret_cast<Slot*>(data_ + sizeof(Header)); }
+    const Slot* slots() const { return reinterpret_cast<const Slot*>(data_ + sizeof(Header)); }
+    
+    // 连续空闲空间大小
+    size_t freeSpace() const;
+    
+    // 存活元组占用的字节数
+    size_t usedSpace() const;
+    
+    // 整理后可用的空闲空间（包括碎片）
+    size_t reclaimableSpace() const;
+    
+    // 整理元组数据区，回收碎片
+    void compact();
+};
+
+} // namespace minidb
\ No newline at end of file
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <iterator>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace minidb {
+
+// 每个线程至少分到的元素个数，元素太少时直接单线程排序
+constexpr size_t kMinParallelSortSize = 16 * 1024;
+
+// 可用的工作线程数
+inline size_t hardwareThreads() {
+    size_t threads = std::thread::hardware_concurrency();
+    return threads == 0 ? 1 : threads;
+}
+
+// 共享的工作线程池：线程在第一次需要时创建，之后一直保留，各次并行执行（扫描、聚合、排序）复用这些线程
+class WorkerPool {
+public:
+    static WorkerPool& getInstance();
+    
+    // 在threads个线程上执行task(序号)，序号从0到threads-1：调用线程执行序号0，其余序号由池中的线程执行，
+    // 池中的线程不够时先补足。所有序号执行完后返回，task抛出的第一个异常在此时重新抛出。
+    // 在task中再次调用或线程池已开始析构时不再分给其他线程，在当前线程中依次执行各序号
+    void run(size_t threads, const std::function<void(size_t worker)>& task);
+    
+    // 当前线程是否正在执行run分出的序号
+    static bool insideTask();
+
+private:
+    WorkerPool() = default;
+    ~WorkerPool();
+    
+    // 禁止拷贝和移动
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+    WorkerPool(WorkerPool&&) = delete;
+    WorkerPool& operator=(WorkerPool&&) = delete;
+    
+    std::vector<std::thread> threads_;
+    std::mutex runMutex_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable done_;
+    
+    // 当前执行的任务：下一个待领取的序号、序号总数和尚未执行完的序号数，以及第一个异常
+    const std::function<void(size_t)>* task_ = nullptr;
+    size_t nextWorker_ = 0;
+    size_t workerCount_ = 0;
+    size_t pending_ = 0;
+    std::exception_ptr error_;
+    bool stopping_ = false;
+    
+    // 池中线程的主循环：等待新的任务，领取其中的序号并执行
+    void loop();
+    
+    // 执行一个序号，记下第一个异常
+    void execute(size_t worker);
+};
+
+// 并行排序：先把区间分成若干段，各段在共享线程池的至多maxThreads个线程中排序，再逐轮两两归并。
+// comp必须可以在多个线程中同时调用
+template <typename Iterator, typename Compare>
+void parallelSort(Iterator first, Iterator last, Compare comp, size_t maxThreads = hardwareThreads()) {
+    size_t size = static_cast<size_t>(std::distance(first, last));
+    size_t threads = std::min(maxThreads, size / kMinParallelSortSize);
+    if (threads < 2) {
+        std::sort(first, last, comp);
+        return;
+    }
+    
+    // 分段排序
+    std::vector<Iterator> bounds;
+    for (size_t i = 0; i < threads; ++i) {
+        bounds.push_back(first + size * i / threads);
+    }
+    bounds.push_back(last);
+    
+    WorkerPool& pool = WorkerPool::getInstance();
+    pool.run(threads, [&bounds, &comp](size_t i) {
+        std::sort(bounds[i], bounds[i + 1], comp);
+    });
+    
+    // 每一轮把相邻的两段归并为一段，段数减半
+    while (bounds.size() > 2) {
+        std::vector<Iterator> merged;
+        size_t pairs = 0;
+        size_t i = 0;
+        for (; i + 2 < bounds.size(); i += 2) {
+            merged.push_back(bounds[i]);
+            ++pairs;
+        }
+        
+        // 段数为奇数时最后一段留到下一轮
+        if (i + 1 < bounds.size()) {
+            merged.push_back(bounds[i]);
+        }
+        merged.push_back(last);
+        
+        pool.run(pairs, [&bounds, &comp](size_t pair) {
+            size_t i = pair * 2;
+            std::inplace_merge(bounds[i], bounds[i + 1], bounds[i + 2], comp);
+        });
+        bounds = std::move(merged);
+    }
+}
+
+} // namespace minidb
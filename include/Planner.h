@@ -0,0 +1,40 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <optional>
+#include "Table.h"
+
+namespace minidb {
+
+// 查询计划器：用表的统计信息估计条件的选择率，在全表扫描、单个索引的查找、多个索引的
+// 交集（条件的合取项）和并集（条件的析取项）之间按估计的代价（以顺序读一页为单位）选择访问路径
+class Planner {
+public:
+    // 列出所有候选访问路径，按代价从小到大排列，第一项就是选中的路径。
+    // 没有条件时只有全表扫描；needed为需要返回的列，为空时只需要行号（DELETE、UPDATE）
+    static std::vector<AccessPath> candidatePaths(Table& table, const Predicate& where,
+                                                  const std::vector<size_t>& needed);
+    
+    // 选择代价最小的访问路径
+    static AccessPath choosePath(Table& table, const Predicate& where, const std::vector<size_t>& needed);
+    
+    // 在第index个索引上做一次等值查找、再回表读取matches行的估计代价，用于索引嵌套循环连接
+    static double probeCost(Table& table, size_t index, double matches);
+    
+    // 按第index个索引的顺序读取前entries个索引项、并逐个回表的估计代价，用于ORDER BY
+    static double orderedScanCost(Table& table, size_t index, double entries);
+    
+    // 对rows行（各列的类型为types）排序、取出前limit行（没有limit时为所有行）的估计代价：
+    // 有limit时用堆，否则超出内存预算的部分还要写出到临时文件再读回
+    static double sortCost(const std::vector<DataType>& types, double rows, size_t memoryBudget,
+                           std::optional<size_t> limit);
+    
+    // 访问路径的文字描述，用于EXPLAIN
+    static std::string describe(const Table& table, const AccessPath& path);
+    
+    // 按第index个索引的顺序读取的文字描述，用于EXPLAIN
+    static std::string describeOrderedScan(const Table& table, size_t index, bool descending);
+};
+
+} // namespace minidb
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "Types.h"
+#include "HeapFile.h"
+#include "ZoneMap.h"
+#include "TableStats.h"
+
+namespace minidb {
+
+// 编译后的WHERE条件：比较（列 op 值）以及由比较组成的AND、OR。编译时NOT已经下推到
+// 比较的操作符中，BETWEEN和IN已经展开为AND和OR，同类的嵌套节点已经合并。
+// 预编译语句中比较的值来自值槽，每次执行前用bind重新取出
+class Predicate {
+public:
+    // 节点类型
+    enum class Kind {
+        NONE,       // 没有条件，所有行都满足
+        COMPARE,    // 列 op 值
+        AND,
+        OR
+    };
+    
+    Predicate() = default;
+    
+    // 比较节点，slot为值在预编译语句值槽中的位置
+    static Predicate compare(size_t column, Operator op, Value value, size_t slot = 0);
+    
+    // AND或OR节点：同类的子节点会被展开，只有一个子条件时直接返回该子条件
+    static Predicate combine(Kind kind, std::vector<Predicate> children);
+    
+    // 节点类型
+    Kind getKind() const { return kind_; }
+    
+    // 比较节点的列、操作符和值
+    size_t getColumn() const { return column_; }
+    Operator getOp() const { return op_; }
+    const Value& getValue() const { return value_; }
+    
+    // AND和OR节点的子条件，按求值顺序排列
+    const std::vector<Predicate>& getChildren() const { return children_; }
+    
+    // 从值槽中取出各比较的值
+    void bind(const std::vector<Value>& values);
+    
+    // 一行是否满足条件，AND和OR按子条件的顺序短路求值
+    bool matches(const TupleView& row) const;
+    
+    // 按列位置给出的一行是否满足条件，只需要条件中用到的列
+    bool matches(const Record& row) const;
+    
+    // 区域映射表明该页所在的区域中没有满足条件的行
+    bool canSkip(const ZoneMap& zoneMap, uint32_t pageId) const;
+    
+    // 估计满足条件的行所占的比例：同一列上的上下界按区间计算，其余子条件按相互独立计算
+    double selectivity(const TableStats& stats) const;
+    
+    // 按估计的选择率和判断代价重新排列子条件：AND中先判断代价低而又最可能不成立的，
+    // OR中先判断代价低而又最可能成立的，使短路求值尽早结束
+    void reorder(const TableStats& stats);
+    
+    // 把条件中用到的列追加到columns中（可能重复）
+    void collectColumns(std::vector<size_t>& columns) const;
+    
+    // 条件的文字形式，按求值顺序排列，用于EXPLAIN
+    std::string toString(const std::vector<ColumnDef>& columns) const;
+
+private:
+    Kind kind_ = Kind::NONE;
+    size_t column_ = 0;
+    Operator op_ = Operator::EQUAL;
+    Value value_;
+    size_t slot_ = 0;
+    std::vector<Predicate> children_;
+    
+    // 判断一行时估计的代价：每个INT比较为1，STRING比较为2
+    double evaluationCost() const;
+};
+
+} // namespace minidb
@@ -0,0 +1,159 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <optional>
+#include "SQLParser.h"
+#include "Predicate.h"
+#include "Aggregate.h"
+#include "Sort.h"
+
+namespace minidb {
+
+class Database;
+class Table;
+class JoinExecutor;
+
+// 预编译语句：INSERT、DELETE、UPDATE或SELECT（可以连接两个表，可以聚合和排序）的语法树，加上解析好的表、列位置和
+// 转换好的常量值，执行时不再解析SQL，也不再按名字查找表和列。参数（?）在执行前绑定，
+// 绑定的值在多次执行之间保留。表被删除或关闭、或切换了数据库之后，下次执行时重新解析
+class PreparedStatement {
+public:
+    explicit PreparedStatement(Statement stmt);
+    
+    // 语句类型
+    SQLType getType() const { return stmt_.type; }
+    
+    // 参数个数
+    size_t getParamCount() const { return stmt_.paramCount; }
+    
+    // 在当前数据库中解析表和列、转换常量值
+    SQLResult resolve();
+    
+    // 绑定第index个参数（从0开始），值的类型必须与对应列的类型相同
+    bool bind(size_t index, const Value& value);
+    
+    // 按对应列的类型转换文本后绑定第index个参数
+    bool bind(size_t index, const std::string& text);
+    
+    // 执行语句，所有参数都必须已绑定
+    SQLResult execute();
+    
+    // 给出计划器为当前绑定的参数选择的访问路径和所有候选路径，不执行语句
+    SQLResult explain();
+
+private:
+    Statement stmt_;
+    std::weak_ptr<Database> db_;
+    std::weak_ptr<Table> table_;
+    
+    // SELECT的连接：另一个表，以及ON子句中左表和右表的列位置
+    std::weak_ptr<Table> joinTable_;
+    size_t leftKey_ = 0;
+    size_t rightKey_ = 0;
+    
+    // 值槽：INSERT为各列的值，UPDATE为设置值和条件中的各个值，DELETE/SELECT为条件中的各个值
+    std::vector<Value> values_;
+    std::vector<DataType> types_;
+    
+    // 每个参数对应的值槽，以及是否已绑定
+    std::vector<size_t> paramSlots_;
+    std::vector<bool> bound_;
+    
+    // 语句中可以引用的列：单表语句为表的各列，连接为左表的各列接着右表的各列（列名带表名前缀）
+    std::vector<ColumnDef> columns_;
+    
+    // 解析得到的列位置：UPDATE的设置列、SELECT的查询列（为空时为所有列；连接时为连接后的位置）
+    size_t setColumn_ = 0;
+    std::optional<size_t> selectColumn_;
+    
+    // 编译后的WHERE条件，比较的值在每次执行前从值槽中取出
+    Predicate where_;
+    
+    // 聚合查询：聚合的输入列（语句中可以引用的列的位置，不重复），分组列和各聚合函数在输入列中的位置，
+    // 以及结果的各列（SELECT列表的各项）在聚合得到的一行中的位置和列名
+    std::vector<size_t> aggregateInput_;
+    std::vector<size_t> groupColumns_;
+    std::vector<DataType> groupTypes_;
+    std::vector<AggregateSpec> aggregates_;
+    std::vector<size_t> itemColumns_;
+    std::vector<std::string> itemNames_;
+    
+    // ORDER BY的排序键。非聚合查询按排序的输入排序：输出列（查询列或所有列）接着只在ORDER BY中出现的列
+    // （语句中可以引用的列的位置）；聚合查询按聚合得到的一行排序，ORDER BY中不在SELECT列表里的聚合函数
+    // 也加入aggregates_
+    std::vector<size_t> sortInput_;
+    std::vector<SortKey> sortKeys_;
+    
+    // 按索引的顺序读取：使用的索引，估计读取的索引项数和代价，以及按访问路径读取再排序的估计代价
+    struct OrderedScan {
+        size_t index = 0;
+        double entries = 0;
+        double cost = 0;
+        double sortCost = 0;
+    };
+    
+    // 是否为聚合查询
+    bool isAggregate() const { return !stmt_.items.empty(); }
+    
+    // 执行时按访问路径全表扫描使用的工作线程数，不并行扫描时为1
+    size_t scanThreads(const Table& table, const AccessPath& path) const;
+    
+    // 需要取出的行数：LIMIT加上OFFSET，没有LIMIT时为空值
+    std::optional<size_t> rowsNeeded() const;
+    
+    // 非聚合查询的输出列个数
+    size_t outputCount() const { return selectColumn_ ? 1 : columns_.size(); }
+    
+    // 没有条件、连接和GROUP BY，SELECT列表都是COUNT：结果直接由表的行数得到
+    bool countsAllRows() const;
+    
+    // 表和数据库不再是解析时的对象时重新解析，再检查参数是否都已绑定
+    SQLResult prepareToRun(std::shared_ptr<Database>& db, std::shared_ptr<Table>& table);
+    
+    // 由计划器列出候选访问路径，第一项是选中的路径
+    std::vector<AccessPath> plan(Table& table);
+    
+    // 按访问路径执行SELECT并格式化查询结果
+    SQLResult executeSelect(Table& table, const AccessPath& path);
+    
+    // 单表的非聚合查询：有一个索引的前几列依次是ORDER BY的各列（方向相同），并且估计按它的顺序
+    // 读取、读够需要的行数为止比按访问路径读取再排序代价低时，返回该索引
+    std::optional<OrderedScan> orderedScan(Table& table, const AccessPath& path) const;
+    
+    // 按ORDER BY执行单表的非聚合查询：按索引的顺序读取，或按访问路径读取后排序
+    std::vector<Record> selectSorted(Table& table, const AccessPath& path);
+    
+    // 按排序的输入创建排序器，只需要前LIMIT + OFFSET行
+    ExternalSorter makeSorter() const;
+    
+    // 去掉前OFFSET行
+    void skipOffset(std::vector<Record>& rows) const;
+    
+    // ORDER BY的文字描述，用于EXPLAIN
+    std::string describeOrder() const;
+    
+    // 按访问路径读取满足条件的行并聚合，估计的行数较多时由多个线程各自累加部分结果再合并
+    std::vector<Record> aggregate(Table& table, const AccessPath& path);
+    
+    // 把聚合得到的各行转换为结果的各行（SELECT列表的各项），跳过OFFSET并按LIMIT截断
+    std::vector<Record> aggregateResult(const std::vector<Record>& groups) const;
+    
+    // 聚合的文字描述，用于EXPLAIN
+    std::string describeAggregate() const;
+    
+    // 按连接两表的列位置、条件和输出列创建连接
+    JoinExecutor makeJoin(Table& left, Table& right) const;
+    
+    // 按代价最小的连接计划执行连接查询并格式化查询结果
+    SQLResult executeJoin(Table& left, Table& right);
+    
+    // 给出选中的连接计划、两侧的访问路径和所有候选计划
+    SQLResult explainJoin(Table& left, Table& right);
+    
+    // 把查询结果格式化为列名、分隔线和各行
+    std::string formatResult(const std::vector<Record>& result) const;
+};
+
+} // namespace minidb
@@ -0,0 +1,158 @@
+#pragma once
+
+#include <cstring>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <variant>
+#include <vector>
+#include "Types.h"
+#include "HeapFile.h"
+#include "Predicate.h"
+
+namespace minidb {
+
+// 列类型对应的比较类型：INT按int32_t比较，STRING按string_view比较（引用页内数据）
+template <DataType Type>
+struct ColumnTraits;
+
+template <>
+struct ColumnTraits<DataType::INT> {
+    using Stored = int32_t;
+    using View = int32_t;
+    
+    // offset为列在元组中的固定偏移，前面有STRING列时为npos，需要逐列计算
+    static int32_t read(const TupleView& row, size_t column, size_t offset) {
+        if (offset == std::string_view::npos) {
+            return row.getInt(column);
+        }
+        int32_t value;
+        std::memcpy(&value, row.getTuple().data() + offset, sizeof(value));
+        return value;
+    }
+};
+
+template <>
+struct ColumnTraits<DataType::STRING> {
+    using Stored = std::string;
+    using View = std::string_view;
+    
+    static std::string_view read(const TupleView& row, size_t column, size_t offset) {
+        if (offset == std::string_view::npos) {
+            return row.getString(column);
+        }
+        uint16_t length;
+        std::memcpy(&length, row.getTuple().data() + offset, sizeof(length));
+        return row.getTuple().substr(offset + sizeof(length), length);
+    }
+};
+
+// 编译期确定的操作符
+template <Operator Op, typename T>
+inline bool applyOperator(const T& left, const T& right) {
+    if constexpr (Op == Operator::EQUAL) {
+        return left == right;
+    } else if constexpr (Op == Operator::NOT_EQUAL) {
+        return left != right;
+    } else if constexpr (Op == Operator::LESS_THAN) {
+        return left < right;
+    } else if constexpr (Op == Operator::LESS_EQUAL) {
+        return left <= right;
+    } else if constexpr (Op == Operator::GREATER_THAN) {
+        return left > right;
+    } else {
+        return left >= right;
+    }
+}
+
+// 列 op 值：列类型和操作符都是模板参数，判断一行时没有variant和操作符的分派
+template <DataType Type, Operator Op>
+struct CompareFunctor {
+    size_t column = 0;
+    size_t offset = std::string_view::npos;
+    typename ColumnTraits<Type>::Stored value{};
+    
+    bool operator()(const TupleView& row) const {
+        using View = typename ColumnTraits<Type>::View;
+        return applyOperator<Op>(ColumnTraits<Type>::read(row, column, offset), View(value));
+    }
+};
+
+// 同一列上的下界和上界（如BETWEEN展开的两个比较）：该列只读取一次
+template <DataType Type, Operator LowerOp, Operator UpperOp>
+struct RangeFunctor {
+    size_t column = 0;
+    size_t offset = std::string_view::npos;
+    typename ColumnTraits<Type>::Stored lower{};
+    typename ColumnTraits<Type>::Stored upper{};
+    
+    bool operator()(const TupleView& row) const {
+        using View = typename ColumnTraits<Type>::View;
+        View value = ColumnTraits<Type>::read(row, column, offset);
+        return applyOperator<LowerOp>(value, View(lower)) && applyOperator<UpperOp>(value, View(upper));
+    }
+};
+
+// 一行是否满足条件：由WHERE条件在每次查询开始时编译一次。条件中的每个比较都特化为
+// CompareFunctor或RangeFunctor；整个条件只是一个比较或一个区间时，dispatch把具体的
+// 函数对象类型交给调用方，逐行判断的循环可以把它内联展开，其余形式经过由特化节点组成的树
+class RowFilter {
+public:
+    // 按表的列定义编译条件，值的类型与列类型不同的比较总是不成立（与compareValues语义一致）
+    static RowFilter compile(const Predicate& where, const std::vector<ColumnDef>& columns);
+    
+    // 一行是否满足条件
+    bool operator()(const TupleView& row) const { return root_->matches(row); }
+    
+    // 用具体的函数对象调用fn(const auto& matches)，每次查询只分派一次
+    template <typename Fn>
+    void dispatch(Fn&& fn) const {
+        std::visit([&](const auto& functor) {
+            if constexpr (std::is_same_v<std::decay_t<decltype(functor)>, std::monostate>) {
+                fn(*this);
+            } else {
+                fn(functor);
+            }
+        }, top_);
+    }
+    
+    // 树中的一个节点（特化的比较或区间、AND、OR、常量）
+    struct Node {
+        virtual ~Node() = default;
+        virtual bool matches(const TupleView& row) const = 0;
+    };
+
+private:
+    // 整个条件是一个比较或一个区间时的函数对象，否则为monostate
+    using Top = std::variant<std::monostate,
+        CompareFunctor<DataType::INT, Operator::EQUAL>,
+        CompareFunctor<DataType::INT, Operator::NOT_EQUAL>,
+        CompareFunctor<DataType::INT, Operator::LESS_THAN>,
+        CompareFunctor<DataType::INT, Operator::LESS_EQUAL>,
+        CompareFunctor<DataType::INT, Operator::GREATER_THAN>,
+        CompareFunctor<DataType::INT, Operator::GREATER_EQUAL>,
+        CompareFunctor<DataType::STRING, Operator::EQUAL>,
+        CompareFunctor<DataType::STRING, Operator::NOT_EQUAL>,
+        CompareFunctor<DataType::STRING, Operator::LESS_THAN>,
+        CompareFunctor<DataType::STRING, Operator::LESS_EQUAL>,
+        CompareFunctor<DataType::STRING, Operator::GREATER_THAN>,
+        CompareFunctor<DataType::STRING, Operator::GREATER_EQUAL>,
+        RangeFunctor<DataType::INT, Operator::GREATER_THAN, Operator::LESS_THAN>,
+        RangeFunctor<DataType::INT, Operator::GREATER_THAN, Operator::LESS_EQUAL>,
+        RangeFunctor<DataType::INT, Operator::GREATER_EQUAL, Operator::LESS_THAN>,
+        RangeFunctor<DataType::INT, Operator::GREATER_EQUAL, Operator::LESS_EQUAL>,
+        RangeFunctor<DataType::STRING, Operator::GREATER_THAN, Operator::LESS_THAN>,
+        RangeFunctor<DataType::STRING, Operator::GREATER_THAN, Operator::LESS_EQUAL>,
+        RangeFunctor<DataType::STRING, Operator::GREATER_EQUAL, Operator::LESS_THAN>,
+        RangeFunctor<DataType::STRING, Operator::GREATER_EQUAL, Operator::LESS_EQUAL>>;
+    
+    std::shared_ptr<const Node> root_;
+    Top top_;
+    
+    // 整个条件是一个比较或同一列上的一个区间时设置top_
+    void compileTop(const Predicate& where, const std::vector<ColumnDef>& columns,
+                    const std::vector<size_t>& offsets);
+};
+
+} // namespace minidb
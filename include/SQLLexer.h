@@ -0,0 +1,52 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace minidb {
+
+// 记号类型
+enum class TokenType {
+    WORD,       // 关键字、标识符或不带引号的值（数字等）
+    STRING,     // 引号中的字符串，text包含两端的引号
+    SYMBOL,     // 符号：( ) , = < > * ; ? 以及比较运算符 <= >= != <>
+    END         // 语句结束
+};
+
+// 记号，text引用原SQL字符串
+struct Token {
+    TokenType type = TokenType::END;
+    std::string_view text;
+    
+    // 是否为指定的关键字（不区分大小写）
+    bool is(std::string_view keyword) const;
+    
+    // 是否为指定的单字符符号
+    bool is(char symbol) const {
+        return type == TokenType::SYMBOL && text.size() == 1 && text[0] == symbol;
+    }
+    
+    // 是否为指定的符号（可以是多个字符）
+    bool isSymbol(std::string_view symbol) const {
+        return type == TokenType::SYMBOL && text == symbol;
+    }
+};
+
+// 词法分析器：一次扫描把SQL语句切分为记号，不复制字符串
+class SQLLexer {
+public:
+    // 把sql切分为记号，末尾追加一个END记号；字符串缺少结束引号时返回false
+    static bool tokenize(std::string_view sql, std::vector<Token>& tokens);
+    
+    // 取出字符串记号的内容：两个连续的引号表示一个引号
+    static std::string unquote(const Token& token);
+    
+    // 单词转为小写：关键字、表名、列名等标识符都不区分大小写，只有引号中的字符串保留大小写
+    static std::string foldCase(std::string_view word);
+    
+    // 是否为符号字符
+    static bool isSymbol(char c);
+};
+
+} // namespace minidb
@@ -3,7 +3,8 @@
 #include <string>
 #include <vector>
 #include <optional>
-#include <tuple>
+#include <string_view>
+#include <memory>
 #include "Types.h"
 
 namespace minidb {
@@ -15,10 +16,18 @@ enum class SQLType {
     USE_DATABASE,
     CREATE_TABLE,
     DROP_TABLE,
+    CREATE_INDEX,
+    DROP_INDEX,
     INSERT,
     DELETE,
     UPDATE,
     SELECT,
+    SET,
+    CHECKPOINT,
+    PREPARE,
+    EXECUTE,
+    DEALLOCATE,
+    EXPLAIN,
     UNKNOWN
 };
 
@@ -36,57 +45,169 @@ struct CreateTableColumn {
     bool isPrimary = false;
 };
 
+// 字面量：引号中的字符串、不带引号的单词（数字、不带引号的字符串）或参数（?）
+struct Literal {
+    std::string text;
+    bool quoted = false;
+    
+    // 参数序号（按?在语句中出现的顺序从0编号），-1表示不是参数
+    int param = -1;
+};
+
+// WHERE条件的节点类型
+enum class ConditionType {
+    COMPARE,    // 列 操作符 值
+    BETWEEN,    // 列 between 下界 and 上界（包括两端）
+    IN,         // 列 in (值1, ...)
+    AND,
+    OR,
+    NOT
+};
+
+// WHERE条件的语法树
+struct Condition {
+    ConditionType type = ConditionType::COMPARE;
+    
+    // COMPARE、BETWEEN和IN的列名（可以写成 表名.列名），COMPARE的操作符
+    std::string column;
+    Operator op = Operator::EQUAL;
+    
+    // COMPARE的值，BETWEEN的下界和上界，或IN的值列表
+    std::vector<Literal> values;
+    
+    // AND和OR的子条件（至少两个），NOT的子条件（一个）
+    std::vector<Condition> children;
+};
+
+// 聚合查询中SELECT列表的一项：列，或作用在列上的聚合函数（COUNT(*)的列为"*"）
+struct SelectItem {
+    std::optional<AggregateFunction> function;
+    std::string column;
+};
+
+// ORDER BY子句的一项：列，或聚合查询中的聚合函数，以及是否降序
+struct OrderItem {
+    SelectItem item;
+    bool descending = false;
+};
+
+// 解析后的语句（语法树），只有与语句类型相关的字段有效
+struct Statement {
+    SQLType type = SQLType::UNKNOWN;
+    
+    // 数据库名或表名
+    std::string name;
+    
+    // 索引名
+    std::string indexName;
+    
+    // USING子句中的索引类型，为空时为B+树
+    std::string indexType;
+    
+    // CREATE TABLE的列定义
+    std::vector<CreateTableColumn> columnDefs;
+    
+    // 索引列，或SELECT的查询列（"*"表示所有列）
+    std::vector<std::string> columns;
+    
+    // INCLUDE子句中的列
+    std::vector<std::string> includeColumns;
+    
+    // INSERT的值列表
+    std::vector<Literal> values;
+    
+    // UPDATE的目标列或SET的设置项，以及要设置的值
+    std::string setName;
+    Literal setValue;
+    
+    // SELECT的JOIN子句：连接的表名，以及ON子句中等值比较的两列
+    std::string joinName;
+    std::string joinLeft;
+    std::string joinRight;
+    
+    // WHERE条件
+    std::optional<Condition> where;
+    
+    // 聚合查询（SELECT列表中有聚合函数，或有GROUP BY子句）的SELECT列表，此时columns为空
+    std::vector<SelectItem> items;
+    
+    // SELECT的GROUP BY子句中的列
+    std::vector<std::string> groupBy;
+    
+    // SELECT的ORDER BY子句，按各项依次比较
+    std::vector<OrderItem> orderBy;
+    
+    // SELECT的LIMIT子句：最多返回的行数，以及OFFSET中先跳过的行数
+    std::optional<size_t> limit;
+    size_t offset = 0;
+    
+    // 参数（?）个数
+    size_t paramCount = 0;
+    
+    // PREPARE和EXPLAIN的语句体
+    std::shared_ptr<const Statement> body;
+};
+
+class PreparedStatement;
+
 class SQLParser {
 public:
     // 解析并执行SQL语句
     static SQLResult execute(const std::string& sql);
     
+    // 把SQL语句解析为语法树；语法错误时返回false，error中为错误信息
+    static bool parse(std::string_view sql, Statement& stmt, std::string& error);
+    
+    // 执行已解析的语句
+    static SQLResult execute(const Statement& stmt);
+    
+    // 预编译一条INSERT、DELETE、UPDATE或SELECT语句，之后可以反复绑定参数并执行；
+    // 失败时返回nullptr，error中为错误信息
+    static std::shared_ptr<PreparedStatement> prepare(std::string_view sql, std::string& error);
+
 private:
-    // 解析CREATE DATABASE语句
-    static SQLResult parseCreateDatabase(const std::string& sql);
+    // 执行CREATE DATABASE语句
+    static SQLResult executeCreateDatabase(const Statement& stmt);
     
-    // 解析DROP DATABASE语句
-    static SQLResult parseDropDatabase(const std::string& sql);
+    // 执行DROP DATABASE语句
+    static SQLResult executeDropDatabase(const Statement& stmt);
     
-    // 解析USE语句
-    static SQLResult parseUse(const std::string& sql);
+    // 执行USE语句
+    static SQLResult executeUse(const Statement& stmt);
     
-    // 解析CREATE TABLE语句
-    static SQLResult parseCreateTable(const std::string& sql);
+    // 执行CREATE TABLE语句
+    static SQLResult executeCreateTable(const Statement& stmt);
     
-    // 解析DROP TABLE语句
-    static SQLResult parseDropTable(const std::string& sql);
+    // 执行DROP TABLE语句
+    static SQLResult executeDropTable(const Statement& stmt);
     
-    // 解析INSERT语句
-    static SQLResult parseInsert(const std::string& sql);
+    // 执行CREATE INDEX语句
+    static SQLResult executeCreateIndex(const Statement& stmt);
     
-    // 解析DELETE语句
-    static SQLResult parseDelete(const std::string& sql);
+    // 执行DROP INDEX语句
+    static SQLResult executeDropIndex(const Statement& stmt);
     
-    // 解析UPDATE语句
-    static SQLResult parseUpdate(const std::string& sql);
+    // 执行SET语句
+    static SQLResult executeSet(const Statement& stmt);
     
-    // 解析SELECT语句
-    static SQLResult parseSelect(const std::string& sql);
+    // 执行CHECKPOINT语句
+    static SQLResult executeCheckpoint(const Statement& stmt);
     
-    // 解析WHERE子句
-    static std::optional<std::tuple<std::string, Operator, std::string>> parseWhereClause(const std::string& whereClause);
+    // 执行PREPARE语句：解析表和列并以名字保存
+    static SQLResult executePrepare(const Statement& stmt);
     
-    // 解析值列表
-    static std::vector<std::string> parseValues(const std::string& values);
+    // 执行EXECUTE语句：绑定参数后执行已保存的预编译语句
+    static SQLResult executeExecute(const Statement& stmt);
     
-    // 解析列定义
-    static std::vector<CreateTableColumn> parseColumnDefs(const std::string& columnDefs);
+    // 执行DEALLOCATE语句
+    static SQLResult executeDeallocate(const Statement& stmt);
     
-    // 将字符串操作符转换为枚举
-    static Operator stringToOperator(const std::string& op);
+    // 执行EXPLAIN语句：给出计划器选择的访问路径，不执行语句体
+    static SQLResult executeExplain(const Statement& stmt);
     
     // 将字符串类型转换为枚举
     static DataType stringToDataType(const std::string& type);
     
-    // 从字符串中提取引号内的内容
-    static std::string extractQuotedString(const std::string& str);
-    
     // 检查标识符是否有效
     static bool isValidIdentifier(const std::string& identifier);
 };
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <vector>
+#include "Types.h"
+#include "Executor.h"
+#include "SpillFile.h"
+
+namespace minidb {
+
+// 排序键：列在行中的位置，以及是否降序
+struct SortKey {
+    size_t column = 0;
+    bool descending = false;
+};
+
+// 按排序键依次比较两行的各键列：a排在b前面时返回负数，排在后面时返回正数，相等时返回0
+int compareRows(const Record& a, const Record& b, const std::vector<SortKey>& keys);
+
+// 排序：依次加入各行，再按排序键取出排序后的行，键相等的行保持加入的顺序。
+// 给出limit时只需要排序后的前limit行，用大小为limit的堆保留当前最靠前的行，批中的行先与堆顶比较，
+// 不会进入堆的行不转换为记录；堆占用的空间超过内存预算时改为下面的方式，归并出limit行后停止。
+// 否则各行先在内存中累积，占用的空间超过内存预算时排序后作为一个有序段写出到临时文件，
+// 最后把各段和内存中的行多路归并
+class ExternalSorter {
+public:
+    // columns为行的各列定义（写出到临时文件时编码用），memoryBudget为内存中行的预算（字节）
+    ExternalSorter(std::vector<ColumnDef> columns, std::vector<SortKey> keys, size_t memoryBudget,
+                   std::optional<size_t> limit = std::nullopt);
+    
+    // 加入一行
+    void add(Record row);
+    
+    // 加入批中选中的各行，批中的列与columns对应
+    void add(const RowBatch& batch);
+    
+    // 排序后的行，跳过前offset行；只能调用一次
+    std::vector<Record> finish(size_t offset = 0);
+    
+    // 写出到临时文件的有序段数
+    size_t getRunCount() const { return runs_.size(); }
+
+private:
+    // 一行及其加入的序号，序号用于在键相等时保持加入的顺序
+    struct Entry {
+        Record row;
+        uint64_t sequence;
+    };
+    
+    std::vector<ColumnDef> columns_;
+    std::vector<SortKey> keys_;
+    size_t memoryBudget_;
+    std::optional<size_t> limit_;
+    uint64_t sequence_ = 0;
+    
+    // 是否用堆保留前limit行：有limit且堆没有超出内存预算
+    bool useHeap_;
+    
+    // 内存中的行：useHeap_时为按entryBefore排列的大顶堆，堆顶是当前最靠后的行
+    std::vector<Entry> entries_;
+    size_t memoryUsage_ = 0;
+    
+    // 已写出的有序段，按写出的顺序排列
+    std::vector<std::unique_ptr<SpillFile>> runs_;
+    
+    // a是否排在b前面
+    bool entryBefore(const Entry& a, const Entry& b) const;
+    
+    // 把一行放入堆中，堆已满时替换堆顶；堆超出内存预算时写出为一个有序段，之后不再使用堆
+    void push(Record row);
+    
+    // 把内存中的行排序后写出为一个有序段
+    void spill();
+    
+    // 一行在内存中占用的估计字节数
+    static size_t rowBytes(const Record& row);
+};
+
+} // namespace minidb
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <fstream>
+#include <filesystem>
+#include <cstdint>
+
+namespace minidb {
+
+// 临时文件：查询算子的数据超出内存预算时，把编码后的行依次写出，之后再按写入的顺序读回。
+// 每行前面写4字节长度；文件建在系统临时目录中，对象析构时删除
+class SpillFile {
+public:
+    SpillFile();
+    ~SpillFile();
+    
+    // 禁止拷贝
+    SpillFile(const SpillFile&) = delete;
+    SpillFile& operator=(const SpillFile&) = delete;
+    
+    // 追加一行，写入失败时抛出异常
+    void append(std::string_view row);
+    
+    // 写完后从头开始读取
+    void rewind();
+    
+    // 读取下一行，没有更多的行时返回false
+    bool next(std::string& row);
+    
+    // 已写入的行数和字节数（含长度）
+    size_t getRowCount() const { return rowCount_; }
+    size_t getByteCount() const { return byteCount_; }
+
+private:
+    std::filesystem::path path_;
+    std::fstream file_;
+    size_t rowCount_ = 0;
+    size_t byteCount_ = 0;
+};
+
+} // namespace minidb
@@ -7,8 +7,17 @@
 #include <fstream>
 #include <variant>
 #include <optional>
+#include <memory>
+#include <functional>
 #include "Types.h"
 #include "Index.h"
+#include "WAL.h"
+#include "HeapFile.h"
+#include "ZoneMap.h"
+#include "BloomFilter.h"
+#include "TableStats.h"
+#include "Predicate.h"
+#include "Executor.h"
 
 namespace minidb {
 
@@ -18,7 +27,7 @@ public:
     Table(const std::string& name, const std::string& dbName, 
           const std::vector<ColumnDef>& columns);
     ~Table();
-
+    
     // 获取表名
     std::string getName() const { return name_; }
     
@@ -34,44 +43,216 @@ public:
     // 插入记录
     bool insert(const std::vector<Value>& values);
     
-    // 根据条件删除记录
-    int deleteWhere(const std::string& colName, Operator op, const Value& value);
+    // 按访问路径删除满足条件的记录，没有条件时删除所有记录
+    int deleteWhere(const Predicate& where, const AccessPath& path);
+    
+    // 按访问路径更新满足条件的记录，没有条件时更新所有记录
+    int updateWhere(size_t setCol, const Value& setValue, const Predicate& where, const AccessPath& path);
+    
+    // 按访问路径查询满足条件的记录，查询列为空时返回所有列；limit为最多返回的行数
+    std::vector<Record> selectWhere(const Predicate& where, std::optional<size_t> selectCol,
+                                     const AccessPath& path, std::optional<size_t> limit = std::nullopt);
+    
+    // 查询所有记录，查询列为空时返回所有列
+    std::vector<Record> selectAll(std::optional<size_t> selectCol, std::optional<size_t> limit = std::nullopt);
+    
+    // 按第index个索引的顺序（descending时按逆序）逐行回表读取满足条件的行，读够limit行后停止；
+    // 返回needed中的列（按needed的顺序）。索引不能按顺序访问时返回空值
+    std::optional<std::vector<Record>> selectOrdered(const Predicate& where, const std::vector<size_t>& needed,
+                                                     size_t index, bool descending, std::optional<size_t> limit);
+    
+    // 按访问路径逐批产生满足条件的行，批中只有needed中的列（按needed的顺序，不能重复）；
+    // 用于连接等需要继续处理各行的查询
+    std::unique_ptr<BatchOperator> selectBatches(const Predicate& where, const std::vector<size_t>& needed,
+                                                 const AccessPath& path);
     
-    // 根据条件更新记录
-    int updateWhere(const std::string& setColName, const Value& setValue, 
-                    const std::string& whereColName, Operator op, const Value& whereValue);
+    // 按访问路径读取满足条件的行，把各批（只有needed中的列，按needed的顺序）交给consume(工作线程序号, 批)，
+    // 用于不关心行的顺序的处理（如聚合）。全表扫描按页块分给最多threads个工作线程，
+    // 索引查找得到的行由调用线程读取后分给threads个工作线程
+    void consumeBatches(const Predicate& where, const std::vector<size_t>& needed, const AccessPath& path,
+                        size_t threads, const std::function<void(size_t worker, const RowBatch& batch)>& consume);
     
-    // 根据条件查询记录
-    std::vector<Record> selectWhere(const std::string& colName, 
-                                     Operator op, const Value& value, 
-                                     const std::string& selectCol);
+    // 全表扫描该条件使用的工作线程数：区域映射不能跳过的页足够多时为parallel_workers设置的线程数
+    // （不超过这些页的页块数），否则为1
+    size_t scanThreads(const Predicate& where) const;
     
-    // 查询所有记录
-    std::vector<Record> selectAll(const std::string& selectCol);
+    // 用第index个索引查找第一列等于key的行，只读访问每个找到的行（元组在回调期间有效）；
+    // 索引不能用于等值查找时返回false
+    bool lookupEqual(size_t index, const Value& key, const std::function<void(const TupleView&)>& visitor);
     
     // 加载表数据
     bool loadData();
     
     // 保存表数据
-    bool saveData() const;
+    bool saveData();
     
-    // 创建索引
+    // 创建主键索引
     bool createIndex();
     
+    // 在一列或多列上创建二级索引（允许重复键），并为现有记录建立索引；
+    // includeNames中的列只保存在索引项中，用于不访问表文件的查询
+    bool createIndex(const std::string& indexName, const std::vector<std::string>& colNames,
+                     IndexType type = IndexType::BTREE, const std::vector<std::string>& includeNames = {});
+    
+    // 删除二级索引及其索引文件
+    bool dropIndex(const std::string& indexName);
+    
     // 获取列索引
     std::optional<size_t> getColumnIndex(const std::string& colName) const;
+    
+    // 获取索引个数（主键索引排在最前）
+    size_t getIndexCount() const { return indexes_.size(); }
+    
+    // 获取第i个索引的定义，主键索引没有名字
+    const IndexDef& getIndexDef(size_t i) const { return indexes_[i].def; }
+    
+    // 第i个索引是否支持用前keyColumns列、以该操作符查找
+    bool supportsLookup(size_t i, size_t keyColumns, Operator op) const;
+    
+    // 第i个索引是否能按键的顺序访问
+    bool supportsOrderedScan(size_t i) const { return i < indexes_.size() && indexes_[i].index->isOrdered(); }
+    
+    // 获取统计信息，修改的行数超过上次抽样时行数的1/10后重新抽样
+    const TableStats& getStats();
+    
+    // 获取数据页数
+    uint32_t getPageCount() const { return heap_->getDataPageCount(); }
+    
+    // 全表扫描该条件时，区域映射不能跳过的页数
+    uint32_t pagesToScan(const Predicate& where) const;
+    
+    // 设置预写日志
+    void setWAL(std::shared_ptr<WAL> wal);
+    
+    // 重放一条日志记录，返回该记录是否在检查点之后
+    bool applyLogRecord(const WALRecord& record);
+    
+    // 日志重放结束后重建索引、区域映射、主键过滤器和行数统计
+    void finishRecovery();
+    
+    // 获取行数
+    size_t getRowCount() const { return heap_->getRowCount(); }
+    
+    // 写出检查点：写回所有脏页，已删除的行过多时顺便整理表文件
+    bool checkpoint(uint64_t lsn);
+    
+    // 是否有尚未写入表文件的修改
+    bool isDirty() const { return dirty_; }
+    
+    // 获取表文件对应的检查点LSN
+    uint64_t getCheckpointLsn() const { return checkpointLsn_; }
 
 private:
+    // 表上的一个索引，主键索引没有名字并且排在最前
+    struct TableIndex {
+        IndexDef def;
+        std::unique_ptr<Index> index;
+    };
+    
     std::string name_;
     std::string dbName_;
     std::vector<ColumnDef> columns_;
     std::optional<size_t> primaryKeyCol_;
-    std::vector<Record> records_;
-    std::unique_ptr<Index> index_;
+    std::unique_ptr<HeapFile> heap_;
+    std::unique_ptr<ZoneMap> zoneMap_;
+    BloomFilter primaryKeys_;
+    TableStats stats_;
+    size_t modifiedRows_ = 0;
+    std::vector<TableIndex> indexes_;
     std::filesystem::path tablePath_;
+    std::filesystem::path indexPath_;
+    std::shared_ptr<WAL> wal_;
+    uint64_t checkpointLsn_ = 0;
+    bool dirty_ = false;
+    bool recovering_ = false;
+    
+    // 写入日志记录（未设置日志时直接返回成功）
+    bool logChange(WALRecord& record);
+    
+    // 在指定位置插入一行并更新索引
+    bool insertRow(RowId rowId, const Record& values, std::string_view tuple, uint64_t lsn);
+    
+    // 删除指定行并更新索引
+    void eraseRows(const std::vector<RowId>& rowIds, uint64_t lsn);
+    
+    // 更新指定行的某一列并更新索引，返回实际写入的行数
+    size_t assignRows(const std::vector<RowId>& rowIds, size_t colIndex, const Value& value, uint64_t lsn);
+    
+    // 把一行移动到新位置（原页放不下更新后的行时使用）
+    bool moveRow(RowId rowId, const Record& values);
+    
+    // 按索引定义创建索引对象
+    std::unique_ptr<Index> makeIndex(const IndexDef& def) const;
+    
+    // 一行的所有索引键是否都能放入索引
+    bool supportsKeys(const Record& values) const;
+    
+    // 从堆文件中读出的元组视图按顺序解码若干列，作为索引键或包含列
+    IndexKey makeKey(const std::vector<size_t>& columns, const TupleView& row) const;
+    
+    // 从已解码的Record中按顺序取出若干列，作为索引键或包含列
+    IndexKey makeKey(const std::vector<size_t>& columns, const Record& values) const;
+    
+    // 索引文件路径：主键索引为<表名>.idx，二级索引为<表名>.<索引名>.idx
+    std::filesystem::path indexPath(const IndexDef& def) const;
+    
+    // 需要写入元数据页的二级索引定义
+    std::vector<IndexDef> secondaryIndexDefs() const;
+    
+    // 条件要求的某个主键值一定不存在（布隆过滤器判断），此时不需要查找
+    bool definitelyAbsent(const Predicate& where) const;
+    
+    // 按访问路径查找满足条件的行号
+    std::vector<RowId> findRows(const Predicate& where, const AccessPath& path);
+    
+    // 索引查找使用的索引，索引不存在或不能用于该查找时返回nullptr
+    const TableIndex* lookupIndex(const IndexLookup& lookup) const;
+    
+    // 在索引上执行一次查找
+    std::vector<RowId> runLookup(const TableIndex& entry, const IndexLookup& lookup);
+    
+    // 按访问路径中的索引查找得到候选行号，交集和并集的结果按行号排序；
+    // 全表扫描或有索引不可用时返回空值
+    std::optional<std::vector<RowId>> lookupRows(const AccessPath& path);
+    
+    // 所有存活行的行号
+    std::vector<RowId> allRows();
+    
+    // 并行全表扫描：按页块把扫描分给threads个工作线程，各线程读取needed中的列（按needed的顺序，不能重复）
+    // 并判断条件，把每一批交给consume(工作线程序号, 页块序号, 批)；按页块序号拼接各块的结果即为按页顺序扫描的结果
+    void scanMorsels(const Predicate& where, const std::vector<size_t>& needed, size_t threads,
+                     const std::function<void(size_t worker, size_t morsel, const RowBatch& batch)>& consume);
+    
+    // 并行全表扫描的页块数
+    size_t getMorselCount() const { return (heap_->getDataPageCount() + kMorselPages - 1) / kMorselPages; }
+    
+    // 全表扫描的算子流水线：按批读取columns中的列，跳过区域映射表明没有满足条件的行的页，
+    // 再按条件过滤；产生的批按表的列位置存放各列
+    std::unique_ptr<BatchOperator> scanPipeline(const Predicate& where, const std::vector<size_t>& columns);
+    
+    // 用一次全表扫描重建所有索引
+    void rebuildIndexes();
+    
+    // 用一次全表扫描取出指定索引的所有项，再批量重建这些索引
+    void rebuildIndexes(const std::vector<Index*>& targets);
+    
+    // 用一次全表扫描重建区域映射
+    void rebuildZoneMap();
+    
+    // 用一次全表扫描重建主键值的布隆过滤器
+    void rebuildPrimaryKeyFilter();
+    
+    // 按页抽样重新计算统计信息
+    void rebuildStats();
+    
+    // 把旧格式的表文件转换为堆文件
+    bool importLegacyData();
+    
+    // 已删除的行是否多到需要整理
+    bool needsCompaction() const;
     
-    // 检查记录是否符合条件
-    bool matchCondition(const Record& record, size_t colIndex, Operator op, const Value& value) const;
+    // 整理表文件：把存活行紧凑地写入新文件并重建索引，行号会改变
+    bool compact(uint64_t lsn);
 };
 
 } // namespace minidb 
\ No newline at end of file
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include "Types.h"
+
+namespace minidb {
+
+// 列统计信息：不同值个数的估计，以及样本排序后等间隔取出的分位点（等深直方图的边界）
+struct ColumnStats {
+    double distinct = 1;
+    std::vector<Value> bounds;
+};
+
+// 表统计信息：由表文件的抽样计算，用于估计条件的选择率
+class TableStats {
+public:
+    // 用每列的样本值重新计算，rowCount为表的总行数；samples中的值会被排序
+    void build(std::vector<std::vector<Value>>& samples, size_t rowCount);
+    
+    // 估计满足 列 op 值 的行所占的比例
+    double selectivity(size_t colIndex, Operator op, const Value& value) const;
+    
+    // 计算统计信息时的行数
+    size_t getRowCount() const { return rowCount_; }
+    
+    // 是否已经计算过
+    bool isBuilt() const { return built_; }
+    
+    // 获取列统计信息
+    const ColumnStats& getColumn(size_t colIndex) const { return columns_[colIndex]; }
+
+private:
+    std::vector<ColumnStats> columns_;
+    size_t rowCount_ = 0;
+    bool built_ = false;
+};
+
+} // namespace minidb
@@ -4,6 +4,7 @@
 #include <variant>
 #include <vector>
 #include <memory>
+#include <optional>
 
 namespace minidb {
 
@@ -17,7 +18,19 @@ enum class DataType {
 enum class Operator {
     EQUAL,
     LESS_THAN,
-    GREATER_THAN
+    GREATER_THAN,
+    LESS_EQUAL,
+    GREATER_EQUAL,
+    NOT_EQUAL
+};
+
+// 聚合函数
+enum class AggregateFunction {
+    COUNT,
+    SUM,
+    MIN,
+    MAX,
+    AVG
 };
 
 // 值类型
@@ -36,6 +49,60 @@ struct ColumnDef {
         : name(name), type(type), isPrimary(isPrimary) {}
 };
 
+// 索引类型
+enum class IndexType {
+    BTREE,
+    HASH
+};
+
+// 二级索引定义：多列索引按columns的顺序比较，include中的列只保存在索引项中
+struct IndexDef {
+    std::string name;
+    std::vector<size_t> columns;
+    IndexType type = IndexType::BTREE;
+    std::vector<size_t> include;
+    
+    // 给定的列是否都在索引键或包含列中
+    bool covers(const std::vector<size_t>& needed) const;
+};
+
+// 访问方式
+enum class AccessMethod {
+    FULL_SCAN,          // 全表扫描，跳过区域映射表明没有满足条件的行的页
+    INDEX_PROBE,        // 索引等值查找
+    INDEX_RANGE_SCAN,   // 索引范围扫描
+    INDEX_INTERSECTION, // 多个索引查找的行号取交集（条件的多个合取项）
+    INDEX_UNION         // 多个索引查找的行号取并集（条件的多个析取项）
+};
+
+// 索引键：按索引定义的列顺序排列的各列值，查找时可以只给出前几列
+using IndexKey = std::vector<Value>;
+
+// 一次索引查找：索引的前几列依次等于prefix中的值，其后一列可以再有下界、上界或区间
+struct IndexLookup {
+    size_t index = 0;                   // 索引在表中的序号
+    IndexKey prefix;                    // 前几列的等值条件
+    std::optional<Operator> lowerOp;    // 下一列的下界（GREATER_THAN或GREATER_EQUAL）
+    Value lower;
+    std::optional<Operator> upperOp;    // 下一列的上界（LESS_THAN或LESS_EQUAL）
+    Value upper;
+    
+    // 是否有范围条件
+    bool hasRange() const { return lowerOp.has_value() || upperOp.has_value(); }
+    
+    // 查找用到的索引列数
+    size_t keyColumns() const { return prefix.size() + (hasRange() ? 1 : 0); }
+};
+
+// 访问路径：查询计划器按估计的代价选出，交给表执行。使用索引时得到的行仍要再判断整个条件
+struct AccessPath {
+    AccessMethod method = AccessMethod::FULL_SCAN;
+    std::vector<IndexLookup> lookups;   // 使用的索引查找，交集和并集时有多项
+    bool covering = false;              // 需要的列和条件列都在索引中，不访问表文件
+    double rows = 0;                    // 估计的行数
+    double cost = 0;                    // 估计的代价
+};
+
 // 获取Value类型的值
 template<typename T>
 T getValue(const Value& value) {
@@ -51,4 +118,7 @@ std::string valueToString(const Value& value);
 // 比较两个Value
 bool compareValues(const Value& left, const Value& right, Operator op);
 
+// 操作符的SQL写法
+std::string operatorToString(Operator op);
+
 } // namespace minidb 
\ No newline at end of file
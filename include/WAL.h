@@ -0,0 +1,93 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <functional>
+#include <filesystem>
+#include <chrono>
+#include <cstdint>
+#include "Types.h"
+
+namespace minidb {
+
+// 日志刷盘策略
+enum class WALSyncMode {
+    OFF,     // 不主动刷盘，由操作系统决定何时落盘
+    NORMAL,  // 每秒最多刷盘一次，检查点时必定刷盘
+    FULL     // 每条日志写入后立即刷盘
+};
+
+// 日志记录类型
+enum class WALRecordType : uint8_t {
+    INSERT = 1,
+    DELETE = 2,
+    UPDATE = 3
+};
+
+// 日志记录（逻辑行变更）
+struct WALRecord {
+    uint64_t lsn = 0;
+    WALRecordType type = WALRecordType::INSERT;
+    std::string tableName;
+    Record row;                  // INSERT：插入的整行
+    std::vector<size_t> rowIds;  // 受影响的行号（INSERT为插入位置）
+    size_t column = 0;           // UPDATE：被更新的列
+    Value value;                 // UPDATE：新值
+};
+
+// 预写日志：每个数据库一个只追加的日志文件，表文件只在检查点时整体写出
+class WAL {
+public:
+    explicit WAL(const std::filesystem::path& logPath);
+    ~WAL();
+    
+    // 追加一条日志记录，成功时为记录分配LSN
+    bool append(WALRecord& record);
+    
+    // 将已写入的日志刷到磁盘
+    bool sync();
+    
+    // 重放日志文件中的所有完整记录，遇到损坏的尾部时截断
+    bool replay(const std::function<void(const WALRecord&)>& apply);
+    
+    // 检查点完成后清空日志
+    bool truncate();
+    
+    // 保证后续分配的LSN不小于给定值
+    void advanceLsn(uint64_t lsn);
+    
+    // 获取最后一个已分配的LSN
+    uint64_t getLastLsn() const { return nextLsn_ - 1; }
+    
+    // 获取日志文件当前大小
+    size_t size() const { return fileSize_; }
+    
+    // 设置刷盘策略
+    void setSyncMode(WALSyncMode mode) { syncMode_ = mode; }
+    
+    // 获取刷盘策略
+    WALSyncMode getSyncMode() const { return syncMode_; }
+
+private:
+    std::filesystem::path logPath_;
+    int fd_ = -1;
+    uint64_t nextLsn_ = 1;
+    size_t fileSize_ = 0;
+    bool unsynced_ = false;
+    WALSyncMode syncMode_ = WALSyncMode::NORMAL;
+    std::chrono::steady_clock::time_point lastSync_;
+    
+    // 打开日志文件（不存在时创建并写入文件头）
+    bool open();
+    
+    // 关闭日志文件
+    void close();
+    
+    // 写入文件头
+    bool writeHeader();
+};
+
+// 将文件内容刷到磁盘
+bool syncFile(const std::filesystem::path& path);
+
+} // namespace minidb
\ No newline at end of file
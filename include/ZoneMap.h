@@ -0,0 +1,76 @@
+#pragma once
+
+#include <vector>
+#include <filesystem>
+#include <cstdint>
+#include "Types.h"
+#include "Page.h"
+#include "HeapFile.h"
+
+namespace minidb {
+
+// 区域映射：数据页按顺序每kZonePages页为一个区域，记录区域中每个INT列的最小值和最大值，
+// 以及插入和删除的行数。扫描时跳过不可能有满足条件的行的区域。
+// 删除和更新只会放宽范围，不会收紧，整理表文件或重建时才重新计算
+class ZoneMap {
+public:
+    ZoneMap(const std::filesystem::path& path, const std::vector<ColumnDef>& columns);
+    ~ZoneMap() = default;
+    
+    // 每个区域包含的数据页数
+    static constexpr uint32_t kZonePages = 16;
+    
+    // 记录插入的一行
+    void insert(RowId rowId, const Record& values);
+    void insert(RowId rowId, const TupleView& row);
+    
+    // 记录更新后的一行（只放宽范围）
+    void update(RowId rowId, const Record& values);
+    
+    // 记录删除的一行
+    void erase(RowId rowId);
+    
+    // 该页所在的区域中是否一定没有满足条件的行
+    bool canSkip(uint32_t pageId, size_t colIndex, Operator op, const Value& value) const;
+    
+    // 清空所有区域并按当前列定义重新确定INT列（重建前使用）
+    void clear();
+    
+    // 把所有区域写入临时文件，落盘后替换区域映射文件
+    bool save();
+    
+    // 读入区域映射文件，文件不存在、格式不对或上次修改后未保存时返回false
+    bool load();
+
+private:
+    // 一个区域：插入的行数，删除的行数，每个INT列的最小值和最大值
+    struct Zone {
+        uint32_t rows = 0;
+        uint32_t deleted = 0;
+        std::vector<int32_t> min;
+        std::vector<int32_t> max;
+    };
+    
+    static constexpr size_t kNoSlot = SIZE_MAX;
+    
+    std::filesystem::path path_;
+    const std::vector<ColumnDef>& columns_;
+    std::vector<size_t> intColumns_;
+    std::vector<size_t> slots_;
+    std::vector<Zone> zones_;
+    bool modified_ = true;
+    
+    // 按列定义确定INT列及每列在区域中的位置
+    void resolveColumns();
+    
+    // 行所在的区域，不存在时添加
+    Zone& zoneFor(RowId rowId);
+    
+    // 放宽区域中第slot个INT列的范围
+    static void widen(Zone& zone, size_t slot, int32_t value);
+    
+    // 保存之后第一次修改前，先把文件标记为未保存并落盘
+    void markModified();
+};
+
+} // namespace minidb
@@ -0,0 +1,419 @@
+#include "../include/Aggregate.h"
+#include "../include/HeapFile.h"
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <functional>
+#include <iomanip>
+#include <numeric>
+#include <sstream>
+
+namespace minidb {
+
+namespace {
+
+// 哈希表初始的槽数
+constexpr size_t kInitialSlots = 64;
+
+// 分组列编码的哈希值：高位用于定位槽，低32位保存在槽中
+uint64_t hashGroupKey(std::string_view key) {
+    uint64_t hash = std::hash<std::string_view>()(key);
+    hash ^= hash >> 33;
+    hash *= 0xFF51AFD7ED558CCDULL;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+// 单个INT分组列的哈希值（斐波那契散列）：高位用于定位槽，连续的值落在均匀分开的槽中
+uint64_t hashIntKey(int32_t value) {
+    return static_cast<uint64_t>(static_cast<uint32_t>(value)) * 0x9E3779B97F4A7C15ULL;
+}
+
+// 把一个值按元组格式追加到key中：INT为4字节，STRING为2字节长度加内容
+void appendKey(int32_t value, std::string& key) {
+    key.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+void appendKey(std::string_view value, std::string& key) {
+    uint16_t length = static_cast<uint16_t>(value.size());
+    key.append(reinterpret_cast<const char*>(&length), sizeof(length));
+    key.append(value);
+}
+
+// 用于STRING列的MIN和MAX：value比当前的值更小（或更大）时替换
+bool replacesText(AggregateFunction function, int64_t count, std::string_view value, const std::string& text) {
+    if (count == 0) {
+        return true;
+    }
+    return function == AggregateFunction::MIN ? value < text : value > text;
+}
+
+} // namespace
+
+const char* aggregateName(AggregateFunction function) {
+    switch (function) {
+        case AggregateFunction::COUNT: return "count";
+        case AggregateFunction::SUM: return "sum";
+        case AggregateFunction::MIN: return "min";
+        case AggregateFunction::MAX: return "max";
+        case AggregateFunction::AVG: return "avg";
+    }
+    return "";
+}
+
+HashAggregator::HashAggregator(std::vector<size_t> groupColumns, std::vector<DataType> groupTypes,
+                               std::vector<AggregateSpec> aggregates)
+    : groupColumns_(std::move(groupColumns)), aggregates_(std::move(aggregates)) {
+    for (size_t i = 0; i < groupTypes.size(); ++i) {
+        groupDefs_.emplace_back("", groupTypes[i]);
+    }
+    intKey_ = groupTypes.size() == 1 && groupTypes.front() == DataType::INT;
+    hasText_ = std::any_of(aggregates_.begin(), aggregates_.end(), [](const AggregateSpec& spec) {
+        return spec.function != AggregateFunction::COUNT && spec.type == DataType::STRING;
+    });
+    slots_.resize(kInitialSlots);
+    mask_ = kInitialSlots - 1;
+    shift_ = 64 - static_cast<unsigned>(std::countr_zero(kInitialSlots));
+    keyOffsets_.push_back(0);
+    
+    // 没有分组列时唯一的一组编码为空
+    if (groupColumns_.empty()) {
+        findOrInsert(std::string_view());
+    }
+}
+
+uint32_t HashAggregator::findOrInsert(std::string_view key) {
+    if (intKey_) {
+        int32_t value;
+        std::memcpy(&value, key.data(), sizeof(value));
+        return findOrInsert(value);
+    }
+    uint64_t hash = hashGroupKey(key);
+    uint32_t tag = static_cast<uint32_t>(hash);
+    for (uint64_t i = hash >> shift_;; i = (i + 1) & mask_) {
+        Slot& slot = slots_[i];
+        if (slot.group == kEmpty) {
+            return insertGroup(slot, tag, key, hash);
+        }
+        if (slot.tag == tag && groupKey(slot.group) == key) {
+            return slot.group;
+        }
+    }
+}
+
+uint32_t HashAggregator::findOrInsert(int32_t value) {
+    uint64_t hash = hashIntKey(value);
+    uint32_t tag = static_cast<uint32_t>(value);
+    for (uint64_t i = hash >> shift_;; i = (i + 1) & mask_) {
+        Slot& slot = slots_[i];
+        if (slot.group == kEmpty) {
+            return insertGroup(slot, tag, std::string_view(reinterpret_cast<const char*>(&value), sizeof(value)), hash);
+        }
+        if (slot.tag == tag) {
+            return slot.group;
+        }
+    }
+}
+
+uint32_t HashAggregator::insertGroup(Slot& slot, uint32_t tag, std::string_view key, uint64_t hash) {
+    uint32_t group = static_cast<uint32_t>(hashes_.size());
+    slot.tag = tag;
+    slot.group = group;
+    keys_.append(key);
+    keyOffsets_.push_back(keys_.size());
+    hashes_.push_back(hash);
+    states_.resize(states_.size() + aggregates_.size());
+    if (hasText_) {
+        texts_.resize(states_.size());
+    }
+    if (hashes_.size() * 4 > slots_.size()) {
+        grow();
+    }
+    return group;
+}
+
+void HashAggregator::grow() {
+    slots_.assign(slots_.size() * 2, Slot());
+    mask_ = slots_.size() - 1;
+    --shift_;
+    for (uint32_t group = 0; group < hashes_.size(); ++group) {
+        uint64_t i = hashes_[group] >> shift_;
+        while (slots_[i].group != kEmpty) {
+            i = (i + 1) & mask_;
+        }
+        if (intKey_) {
+            std::memcpy(&slots_[i].tag, keys_.data() + keyOffsets_[group], sizeof(uint32_t));
+        } else {
+            slots_[i].tag = static_cast<uint32_t>(hashes_[group]);
+        }
+        slots_[i].group = group;
+    }
+}
+
+template <typename Fn>
+void HashAggregator::forEachSelected(const RowBatch& batch, size_t aggregate, Fn&& fn) {
+    State* states = states_.data() + aggregate;
+    size_t stride = aggregates_.size();
+    const auto& selection = batch.selection;
+    for (size_t k = 0; k < selection.size(); ++k) {
+        fn(states[groupIds_[k] * stride], selection[k]);
+    }
+}
+
+void HashAggregator::consume(const RowBatch& batch) {
+    const auto& selection = batch.selection;
+    
+    // 先找到每一行所在的组
+    if (groupColumns_.empty()) {
+        groupIds_.assign(selection.size(), 0);
+    } else if (intKey_) {
+        groupIds_.resize(selection.size());
+        const int32_t* keys = batch.columns[groupColumns_.front()].ints.data();
+        uint32_t* groupIds = groupIds_.data();
+        for (size_t k = 0; k < selection.size(); ++k) {
+            // 探测在局部变量上进行，只有新建分组时才可能改变哈希表
+            int32_t value = keys[selection[k]];
+            uint64_t hash = hashIntKey(value);
+            const Slot* slots = slots_.data();
+            uint64_t i = hash >> shift_;
+            while (slots[i].group != kEmpty && slots[i].tag != static_cast<uint32_t>(value)) {
+                i = (i + 1) & mask_;
+            }
+            groupIds[k] = slots[i].group != kEmpty ? slots[i].group : findOrInsert(value);
+        }
+    } else {
+        groupIds_.resize(selection.size());
+        for (size_t k = 0; k < selection.size(); ++k) {
+            key_.clear();
+            for (size_t column : groupColumns_) {
+                const ColumnVector& values = batch.columns[column];
+                if (values.type == DataType::INT) {
+                    appendKey(values.ints[selection[k]], key_);
+                } else {
+                    appendKey(values.strings[selection[k]], key_);
+                }
+            }
+            groupIds_[k] = findOrInsert(key_);
+        }
+    }
+    
+    // 再按聚合函数逐列累加，每个聚合函数只分派一次
+    for (size_t a = 0; a < aggregates_.size(); ++a) {
+        const AggregateSpec& spec = aggregates_[a];
+        if (spec.function == AggregateFunction::COUNT) {
+            forEachSelected(batch, a, [](State& state, uint16_t) { ++state.count; });
+            continue;
+        }
+        const ColumnVector& values = batch.columns[*spec.column];
+        if (spec.type == DataType::STRING) {
+            const std::string_view* strings = values.strings.data();
+            for (size_t k = 0; k < selection.size(); ++k) {
+                size_t position = groupIds_[k] * aggregates_.size() + a;
+                std::string_view value = strings[selection[k]];
+                if (replacesText(spec.function, states_[position].count, value, texts_[position])) {
+                    texts_[position].assign(value);
+                }
+                ++states_[position].count;
+            }
+            continue;
+        }
+        const int32_t* ints = values.ints.data();
+        switch (spec.function) {
+            case AggregateFunction::MIN:
+                forEachSelected(batch, a, [&](State& state, uint16_t i) {
+                    state.min = std::min(state.min, ints[i]);
+                    ++state.count;
+                });
+                break;
+            case AggregateFunction::MAX:
+                forEachSelected(batch, a, [&](State& state, uint16_t i) {
+                    state.max = std::max(state.max, ints[i]);
+                    ++state.count;
+                });
+                break;
+            default:
+                forEachSelected(batch, a, [&](State& state, uint16_t i) {
+                    state.sum += ints[i];
+                    ++state.count;
+                });
+                break;
+        }
+    }
+}
+
+void HashAggregator::consume(const Record& row) {
+    uint32_t group = 0;
+    if (!groupColumns_.empty()) {
+        key_.clear();
+        for (size_t column : groupColumns_) {
+            if (std::holds_alternative<int>(row[column])) {
+                appendKey(std::get<int>(row[column]), key_);
+            } else {
+                appendKey(std::get<std::string>(row[column]), key_);
+            }
+        }
+        group = findOrInsert(key_);
+    }
+    
+    for (size_t a = 0; a < aggregates_.size(); ++a) {
+        const AggregateSpec& spec = aggregates_[a];
+        size_t position = group * aggregates_.size() + a;
+        State& state = states_[position];
+        if (spec.function != AggregateFunction::COUNT) {
+            const Value& value = row[*spec.column];
+            if (spec.type == DataType::STRING) {
+                const std::string& text = std::get<std::string>(value);
+                if (replacesText(spec.function, state.count, text, texts_[position])) {
+                    texts_[position] = text;
+                }
+            } else {
+                int32_t number = std::get<int>(value);
+                state.sum += number;
+                state.min = std::min(state.min, number);
+                state.max = std::max(state.max, number);
+            }
+        }
+        ++state.count;
+    }
+}
+
+void HashAggregator::merge(const HashAggregator& other) {
+    size_t stride = aggregates_.size();
+    for (uint32_t from = 0; from < other.hashes_.size(); ++from) {
+        uint32_t group = findOrInsert(other.groupKey(from));
+        for (size_t a = 0; a < stride; ++a) {
+            size_t position = group * stride + a;
+            size_t partialPosition = from * stride + a;
+            State& state = states_[position];
+            const State& partial = other.states_[partialPosition];
+            if (partial.count == 0) {
+                continue;
+            }
+            if (hasText_ && replacesText(aggregates_[a].function, state.count, other.texts_[partialPosition],
+                                         texts_[position])) {
+                texts_[position] = other.texts_[partialPosition];
+            }
+            state.count += partial.count;
+            state.sum += partial.sum;
+            state.min = std::min(state.min, partial.min);
+            state.max = std::max(state.max, partial.max);
+        }
+    }
+}
+
+std::vector<Record> HashAggregator::finish(const std::vector<SortKey>& order) const {
+    size_t stride = aggregates_.size();
+    size_t keyColumns = groupDefs_.size();
+    
+    // 结果按分组列排序，多线程累加时也与单线程相同。只有一个INT分组列时先按（值，分组号）排列分组
+    std::vector<std::pair<int32_t, uint32_t>> groups(hashes_.size());
+    for (uint32_t group = 0; group < groups.size(); ++group) {
+        groups[group].second = group;
+        if (intKey_) {
+            std::memcpy(&groups[group].first, keys_.data() + keyOffsets_[group], sizeof(int32_t));
+        }
+    }
+    if (intKey_) {
+        std::sort(groups.begin(), groups.end());
+    }
+    
+    std::vector<Record> rows;
+    rows.reserve(hashes_.size());
+    for (const auto& [value, group] : groups) {
+        Record& row = rows.emplace_back();
+        row.reserve(keyColumns + stride);
+        if (intKey_) {
+            row.emplace_back(value);
+        } else {
+            row = decodeTuple(groupKey(group), groupDefs_);
+        }
+        for (size_t a = 0; a < stride; ++a) {
+            const AggregateSpec& spec = aggregates_[a];
+            const State& state = states_[group * stride + a];
+            if (spec.function == AggregateFunction::COUNT) {
+                row.emplace_back(static_cast<int>(state.count));
+                continue;
+            }
+            if (state.count == 0) {
+                row.emplace_back(std::string("NULL"));
+                continue;
+            }
+            switch (spec.function) {
+                case AggregateFunction::SUM:
+                    row.emplace_back(std::to_string(state.sum));
+                    break;
+                case AggregateFunction::AVG: {
+                    std::ostringstream text;
+                    text << std::fixed << std::setprecision(2)
+                         << static_cast<double>(state.sum) / static_cast<double>(state.count);
+                    row.emplace_back(text.str());
+                    break;
+                }
+                default:
+                    if (spec.type == DataType::STRING) {
+                        row.emplace_back(texts_[group * stride + a]);
+                    } else {
+                        row.emplace_back(spec.function == AggregateFunction::MIN ? state.min : state.max);
+                    }
+                    break;
+            }
+        }
+    }
+    if (intKey_ && order.empty()) {
+        return rows;
+    }
+    
+    // 按排列后的位置比较两行：分组列、COUNT、MIN和MAX比较行中的值，SUM和AVG的文本不能直接比较，
+    // 比较累加状态中的和与平均值
+    auto compareKey = [&](const SortKey& key, size_t a, size_t b) {
+        if (key.column >= keyColumns && rows[a][key.column] != rows[b][key.column]) {
+            size_t aggregate = key.column - keyColumns;
+            const State& left = states_[groups[a].second * stride + aggregate];
+            const State& right = states_[groups[b].second * stride + aggregate];
+            if (aggregates_[aggregate].function == AggregateFunction::SUM) {
+                return left.sum < right.sum ? -1 : (left.sum > right.sum ? 1 : 0);
+            }
+            if (aggregates_[aggregate].function == AggregateFunction::AVG) {
+                double x = static_cast<double>(left.sum) / static_cast<double>(left.count);
+                double y = static_cast<double>(right.sum) / static_cast<double>(right.count);
+                return x < y ? -1 : (x > y ? 1 : 0);
+            }
+        }
+        const Value& x = rows[a][key.column];
+        const Value& y = rows[b][key.column];
+        return x < y ? -1 : (y < x ? 1 : 0);
+    };
+    std::vector<size_t> positions(rows.size());
+    std::iota(positions.begin(), positions.end(), 0);
+    if (!intKey_) {
+        std::sort(positions.begin(), positions.end(), [&](size_t a, size_t b) {
+            for (size_t i = 0; i < keyColumns; ++i) {
+                if (int cmp = compareKey(SortKey{i, false}, a, b); cmp != 0) {
+                    return cmp < 0;
+                }
+            }
+            return false;
+        });
+    }
+    
+    // ORDER BY的各项相等时保持按分组列排列的顺序
+    if (!order.empty()) {
+        std::stable_sort(positions.begin(), positions.end(), [&](size_t a, size_t b) {
+            for (const auto& key : order) {
+                if (int cmp = compareKey(key, a, b); cmp != 0) {
+                    return key.descending ? cmp > 0 : cmp < 0;
+                }
+            }
+            return false;
+        });
+    }
+    
+    std::vector<Record> result;
+    result.reserve(rows.size());
+    for (size_t position : positions) {
+        result.push_back(std::move(rows[position]));
+    }
+    return result;
+}
+
+} // namespace minidb
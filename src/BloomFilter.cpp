@@ -0,0 +1,83 @@
+#include "../include/BloomFilter.h"
+#include <string_view>
+#include <algorithm>
+#include <functional>
+
+namespace minidb {
+
+namespace {
+
+// 每个值占用的位数，约1%的误判率
+constexpr size_t kBitsPerValue = 10;
+
+// 最小容量
+constexpr size_t kMinCapacity = 1024;
+
+// 块内8个字各自的奇数乘数，把同一个32位哈希值映射为8个不同的位
+constexpr uint32_t kSalts[8] = {
+    0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU,
+    0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U
+};
+
+// 64位整数混合函数
+uint64_t mix(uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdull;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ull;
+    h ^= h >> 33;
+    return h;
+}
+
+} // namespace
+
+void BloomFilter::reset(size_t expectedValues) {
+    capacity_ = std::max(expectedValues, kMinCapacity);
+    size_t blockCount = (capacity_ * kBitsPerValue + sizeof(Block) * 8 - 1) / (sizeof(Block) * 8);
+    blocks_.assign(blockCount, Block{});
+    added_ = 0;
+    removed_ = 0;
+}
+
+void BloomFilter::add(const Value& value) {
+    uint64_t h = hash(value);
+    Block& block = blocks_[((h >> 32) * blocks_.size()) >> 32];
+    Block bits = mask(static_cast<uint32_t>(h));
+    for (size_t i = 0; i < block.size(); ++i) {
+        block[i] |= bits[i];
+    }
+    ++added_;
+}
+
+bool BloomFilter::mayContain(const Value& value) const {
+    uint64_t h = hash(value);
+    const Block& block = blocks_[((h >> 32) * blocks_.size()) >> 32];
+    Block bits = mask(static_cast<uint32_t>(h));
+    for (size_t i = 0; i < block.size(); ++i) {
+        if ((block[i] & bits[i]) == 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool BloomFilter::needsRebuild() const {
+    return added_ > capacity_ || (removed_ >= kMinCapacity && removed_ * 2 > added_);
+}
+
+uint64_t BloomFilter::hash(const Value& value) {
+    if (std::holds_alternative<int>(value)) {
+        return mix(static_cast<uint32_t>(std::get<int>(value)));
+    }
+    return mix(std::hash<std::string_view>{}(std::get<std::string>(value)) ^ 0x9e3779b97f4a7c15ull);
+}
+
+BloomFilter::Block BloomFilter::mask(uint32_t hash) {
+    Block bits;
+    for (size_t i = 0; i < bits.size(); ++i) {
+        bits[i] = 1U << ((hash * kSalts[i]) >> 27);
+    }
+    return bits;
+}
+
+} // namespace minidb
@@ -0,0 +1,366 @@
+#include "../include/BufferPool.h"
+#include <iostream>
+#include <cstring>
+#include <cerrno>
+#include <algorithm>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace minidb {
+
+// 默认缓冲池大小：64MB
+constexpr size_t kDefaultPoolPages = 64 * 1024 * 1024 / kPageSize;
+
+// 缓冲池最少保留的页数
+constexpr size_t kMinPoolPages = 16;
+
+PageFile::PageFile(const std::filesystem::path& path) : path_(path) {
+}
+
+PageFile::~PageFile() {
+    close();
+}
+
+bool PageFile::open() {
+    if (fd_ >= 0) {
+        return true;
+    }
+    
+    fd_ = ::open(path_.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd_ < 0) {
+        std::cerr << "打开页文件失败: " << path_ << std::endl;
+        return false;
+    }
+    
+    // 崩溃时可能留下不完整的最后一页，按整页计算
+    off_t size = ::lseek(fd_, 0, SEEK_END);
+    fileSize_ = static_cast<size_t>(size);
+    pageCount_ = static_cast<uint32_t>((size + kPageSize - 1) / kPageSize);
+    return true;
+}
+
+void PageFile::close() {
+    if (fd_ >= 0) {
+        BufferPool::getInstance().discardFile(*this);
+        unmap();
+        ::close(fd_);
+        fd_ = -1;
+    }
+}
+
+bool PageFile::truncate() {
+    if (!open()) {
+        return false;
+    }
+    
+    BufferPool::getInstance().discardFile(*this);
+    unmap();
+    if (::ftruncate(fd_, 0) != 0) {
+        std::cerr << "清空页文件失败: " << path_ << std::endl;
+        return false;
+    }
+    pageCount_ = 0;
+    fileSize_ = 0;
+    return true;
+}
+
+void PageFile::ensurePageCount(uint32_t count) {
+    if (count > pageCount_) {
+        pageCount_ = count;
+    }
+}
+
+bool PageFile::readPage(uint32_t pageId, char* buffer) const {
+    size_t done = 0;
+    off_t offset = static_cast<off_t>(pageId) * kPageSize;
+    while (done < kPageSize) {
+        ssize_t n = ::pread(fd_, buffer + done, kPageSize - done, offset + done);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            std::cerr << "读取页失败: " << path_ << " 页 " << pageId << std::endl;
+            return false;
+        }
+        if (n == 0) {
+            // 超出文件末尾的部分补0
+            std::memset(buffer + done, 0, kPageSize - done);
+            break;
+        }
+        done += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+bool PageFile::writePage(uint32_t pageId, const char* buffer) {
+    // 先写日志后写数据：数据页落盘前，修改它的日志必须已经落盘
+    if (wal_ && !wal_->sync()) {
+        return false;
+    }
+    
+    size_t done = 0;
+    off_t offset = static_cast<off_t>(pageId) * kPageSize;
+    while (done < kPageSize) {
+        ssize_t n = ::pwrite(fd_, buffer + done, kPageSize - done, offset + done);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            std::cerr << "写入页失败: " << path_ << " 页 " << pageId << std::endl;
+            return false;
+        }
+        done += static_cast<size_t>(n);
+    }
+    
+    if (offset + kPageSize > fileSize_) {
+        fileSize_ = offset + kPageSize;
+    }
+    return true;
+}
+
+const char* PageFile::mappedPage(uint32_t pageId) {
+    if (fd_ < 0 || !BufferPool::getInstance().isMmapReads()) {
+        return nullptr;
+    }
+    
+    // 文件在映射之后变长时重新映射
+    size_t end = (static_cast<size_t>(pageId) + 1) * kPageSize;
+    if (end > mapSize_ && (end > fileSize_ || !remap())) {
+        return nullptr;
+    }
+    return map_ + static_cast<size_t>(pageId) * kPageSize;
+}
+
+bool PageFile::remap() {
+    unmap();
+    
+    // 不映射不完整的最后一页，访问超出文件末尾的映射区会触发SIGBUS
+    size_t size = fileSize_ / kPageSize * kPageSize;
+    if (size == 0) {
+        return false;
+    }
+    
+    void* addr = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd_, 0);
+    if (addr == MAP_FAILED) {
+        std::cerr << "映射页文件失败: " << path_ << std::endl;
+        return false;
+    }
+    
+    // 扫描按页顺序进行，提示内核预读
+    ::madvise(addr, size, MADV_SEQUENTIAL);
+    map_ = static_cast<const char*>(addr);
+    mapSize_ = size;
+    return true;
+}
+
+void PageFile::unmap() {
+    if (map_) {
+        ::munmap(const_cast<char*>(map_), mapSize_);
+        map_ = nullptr;
+        mapSize_ = 0;
+    }
+}
+
+bool PageFile::sync() {
+    if (fd_ < 0) {
+        return false;
+    }
+    return ::fdatasync(fd_) == 0;
+}
+
+PageGuard& PageGuard::operator=(PageGuard&& other) noexcept {
+    if (this != &other) {
+        release();
+        frame_ = other.frame_;
+        other.frame_ = nullptr;
+    }
+    return *this;
+}
+
+void PageGuard::release() {
+    if (frame_) {
+        --frame_->pinCount;
+        frame_ = nullptr;
+    }
+}
+
+BufferPool::BufferPool() : capacity_(kDefaultPoolPages) {
+}
+
+BufferPool::~BufferPool() {
+    // 程序退出时写回剩余的脏页
+    for (auto& frame : frames_) {
+        if (frame->file && frame->dirty) {
+            frame->file->writePage(frame->pageId, frame->data.get());
+        }
+    }
+}
+
+BufferPool& BufferPool::getInstance() {
+    static BufferPool instance;
+    return instance;
+}
+
+PageGuard BufferPool::fetchPage(PageFile& file, uint32_t pageId) {
+    // 命中缓存
+    auto it = pageTable_.find({&file, pageId});
+    if (it != pageTable_.end()) {
+        Frame* frame = frames_[it->second].get();
+        ++frame->pinCount;
+        frame->referenced = true;
+        return PageGuard(frame);
+    }
+    
+    // 未命中：找一个页帧并从文件读入
+    auto frameIndex = acquireFrame();
+    if (!frameIndex.has_value()) {
+        return PageGuard();
+    }
+    
+    Frame* frame = frames_[frameIndex.value()].get();
+    if (!file.readPage(pageId, frame->data.get())) {
+        freeFrames_.push_back(frameIndex.value());
+        return PageGuard();
+    }
+    
+    frame->file = &file;
+    frame->pageId = pageId;
+    frame->pinCount = 1;
+    frame->dirty = false;
+    frame->referenced = true;
+    pageTable_[{&file, pageId}] = frameIndex.value();
+    
+    return PageGuard(frame);
+}
+
+const char* BufferPool::readPage(PageFile& file, uint32_t pageId, PageGuard& guard) {
+    // 缓冲池中的页可能比文件中的新，优先使用
+    auto it = pageTable_.find({&file, pageId});
+    if (it != pageTable_.end()) {
+        Frame* frame = frames_[it->second].get();
+        ++frame->pinCount;
+        frame->referenced = true;
+        guard = PageGuard(frame);
+        return guard.data();
+    }
+    
+    // 不在缓冲池中的页以文件内容为准，直接从映射区读取
+    if (const char* data = file.mappedPage(pageId)) {
+        return data;
+    }
+    
+    // 未启用映射或页超出文件末尾时读入缓冲池
+    guard = fetchPage(file, pageId);
+    return guard ? guard.data() : nullptr;
+}
+
+std::optional<size_t> BufferPool::acquireFrame() {
+    // 优先使用空闲页帧
+    if (!freeFrames_.empty()) {
+        size_t index = freeFrames_.back();
+        freeFrames_.pop_back();
+        return index;
+    }
+    
+    // 未达到容量时分配新页帧
+    if (frames_.size() < capacity_) {
+        auto frame = std::make_unique<Frame>();
+        frame->data = std::make_unique<char[]>(kPageSize);
+        frames_.push_back(std::move(frame));
+        return frames_.size() - 1;
+    }
+    
+    // CLOCK：最近访问过的页给一次机会，跳过被固定的页
+    for (size_t step = 0; step < frames_.size() * 2; ++step) {
+        size_t index = clockHand_;
+        clockHand_ = (clockHand_ + 1) % frames_.size();
+        
+        Frame* frame = frames_[index].get();
+        if (frame->pinCount > 0) {
+            continue;
+        }
+        if (frame->referenced) {
+            frame->referenced = false;
+            continue;
+        }
+        if (evict(index)) {
+            return index;
+        }
+    }
+    
+    // 所有页都被固定时临时超出容量
+    auto frame = std::make_unique<Frame>();
+    frame->data = std::make_unique<char[]>(kPageSize);
+    frames_.push_back(std::move(frame));
+    return frames_.size() - 1;
+}
+
+bool BufferPool::evict(size_t frameIndex) {
+    Frame* frame = frames_[frameIndex].get();
+    if (frame->file) {
+        if (frame->dirty && !frame->file->writePage(frame->pageId, frame->data.get())) {
+            return false;
+        }
+        pageTable_.erase({frame->file, frame->pageId});
+    }
+    frame->file = nullptr;
+    frame->dirty = false;
+    frame->referenced = false;
+    return true;
+}
+
+bool BufferPool::flushFile(PageFile& file) {
+    bool ok = true;
+    for (auto& frame : frames_) {
+        if (frame->file == &file && frame->dirty) {
+            if (file.writePage(frame->pageId, frame->data.get())) {
+                frame->dirty = false;
+            } else {
+                ok = false;
+            }
+        }
+    }
+    return ok;
+}
+
+void BufferPool::discardFile(PageFile& file) {
+    for (size_t i = 0; i < frames_.size(); ++i) {
+        Frame* frame = frames_[i].get();
+        if (frame->file == &file) {
+            pageTable_.erase({frame->file, frame->pageId});
+            frame->file = nullptr;
+            frame->dirty = false;
+            frame->referenced = false;
+            frame->pinCount = 0;
+            freeFrames_.push_back(i);
+        }
+    }
+}
+
+void BufferPool::setCapacity(size_t pages) {
+    capacity_ = std::max(pages, kMinPoolPages);
+    if (frames_.size() <= capacity_) {
+        return;
+    }
+    
+    // 缩小容量：写回并释放所有未固定的页帧，然后重建页表
+    std::vector<std::unique_ptr<Frame>> kept;
+    for (size_t i = 0; i < frames_.size(); ++i) {
+        if (frames_[i]->pinCount > 0) {
+            kept.push_back(std::move(frames_[i]));
+        } else {
+            evict(i);
+        }
+    }
+    
+    frames_ = std::move(kept);
+    freeFrames_.clear();
+    pageTable_.clear();
+    for (size_t i = 0; i < frames_.size(); ++i) {
+        pageTable_[{frames_[i]->file, frames_[i]->pageId}] = i;
+    }
+    clockHand_ = 0;
+}
+
+} // namespace minidb
\ No newline at end of file
@@ -1,4 +1,5 @@
 #include "../include/DBManager.h"
+#include "../include/BufferPool.h"
 #include <iostream>
 #include <fstream>
 #include <stdexcept>
@@ -6,6 +7,9 @@
 namespace minidb {
 
 DBManager::DBManager() : dataPath_("./data") {
+    // 先构造缓冲池和工作线程池，保证它们在所有数据库析构之后才析构：退出时的检查点会读写页并在线程池上重建索引
+    BufferPool::getInstance();
+    WorkerPool::getInstance();
 }
 
 DBManager::~DBManager() {
@@ -40,6 +44,7 @@ bool DBManager::loadDatabases() {
             if (entry.is_directory()) {
                 std::string dbName = entry.path().filename().string();
                 databases_[dbName] = std::make_shared<Database>(dbName);
+                databases_[dbName]->setSyncMode(walSyncMode_);
                 databases_[dbName]->loadTables();
             }
         }
@@ -70,6 +75,7 @@ bool DBManager::createDatabase(const std::string& dbName) {
         
         // 创建数据库对象
         databases_[dbName] = std::make_shared<Database>(dbName);
+        databases_[dbName]->setSyncMode(walSyncMode_);
         return true;
     } catch (const std::exception& e) {
         std::cerr << "创建数据库失败: " << e.what() << std::endl;
@@ -126,4 +132,11 @@ std::string DBManager::getCurrentDatabaseName() const {
     return currentDbName_;
 }
 
+void DBManager::setWalSyncMode(WALSyncMode mode) {
+    walSyncMode_ = mode;
+    for (auto& [name, db] : databases_) {
+        db->setSyncMode(mode);
+    }
+}
+
 } // namespace minidb 
\ No newline at end of file
@@ -2,15 +2,24 @@
 #include <iostream>
 #include <fstream>
 #include <stdexcept>
+#include <unordered_set>
 
 namespace minidb {
 
+// 日志超过该大小时自动写出检查点
+constexpr size_t kCheckpointThreshold = 8 * 1024 * 1024;
+
+// 每个数据库最多同时打开的表数，超过时关闭最久未使用的表
+constexpr size_t kMaxOpenTables = 64;
+
 Database::Database(const std::string& name) 
-    : name_(name), dbPath_("./data/" + name) {
+    : name_(name), dbPath_("./data/" + name), 
+      wal_(std::make_shared<WAL>(dbPath_ / "wal.log")) {
 }
 
 Database::~Database() {
-    // 保存数据库元数据
+    // 写出检查点并保存数据库元数据
+    checkpoint();
     saveMetadata();
 }
 
@@ -21,8 +30,11 @@ bool Database::createTable(const std::string& tableName, const std::vector<Colum
             return false;
         }
         
+        // 先重放日志，保证新表之后写入的日志LSN是连续的
+        recover();
+        
         // 检查表是否已存在
-        if (tables_.find(tableName) != tables_.end()) {
+        if (catalog_.find(tableName) != catalog_.end()) {
             return false;
         }
         
@@ -33,13 +45,24 @@ bool Database::createTable(const std::string& tableName, const std::vector<Colum
         
         // 创建表对象
         auto table = std::make_shared<Table>(tableName, name_, columns);
+        table->setWAL(wal_);
         tables_[tableName] = table;
         
         // 创建索引（如果有主键）
         table->createIndex();
         
-        // 保存表元数据
-        return table->saveData();
+        // 保存表元数据，日志中已有的同名表记录不会重放到新表上
+        if (!table->checkpoint(wal_->getLastLsn())) {
+            tables_.erase(tableName);
+            return false;
+        }
+        
+        // 加入数据库目录
+        catalog_.insert(tableName);
+        lastUsed_[tableName] = ++useClock_;
+        saveMetadata();
+        releaseColdTables();
+        return true;
     } catch (const std::exception& e) {
         std::cerr << "创建表失败: " << e.what() << std::endl;
         return false;
@@ -48,29 +71,40 @@ bool Database::createTable(const std::string& tableName, const std::vector<Colum
 
 bool Database::dropTable(const std::string& tableName) {
     try {
+        recover();
+        
         // 检查表是否存在
-        auto it = tables_.find(tableName);
-        if (it == tables_.end()) {
+        if (catalog_.find(tableName) == catalog_.end()) {
             return false;
         }
         
+        // 先从数据库中移除表，关闭表文件并丢弃缓冲池中的页
+        tables_.erase(tableName);
+        lastUsed_.erase(tableName);
+        catalog_.erase(tableName);
+        saveMetadata();
+        
         // 获取表路径
         std::filesystem::path tablePath = dbPath_ / (tableName + ".dat");
-        std::filesystem::path indexPath = dbPath_ / (tableName + ".idx");
         
         // 删除表文件
         if (std::filesystem::exists(tablePath)) {
             std::filesystem::remove(tablePath);
         }
         
-        // 删除索引文件
-        if (std::filesystem::exists(indexPath)) {
+        // 删除主键索引文件<表名>.idx、二级索引文件<表名>.<索引名>.idx和区域映射文件<表名>.zmap
+        std::vector<std::filesystem::path> indexPaths;
+        for (const auto& entry : std::filesystem::directory_iterator(dbPath_)) {
+            std::string fileName = entry.path().filename().string();
+            std::filesystem::path extension = entry.path().extension();
+            if ((extension == ".idx" || extension == ".zmap") && fileName.rfind(tableName + ".", 0) == 0) {
+                indexPaths.push_back(entry.path());
+            }
+        }
+        for (const auto& indexPath : indexPaths) {
             std::filesystem::remove(indexPath);
         }
         
-        // 从数据库中移除表
-        tables_.erase(it);
-        
         return true;
     } catch (const std::exception& e) {
         std::cerr << "删除表失败: " << e.what() << std::endl;
@@ -78,12 +112,55 @@ bool Database::dropTable(const std::string& tableName) {
     }
 }
 
+bool Database::createIndex(const std::string& tableName, const std::string& indexName,
+                           const std::vector<std::string>& colNames, IndexType type,
+                           const std::vector<std::string>& includeNames) {
+    try {
+        auto table = getTable(tableName);
+        if (!table || !table->createIndex(indexName, colNames, type, includeNames)) {
+            return false;
+        }
+        
+        // 索引的建立不写日志，立即写出检查点使索引定义和索引文件落盘
+        return checkpoint();
+    } catch (const std::exception& e) {
+        std::cerr << "创建索引失败: " << e.what() << std::endl;
+        return false;
+    }
+}
+
+bool Database::dropIndex(const std::string& tableName, const std::string& indexName) {
+    try {
+        auto table = getTable(tableName);
+        if (!table || !table->dropIndex(indexName)) {
+            return false;
+        }
+        
+        // 立即写出检查点，使元数据页中不再有该索引
+        return checkpoint();
+    } catch (const std::exception& e) {
+        std::cerr << "删除索引失败: " << e.what() << std::endl;
+        return false;
+    }
+}
+
 std::shared_ptr<Table> Database::getTable(const std::string& tableName) {
+    recover();
+    
+    // 已打开的表直接返回，否则按目录打开表文件
+    std::shared_ptr<Table> table;
     auto it = tables_.find(tableName);
-    if (it == tables_.end()) {
-        return nullptr;
+    if (it != tables_.end()) {
+        table = it->second;
+    } else {
+        table = openTable(tableName);
+    }
+    
+    if (table) {
+        lastUsed_[tableName] = ++useClock_;
+        releaseColdTables();
     }
-    return it->second;
+    return table;
 }
 
 bool Database::loadTables() {
@@ -93,17 +170,36 @@ bool Database::loadTables() {
             return false;
         }
         
-        // 遍历数据库目录下的所有.dat文件
-        for (const auto& entry : std::filesystem::directory_iterator(dbPath_)) {
-            if (entry.is_regular_file() && entry.path().extension() == ".dat") {
-                std::string tableName = entry.path().stem().string();
-                
-                // 创建表对象并加载数据
-                auto table = std::make_shared<Table>(tableName, name_, std::vector<ColumnDef>());
-                if (table->loadData()) {
-                    tables_[tableName] = table;
+        // 从目录文件读取表名，表文件在首次访问时才打开
+        catalog_.clear();
+        std::ifstream metadataFile(dbPath_ / "metadata.json");
+        std::string content;
+        if (metadataFile.is_open()) {
+            content.assign(std::istreambuf_iterator<char>(metadataFile), std::istreambuf_iterator<char>());
+        }
+        
+        size_t tablesPos = content.find("\"tables\"");
+        size_t listBegin = content.find('[', tablesPos);
+        size_t listEnd = content.find(']', listBegin);
+        if (tablesPos != std::string::npos && listBegin != std::string::npos && listEnd != std::string::npos) {
+            // 表名都是合法标识符，不需要处理转义
+            size_t pos = listBegin;
+            while ((pos = content.find('"', pos + 1)) < listEnd) {
+                size_t end = content.find('"', pos + 1);
+                if (end >= listEnd) {
+                    break;
+                }
+                catalog_.insert(content.substr(pos + 1, end - pos - 1));
+                pos = end;
+            }
+        } else {
+            // 没有目录文件的旧数据库：按表文件重建目录
+            for (const auto& entry : std::filesystem::directory_iterator(dbPath_)) {
+                if (entry.is_regular_file() && entry.path().extension() == ".dat") {
+                    catalog_.insert(entry.path().stem().string());
                 }
             }
+            saveMetadata();
         }
         
         return true;
@@ -113,11 +209,140 @@ bool Database::loadTables() {
     }
 }
 
+std::shared_ptr<Table> Database::openTable(const std::string& tableName) {
+    if (catalog_.find(tableName) == catalog_.end()) {
+        return nullptr;
+    }
+    
+    // 创建表对象，只读取元数据页和索引
+    auto table = std::make_shared<Table>(tableName, name_, std::vector<ColumnDef>());
+    if (!table->loadData()) {
+        return nullptr;
+    }
+    table->setWAL(wal_);
+    tables_[tableName] = table;
+    lastUsed_[tableName] = ++useClock_;
+    wal_->advanceLsn(table->getCheckpointLsn() + 1);
+    return table;
+}
+
+bool Database::recover() {
+    if (recovered_) {
+        return true;
+    }
+    recovered_ = true;
+    
+    try {
+        // 重放检查点之后的日志，只打开日志中涉及的表
+        std::unordered_set<std::string> recovered;
+        bool ok = wal_->replay([&](const WALRecord& record) {
+            auto it = tables_.find(record.tableName);
+            auto table = it != tables_.end() ? it->second : openTable(record.tableName);
+            if (table && table->applyLogRecord(record)) {
+                recovered.insert(record.tableName);
+            }
+        });
+        
+        // 重放过的表需要重建索引和行数统计
+        for (const auto& tableName : recovered) {
+            tables_[tableName]->finishRecovery();
+        }
+        
+        // 重放后立即写出检查点，避免日志在多次启动之间持续增长
+        if (ok && !recovered.empty()) {
+            checkpoint();
+        }
+        
+        releaseColdTables();
+        return ok;
+    } catch (const std::exception& e) {
+        std::cerr << "重放日志失败: " << e.what() << std::endl;
+        return false;
+    }
+}
+
+void Database::releaseColdTables() {
+    while (tables_.size() > kMaxOpenTables) {
+        // 找出最久未使用且没有被其他地方持有的表
+        auto coldest = tables_.end();
+        for (auto it = tables_.begin(); it != tables_.end(); ++it) {
+            if (it->second.use_count() == 1 &&
+                (coldest == tables_.end() || lastUsed_[it->first] < lastUsed_[coldest->first])) {
+                coldest = it;
+            }
+        }
+        if (coldest == tables_.end()) {
+            return;
+        }
+        
+        // 有修改的表先单独写出，日志中更早的记录重新打开时会被跳过
+        if (coldest->second->isDirty() &&
+            (!wal_->sync() || !coldest->second->checkpoint(wal_->getLastLsn()))) {
+            std::cerr << "关闭表 " << coldest->first << " 失败" << std::endl;
+            return;
+        }
+        
+        lastUsed_.erase(coldest->first);
+        tables_.erase(coldest);
+    }
+}
+
+bool Database::checkpoint() {
+    try {
+        // 数据库目录已被删除时无需写出
+        if (!std::filesystem::exists(dbPath_)) {
+            return false;
+        }
+        
+        // 尚未使用的数据库没有修改，日志留到下次使用时重放
+        if (!recovered_) {
+            return true;
+        }
+        
+        // 日志先落盘，再写表文件
+        if (!wal_->sync()) {
+            return false;
+        }
+        
+        uint64_t lsn = wal_->getLastLsn();
+        bool ok = true;
+        for (const auto& [tableName, table] : tables_) {
+            if (table->isDirty() && !table->checkpoint(lsn)) {
+                std::cerr << "写出表 " << tableName << " 失败" << std::endl;
+                ok = false;
+            }
+        }
+        
+        // 所有表都写出成功后才能清空日志
+        if (ok && wal_->size() > 0) {
+            ok = wal_->truncate();
+        }
+        
+        return ok;
+    } catch (const std::exception& e) {
+        std::cerr << "写出检查点失败: " << e.what() << std::endl;
+        return false;
+    }
+}
+
+bool Database::maybeCheckpoint() {
+    if (wal_->size() < kCheckpointThreshold) {
+        return true;
+    }
+    return checkpoint();
+}
+
 bool Database::saveMetadata() const {
     try {
-        // 保存数据库元数据（可以扩展添加更多元数据）
+        // 数据库目录已被删除时无需保存
+        if (!std::filesystem::exists(dbPath_)) {
+            return false;
+        }
+        
+        // 保存数据库目录：先写临时文件再替换，避免崩溃时留下不完整的目录
         std::filesystem::path metadataPath = dbPath_ / "metadata.json";
-        std::ofstream metadataFile(metadataPath);
+        std::filesystem::path tmpPath = dbPath_ / "metadata.json.tmp";
+        std::ofstream metadataFile(tmpPath);
         if (!metadataFile.is_open()) {
             return false;
         }
@@ -125,7 +350,7 @@ bool Database::saveMetadata() const {
         metadataFile << "{\"name\":\"" << name_ << "\",\"tables\":[";
         
         bool first = true;
-        for (const auto& [tableName, _] : tables_) {
+        for (const auto& tableName : catalog_) {
             if (!first) {
                 metadataFile << ",";
             }
@@ -135,7 +360,12 @@ bool Database::saveMetadata() const {
         
         metadataFile << "]}";
         metadataFile.close();
+        if (!metadataFile) {
+            return false;
+        }
         
+        syncFile(tmpPath);
+        std::filesystem::rename(tmpPath, metadataPath);
         return true;
     } catch (const std::exception& e) {
         std::cerr << "保存数据库元数据失败: " << e.what() << std::endl;
@@ -0,0 +1,602 @@
+#include "../include/Executor.h"
+#include "../include/FilterKernels.h"
+#include "../include/Parallel.h"
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <iterator>
+#include <mutex>
+#include <numeric>
+#include <thread>
+
+namespace minidb {
+
+namespace {
+
+// 保留选择向量中满足 values[i] compare constant 的行。不用分支：每行都写入当前位置，
+// 只有满足条件时位置才前进。dense表示选择向量就是批中的所有行，此时不必经过选择向量取值
+template <typename T, typename Compare>
+size_t selectMatching(const T* values, const T& constant, Compare compare,
+                      uint16_t* selection, size_t count, bool dense) {
+    size_t kept = 0;
+    if (dense) {
+        for (size_t i = 0; i < count; ++i) {
+            selection[kept] = static_cast<uint16_t>(i);
+            kept += compare(values[i], constant) ? 1 : 0;
+        }
+    } else {
+        for (size_t k = 0; k < count; ++k) {
+            uint16_t i = selection[k];
+            selection[kept] = i;
+            kept += compare(values[i], constant) ? 1 : 0;
+        }
+    }
+    return kept;
+}
+
+// 按操作符选出比较函数，每批只分派一次
+template <typename T>
+size_t selectByOperator(const T* values, const T& constant, Operator op,
+                        uint16_t* selection, size_t count, bool dense) {
+    switch (op) {
+        case Operator::EQUAL:
+            return selectMatching(values, constant, std::equal_to<T>(), selection, count, dense);
+        case Operator::NOT_EQUAL:
+            return selectMatching(values, constant, std::not_equal_to<T>(), selection, count, dense);
+        case Operator::LESS_THAN:
+            return selectMatching(values, constant, std::less<T>(), selection, count, dense);
+        case Operator::LESS_EQUAL:
+            return selectMatching(values, constant, std::less_equal<T>(), selection, count, dense);
+        case Operator::GREATER_THAN:
+            return selectMatching(values, constant, std::greater<T>(), selection, count, dense);
+        case Operator::GREATER_EQUAL:
+            return selectMatching(values, constant, std::greater_equal<T>(), selection, count, dense);
+    }
+    return 0;
+}
+
+// 在INT列上按区间条件缩小选择向量：选择向量是整批时使用SIMD过滤核，否则逐个判断选中的行
+void filterIntRange(const ColumnVector& column, const IntRange& range, size_t batchSize,
+                    std::vector<uint16_t>& selection) {
+    if (selection.size() == batchSize) {
+        selection.resize(batchSize + kSelectionPadding);
+        selection.resize(selectIntRange(column.ints.data(), batchSize, range, selection.data()));
+        return;
+    }
+    if (range.lower > range.upper) {
+        if (range.inside) {
+            selection.clear();
+        }
+        return;
+    }
+    
+    // (v - lower) 按无符号数不大于 (upper - lower) 时v在区间内
+    uint32_t lower = static_cast<uint32_t>(range.lower);
+    uint32_t width = static_cast<uint32_t>(range.upper) - lower;
+    const int32_t* values = column.ints.data();
+    size_t kept = 0;
+    for (uint16_t i : selection) {
+        selection[kept] = i;
+        bool inside = static_cast<uint32_t>(values[i]) - lower <= width;
+        kept += inside == range.inside ? 1 : 0;
+    }
+    selection.resize(kept);
+}
+
+// 比较的列已读入批中，并且值的类型与列类型相同
+bool comparesLoadedColumn(const Predicate& where, const RowBatch& batch) {
+    if (where.getKind() != Predicate::Kind::COMPARE || where.getColumn() >= batch.columns.size()) {
+        return false;
+    }
+    const ColumnVector& column = batch.columns[where.getColumn()];
+    bool isInt = std::holds_alternative<int>(where.getValue());
+    return column.loaded && isInt == (column.type == DataType::INT);
+}
+
+// 可以与同列上的其他比较合并为一个区间的INT比较（!=不是区间）
+bool isIntBound(const Predicate& where, const RowBatch& batch) {
+    return comparesLoadedColumn(where, batch) && batch.columns[where.getColumn()].type == DataType::INT &&
+           where.getOp() != Operator::NOT_EQUAL;
+}
+
+// 判断一个比较：与compareValues语义一致，值的类型与列类型不同时任何行都不满足
+void filterCompare(const Predicate& where, const RowBatch& batch, std::vector<uint16_t>& selection) {
+    if (!comparesLoadedColumn(where, batch)) {
+        selection.clear();
+        return;
+    }
+    const ColumnVector& column = batch.columns[where.getColumn()];
+    if (column.type == DataType::INT) {
+        IntRange range = IntRange::fromCompare(where.getOp(), std::get<int>(where.getValue()));
+        filterIntRange(column, range, batch.size, selection);
+        return;
+    }
+    std::string_view constant = std::get<std::string>(where.getValue());
+    bool dense = selection.size() == batch.size;
+    selection.resize(selectByOperator(column.strings.data(), constant, where.getOp(),
+                                      selection.data(), selection.size(), dense));
+}
+
+} // namespace
+
+void RowBatch::clear() {
+    size = 0;
+    for (auto& column : columns) {
+        column.loaded = false;
+    }
+    selection.clear();
+    arenaUsed = 0;
+}
+
+void RowBatch::appendRecords(std::vector<Record>& result) const {
+    result.reserve(result.size() + selection.size());
+    for (uint16_t i : selection) {
+        Record row;
+        row.reserve(columns.size());
+        for (const auto& column : columns) {
+            if (!column.loaded) {
+                continue;
+            }
+            if (column.type == DataType::INT) {
+                row.emplace_back(static_cast<int>(column.ints[i]));
+            } else {
+                row.emplace_back(std::string(column.strings[i]));
+            }
+        }
+        result.push_back(std::move(row));
+    }
+}
+
+TupleDecoder::TupleDecoder(const std::vector<ColumnDef>& columns, const std::vector<size_t>& needed)
+    : columns_(columns), needed_(columns.size(), 0) {
+    // 只需要解码到最后一个用到的列
+    for (size_t column : needed) {
+        if (column < columns_.size()) {
+            needed_[column] = 1;
+            columnCount_ = std::max(columnCount_, column + 1);
+        }
+    }
+}
+
+void TupleDecoder::reset(RowBatch& batch) const {
+    batch.clear();
+    batch.columns.resize(columns_.size());
+    for (size_t i = 0; i < columns_.size(); ++i) {
+        ColumnVector& column = batch.columns[i];
+        column.type = columns_[i].type;
+        column.loaded = needed_[i] != 0;
+        if (column.loaded && column.type == DataType::INT) {
+            column.ints.resize(kMaxBatchRows);
+        } else if (column.loaded) {
+            column.strings.resize(kMaxBatchRows);
+        }
+    }
+    batch.rowIds.resize(kMaxBatchRows);
+    if (!batch.arena) {
+        batch.arena = std::make_unique<char[]>(kBatchArenaSize);
+    }
+}
+
+bool TupleDecoder::hasRoom(const RowBatch& batch) const {
+    return batch.size < kBatchSize && batch.arenaUsed + kPageSize <= kBatchArenaSize;
+}
+
+void TupleDecoder::append(std::string_view tuple, RowId rowId, RowBatch& batch) const {
+    // 按列顺序依次解码，没有用到的列只跳过
+    const char* data = tuple.data();
+    size_t row = batch.size;
+    size_t offset = 0;
+    for (size_t i = 0; i < columnCount_; ++i) {
+        ColumnVector& column = batch.columns[i];
+        if (column.type == DataType::INT) {
+            if (needed_[i]) {
+                std::memcpy(&column.ints[row], data + offset, sizeof(int32_t));
+            }
+            offset += sizeof(int32_t);
+        } else {
+            uint16_t length;
+            std::memcpy(&length, data + offset, sizeof(length));
+            offset += sizeof(length);
+            if (needed_[i]) {
+                char* target = batch.arena.get() + batch.arenaUsed;
+                std::memcpy(target, data + offset, length);
+                batch.arenaUsed += length;
+                column.strings[row] = std::string_view(target, length);
+            }
+            offset += length;
+        }
+    }
+    batch.rowIds[row] = rowId;
+    batch.size = row + 1;
+}
+
+ScanOperator::ScanOperator(HeapFile& heap, const std::vector<ColumnDef>& columns,
+                           const std::vector<size_t>& needed, std::function<bool(uint32_t)> skipPage)
+    : heap_(heap), decoder_(columns, needed), skipPage_(std::move(skipPage)) {}
+
+bool ScanOperator::next(RowBatch& batch) {
+    decoder_.reset(batch);
+    
+    // 读满一批，或缓冲区剩余的空间可能放不下下一页中的字符串为止
+    uint32_t pageCount = heap_.getDataPageCount() + 1;
+    while (nextPage_ < pageCount && decoder_.hasRoom(batch)) {
+        uint32_t pageId = nextPage_++;
+        if (skipPage_ && skipPage_(pageId)) {
+            continue;
+        }
+        PageGuard guard;
+        if (auto page = heap_.readDataPage(pageId, guard)) {
+            readPage(*page, pageId, batch);
+        }
+    }
+    
+    batch.selection.resize(batch.size);
+    std::iota(batch.selection.begin(), batch.selection.end(), static_cast<uint16_t>(0));
+    return batch.size > 0;
+}
+
+void ScanOperator::readPage(const SlottedPage& page, uint32_t pageId, RowBatch& batch) {
+    uint16_t slotCount = page.getSlotCount();
+    for (uint16_t slot = 0; slot < slotCount; ++slot) {
+        if (auto tuple = page.get(slot)) {
+            decoder_.append(*tuple, makeRowId(pageId, slot), batch);
+        }
+    }
+}
+
+FetchOperator::FetchOperator(HeapFile& heap, const std::vector<ColumnDef>& columns,
+                             const std::vector<size_t>& needed, std::vector<RowId> rowIds)
+    : heap_(heap), decoder_(columns, needed), rowIds_(std::move(rowIds)) {}
+
+bool FetchOperator::next(RowBatch& batch) {
+    decoder_.reset(batch);
+    while (position_ < rowIds_.size() && decoder_.hasRoom(batch)) {
+        RowId rowId = rowIds_[position_++];
+        heap_.read(rowId, [&](std::string_view tuple) {
+            decoder_.append(tuple, rowId, batch);
+        });
+    }
+    
+    batch.selection.resize(batch.size);
+    std::iota(batch.selection.begin(), batch.selection.end(), static_cast<uint16_t>(0));
+    return batch.size > 0;
+}
+
+FilterOperator::FilterOperator(std::unique_ptr<BatchOperator> child, const Predicate& where)
+    : child_(std::move(child)), where_(where) {}
+
+bool FilterOperator::next(RowBatch& batch) {
+    while (child_->next(batch)) {
+        filterBatch(where_, batch, batch.selection);
+        if (!batch.selection.empty()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+ProjectOperator::ProjectOperator(std::unique_ptr<BatchOperator> child, std::vector<size_t> columns)
+    : child_(std::move(child)), columns_(std::move(columns)) {}
+
+bool ProjectOperator::next(RowBatch& batch) {
+    if (!child_->next(input_)) {
+        return false;
+    }
+    
+    // 交换而不是复制：列向量和缓冲区在两个批之间轮流使用，不重新分配
+    batch.size = input_.size;
+    batch.rowIds.swap(input_.rowIds);
+    batch.selection.swap(input_.selection);
+    batch.columns.resize(columns_.size());
+    for (size_t i = 0; i < columns_.size(); ++i) {
+        std::swap(batch.columns[i], input_.columns[columns_[i]]);
+    }
+    batch.arena.swap(input_.arena);
+    std::swap(batch.arenaUsed, input_.arenaUsed);
+    return true;
+}
+
+LimitOperator::LimitOperator(std::unique_ptr<BatchOperator> child, size_t limit)
+    : child_(std::move(child)), remaining_(limit) {}
+
+bool LimitOperator::next(RowBatch& batch) {
+    if (remaining_ == 0 || !child_->next(batch)) {
+        return false;
+    }
+    if (batch.selection.size() > remaining_) {
+        batch.selection.resize(remaining_);
+    }
+    remaining_ -= batch.selection.size();
+    return true;
+}
+
+// 页块扫描：MorselScan的每个工作线程一个，只读取当前页块中的页，读完后返回false，再由start开始下一个页块
+class MorselOperator : public BatchOperator {
+public:
+    explicit MorselOperator(MorselScan& scan)
+        : scan_(scan), decoder_(scan.columns_, scan.needed_),
+          buffer_(std::make_unique<char[]>(static_cast<size_t>(kMorselPages) * kPageSize)) {
+        pages_.reserve(kMorselPages);
+    }
+    
+    // 开始扫描第morsel个页块：块中要读的页一次复制到缓冲区
+    void start(size_t morsel) {
+        uint32_t first = static_cast<uint32_t>(1 + morsel * kMorselPages);
+        uint32_t end = std::min(first + kMorselPages, scan_.pageCount_);
+        scan_.copyPages(first, end, buffer_.get(), pages_);
+        nextPage_ = 0;
+    }
+    
+    bool next(RowBatch& batch) override {
+        decoder_.reset(batch);
+        while (nextPage_ < pages_.size() && decoder_.hasRoom(batch)) {
+            uint32_t pageId = pages_[nextPage_];
+            SlottedPage page(buffer_.get() + nextPage_ * kPageSize);
+            ++nextPage_;
+            uint16_t slotCount = page.getSlotCount();
+            for (uint16_t slot = 0; slot < slotCount; ++slot) {
+                if (auto tuple = page.get(slot)) {
+                    decoder_.append(*tuple, makeRowId(pageId, slot), batch);
+                }
+            }
+        }
+        
+        batch.selection.resize(batch.size);
+        std::iota(batch.selection.begin(), batch.selection.end(), static_cast<uint16_t>(0));
+        return batch.size > 0;
+    }
+
+private:
+    MorselScan& scan_;
+    TupleDecoder decoder_;
+    std::unique_ptr<char[]> buffer_;
+    std::vector<uint32_t> pages_;
+    size_t nextPage_ = 0;
+};
+
+MorselScan::MorselScan(HeapFile& heap, const std::vector<ColumnDef>& columns, const std::vector<size_t>& needed,
+                       std::function<bool(uint32_t)> skipPage)
+    : heap_(heap), columns_(columns), needed_(needed), skipPage_(std::move(skipPage)),
+      pageCount_(heap.getDataPageCount() + 1),
+      morselCount_((heap.getDataPageCount() + kMorselPages - 1) / kMorselPages) {}
+
+void MorselScan::run(size_t threads,
+                     const std::function<std::unique_ptr<BatchOperator>(std::unique_ptr<BatchOperator>)>& makePlan,
+                     const std::function<void(size_t worker, size_t morsel, const RowBatch& batch)>& consume) {
+    nextMorsel_ = 0;
+    threads = std::max<size_t>(1, std::min(threads, morselCount_));
+    WorkerPool::getInstance().run(threads, [&](size_t worker) {
+        auto scan = std::make_unique<MorselOperator>(*this);
+        MorselOperator& morsels = *scan;
+        std::unique_ptr<BatchOperator> plan = makePlan(std::move(scan));
+        RowBatch batch;
+        try {
+            for (size_t morsel = nextMorsel_++; morsel < morselCount_; morsel = nextMorsel_++) {
+                morsels.start(morsel);
+                while (plan->next(batch)) {
+                    consume(worker, morsel, batch);
+                }
+            }
+        } catch (...) {
+            // 其他线程不再领取新的页块
+            nextMorsel_ = morselCount_;
+            throw;
+        }
+    });
+}
+
+void MorselScan::copyPages(uint32_t first, uint32_t end, char* buffer, std::vector<uint32_t>& pages) {
+    // 区域映射的判断不访问缓冲池，在锁外进行
+    pages.clear();
+    for (uint32_t pageId = first; pageId < end; ++pageId) {
+        if (!skipPage_ || !skipPage_(pageId)) {
+            pages.push_back(pageId);
+        }
+    }
+    
+    std::lock_guard<std::mutex> lock(readMutex_);
+    size_t copied = 0;
+    for (uint32_t pageId : pages) {
+        PageGuard guard;
+        auto page = heap_.readDataPage(pageId, guard);
+        if (!page) {
+            continue;
+        }
+        std::memcpy(buffer + copied * kPageSize, page->data(), kPageSize);
+        pages[copied++] = pageId;
+    }
+    pages.resize(copied);
+}
+
+void parallelConsume(BatchOperator& input, size_t threads,
+                     const std::function<void(size_t worker, const RowBatch& batch)>& consume) {
+    if (threads <= 1 || WorkerPool::insideTask()) {
+        RowBatch batch;
+        while (input.next(batch)) {
+            consume(0, batch);
+        }
+        return;
+    }
+    
+    // 每个工作线程处理一批时还有一批在排队，批的个数为线程数的两倍
+    std::vector<RowBatch> batches(threads * 2);
+    std::vector<RowBatch*> idle;
+    for (auto& batch : batches) {
+        idle.push_back(&batch);
+    }
+    std::deque<RowBatch*> ready;
+    bool finished = false;
+    std::exception_ptr error;
+    std::mutex mutex;
+    std::condition_variable readyChanged;
+    std::condition_variable idleChanged;
+    
+    auto work = [&](size_t worker) {
+        while (true) {
+            RowBatch* batch;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                readyChanged.wait(lock, [&] { return !ready.empty() || finished; });
+                if (ready.empty()) {
+                    return;
+                }
+                batch = ready.front();
+                ready.pop_front();
+            }
+            try {
+                consume(worker, *batch);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (!error) {
+                    error = std::current_exception();
+                }
+            }
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                idle.push_back(batch);
+            }
+            idleChanged.notify_one();
+        }
+    };
+    
+    // 拉取批的异常也要等工作线程结束后再抛出
+    auto pull = [&] {
+        try {
+            while (true) {
+                RowBatch* batch;
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    idleChanged.wait(lock, [&] { return !idle.empty(); });
+                    if (error) {
+                        break;
+                    }
+                    batch = idle.back();
+                    idle.pop_back();
+                }
+                if (!input.next(*batch)) {
+                    break;
+                }
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    ready.push_back(batch);
+                }
+                readyChanged.notify_one();
+            }
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!error) {
+                error = std::current_exception();
+            }
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            finished = true;
+        }
+        readyChanged.notify_all();
+    };
+    
+    // 线程池中的序号0（调用线程）拉取批，其余序号各是一个工作线程
+    WorkerPool::getInstance().run(threads + 1, [&](size_t worker) {
+        if (worker == 0) {
+            pull();
+        } else {
+            work(worker - 1);
+        }
+    });
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+namespace {
+
+// AND：每个合取项只判断前面的合取项都满足的行。选择向量是整批时，第一个INT区间比较与
+// 同列上的其余区间比较（如BETWEEN展开的下界和上界）合并为一次SIMD区间判断
+void filterConjunction(const Predicate& where, const RowBatch& batch, std::vector<uint16_t>& selection) {
+    const auto& children = where.getChildren();
+    std::vector<bool> fused(children.size(), false);
+    if (selection.size() == batch.size) {
+        auto first = std::find_if(children.begin(), children.end(), [&](const Predicate& child) {
+            return isIntBound(child, batch);
+        });
+        if (first != children.end()) {
+            size_t column = first->getColumn();
+            IntRange range;
+            size_t merged = 0;
+            for (size_t i = static_cast<size_t>(first - children.begin()); i < children.size(); ++i) {
+                if (isIntBound(children[i], batch) && children[i].getColumn() == column) {
+                    range.intersect(IntRange::fromCompare(children[i].getOp(), std::get<int>(children[i].getValue())));
+                    fused[i] = true;
+                    ++merged;
+                }
+            }
+            if (merged > 1) {
+                filterIntRange(batch.columns[column], range, batch.size, selection);
+            } else {
+                std::fill(fused.begin(), fused.end(), false);
+            }
+        }
+    }
+    
+    for (size_t i = 0; i < children.size(); ++i) {
+        if (selection.empty()) {
+            return;
+        }
+        if (!fused[i]) {
+            filterBatch(children[i], batch, selection);
+        }
+    }
+}
+
+} // namespace
+
+void filterBatch(const Predicate& where, const RowBatch& batch, std::vector<uint16_t>& selection) {
+    switch (where.getKind()) {
+        case Predicate::Kind::NONE:
+            return;
+        case Predicate::Kind::COMPARE:
+            filterCompare(where, batch, selection);
+            return;
+        case Predicate::Kind::AND:
+            filterConjunction(where, batch, selection);
+            return;
+        case Predicate::Kind::OR:
+            break;
+    }
+    
+    // 每个析取项只判断前面的析取项都不满足的行，满足的行归并到结果中
+    std::vector<uint16_t> pending = selection;
+    std::vector<uint16_t> result;
+    std::vector<uint16_t> hits;
+    std::vector<uint16_t> merged;
+    for (const auto& child : where.getChildren()) {
+        if (pending.empty()) {
+            break;
+        }
+        hits = pending;
+        filterBatch(child, batch, hits);
+        if (hits.empty()) {
+            continue;
+        }
+        merged.clear();
+        std::merge(result.begin(), result.end(), hits.begin(), hits.end(), std::back_inserter(merged));
+        result.swap(merged);
+        
+        // 从待判断的行中去掉已满足的行（两者都是升序）
+        size_t kept = 0;
+        size_t h = 0;
+        for (uint16_t i : pending) {
+            if (h < hits.size() && hits[h] == i) {
+                ++h;
+            } else {
+                pending[kept++] = i;
+            }
+        }
+        pending.resize(kept);
+    }
+    selection.swap(result);
+}
+
+} // namespace minidb
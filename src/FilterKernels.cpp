@@ -0,0 +1,216 @@
+#include "../include/FilterKernels.h"
+#include <algorithm>
+#include <array>
+#include <numeric>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define MINIDB_X86_KERNELS 1
+#endif
+
+namespace minidb {
+
+namespace {
+
+// 区间条件的标量判断：(v - lower) 按无符号数不大于 (upper - lower) 时v在区间内，只需一次比较
+inline bool inRange(int32_t value, uint32_t lower, uint32_t width) {
+    return static_cast<uint32_t>(value) - lower <= width;
+}
+
+// 标量过滤核：不用分支，每个位置都写入，满足条件时才前进；base为values[0]在批中的位置
+size_t selectScalar(const int32_t* values, size_t count, size_t base, const IntRange& range,
+                    uint16_t* selection) {
+    uint32_t lower = static_cast<uint32_t>(range.lower);
+    uint32_t width = static_cast<uint32_t>(range.upper) - lower;
+    size_t kept = 0;
+    if (range.inside) {
+        for (size_t i = 0; i < count; ++i) {
+            selection[kept] = static_cast<uint16_t>(base + i);
+            kept += inRange(values[i], lower, width) ? 1 : 0;
+        }
+    } else {
+        for (size_t i = 0; i < count; ++i) {
+            selection[kept] = static_cast<uint16_t>(base + i);
+            kept += inRange(values[i], lower, width) ? 0 : 1;
+        }
+    }
+    return kept;
+}
+
+#ifdef MINIDB_X86_KERNELS
+
+// 8位掩码对应的位置表：第m项按升序列出m中为1的位，其余填0，以及这些位的个数
+struct PositionTable {
+    alignas(16) uint16_t positions[256][8];
+    uint8_t counts[256];
+};
+
+constexpr PositionTable makePositionTable() {
+    PositionTable table{};
+    for (unsigned mask = 0; mask < 256; ++mask) {
+        uint8_t count = 0;
+        for (uint16_t bit = 0; bit < 8; ++bit) {
+            if (mask & (1u << bit)) {
+                table.positions[mask][count++] = bit;
+            }
+        }
+        table.counts[mask] = count;
+    }
+    return table;
+}
+
+constexpr PositionTable kPositionTable = makePositionTable();
+
+// 把8个值的比较掩码转换为位置：一次写入8个位置，只前进满足条件的个数
+inline size_t storePositions(unsigned mask, size_t base, uint16_t* out) {
+    __m128i positions = _mm_load_si128(reinterpret_cast<const __m128i*>(kPositionTable.positions[mask]));
+    positions = _mm_add_epi16(positions, _mm_set1_epi16(static_cast<short>(base)));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out), positions);
+    return kPositionTable.counts[mask];
+}
+
+// AVX2过滤核：每次比较8个值，不在区间内 = (lower > v) | (v > upper)
+__attribute__((target("avx2")))
+size_t selectAvx2(const int32_t* values, size_t count, const IntRange& range, uint16_t* selection) {
+    const __m256i lower = _mm256_set1_epi32(range.lower);
+    const __m256i upper = _mm256_set1_epi32(range.upper);
+    const unsigned flip = range.inside ? 0xFF : 0;
+    size_t kept = 0;
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(values + i));
+        __m256i outside = _mm256_or_si256(_mm256_cmpgt_epi32(lower, v), _mm256_cmpgt_epi32(v, upper));
+        unsigned mask = static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(outside))) ^ flip;
+        kept += storePositions(mask, i, selection + kept);
+    }
+    return kept + selectScalar(values + i, count - i, i, range, selection + kept);
+}
+
+// SSE4过滤核：每次比较两组4个值，掩码拼成8位
+__attribute__((target("sse4.1")))
+size_t selectSse4(const int32_t* values, size_t count, const IntRange& range, uint16_t* selection) {
+    const __m128i lower = _mm_set1_epi32(range.lower);
+    const __m128i upper = _mm_set1_epi32(range.upper);
+    const unsigned flip = range.inside ? 0xFF : 0;
+    size_t kept = 0;
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m128i v0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(values + i));
+        __m128i v1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(values + i + 4));
+        __m128i outside0 = _mm_or_si128(_mm_cmpgt_epi32(lower, v0), _mm_cmpgt_epi32(v0, upper));
+        __m128i outside1 = _mm_or_si128(_mm_cmpgt_epi32(lower, v1), _mm_cmpgt_epi32(v1, upper));
+        unsigned mask = static_cast<unsigned>(_mm_movemask_ps(_mm_castsi128_ps(outside0))) |
+                        (static_cast<unsigned>(_mm_movemask_ps(_mm_castsi128_ps(outside1))) << 4);
+        kept += storePositions(mask ^ flip, i, selection + kept);
+    }
+    return kept + selectScalar(values + i, count - i, i, range, selection + kept);
+}
+
+#endif
+
+} // namespace
+
+IntRange IntRange::fromCompare(Operator op, int32_t value) {
+    constexpr int32_t kMin = std::numeric_limits<int32_t>::min();
+    constexpr int32_t kMax = std::numeric_limits<int32_t>::max();
+    IntRange range;
+    switch (op) {
+        case Operator::EQUAL:
+            range.lower = value;
+            range.upper = value;
+            break;
+        case Operator::NOT_EQUAL:
+            range.lower = value;
+            range.upper = value;
+            range.inside = false;
+            break;
+        case Operator::LESS_THAN:
+            if (value == kMin) {
+                range.lower = kMax;
+                range.upper = kMin;
+            } else {
+                range.upper = value - 1;
+            }
+            break;
+        case Operator::LESS_EQUAL:
+            range.upper = value;
+            break;
+        case Operator::GREATER_THAN:
+            if (value == kMax) {
+                range.lower = kMax;
+                range.upper = kMin;
+            } else {
+                range.lower = value + 1;
+            }
+            break;
+        case Operator::GREATER_EQUAL:
+            range.lower = value;
+            break;
+    }
+    return range;
+}
+
+void IntRange::intersect(const IntRange& other) {
+    lower = std::max(lower, other.lower);
+    upper = std::min(upper, other.upper);
+}
+
+SimdLevel detectSimdLevel() {
+    static const SimdLevel level = [] {
+#ifdef MINIDB_X86_KERNELS
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) {
+            return SimdLevel::AVX2;
+        }
+        if (__builtin_cpu_supports("sse4.1")) {
+            return SimdLevel::SSE4;
+        }
+#endif
+        return SimdLevel::SCALAR;
+    }();
+    return level;
+}
+
+const char* simdLevelName(SimdLevel level) {
+    switch (level) {
+        case SimdLevel::SCALAR:
+            return "scalar";
+        case SimdLevel::SSE4:
+            return "sse4";
+        case SimdLevel::AVX2:
+            return "avx2";
+    }
+    return "scalar";
+}
+
+size_t selectIntRange(const int32_t* values, size_t count, const IntRange& range, uint16_t* selection) {
+    return selectIntRange(detectSimdLevel(), values, count, range, selection);
+}
+
+size_t selectIntRange(SimdLevel level, const int32_t* values, size_t count, const IntRange& range,
+                      uint16_t* selection) {
+    // 空区间：区间内没有值，区间外是所有值
+    if (range.lower > range.upper) {
+        if (!range.inside) {
+            std::iota(selection, selection + count, static_cast<uint16_t>(0));
+            return count;
+        }
+        return 0;
+    }
+
+#ifdef MINIDB_X86_KERNELS
+    switch (level) {
+        case SimdLevel::AVX2:
+            return selectAvx2(values, count, range, selection);
+        case SimdLevel::SSE4:
+            return selectSse4(values, count, range, selection);
+        case SimdLevel::SCALAR:
+            break;
+    }
+#else
+    (void)level;
+#endif
+    return selectScalar(values, count, 0, range, selection);
+}
+
+} // namespace minidb
@@ -0,0 +1,406 @@
+#include "../include/Index.h"
+#include "../include/WAL.h"
+#include <iostream>
+#include <fstream>
+#include <cstring>
+#include <algorithm>
+#include <stdexcept>
+
+namespace minidb {
+
+namespace {
+
+// 索引文件布局：文件头之后依次是每个索引项
+constexpr uint64_t kHashFileMagic = 0x314853414842444Dull; // "MDBHASH1"
+constexpr uint32_t kHashFileVersion = 1;
+constexpr size_t kMagicOffset = 0;
+constexpr size_t kVersionOffset = 8;
+constexpr size_t kCleanOffset = 12;
+constexpr size_t kEntryCountOffset = 16;
+constexpr size_t kHeaderSize = 24;
+
+// 哈希表的最小容量和最大装载因子（十分之七）
+constexpr size_t kMinCapacity = 16;
+constexpr size_t kMaxLoadNumerator = 7;
+constexpr size_t kMaxLoadDenominator = 10;
+
+// 键区中的垃圾超过该字节数且超过一半时整理键区
+constexpr size_t kMinGarbageBytes = 64 * 1024;
+
+// 64位整数混合函数，使相邻的INT键分散到不同的槽
+uint64_t mixHash(uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdull;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ull;
+    h ^= h >> 33;
+    return h;
+}
+
+// 容纳entryCount项而不超过最大装载因子的最小容量
+size_t capacityFor(size_t entryCount) {
+    size_t capacity = kMinCapacity;
+    while (entryCount * kMaxLoadDenominator > capacity * kMaxLoadNumerator) {
+        capacity *= 2;
+    }
+    return capacity;
+}
+
+uint64_t hashInt(int32_t key) {
+    return mixHash(static_cast<uint32_t>(key));
+}
+
+uint64_t hashBytes(std::string_view key) {
+    return mixHash(std::hash<std::string_view>{}(key) ^ 0x9e3779b97f4a7c15ull);
+}
+
+} // namespace
+
+HashIndex::HashIndex(const std::filesystem::path& indexPath, size_t keyColumns)
+    : indexPath_(indexPath), keyColumns_(keyColumns) {
+}
+
+bool HashIndex::insert(const IndexKey& key, size_t rowId, const Record&) {
+    try {
+        if (!open_ || !markModified()) {
+            return false;
+        }
+        
+        // 装载因子过高时扩容
+        if ((entryCount_ + 1) * kMaxLoadDenominator > slots_.size() * kMaxLoadNumerator) {
+            rehash(std::max(kMinCapacity, slots_.size() * 2));
+        }
+        
+        // 键和行号都相同的项已存在时不再插入
+        std::string keyBytes;
+        Slot slot = makeSlot(key, keyBytes);
+        slot.rowId = rowId;
+        size_t mask = slots_.size() - 1;
+        for (size_t i = slot.hash & mask; slots_[i].rowId != kEmptySlot; i = (i + 1) & mask) {
+            if (slots_[i].rowId == rowId && keyEquals(slots_[i], slot, keyBytes)) {
+                return true;
+            }
+        }
+        
+        place(slot, keyBytes);
+        ++entryCount_;
+        return true;
+    } catch (const std::exception& e) {
+        std::cerr << "插入索引失败: " << e.what() << std::endl;
+        return false;
+    }
+}
+
+bool HashIndex::remove(const IndexKey& key, size_t rowId) {
+    try {
+        if (!open_ || slots_.empty()) {
+            return false;
+        }
+        
+        std::string keyBytes;
+        Slot probe = makeSlot(key, keyBytes);
+        size_t mask = slots_.size() - 1;
+        size_t i = probe.hash & mask;
+        while (slots_[i].rowId != kEmptySlot &&
+               !(slots_[i].rowId == rowId && keyEquals(slots_[i], probe, keyBytes))) {
+            i = (i + 1) & mask;
+        }
+        if (slots_[i].rowId == kEmptySlot || !markModified()) {
+            return false;
+        }
+        
+        if (slots_[i].keyLength != kIntKey) {
+            garbageBytes_ += slots_[i].keyLength;
+        }
+        slots_[i].rowId = kEmptySlot;
+        --entryCount_;
+        
+        // 把后面探测链上的项向前移动填补空槽，查找时不需要跳过墓碑
+        for (size_t j = (i + 1) & mask; slots_[j].rowId != kEmptySlot; j = (j + 1) & mask) {
+            size_t home = slots_[j].hash & mask;
+            bool stays = (i <= j) ? (i < home && home <= j) : (i < home || home <= j);
+            if (!stays) {
+                slots_[i] = slots_[j];
+                slots_[j].rowId = kEmptySlot;
+                i = j;
+            }
+        }
+        
+        // 删除的键留在键区中，垃圾过多时整理
+        if (garbageBytes_ >= kMinGarbageBytes && garbageBytes_ * 2 >= keys_.size()) {
+            rehash(slots_.size());
+        }
+        return true;
+    } catch (const std::exception& e) {
+        std::cerr << "删除索引失败: " << e.what() << std::endl;
+        return false;
+    }
+}
+
+std::vector<size_t> HashIndex::find(const IndexKey& key, Operator op) {
+    std::vector<size_t> result;
+    if (!open_ || slots_.empty() || !supportsLookup(key.size(), op)) {
+        return result;
+    }
+    
+    std::string keyBytes;
+    Slot probe = makeSlot(key, keyBytes);
+    size_t mask = slots_.size() - 1;
+    for (size_t i = probe.hash & mask; slots_[i].rowId != kEmptySlot; i = (i + 1) & mask) {
+        if (keyEquals(slots_[i], probe, keyBytes)) {
+            result.push_back(static_cast<size_t>(slots_[i].rowId));
+        }
+    }
+    
+    // 按行号排序，结果与扫描和B+树索引的顺序一致
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+bool HashIndex::scan(const IndexKey& key, Operator op, const IndexEntryVisitor& visitor) {
+    // 查找结果已按行号排序，键都等于key
+    for (size_t rowId : find(key, op)) {
+        if (!visitor(rowId, key, {})) {
+            break;
+        }
+    }
+    return true;
+}
+
+bool HashIndex::clear() {
+    try {
+        open_ = true;
+        slots_.assign(kMinCapacity, Slot{0, kEmptySlot, 0, 0});
+        keys_.clear();
+        entryCount_ = 0;
+        garbageBytes_ = 0;
+        return markModified();
+    } catch (const std::exception& e) {
+        std::cerr << "清空索引失败: " << e.what() << std::endl;
+        return false;
+    }
+}
+
+bool HashIndex::build(std::vector<IndexBuildEntry>& entries) {
+    try {
+        if (!clear()) {
+            return false;
+        }
+        
+        // 表中每行只有一项，不需要检查重复；一次分配足够的槽，放入过程中不会扩容
+        slots_.assign(capacityFor(entries.size()), Slot{0, kEmptySlot, 0, 0});
+        std::string keyBytes;
+        for (const auto& entry : entries) {
+            Slot slot = makeSlot(entry.key, keyBytes);
+            slot.rowId = entry.rowId;
+            place(slot, keyBytes);
+        }
+        entryCount_ = entries.size();
+        return true;
+    } catch (const std::exception& e) {
+        std::cerr << "建立索引失败: " << e.what() << std::endl;
+        return false;
+    }
+}
+
+bool HashIndex::save() {
+    try {
+        if (!open_) {
+            return false;
+        }
+        if (!modified_) {
+            return true;
+        }
+        
+        std::filesystem::path tmpPath = indexPath_;
+        tmpPath += ".tmp";
+        {
+            std::ofstream file(tmpPath, std::ios::binary | std::ios::trunc);
+            if (!file.is_open()) {
+                return false;
+            }
+            
+            // 写入文件头（已保存标记为1）
+            char header[kHeaderSize] = {};
+            uint64_t entryCount = entryCount_;
+            std::memcpy(header + kMagicOffset, &kHashFileMagic, sizeof(kHashFileMagic));
+            std::memcpy(header + kVersionOffset, &kHashFileVersion, sizeof(kHashFileVersion));
+            std::memcpy(header + kEntryCountOffset, &entryCount, sizeof(entryCount));
+            header[kCleanOffset] = 1;
+            file.write(header, sizeof(header));
+            
+            // 写入索引项：2字节键长度，编码后的键，行号
+            std::string intKey;
+            for (const auto& slot : slots_) {
+                if (slot.rowId == kEmptySlot) {
+                    continue;
+                }
+                std::string_view keyBytes;
+                if (slot.keyLength == kIntKey) {
+                    intKey = encodeIndexKey({static_cast<int>(static_cast<int32_t>(slot.keyOffset))});
+                    keyBytes = intKey;
+                } else {
+                    keyBytes = std::string_view(keys_.data() + slot.keyOffset, slot.keyLength);
+                }
+                uint16_t length = static_cast<uint16_t>(keyBytes.size());
+                file.write(reinterpret_cast<const char*>(&length), sizeof(length));
+                file.write(keyBytes.data(), length);
+                file.write(reinterpret_cast<const char*>(&slot.rowId), sizeof(slot.rowId));
+            }
+            
+            if (!file) {
+                return false;
+            }
+        }
+        
+        // 新文件落盘后再替换旧文件
+        if (!syncFile(tmpPath)) {
+            return false;
+        }
+        std::filesystem::rename(tmpPath, indexPath_);
+        modified_ = false;
+        return true;
+    } catch (const std::exception& e) {
+        std::cerr << "保存索引失败: " << e.what() << std::endl;
+        return false;
+    }
+}
+
+bool HashIndex::load() {
+    try {
+        std::ifstream file(indexPath_, std::ios::binary);
+        if (!file.is_open()) {
+            return false;
+        }
+        
+        // 上次修改后没有保存的索引可能不完整，需要重建
+        char header[kHeaderSize];
+        uint64_t magic;
+        uint32_t version;
+        uint64_t entryCount;
+        if (!file.read(header, sizeof(header))) {
+            return false;
+        }
+        std::memcpy(&magic, header + kMagicOffset, sizeof(magic));
+        std::memcpy(&version, header + kVersionOffset, sizeof(version));
+        std::memcpy(&entryCount, header + kEntryCountOffset, sizeof(entryCount));
+        if (magic != kHashFileMagic || version != kHashFileVersion || header[kCleanOffset] == 0) {
+            return false;
+        }
+        
+        // 按项数一次分配足够的槽，避免加载过程中扩容
+        slots_.assign(capacityFor(static_cast<size_t>(entryCount)), Slot{0, kEmptySlot, 0, 0});
+        keys_.clear();
+        garbageBytes_ = 0;
+        
+        std::string keyBytes;
+        for (uint64_t i = 0; i < entryCount; ++i) {
+            uint16_t length;
+            file.read(reinterpret_cast<char*>(&length), sizeof(length));
+            keyBytes.resize(length);
+            file.read(keyBytes.data(), length);
+            
+            // 与插入时一样由makeSlot生成槽，单列INT键内联在槽中
+            std::string encoded;
+            Slot slot = makeSlot(decodeIndexKey(keyBytes), encoded);
+            file.read(reinterpret_cast<char*>(&slot.rowId), sizeof(slot.rowId));
+            if (!file) {
+                return false;
+            }
+            place(slot, encoded);
+        }
+        
+        entryCount_ = static_cast<size_t>(entryCount);
+        open_ = true;
+        modified_ = false;
+        return true;
+    } catch (const std::exception& e) {
+        std::cerr << "加载索引失败: " << e.what() << std::endl;
+        return false;
+    }
+}
+
+HashIndex::Slot HashIndex::makeSlot(const IndexKey& key, std::string& keyBytes) const {
+    if (key.size() == 1 && std::holds_alternative<int>(key[0])) {
+        int32_t value = std::get<int>(key[0]);
+        return Slot{hashInt(value), 0, static_cast<uint32_t>(value), kIntKey};
+    }
+    keyBytes = encodeIndexKey(key);
+    return Slot{hashBytes(keyBytes), 0, 0, static_cast<uint32_t>(keyBytes.size())};
+}
+
+bool HashIndex::keyEquals(const Slot& slot, const Slot& probe, std::string_view keyBytes) const {
+    if (slot.hash != probe.hash || slot.keyLength != probe.keyLength) {
+        return false;
+    }
+    if (probe.keyLength == kIntKey) {
+        return slot.keyOffset == probe.keyOffset;
+    }
+    return std::memcmp(keys_.data() + slot.keyOffset, keyBytes.data(), keyBytes.size()) == 0;
+}
+
+void HashIndex::place(Slot slot, std::string_view keyBytes) {
+    if (slot.keyLength != kIntKey) {
+        if (keys_.size() + keyBytes.size() > UINT32_MAX) {
+            throw std::length_error("哈希索引键区过大");
+        }
+        slot.keyOffset = static_cast<uint32_t>(keys_.size());
+        keys_.append(keyBytes);
+    }
+    
+    size_t mask = slots_.size() - 1;
+    size_t i = slot.hash & mask;
+    while (slots_[i].rowId != kEmptySlot) {
+        i = (i + 1) & mask;
+    }
+    slots_[i] = slot;
+}
+
+void HashIndex::rehash(size_t capacity) {
+    std::vector<Slot> oldSlots = std::move(slots_);
+    std::string oldKeys = std::move(keys_);
+    
+    slots_.assign(capacity, Slot{0, kEmptySlot, 0, 0});
+    keys_.clear();
+    keys_.reserve(oldKeys.size() - garbageBytes_);
+    garbageBytes_ = 0;
+    
+    for (const auto& slot : oldSlots) {
+        if (slot.rowId == kEmptySlot) {
+            continue;
+        }
+        std::string_view keyBytes;
+        if (slot.keyLength != kIntKey) {
+            keyBytes = std::string_view(oldKeys.data() + slot.keyOffset, slot.keyLength);
+        }
+        place(slot, keyBytes);
+    }
+}
+
+bool HashIndex::markModified() {
+    if (modified_) {
+        return true;
+    }
+    
+    // 已有的索引文件先标记为未保存，崩溃后加载时会重建
+    if (std::filesystem::exists(indexPath_)) {
+        {
+            std::fstream file(indexPath_, std::ios::binary | std::ios::in | std::ios::out);
+            if (!file.is_open()) {
+                return false;
+            }
+            file.seekp(kCleanOffset);
+            file.put(0);
+            if (!file) {
+                return false;
+            }
+        }
+        if (!syncFile(indexPath_)) {
+            return false;
+        }
+    }
+    modified_ = true;
+    return true;
+}
+
+} // namespace minidb
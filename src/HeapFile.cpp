@@ -0,0 +1,551 @@
+#include "../include/HeapFile.h"
+#include <iostream>
+#include <fstream>
+#include <cstring>
+#include <stdexcept>
+
+namespace minidb {
+
+// 元数据页布局
+constexpr uint64_t kHeapFileMagic = 0x315041454842444Dull; // "MDBHEAP1"
+constexpr uint32_t kHeapFileVersion = 1;
+constexpr size_t kMagicOffset = 0;
+constexpr size_t kVersionOffset = 8;
+constexpr size_t kColumnCountOffset = 12;
+constexpr size_t kCheckpointLsnOffset = 16;
+constexpr size_t kRowCountOffset = 24;
+constexpr size_t kDeletedCountOffset = 32;
+constexpr size_t kColumnsOffset = 40;
+
+std::string encodeTuple(const Record& record, const std::vector<ColumnDef>& columns) {
+    std::string tuple;
+    for (size_t i = 0; i < columns.size(); ++i) {
+        if (columns[i].type == DataType::INT) {
+            int32_t value = std::get<int>(record[i]);
+            tuple.append(reinterpret_cast<const char*>(&value), sizeof(value));
+        } else {
+            const std::string& value = std::get<std::string>(record[i]);
+            if (value.size() > UINT16_MAX) {
+                throw std::length_error("字符串过长");
+            }
+            uint16_t length = static_cast<uint16_t>(value.size());
+            tuple.append(reinterpret_cast<const char*>(&length), sizeof(length));
+            tuple.append(value);
+        }
+    }
+    return tuple;
+}
+
+Record decodeTuple(std::string_view tuple, const std::vector<ColumnDef>& columns) {
+    Record record;
+    record.reserve(columns.size());
+    
+    size_t offset = 0;
+    for (const auto& column : columns) {
+        if (column.type == DataType::INT) {
+            int32_t value;
+            std::memcpy(&value, tuple.data() + offset, sizeof(value));
+            offset += sizeof(value);
+            record.emplace_back(std::in_place_type<int>, value);
+        } else {
+            uint16_t length;
+            std::memcpy(&length, tuple.data() + offset, sizeof(length));
+            offset += sizeof(length);
+            record.emplace_back(std::in_place_type<std::string>, tuple.data() + offset, length);
+            offset += length;
+        }
+    }
+    return record;
+}
+
+size_t TupleView::columnOffset(size_t colIndex) const {
+    size_t offset = 0;
+    for (size_t i = 0; i < colIndex; ++i) {
+        if (columns_[i].type == DataType::INT) {
+            offset += sizeof(int32_t);
+        } else {
+            uint16_t length;
+            std::memcpy(&length, tuple_.data() + offset, sizeof(length));
+            offset += sizeof(length) + length;
+        }
+    }
+    return offset;
+}
+
+int TupleView::getInt(size_t colIndex) const {
+    int32_t value;
+    std::memcpy(&value, tuple_.data() + columnOffset(colIndex), sizeof(value));
+    return value;
+}
+
+std::string_view TupleView::getString(size_t colIndex) const {
+    size_t offset = columnOffset(colIndex);
+    uint16_t length;
+    std::memcpy(&length, tuple_.data() + offset, sizeof(length));
+    return tuple_.substr(offset + sizeof(length), length);
+}
+
+Value TupleView::getValue(size_t colIndex) const {
+    if (columns_[colIndex].type == DataType::INT) {
+        return getInt(colIndex);
+    }
+    return std::string(getString(colIndex));
+}
+
+bool TupleView::matches(size_t colIndex, Operator op, const Value& value) const {
+    // 与compareValues语义一致：类型不同时不匹配
+    if (columns_[colIndex].type == DataType::INT) {
+        if (!std::holds_alternative<int>(value)) {
+            return false;
+        }
+        int left = getInt(colIndex);
+        int right = std::get<int>(value);
+        switch (op) {
+            case Operator::EQUAL: return left == right;
+            case Operator::LESS_THAN: return left < right;
+            case Operator::GREATER_THAN: return left > right;
+            case Operator::LESS_EQUAL: return left <= right;
+            case Operator::GREATER_EQUAL: return left >= right;
+            case Operator::NOT_EQUAL: return left != right;
+        }
+    } else {
+        if (!std::holds_alternative<std::string>(value)) {
+            return false;
+        }
+        std::string_view left = getString(colIndex);
+        std::string_view right = std::get<std::string>(value);
+        switch (op) {
+            case Operator::EQUAL: return left == right;
+            case Operator::LESS_THAN: return left < right;
+            case Operator::GREATER_THAN: return left > right;
+            case Operator::LESS_EQUAL: return left <= right;
+            case Operator::GREATER_EQUAL: return left >= right;
+            case Operator::NOT_EQUAL: return left != right;
+        }
+    }
+    return false;
+}
+
+HeapFile::HeapFile(const std::filesystem::path& path) : file_(path) {
+}
+
+bool HeapFile::isHeapFile(const std::filesystem::path& path) {
+    std::ifstream file(path, std::ios::binary);
+    uint64_t magic = 0;
+    file.read(reinterpret_cast<char*>(&magic), sizeof(magic));
+    return file && magic == kHeapFileMagic;
+}
+
+bool HeapFile::create(const std::vector<ColumnDef>& columns) {
+    if (!file_.open()) {
+        return false;
+    }
+    if (file_.getPageCount() == 0) {
+        file_.allocatePage();
+    }
+    open_ = true;
+    rowCount_ = 0;
+    deletedCount_ = 0;
+    return writeHeader(columns, {}, 0);
+}
+
+bool HeapFile::open(std::vector<ColumnDef>& columns, std::vector<IndexDef>& indexes, uint64_t& checkpointLsn) {
+    try {
+        if (!file_.open() || file_.getPageCount() == 0) {
+            return false;
+        }
+        
+        PageGuard guard = BufferPool::getInstance().fetchPage(file_, 0);
+        if (!guard) {
+            return false;
+        }
+        const char* data = guard.data();
+        
+        uint64_t magic;
+        std::memcpy(&magic, data + kMagicOffset, sizeof(magic));
+        if (magic != kHeapFileMagic) {
+            std::cerr << "表文件格式错误: " << file_.getPath() << std::endl;
+            return false;
+        }
+        
+        uint32_t version;
+        std::memcpy(&version, data + kVersionOffset, sizeof(version));
+        if (version != kHeapFileVersion) {
+            std::cerr << "表文件版本不支持: " << file_.getPath() << std::endl;
+            return false;
+        }
+        
+        uint32_t columnCount;
+        uint64_t rowCount;
+        uint64_t deletedCount;
+        std::memcpy(&columnCount, data + kColumnCountOffset, sizeof(columnCount));
+        std::memcpy(&checkpointLsn, data + kCheckpointLsnOffset, sizeof(checkpointLsn));
+        std::memcpy(&rowCount, data + kRowCountOffset, sizeof(rowCount));
+        std::memcpy(&deletedCount, data + kDeletedCountOffset, sizeof(deletedCount));
+        
+        // 读取列定义
+        columns.clear();
+        size_t offset = kColumnsOffset;
+        for (uint32_t i = 0; i < columnCount; ++i) {
+            uint16_t nameLength;
+            std::memcpy(&nameLength, data + offset, sizeof(nameLength));
+            offset += sizeof(nameLength);
+            
+            std::string name(data + offset, nameLength);
+            offset += nameLength;
+            
+            auto type = static_cast<DataType>(static_cast<uint8_t>(data[offset++]));
+            bool isPrimary = data[offset++] != 0;
+            columns.push_back({name, type, isPrimary});
+        }
+        
+        // 读取二级索引定义：名字、键列、索引类型和包含列
+        indexes.clear();
+        uint16_t indexCount;
+        std::memcpy(&indexCount, data + offset, sizeof(indexCount));
+        offset += sizeof(indexCount);
+        for (uint16_t i = 0; i < indexCount; ++i) {
+            uint16_t nameLength;
+            std::memcpy(&nameLength, data + offset, sizeof(nameLength));
+            offset += sizeof(nameLength);
+            
+            std::string name(data + offset, nameLength);
+            offset += nameLength;
+            
+            uint16_t keyCount;
+            std::memcpy(&keyCount, data + offset, sizeof(keyCount));
+            offset += sizeof(keyCount);
+            std::vector<size_t> indexColumns;
+            for (uint16_t j = 0; j < keyCount; ++j) {
+                uint16_t column;
+                std::memcpy(&column, data + offset, sizeof(column));
+                offset += sizeof(column);
+                indexColumns.push_back(column);
+            }
+            
+            auto type = static_cast<IndexType>(static_cast<uint8_t>(data[offset++]));
+            
+            uint16_t includeCount;
+            std::memcpy(&includeCount, data + offset, sizeof(includeCount));
+            offset += sizeof(includeCount);
+            std::vector<size_t> include;
+            for (uint16_t j = 0; j < includeCount; ++j) {
+                uint16_t column;
+                std::memcpy(&column, data + offset, sizeof(column));
+                offset += sizeof(column);
+                include.push_back(column);
+            }
+            indexes.push_back({name, std::move(indexColumns), type, std::move(include)});
+        }
+        
+        rowCount_ = static_cast<size_t>(rowCount);
+        deletedCount_ = static_cast<size_t>(deletedCount);
+        open_ = true;
+        return true;
+    } catch (const std::exception& e) {
+        std::cerr << "打开表文件失败: " << e.what() << std::endl;
+        return false;
+    }
+}
+
+bool HeapFile::writeHeader(const std::vector<ColumnDef>& columns, const std::vector<IndexDef>& indexes,
+                           uint64_t checkpointLsn) {
+    PageGuard guard = BufferPool::getInstance().fetchPage(file_, 0);
+    if (!guard) {
+        return false;
+    }
+    
+    // 先在临时缓冲区中组装，确认放得下再写入页
+    std::string header(kColumnsOffset, '\0');
+    uint32_t columnCount = static_cast<uint32_t>(columns.size());
+    uint64_t rowCount = rowCount_;
+    uint64_t deletedCount = deletedCount_;
+    std::memcpy(&header[kMagicOffset], &kHeapFileMagic, sizeof(kHeapFileMagic));
+    std::memcpy(&header[kVersionOffset], &kHeapFileVersion, sizeof(kHeapFileVersion));
+    std::memcpy(&header[kColumnCountOffset], &columnCount, sizeof(columnCount));
+    std::memcpy(&header[kCheckpointLsnOffset], &checkpointLsn, sizeof(checkpointLsn));
+    std::memcpy(&header[kRowCountOffset], &rowCount, sizeof(rowCount));
+    std::memcpy(&header[kDeletedCountOffset], &deletedCount, sizeof(deletedCount));
+    
+    for (const auto& column : columns) {
+        uint16_t nameLength = static_cast<uint16_t>(column.name.size());
+        header.append(reinterpret_cast<const char*>(&nameLength), sizeof(nameLength));
+        header.append(column.name);
+        header.push_back(static_cast<char>(column.type));
+        header.push_back(column.isPrimary ? 1 : 0);
+    }
+    
+    uint16_t indexCount = static_cast<uint16_t>(indexes.size());
+    header.append(reinterpret_cast<const char*>(&indexCount), sizeof(indexCount));
+    for (const auto& index : indexes) {
+        uint16_t nameLength = static_cast<uint16_t>(index.name.size());
+        uint16_t columnCount = static_cast<uint16_t>(index.columns.size());
+        header.append(reinterpret_cast<const char*>(&nameLength), sizeof(nameLength));
+        header.append(index.name);
+        header.append(reinterpret_cast<const char*>(&columnCount), sizeof(columnCount));
+        for (size_t column : index.columns) {
+            uint16_t value = static_cast<uint16_t>(column);
+            header.append(reinterpret_cast<const char*>(&value), sizeof(value));
+        }
+        header.push_back(static_cast<char>(index.type));
+        
+        uint16_t includeCount = static_cast<uint16_t>(index.include.size());
+        header.append(reinterpret_cast<const char*>(&includeCount), sizeof(includeCount));
+        for (size_t column : index.include) {
+            uint16_t value = static_cast<uint16_t>(column);
+            header.append(reinterpret_cast<const char*>(&value), sizeof(value));
+        }
+    }
+    
+    if (header.size() > kPageSize) {
+        std::cerr << "表结构过大，无法写入元数据页" << std::endl;
+        return false;
+    }
+    
+    std::memset(guard.data(), 0, kPageSize);
+    std::memcpy(guard.data(), header.data(), header.size());
+    guard.markDirty();
+    return true;
+}
+
+bool HeapFile::flush() {
+    return BufferPool::getInstance().flushFile(file_) && file_.sync();
+}
+
+PageGuard HeapFile::fetchDataPage(uint32_t pageId) {
+    PageGuard guard = BufferPool::getInstance().fetchPage(file_, pageId);
+    if (guard) {
+        SlottedPage page(guard.data());
+        if (!page.isInitialized()) {
+            page.init();
+            guard.markDirty();
+        }
+    }
+    return guard;
+}
+
+std::optional<RowId> HeapFile::reserveInsert(size_t tupleSize) {
+    if (tupleSize == 0 || tupleSize > maxTupleSize()) {
+        return std::nullopt;
+    }
+    
+    // 优先放入最后一个数据页
+    uint32_t pageCount = file_.getPageCount();
+    if (pageCount > 1) {
+        uint32_t lastPage = pageCount - 1;
+        PageGuard guard = fetchDataPage(lastPage);
+        if (!guard) {
+            return std::nullopt;
+        }
+        SlottedPage page(guard.data());
+        if (page.canInsert(tupleSize)) {
+            return makeRowId(lastPage, page.getSlotCount());
+        }
+    }
+    
+    // 最后一页放不下时分配新页
+    uint32_t newPage = file_.allocatePage();
+    if (!fetchDataPage(newPage)) {
+        return std::nullopt;
+    }
+    return makeRowId(newPage, 0);
+}
+
+bool HeapFile::insertAt(RowId rowId, std::string_view tuple, uint64_t lsn) {
+    uint32_t pageId = rowIdPage(rowId);
+    file_.ensurePageCount(pageId + 1);
+    
+    PageGuard guard = fetchDataPage(pageId);
+    if (!guard) {
+        return false;
+    }
+    
+    SlottedPage page(guard.data());
+    if (lsn != 0 && page.getLsn() >= lsn) {
+        return false;
+    }
+    if (!page.insertAt(rowIdSlot(rowId), tuple)) {
+        std::cerr << "插入元组失败: 页 " << pageId << " 槽 " << rowIdSlot(rowId) << std::endl;
+        return false;
+    }
+    
+    if (lsn > page.getLsn()) {
+        page.setLsn(lsn);
+    }
+    guard.markDirty();
+    ++rowCount_;
+    return true;
+}
+
+bool HeapFile::erase(RowId rowId, uint64_t lsn) {
+    uint32_t pageId = rowIdPage(rowId);
+    if (pageId == 0 || pageId >= file_.getPageCount()) {
+        return false;
+    }
+    
+    PageGuard guard = fetchDataPage(pageId);
+    if (!guard) {
+        return false;
+    }
+    
+    // 一条日志可能删除同一页上的多行，页LSN等于lsn时其余行仍需删除
+    SlottedPage page(guard.data());
+    if ((lsn != 0 && page.getLsn() > lsn) || !page.erase(rowIdSlot(rowId))) {
+        return false;
+    }
+    
+    if (lsn > page.getLsn()) {
+        page.setLsn(lsn);
+    }
+    guard.markDirty();
+    --rowCount_;
+    ++deletedCount_;
+    return true;
+}
+
+bool HeapFile::update(RowId rowId, std::string_view tuple, uint64_t lsn) {
+    uint32_t pageId = rowIdPage(rowId);
+    if (pageId == 0 || pageId >= file_.getPageCount()) {
+        return false;
+    }
+    
+    PageGuard guard = fetchDataPage(pageId);
+    if (!guard) {
+        return false;
+    }
+    
+    // 同上，重复应用同一条更新结果不变
+    SlottedPage page(guard.data());
+    if ((lsn != 0 && page.getLsn() > lsn) || !page.update(rowIdSlot(rowId), tuple)) {
+        return false;
+    }
+    
+    if (lsn > page.getLsn()) {
+        page.setLsn(lsn);
+    }
+    guard.markDirty();
+    return true;
+}
+
+bool HeapFile::canUpdate(RowId rowId, size_t tupleSize, size_t reserved) {
+    uint32_t pageId = rowIdPage(rowId);
+    if (pageId == 0 || pageId >= file_.getPageCount()) {
+        return false;
+    }
+    
+    PageGuard guard = fetchDataPage(pageId);
+    if (!guard) {
+        return false;
+    }
+    return SlottedPage(guard.data()).canUpdate(rowIdSlot(rowId), tupleSize, reserved);
+}
+
+std::optional<Record> HeapFile::get(RowId rowId, const std::vector<ColumnDef>& columns) {
+    std::optional<Record> record;
+    read(rowId, [&](std::string_view tuple) {
+        record = decodeTuple(tuple, columns);
+    });
+    return record;
+}
+
+bool HeapFile::read(RowId rowId, const std::function<void(std::string_view)>& visitor) {
+    uint32_t pageId = rowIdPage(rowId);
+    if (pageId == 0 || pageId >= file_.getPageCount()) {
+        return false;
+    }
+    
+    PageGuard guard;
+    const char* data = BufferPool::getInstance().readPage(file_, pageId, guard);
+    if (!data) {
+        return false;
+    }
+    
+    // 只读访问不修改页内容
+    SlottedPage page(const_cast<char*>(data));
+    if (!page.isInitialized()) {
+        return false;
+    }
+    
+    auto tuple = page.get(rowIdSlot(rowId));
+    if (!tuple.has_value()) {
+        return false;
+    }
+    visitor(tuple.value());
+    return true;
+}
+
+void HeapFile::scan(const std::function<void(RowId, std::string_view)>& visitor) {
+    scan(nullptr, visitor);
+}
+
+void HeapFile::scan(const std::function<bool(uint32_t pageId)>& skipPage,
+                    const std::function<void(RowId, std::string_view)>& visitor) {
+    uint32_t pageCount = file_.getPageCount();
+    for (uint32_t pageId = 1; pageId < pageCount; ++pageId) {
+        if (skipPage && skipPage(pageId)) {
+            continue;
+        }
+        
+        PageGuard guard;
+        auto page = readDataPage(pageId, guard);
+        if (!page) {
+            continue;
+        }
+        
+        uint16_t slotCount = page->getSlotCount();
+        for (uint16_t slot = 0; slot < slotCount; ++slot) {
+            auto tuple = page->get(slot);
+            if (tuple.has_value()) {
+                visitor(makeRowId(pageId, slot), tuple.value());
+            }
+        }
+    }
+}
+
+std::optional<SlottedPage> HeapFile::readDataPage(uint32_t pageId, PageGuard& guard) {
+    if (pageId == 0 || pageId >= file_.getPageCount()) {
+        return std::nullopt;
+    }
+    
+    // 不在缓冲池中的页直接从映射区读取，全表扫描不会挤出缓存中的热点页
+    const char* data = BufferPool::getInstance().readPage(file_, pageId, guard);
+    if (!data) {
+        return std::nullopt;
+    }
+    
+    // 整页都已删除时跳过
+    SlottedPage page(const_cast<char*>(data));
+    if (!page.isInitialized() || page.getLiveCount() == 0) {
+        return std::nullopt;
+    }
+    return page;
+}
+
+void HeapFile::recount() {
+    // 只读取页头：存活元组数和已删除的槽数
+    size_t live = 0;
+    size_t deleted = 0;
+    uint32_t pageCount = file_.getPageCount();
+    for (uint32_t pageId = 1; pageId < pageCount; ++pageId) {
+        PageGuard guard;
+        const char* data = BufferPool::getInstance().readPage(file_, pageId, guard);
+        if (!data) {
+            continue;
+        }
+        
+        SlottedPage page(const_cast<char*>(data));
+        if (page.isInitialized()) {
+            live += page.getLiveCount();
+            deleted += page.getSlotCount() - page.getLiveCount();
+        }
+    }
+    rowCount_ = live;
+    deletedCount_ = deleted;
+}
+
+uint32_t HeapFile::getDataPageCount() const {
+    uint32_t pageCount = file_.getPageCount();
+    return pageCount > 0 ? pageCount - 1 : 0;
+}
+
+} // namespace minidb
\ No newline at end of file
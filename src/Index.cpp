@@ -1,12 +1,400 @@
 #include "../include/Index.h"
+#include "../include/Parallel.h"
+#include "../include/DBManager.h"
 #include <iostream>
+#include <cstring>
+#include <algorithm>
+#include <stdexcept>
+#include <cstdint>
 
 namespace minidb {
 
-bool BTreeIndex::insert(const Value& key, size_t rowId) {
+namespace {
+
+// 元数据页布局
+constexpr uint64_t kIndexFileMagic = 0x314552544242444Dull; // "MDBBTRE1"
+constexpr uint32_t kIndexFileVersion = 1;
+constexpr size_t kMagicOffset = 0;
+constexpr size_t kVersionOffset = 8;
+constexpr size_t kRootPageOffset = 12;
+constexpr size_t kEntryCountOffset = 16;
+constexpr size_t kCleanOffset = 24;
+
+// 键中每一列的编码：1字节类型标记，之后INT为翻转符号位后的4字节大端整数，
+// STRING为内容（0字节转义为0x00 0xFF）加0x00 0x00结束符。
+// 编码保持顺序，两个键可以直接用memcmp比较，较短的键是较长的键的前缀时较小
+constexpr uint8_t kIntKeyTag = 0;
+constexpr uint8_t kStringKeyTag = 1;
+constexpr uint8_t kStringEscape = 0xFF;
+
+// 批量建立索引时每个节点的填充比例（百分比），留出空间给之后的插入，避免立即分裂
+constexpr size_t kBulkFillPercent = 90;
+
+// 查找范围条件时追加在键前缀之后的标记，比任何列的类型标记都大，
+// 因此“前缀 + 标记”排在所有以该前缀开头的键之后
+constexpr uint8_t kMaxKeyTag = 0xFF;
+
+// 节点中的键：2字节长度加各列的编码
+std::string encodeKey(const IndexKey& key) {
+    std::string fields = encodeIndexKey(key);
+    uint16_t length = static_cast<uint16_t>(std::min<size_t>(fields.size(), UINT16_MAX));
+    std::string bytes(reinterpret_cast<const char*>(&length), sizeof(length));
+    bytes.append(fields, 0, length);
+    return bytes;
+}
+
+// 把键前缀编码为排在所有以该前缀开头的键之后的探测键
+std::string encodeKeyAfter(const IndexKey& key) {
+    std::string fields = encodeIndexKey(key);
+    fields.push_back(static_cast<char>(kMaxKeyTag));
+    uint16_t length = static_cast<uint16_t>(fields.size());
+    std::string bytes(reinterpret_cast<const char*>(&length), sizeof(length));
+    bytes.append(fields);
+    return bytes;
+}
+
+// 索引项：编码后的键加8字节行号，键相同的项按行号排序，因此允许重复键
+std::string makeEntry(const std::string& keyBytes, uint64_t rowId) {
+    std::string entry = keyBytes;
+    entry.append(reinterpret_cast<const char*>(&rowId), sizeof(rowId));
+    return entry;
+}
+
+// 从单元开头解析出键的长度
+size_t keySize(const char* data) {
+    uint16_t length;
+    std::memcpy(&length, data, sizeof(length));
+    return sizeof(length) + length;
+}
+
+// 从单元开头解析出索引项的长度
+size_t entrySize(const char* data) {
+    return keySize(data) + sizeof(uint64_t);
+}
+
+// 叶子单元中索引项之后的包含列：2字节长度加各列的编码
+std::string encodeIncluded(const Record& included) {
+    std::string fields = encodeIndexKey(included);
+    uint16_t length = static_cast<uint16_t>(fields.size());
+    std::string bytes(reinterpret_cast<const char*>(&length), sizeof(length));
+    bytes.append(fields);
+    return bytes;
+}
+
+// 包含列的长度
+size_t includedSize(const char* data) {
+    uint16_t length;
+    std::memcpy(&length, data, sizeof(length));
+    return sizeof(length) + length;
+}
+
+// 索引项中的行号
+uint64_t entryRowId(std::string_view entry) {
+    uint64_t rowId;
+    std::memcpy(&rowId, entry.data() + entry.size() - sizeof(rowId), sizeof(rowId));
+    return rowId;
+}
+
+// 比较两个编码后的键，返回负数、0或正数；较短的键是较长的键的前缀时较小。
+// prefixOnly为true时只比较right中的列，right是left的前缀时返回0。
+// 每列的编码都不是其他值的编码的前缀，所以按字节的前缀就是按列的前缀
+int compareKeys(std::string_view left, std::string_view right, bool prefixOnly = false) {
+    size_t leftSize = left.size() - sizeof(uint16_t);
+    size_t rightSize = right.size() - sizeof(uint16_t);
+    int cmp = std::memcmp(left.data() + sizeof(uint16_t), right.data() + sizeof(uint16_t),
+                          std::min(leftSize, rightSize));
+    if (cmp != 0) {
+        return cmp;
+    }
+    if (leftSize < rightSize) {
+        return -1;
+    }
+    return (leftSize == rightSize || prefixOnly) ? 0 : 1;
+}
+
+// 比较两个索引项：先比较键，键相同时比较行号
+int compareEntries(std::string_view left, std::string_view right) {
+    size_t leftKeySize = left.size() - sizeof(uint64_t);
+    size_t rightKeySize = right.size() - sizeof(uint64_t);
+    int cmp = compareKeys(left.substr(0, leftKeySize), right.substr(0, rightKeySize));
+    if (cmp != 0) {
+        return cmp;
+    }
+    uint64_t leftRowId = entryRowId(left);
+    uint64_t rightRowId = entryRowId(right);
+    return leftRowId < rightRowId ? -1 : (leftRowId > rightRowId ? 1 : 0);
+}
+
+// B+树节点页：页头之后是单元偏移数组，单元数据从页尾向前增长
+//
+// 叶子单元：索引项（键 + 8字节行号）+ 包含列；内部节点单元：索引项 + 4字节子节点页号，
+// 子节点中的项都不小于该单元的项，小于第一个项的在firstChild中
+class BTreeNode {
+public:
+    struct Header {
+        uint8_t isLeaf;
+        uint8_t reserved;
+        uint16_t count;       // 单元数
+        uint16_t freeEnd;     // 单元数据区的起始偏移
+        uint16_t reserved2;
+        uint32_t next;        // 叶子：右兄弟页号，0表示没有
+        uint32_t firstChild;  // 内部节点：最左边的子节点页号
+    };
+    
+    explicit BTreeNode(char* data) : data_(data) {}
+    
+    void init(bool isLeaf) {
+        std::memset(data_, 0, kPageSize);
+        header()->isLeaf = isLeaf ? 1 : 0;
+        header()->freeEnd = static_cast<uint16_t>(kPageSize);
+    }
+    
+    bool isLeaf() const { return header()->isLeaf != 0; }
+    size_t count() const { return header()->count; }
+    uint32_t getNext() const { return header()->next; }
+    void setNext(uint32_t pageId) { header()->next = pageId; }
+    uint32_t getFirstChild() const { return header()->firstChild; }
+    void setFirstChild(uint32_t pageId) { header()->firstChild = pageId; }
+    
+    // 单元
+    std::string_view cell(size_t i) const {
+        const char* data = data_ + offsets()[i];
+        size_t size = entrySize(data);
+        return std::string_view(data, size + (isLeaf() ? includedSize(data + size) : sizeof(uint32_t)));
+    }
+    
+    // 叶子单元中的包含列
+    std::string_view included(size_t i) const {
+        const char* data = data_ + offsets()[i] + entrySize(data_ + offsets()[i]);
+        return std::string_view(data, includedSize(data));
+    }
+    
+    // 单元中的索引项
+    std::string_view entry(size_t i) const {
+        const char* data = data_ + offsets()[i];
+        return std::string_view(data, entrySize(data));
+    }
+    
+    // 单元中的键
+    std::string_view key(size_t i) const {
+        const char* data = data_ + offsets()[i];
+        return std::string_view(data, keySize(data));
+    }
+    
+    // 内部节点单元中的子节点页号
+    uint32_t child(size_t i) const {
+        uint32_t value;
+        std::string_view entry = cell(i);
+        std::memcpy(&value, entry.data() + entry.size() - sizeof(value), sizeof(value));
+        return value;
+    }
+    
+    // 第一个不小于target的单元位置
+    size_t lowerBound(std::string_view target) const {
+        size_t low = 0;
+        size_t high = count();
+        while (low < high) {
+            size_t mid = (low + high) / 2;
+            if (compareEntries(entry(mid), target) < 0) {
+                low = mid + 1;
+            } else {
+                high = mid;
+            }
+        }
+        return low;
+    }
+    
+    // 第一个大于target的单元位置
+    size_t upperBound(std::string_view target) const {
+        size_t low = 0;
+        size_t high = count();
+        while (low < high) {
+            size_t mid = (low + high) / 2;
+            if (compareEntries(entry(mid), target) <= 0) {
+                low = mid + 1;
+            } else {
+                high = mid;
+            }
+        }
+        return low;
+    }
+    
+    // 内部节点中target所在的子节点
+    uint32_t childFor(std::string_view target) const {
+        size_t pos = upperBound(target);
+        return pos == 0 ? getFirstChild() : child(pos - 1);
+    }
+    
+    // 在pos处插入单元，空间不足时返回false且不修改节点
+    bool insert(size_t pos, std::string_view entry) {
+        // 连续空间不够时，算上已删除单元的空间仍不够才返回false
+        size_t directoryEnd = sizeof(Header) + (count() + 1) * sizeof(uint16_t);
+        if (header()->freeEnd < directoryEnd + entry.size()) {
+            if (directoryEnd + usedSpace() + entry.size() > kPageSize) {
+                return false;
+            }
+            compact();
+        }
+        
+        uint16_t offset = static_cast<uint16_t>(header()->freeEnd - entry.size());
+        std::memcpy(data_ + offset, entry.data(), entry.size());
+        header()->freeEnd = offset;
+        
+        uint16_t* slots = offsets();
+        std::memmove(slots + pos + 1, slots + pos, (count() - pos) * sizeof(uint16_t));
+        slots[pos] = offset;
+        ++header()->count;
+        return true;
+    }
+    
+    // 删除pos处的单元，空间在整理时回收
+    void erase(size_t pos) {
+        uint16_t* slots = offsets();
+        std::memmove(slots + pos, slots + pos + 1, (count() - pos - 1) * sizeof(uint16_t));
+        --header()->count;
+    }
+
+private:
+    char* data_;
+    
+    Header* header() { return reinterpret_cast<Header*>(data_); }
+    const Header* header() const { return reinterpret_cast<const Header*>(data_); }
+    uint16_t* offsets() { return reinterpret_cast<uint16_t*>(data_ + sizeof(Header)); }
+    const uint16_t* offsets() const { return reinterpret_cast<const uint16_t*>(data_ + sizeof(Header)); }
+    
+    // 所有单元占用的字节数
+    size_t usedSpace() const {
+        size_t used = 0;
+        for (size_t i = 0; i < count(); ++i) {
+            used += cell(i).size();
+        }
+        return used;
+    }
+    
+    // 整理单元数据区，回收已删除单元的空间
+    void compact() {
+        std::vector<std::string> cells;
+        cells.reserve(count());
+        for (size_t i = 0; i < count(); ++i) {
+            cells.emplace_back(cell(i));
+        }
+        
+        uint16_t freeEnd = static_cast<uint16_t>(kPageSize);
+        for (size_t i = 0; i < cells.size(); ++i) {
+            freeEnd = static_cast<uint16_t>(freeEnd - cells[i].size());
+            std::memcpy(data_ + freeEnd, cells[i].data(), cells[i].size());
+            offsets()[i] = freeEnd;
+        }
+        header()->freeEnd = freeEnd;
+    }
+};
+
+// 用一组单元重新填充节点
+void fillNode(BTreeNode& node, bool isLeaf, const std::vector<std::string>& cells, size_t begin, size_t end) {
+    node.init(isLeaf);
+    for (size_t i = begin; i < end; ++i) {
+        node.insert(i - begin, cells[i]);
+    }
+}
+
+} // namespace
+
+std::string encodeIndexKey(const IndexKey& key) {
+    std::string bytes;
+    bytes.reserve(encodedKeySize(key));
+    for (const auto& value : key) {
+        if (std::holds_alternative<int>(value)) {
+            // 翻转符号位后负数排在正数之前，大端序使按字节比较等于按数值比较
+            uint32_t bits = static_cast<uint32_t>(std::get<int>(value)) ^ 0x80000000U;
+            bytes.push_back(static_cast<char>(kIntKeyTag));
+            for (int shift = 24; shift >= 0; shift -= 8) {
+                bytes.push_back(static_cast<char>((bits >> shift) & 0xFF));
+            }
+        } else {
+            // 0字节转义后，结束符0x00 0x00比任何后续内容都小，较短的字符串排在前面
+            bytes.push_back(static_cast<char>(kStringKeyTag));
+            for (char c : std::get<std::string>(value)) {
+                bytes.push_back(c);
+                if (c == '\0') {
+                    bytes.push_back(static_cast<char>(kStringEscape));
+                }
+            }
+            bytes.push_back('\0');
+            bytes.push_back('\0');
+        }
+    }
+    return bytes;
+}
+
+IndexKey decodeIndexKey(std::string_view bytes) {
+    IndexKey key;
+    size_t offset = 0;
+    while (offset < bytes.size()) {
+        uint8_t tag = static_cast<uint8_t>(bytes[offset++]);
+        if (tag == kIntKeyTag) {
+            uint32_t bits = 0;
+            for (size_t i = 0; i < sizeof(bits); ++i) {
+                bits = (bits << 8) | static_cast<uint8_t>(bytes[offset++]);
+            }
+            key.emplace_back(std::in_place_type<int>, static_cast<int32_t>(bits ^ 0x80000000U));
+        } else {
+            std::string value;
+            while (offset + 1 < bytes.size() && !(bytes[offset] == '\0' && bytes[offset + 1] == '\0')) {
+                value.push_back(bytes[offset]);
+                offset += bytes[offset] == '\0' ? 2 : 1;
+            }
+            offset += 2;
+            key.emplace_back(std::move(value));
+        }
+    }
+    return key;
+}
+
+size_t encodedKeySize(const IndexKey& key) {
+    size_t size = 0;
+    for (const auto& value : key) {
+        if (std::holds_alternative<int>(value)) {
+            size += 1 + sizeof(int32_t);
+        } else {
+            const std::string& stringValue = std::get<std::string>(value);
+            size += 1 + stringValue.size() + std::count(stringValue.begin(), stringValue.end(), '\0') + 2;
+        }
+    }
+    return size;
+}
+
+BTreeIndex::BTreeIndex(const std::filesystem::path& indexPath) : file_(indexPath) {
+}
+
+bool BTreeIndex::insert(const IndexKey& key, size_t rowId, const Record& included) {
     try {
-        // 简化实现，使用map代替B树
-        indexMap_[key] = rowId;
+        if (!open_ || !supportsKey(key, included) || !markModified()) {
+            return false;
+        }
+        
+        std::string entry = makeEntry(encodeKey(key), rowId);
+        std::vector<uint32_t> path;
+        uint32_t leafId = findLeaf(entry, &path);
+        
+        // 同一个键可以对应多行，键和行号都相同的项已存在时不再插入
+        size_t pos;
+        {
+            PageGuard guard;
+            const char* data = BufferPool::getInstance().readPage(file_, leafId, guard);
+            if (!data) {
+                return false;
+            }
+            BTreeNode leaf(const_cast<char*>(data));
+            pos = leaf.lowerBound(entry);
+            if (pos < leaf.count() && compareEntries(leaf.entry(pos), entry) == 0) {
+                return true;
+            }
+        }
+        
+        if (!insertCell(leafId, pos, entry + encodeIncluded(included), path)) {
+            return false;
+        }
+        ++entryCount_;
         return true;
     } catch (const std::exception& e) {
         std::cerr << "插入索引失败: " << e.what() << std::endl;
@@ -14,98 +402,296 @@ bool BTreeIndex::insert(const Value& key, size_t rowId) {
     }
 }
 
-bool BTreeIndex::remove(const Value& key) {
+bool BTreeIndex::remove(const IndexKey& key, size_t rowId) {
     try {
-        // 从索引中删除键
-        auto it = indexMap_.find(key);
-        if (it != indexMap_.end()) {
-            indexMap_.erase(it);
-            return true;
+        if (!open_ || !supportsKey(key, {})) {
+            return false;
         }
-        return false;
+        
+        std::string entry = makeEntry(encodeKey(key), rowId);
+        uint32_t leafId = findLeaf(entry, nullptr);
+        
+        // 先只读查找，索引项不存在时不修改索引
+        {
+            PageGuard guard;
+            const char* data = BufferPool::getInstance().readPage(file_, leafId, guard);
+            if (!data) {
+                return false;
+            }
+            BTreeNode leaf(const_cast<char*>(data));
+            size_t pos = leaf.lowerBound(entry);
+            if (pos >= leaf.count() || compareEntries(leaf.entry(pos), entry) != 0) {
+                return false;
+            }
+        }
+        
+        if (!markModified()) {
+            return false;
+        }
+        PageGuard guard = BufferPool::getInstance().fetchPage(file_, leafId);
+        if (!guard) {
+            return false;
+        }
+        
+        // 不合并节点：删除后变空的叶子仍留在链表中，扫描时跳过
+        BTreeNode leaf(guard.data());
+        leaf.erase(leaf.lowerBound(entry));
+        guard.markDirty();
+        --entryCount_;
+        return true;
     } catch (const std::exception& e) {
         std::cerr << "删除索引失败: " << e.what() << std::endl;
         return false;
     }
 }
 
-std::vector<size_t> BTreeIndex::find(const Value& key, Operator op) {
+std::vector<size_t> BTreeIndex::find(const IndexKey& key, Operator op) {
     try {
         std::vector<size_t> result;
-        
-        switch (op) {
-            case Operator::EQUAL: {
-                // 查找等于key的记录
-                auto it = indexMap_.find(key);
-                if (it != indexMap_.end()) {
-                    result.push_back(it->second);
+        lookup(key, op, nullptr, Operator::LESS_EQUAL, [&](std::string_view, size_t rowId, std::string_view) {
+            result.push_back(rowId);
+            return true;
+        });
+        return result;
+    } catch (const std::exception& e) {
+        std::cerr << "查找索引失败: " << e.what() << std::endl;
+        return {};
+    }
+}
+
+bool BTreeIndex::scan(const IndexKey& key, Operator op, const IndexEntryVisitor& visitor) {
+    try {
+        // 键和包含列直接从叶子中解码，不访问表文件
+        lookup(key, op, nullptr, Operator::LESS_EQUAL,
+               [&](std::string_view entryKey, size_t rowId, std::string_view included) {
+            return visitor(rowId, decodeIndexKey(entryKey.substr(sizeof(uint16_t))),
+                           decodeIndexKey(included.substr(sizeof(uint16_t))));
+        });
+        return true;
+    } catch (const std::exception& e) {
+        std::cerr << "查找索引失败: " << e.what() << std::endl;
+        return false;
+    }
+}
+
+std::vector<size_t> BTreeIndex::findRange(const IndexKey& lower, Operator lowerOp,
+                                          const IndexKey& upper, Operator upperOp) {
+    try {
+        std::vector<size_t> result;
+        lookup(lower, lowerOp, &upper, upperOp, [&](std::string_view, size_t rowId, std::string_view) {
+            result.push_back(rowId);
+            return true;
+        });
+        return result;
+    } catch (const std::exception& e) {
+        std::cerr << "查找索引失败: " << e.what() << std::endl;
+        return {};
+    }
+}
+
+bool BTreeIndex::scanRange(const IndexKey& lower, Operator lowerOp, const IndexKey& upper, Operator upperOp,
+                           const IndexEntryVisitor& visitor) {
+    try {
+        lookup(lower, lowerOp, &upper, upperOp,
+               [&](std::string_view entryKey, size_t rowId, std::string_view included) {
+            return visitor(rowId, decodeIndexKey(entryKey.substr(sizeof(uint16_t))),
+                           decodeIndexKey(included.substr(sizeof(uint16_t))));
+        });
+        return true;
+    } catch (const std::exception& e) {
+        std::cerr << "查找索引失败: " << e.what() << std::endl;
+        return false;
+    }
+}
+
+bool BTreeIndex::scanOrdered(bool descending, const std::function<bool(size_t rowId)>& visitor) {
+    try {
+        if (!open_) {
+            return true;
+        }
+        if (descending) {
+            scanReverse(rootPage_, visitor);
+        } else {
+            scanLeaves(leftmostLeaf(), 0, [&](std::string_view, size_t rowId, std::string_view) {
+                return visitor(rowId);
+            });
+        }
+        return true;
+    } catch (const std::exception& e) {
+        std::cerr << "扫描索引失败: " << e.what() << std::endl;
+        return false;
+    }
+}
+
+bool BTreeIndex::supportsKey(const IndexKey& key, const Record& included) const {
+    return sizeof(uint16_t) + encodedKeySize(key) + sizeof(uint16_t) + encodedKeySize(included) <= kMaxKeySize;
+}
+
+void BTreeIndex::lookup(const IndexKey& key, Operator op, const IndexKey* upper, Operator upperOp,
+                        const std::function<bool(std::string_view key, size_t rowId,
+                                                 std::string_view included)>& visitor) {
+    if (!open_ || !supportsKey(key, {}) || (upper && !supportsKey(*upper, {}))) {
+        return;
+    }
+    
+    // 前缀不超过上界（没有上界时总是成立）
+    std::string keyBytes = encodeKey(key);
+    std::string upperBytes = upper ? encodeKey(*upper) : std::string();
+    auto belowUpper = [&](std::string_view entryKey) {
+        if (!upper) {
+            return true;
+        }
+        int cmp = compareKeys(entryKey, upperBytes, true);
+        return cmp < 0 || (cmp == 0 && upperOp == Operator::LESS_EQUAL);
+    };
+    
+    switch (op) {
+        case Operator::EQUAL: {
+            // 下降到以key开头的第一项，扫描到前缀不相等为止
+            auto [leafId, pos] = seek(makeEntry(keyBytes, 0));
+            scanLeaves(leafId, pos, [&](std::string_view entryKey, size_t rowId, std::string_view included) {
+                if (compareKeys(entryKey, keyBytes, true) != 0 || !belowUpper(entryKey)) {
+                    return false;
                 }
-                break;
-            }
-            case Operator::LESS_THAN: {
-                // 查找小于key的记录
-                for (auto it = indexMap_.begin(); it != indexMap_.end(); ++it) {
-                    if (compareValues(it->first, key, Operator::LESS_THAN)) {
-                        result.push_back(it->second);
-                    }
+                return visitor(entryKey, rowId, included);
+            });
+            break;
+        }
+        case Operator::LESS_THAN:
+        case Operator::LESS_EQUAL: {
+            // 从最左边的叶子开始扫描，遇到前缀不满足条件的键时停止
+            bool inclusive = op == Operator::LESS_EQUAL;
+            scanLeaves(leftmostLeaf(), 0, [&](std::string_view entryKey, size_t rowId, std::string_view included) {
+                int cmp = compareKeys(entryKey, keyBytes, true);
+                if (cmp > 0 || (cmp == 0 && !inclusive) || !belowUpper(entryKey)) {
+                    return false;
                 }
-                break;
-            }
-            case Operator::GREATER_THAN: {
-                // 查找大于key的记录
-                for (auto it = indexMap_.begin(); it != indexMap_.end(); ++it) {
-                    if (compareValues(it->first, key, Operator::GREATER_THAN)) {
-                        result.push_back(it->second);
-                    }
+                return visitor(entryKey, rowId, included);
+            });
+            break;
+        }
+        case Operator::GREATER_THAN:
+        case Operator::GREATER_EQUAL: {
+            // 下降到前缀大于（或等于）key的第一项，扫描到上界或最后
+            std::string start = op == Operator::GREATER_THAN ? encodeKeyAfter(key) : keyBytes;
+            auto [leafId, pos] = seek(makeEntry(start, 0));
+            scanLeaves(leafId, pos, [&](std::string_view entryKey, size_t rowId, std::string_view included) {
+                if (!belowUpper(entryKey)) {
+                    return false;
                 }
-                break;
-            }
+                return visitor(entryKey, rowId, included);
+            });
+            break;
+        }
+        case Operator::NOT_EQUAL:
+            // 不等于条件不能用索引查找
+            break;
+    }
+}
+
+bool BTreeIndex::clear() {
+    try {
+        if (!file_.truncate()) {
+            return false;
         }
         
-        return result;
+        // 第0页为元数据页，第1页为空的根叶子
+        file_.allocatePage();
+        rootPage_ = file_.allocatePage();
+        PageGuard guard = BufferPool::getInstance().fetchPage(file_, rootPage_);
+        if (!guard) {
+            return false;
+        }
+        BTreeNode(guard.data()).init(true);
+        guard.markDirty();
+        
+        entryCount_ = 0;
+        open_ = true;
+        modified_ = true;
+        return writeMeta(false);
     } catch (const std::exception& e) {
-        std::cerr << "查找索引失败: " << e.what() << std::endl;
-        return {};
+        std::cerr << "清空索引失败: " << e.what() << std::endl;
+        return false;
     }
 }
 
-bool BTreeIndex::save(const std::filesystem::path& indexPath) const {
+bool BTreeIndex::build(std::vector<IndexBuildEntry>& entries) {
     try {
-        // 打开索引文件
-        std::ofstream indexFile(indexPath, std::ios::binary | std::ios::trunc);
-        if (!indexFile.is_open()) {
+        if (!clear()) {
             return false;
         }
         
-        // 写入索引项数量
-        size_t indexCount = indexMap_.size();
-        indexFile.write(reinterpret_cast<const char*>(&indexCount), sizeof(indexCount));
+        // 把所有叶子单元编码到一块连续内存中，放不下的键与insert一样跳过
+        std::string arena;
+        std::vector<std::pair<size_t, size_t>> ranges;
+        ranges.reserve(entries.size());
+        for (const auto& entry : entries) {
+            if (!supportsKey(entry.key, entry.included)) {
+                continue;
+            }
+            size_t offset = arena.size();
+            arena += makeEntry(encodeKey(entry.key), entry.rowId);
+            arena += encodeIncluded(entry.included);
+            ranges.emplace_back(offset, arena.size() - offset);
+        }
+        
+        std::vector<std::string_view> cells;
+        cells.reserve(ranges.size());
+        for (const auto& [offset, size] : ranges) {
+            cells.emplace_back(arena.data() + offset, size);
+        }
+        // 与并行扫描一样受parallel_workers限制
+        parallelSort(cells.begin(), cells.end(), [](std::string_view left, std::string_view right) {
+            return compareEntries(left.substr(0, entrySize(left.data())),
+                                  right.substr(0, entrySize(right.data()))) < 0;
+        }, DBManager::getInstance().getParallelWorkers());
         
-        // 写入索引项
-        for (const auto& [key, rowId] : indexMap_) {
-            // 写入键类型（0表示int，1表示string）
-            bool isString = std::holds_alternative<std::string>(key);
-            indexFile.write(reinterpret_cast<const char*>(&isString), sizeof(isString));
-            
-            if (isString) {
-                // 写入字符串键
-                std::string strKey = std::get<std::string>(key);
-                size_t keyLength = strKey.length();
-                indexFile.write(reinterpret_cast<const char*>(&keyLength), sizeof(keyLength));
-                indexFile.write(strKey.c_str(), keyLength);
-            } else {
-                // 写入整数键
-                int intKey = std::get<int>(key);
-                indexFile.write(reinterpret_cast<const char*>(&intKey), sizeof(intKey));
+        // 先填满叶子，再逐层用下一层每个节点的第一项作为分隔项建立内部节点，直到只剩一个节点
+        std::vector<BuiltNode> nodes;
+        if (!buildLevel(true, cells, nodes)) {
+            return false;
+        }
+        while (nodes.size() > 1) {
+            std::vector<std::string> parentCells;
+            parentCells.reserve(nodes.size());
+            for (const auto& node : nodes) {
+                parentCells.push_back(node.firstEntry);
+                parentCells.back().append(reinterpret_cast<const char*>(&node.pageId), sizeof(node.pageId));
             }
-            
-            // 写入行ID
-            indexFile.write(reinterpret_cast<const char*>(&rowId), sizeof(rowId));
+            std::vector<std::string_view> views(parentCells.begin(), parentCells.end());
+            std::vector<BuiltNode> parents;
+            if (!buildLevel(false, views, parents)) {
+                return false;
+            }
+            nodes = std::move(parents);
         }
         
-        // 关闭文件
-        indexFile.close();
+        rootPage_ = nodes.front().pageId;
+        entryCount_ = cells.size();
+        return writeMeta(false);
+    } catch (const std::exception& e) {
+        std::cerr << "建立索引失败: " << e.what() << std::endl;
+        return false;
+    }
+}
+
+bool BTreeIndex::save() {
+    try {
+        if (!open_) {
+            return false;
+        }
+        if (!modified_) {
+            return true;
+        }
         
+        // 先写回所有节点，再把元数据页标记为已保存
+        if (!BufferPool::getInstance().flushFile(file_) || !file_.sync()) {
+            return false;
+        }
+        if (!writeMeta(true) || !BufferPool::getInstance().flushFile(file_) || !file_.sync()) {
+            return false;
+        }
+        modified_ = false;
         return true;
     } catch (const std::exception& e) {
         std::cerr << "保存索引失败: " << e.what() << std::endl;
@@ -113,64 +699,325 @@ bool BTreeIndex::save(const std::filesystem::path& indexPath) const {
     }
 }
 
-bool BTreeIndex::load(const std::filesystem::path& indexPath) {
+bool BTreeIndex::load() {
     try {
-        // 如果索引文件不存在，返回false
-        if (!std::filesystem::exists(indexPath)) {
+        if (!std::filesystem::exists(file_.getPath()) || !file_.open() || file_.getPageCount() < 2) {
             return false;
         }
         
-        // 打开索引文件
-        std::ifstream indexFile(indexPath, std::ios::binary);
-        if (!indexFile.is_open()) {
+        PageGuard guard = BufferPool::getInstance().fetchPage(file_, 0);
+        if (!guard) {
             return false;
         }
+        const char* data = guard.data();
         
-        // 清空现有索引
-        indexMap_.clear();
+        // 旧格式的索引文件没有魔数；上次修改后没有保存的索引可能不完整，都需要重建
+        uint64_t magic;
+        uint32_t version;
+        std::memcpy(&magic, data + kMagicOffset, sizeof(magic));
+        std::memcpy(&version, data + kVersionOffset, sizeof(version));
+        if (magic != kIndexFileMagic || version != kIndexFileVersion || data[kCleanOffset] == 0) {
+            return false;
+        }
         
-        // 读取索引项数量
-        size_t indexCount;
-        indexFile.read(reinterpret_cast<char*>(&indexCount), sizeof(indexCount));
+        std::memcpy(&rootPage_, data + kRootPageOffset, sizeof(rootPage_));
+        std::memcpy(&entryCount_, data + kEntryCountOffset, sizeof(entryCount_));
+        open_ = true;
+        modified_ = false;
+        return true;
+    } catch (const std::exception& e) {
+        std::cerr << "加载索引失败: " << e.what() << std::endl;
+        return false;
+    }
+}
+
+uint32_t BTreeIndex::findLeaf(std::string_view entry, std::vector<uint32_t>* path) {
+    uint32_t pageId = rootPage_;
+    while (true) {
+        PageGuard guard;
+        const char* data = BufferPool::getInstance().readPage(file_, pageId, guard);
+        if (!data) {
+            throw std::runtime_error("读取索引节点失败");
+        }
         
-        // 读取索引项
-        for (size_t i = 0; i < indexCount; ++i) {
-            // 读取键类型
-            bool isString;
-            indexFile.read(reinterpret_cast<char*>(&isString), sizeof(isString));
-            
-            Value key;
-            if (isString) {
-                // 读取字符串键
-                size_t keyLength;
-                indexFile.read(reinterpret_cast<char*>(&keyLength), sizeof(keyLength));
-                
-                std::string strKey(keyLength, '\0');
-                indexFile.read(&strKey[0], keyLength);
-                key = strKey;
-            } else {
-                // 读取整数键
-                int intKey;
-                indexFile.read(reinterpret_cast<char*>(&intKey), sizeof(intKey));
-                key = intKey;
+        BTreeNode node(const_cast<char*>(data));
+        if (node.isLeaf()) {
+            return pageId;
+        }
+        if (path) {
+            path->push_back(pageId);
+        }
+        pageId = node.childFor(entry);
+    }
+}
+
+std::pair<uint32_t, size_t> BTreeIndex::seek(std::string_view entry) {
+    uint32_t leafId = findLeaf(entry, nullptr);
+    PageGuard guard;
+    const char* data = BufferPool::getInstance().readPage(file_, leafId, guard);
+    if (!data) {
+        throw std::runtime_error("读取索引节点失败");
+    }
+    BTreeNode leaf(const_cast<char*>(data));
+    return {leafId, leaf.lowerBound(entry)};
+}
+
+uint32_t BTreeIndex::leftmostLeaf() {
+    uint32_t pageId = rootPage_;
+    while (true) {
+        PageGuard guard;
+        const char* data = BufferPool::getInstance().readPage(file_, pageId, guard);
+        if (!data) {
+            throw std::runtime_error("读取索引节点失败");
+        }
+        
+        BTreeNode node(const_cast<char*>(data));
+        if (node.isLeaf()) {
+            return pageId;
+        }
+        pageId = node.getFirstChild();
+    }
+}
+
+void BTreeIndex::scanLeaves(uint32_t pageId, size_t pos,
+                            const std::function<bool(std::string_view key, size_t rowId,
+                                                     std::string_view included)>& visitor) {
+    while (pageId != 0) {
+        PageGuard guard;
+        const char* data = BufferPool::getInstance().readPage(file_, pageId, guard);
+        if (!data) {
+            throw std::runtime_error("读取索引节点失败");
+        }
+        
+        // 起始位置可能在叶子末尾，此时从下一个叶子开始
+        BTreeNode leaf(const_cast<char*>(data));
+        for (size_t i = pos; i < leaf.count(); ++i) {
+            if (!visitor(leaf.key(i), static_cast<size_t>(entryRowId(leaf.entry(i))), leaf.included(i))) {
+                return;
             }
-            
-            // 读取行ID
-            size_t rowId;
-            indexFile.read(reinterpret_cast<char*>(&rowId), sizeof(rowId));
-            
-            // 添加到索引
-            indexMap_[key] = rowId;
+        }
+        pos = 0;
+        pageId = leaf.getNext();
+    }
+}
+
+bool BTreeIndex::scanReverse(uint32_t pageId, const std::function<bool(size_t rowId)>& visitor) {
+    // 内部节点只记下各子节点的页号，访问子树时不再占用该节点的页
+    std::vector<uint32_t> children;
+    {
+        PageGuard guard;
+        const char* data = BufferPool::getInstance().readPage(file_, pageId, guard);
+        if (!data) {
+            throw std::runtime_error("读取索引节点失败");
         }
         
-        // 关闭文件
-        indexFile.close();
+        BTreeNode node(const_cast<char*>(data));
+        if (node.isLeaf()) {
+            for (size_t i = node.count(); i > 0; --i) {
+                if (!visitor(static_cast<size_t>(entryRowId(node.entry(i - 1))))) {
+                    return false;
+                }
+            }
+            return true;
+        }
+        children.push_back(node.getFirstChild());
+        for (size_t i = 0; i < node.count(); ++i) {
+            children.push_back(node.child(i));
+        }
+    }
+    
+    for (auto it = children.rbegin(); it != children.rend(); ++it) {
+        if (!scanReverse(*it, visitor)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool BTreeIndex::insertCell(uint32_t pageId, size_t pos, std::string_view cell, std::vector<uint32_t>& path) {
+    PageGuard guard = BufferPool::getInstance().fetchPage(file_, pageId);
+    if (!guard) {
+        return false;
+    }
+    BTreeNode node(guard.data());
+    
+    // 放得下时直接插入
+    if (node.insert(pos, cell)) {
+        guard.markDirty();
+        return true;
+    }
+    
+    // 放不下时把所有单元（包括新单元）按字节数对半分到两个节点
+    bool isLeaf = node.isLeaf();
+    std::vector<std::string> cells;
+    cells.reserve(node.count() + 1);
+    size_t totalSize = 0;
+    for (size_t i = 0; i < node.count(); ++i) {
+        cells.emplace_back(node.cell(i));
+        totalSize += cells.back().size();
+    }
+    cells.insert(cells.begin() + pos, std::string(cell));
+    totalSize += cell.size();
+    
+    size_t middle = 0;
+    size_t leftSize = 0;
+    while (middle < cells.size() - 1 && leftSize + cells[middle].size() <= totalSize / 2) {
+        leftSize += cells[middle].size();
+        ++middle;
+    }
+    middle = std::max<size_t>(middle, 1);
+    
+    uint32_t rightId = file_.allocatePage();
+    PageGuard rightGuard = BufferPool::getInstance().fetchPage(file_, rightId);
+    if (!rightGuard) {
+        return false;
+    }
+    BTreeNode right(rightGuard.data());
+    
+    std::string separator;
+    if (isLeaf) {
+        // 叶子：右节点第一项的索引项（不含包含列）作为分隔项，并接入叶子链表
+        uint32_t next = node.getNext();
+        fillNode(node, true, cells, 0, middle);
+        fillNode(right, true, cells, middle, cells.size());
+        right.setNext(next);
+        node.setNext(rightId);
+        separator = cells[middle].substr(0, entrySize(cells[middle].data()));
+    } else {
+        // 内部节点：中间单元的索引项上移到父节点，它的子节点成为右节点的最左子节点
+        uint32_t firstChild = node.getFirstChild();
+        const std::string& up = cells[middle];
+        size_t upEntrySize = entrySize(up.data());
+        uint32_t upChild;
+        std::memcpy(&upChild, up.data() + upEntrySize, sizeof(upChild));
+        separator = up.substr(0, upEntrySize);
         
+        fillNode(node, false, cells, 0, middle);
+        node.setFirstChild(firstChild);
+        fillNode(right, false, cells, middle + 1, cells.size());
+        right.setFirstChild(upChild);
+    }
+    guard.markDirty();
+    rightGuard.markDirty();
+    guard.release();
+    rightGuard.release();
+    
+    std::string parentCell = separator;
+    parentCell.append(reinterpret_cast<const char*>(&rightId), sizeof(rightId));
+    
+    // 根节点分裂时新建根节点
+    if (path.empty()) {
+        uint32_t rootId = file_.allocatePage();
+        PageGuard rootGuard = BufferPool::getInstance().fetchPage(file_, rootId);
+        if (!rootGuard) {
+            return false;
+        }
+        BTreeNode root(rootGuard.data());
+        root.init(false);
+        root.setFirstChild(pageId);
+        root.insert(0, parentCell);
+        rootGuard.markDirty();
+        rootPage_ = rootId;
         return true;
-    } catch (const std::exception& e) {
-        std::cerr << "加载索引失败: " << e.what() << std::endl;
+    }
+    
+    // 把分隔项插入父节点
+    uint32_t parentId = path.back();
+    path.pop_back();
+    size_t parentPos;
+    {
+        PageGuard parentGuard;
+        const char* data = BufferPool::getInstance().readPage(file_, parentId, parentGuard);
+        if (!data) {
+            return false;
+        }
+        parentPos = BTreeNode(const_cast<char*>(data)).upperBound(separator);
+    }
+    return insertCell(parentId, parentPos, parentCell, path);
+}
+
+bool BTreeIndex::buildLevel(bool isLeaf, const std::vector<std::string_view>& cells, std::vector<BuiltNode>& nodes) {
+    // 叶子层从clear创建的空根叶子开始，内部节点都是新分配的页
+    const size_t limit = kPageSize * kBulkFillPercent / 100;
+    uint32_t pageId = isLeaf ? rootPage_ : file_.allocatePage();
+    PageGuard guard = BufferPool::getInstance().fetchPage(file_, pageId);
+    if (!guard) {
+        return false;
+    }
+    BTreeNode node(guard.data());
+    node.init(isLeaf);
+    nodes.push_back({pageId, {}});
+    size_t used = sizeof(BTreeNode::Header);
+    bool empty = true;
+    
+    for (std::string_view cell : cells) {
+        // 当前节点达到填充比例时换到新节点，叶子接入链表
+        if (!empty && used + sizeof(uint16_t) + cell.size() > limit) {
+            uint32_t nextId = file_.allocatePage();
+            if (isLeaf) {
+                node.setNext(nextId);
+            }
+            guard.markDirty();
+            guard = BufferPool::getInstance().fetchPage(file_, nextId);
+            if (!guard) {
+                return false;
+            }
+            node = BTreeNode(guard.data());
+            node.init(isLeaf);
+            nodes.push_back({nextId, {}});
+            used = sizeof(BTreeNode::Header);
+            empty = true;
+        }
+        
+        size_t cellEntrySize = entrySize(cell.data());
+        if (empty) {
+            nodes.back().firstEntry = std::string(cell.substr(0, cellEntrySize));
+            empty = false;
+            
+            // 内部节点的第一个子节点作为firstChild，它的分隔项由上一层保存
+            if (!isLeaf) {
+                uint32_t child;
+                std::memcpy(&child, cell.data() + cellEntrySize, sizeof(child));
+                node.setFirstChild(child);
+                continue;
+            }
+        }
+        node.insert(node.count(), cell);
+        used += sizeof(uint16_t) + cell.size();
+    }
+    guard.markDirty();
+    return true;
+}
+
+bool BTreeIndex::writeMeta(bool clean) {
+    PageGuard guard = BufferPool::getInstance().fetchPage(file_, 0);
+    if (!guard) {
+        return false;
+    }
+    
+    char* data = guard.data();
+    std::memset(data, 0, kPageSize);
+    std::memcpy(data + kMagicOffset, &kIndexFileMagic, sizeof(kIndexFileMagic));
+    std::memcpy(data + kVersionOffset, &kIndexFileVersion, sizeof(kIndexFileVersion));
+    std::memcpy(data + kRootPageOffset, &rootPage_, sizeof(rootPage_));
+    std::memcpy(data + kEntryCountOffset, &entryCount_, sizeof(entryCount_));
+    data[kCleanOffset] = clean ? 1 : 0;
+    guard.markDirty();
+    return true;
+}
+
+bool BTreeIndex::markModified() {
+    if (modified_) {
+        return true;
+    }
+    
+    // 元数据页先于任何节点落盘，崩溃后加载时会发现索引未保存而重建
+    modified_ = true;
+    PageGuard guard = BufferPool::getInstance().fetchPage(file_, 0);
+    if (!guard || !writeMeta(false)) {
         return false;
     }
+    return file_.writePage(0, guard.data()) && file_.sync();
 }
 
-} // namespace minidb 
\ No newline at end of file
+} // namespace minidb
@@ -0,0 +1,541 @@
+#include "../include/Join.h"
+#include "../include/Planner.h"
+#include "../include/RowFilter.h"
+#include "../include/SpillFile.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <memory>
+
+namespace minidb {
+
+namespace {
+
+// 建哈希表或探测时处理一行的代价，与计划器中处理一行的代价相同
+constexpr double kCpuHashCost = 0.01;
+
+// 分区写出到临时文件、再读回一页数据的代价
+constexpr double kSpillPageCost = 2.0;
+
+// 估计哈希表中一行时STRING列的平均长度
+constexpr double kEstimatedStringLength = 16;
+
+// 哈希表超出内存预算时分成的区数，以及最多分区的层数：每一层用不同的哈希种子重新分区，
+// 最后一层仍然超出预算时（如大量相同的连接列值）不再分区，直接在内存中连接
+constexpr size_t kSpillPartitions = 16;
+constexpr size_t kMaxSpillLevels = 3;
+
+// 比较的列位置减去offset，用于把只涉及右表的条件改写为右表中的列位置
+Predicate shiftColumns(const Predicate& where, size_t offset) {
+    if (where.getKind() == Predicate::Kind::COMPARE) {
+        return Predicate::compare(where.getColumn() - offset, where.getOp(), where.getValue());
+    }
+    std::vector<Predicate> children;
+    for (const auto& child : where.getChildren()) {
+        children.push_back(shiftColumns(child, offset));
+    }
+    return Predicate::combine(where.getKind(), std::move(children));
+}
+
+// 条件用到的列都在[begin, end)中
+bool usesOnly(const Predicate& where, size_t begin, size_t end) {
+    std::vector<size_t> columns;
+    where.collectColumns(columns);
+    return std::all_of(columns.begin(), columns.end(), [&](size_t column) {
+        return column >= begin && column < end;
+    });
+}
+
+// 把批中第i行编码为元组，列按批中的顺序，格式与encodeTuple相同
+void encodeBatchRow(const RowBatch& batch, uint16_t i, std::string& row) {
+    row.clear();
+    for (const auto& column : batch.columns) {
+        if (column.type == DataType::INT) {
+            row.append(reinterpret_cast<const char*>(&column.ints[i]), sizeof(int32_t));
+        } else {
+            uint16_t length = static_cast<uint16_t>(column.strings[i].size());
+            row.append(reinterpret_cast<const char*>(&length), sizeof(length));
+            row.append(column.strings[i]);
+        }
+    }
+}
+
+// 把一行中的若干列编码为元组
+void encodeColumns(const TupleView& tuple, const std::vector<size_t>& columns,
+                   const std::vector<ColumnDef>& defs, std::string& row) {
+    row.clear();
+    for (size_t column : columns) {
+        if (defs[column].type == DataType::INT) {
+            int32_t value = tuple.getInt(column);
+            row.append(reinterpret_cast<const char*>(&value), sizeof(value));
+        } else {
+            std::string_view value = tuple.getString(column);
+            uint16_t length = static_cast<uint16_t>(value.size());
+            row.append(reinterpret_cast<const char*>(&length), sizeof(length));
+            row.append(value);
+        }
+    }
+}
+
+// 编码后的行开头的连接列（INT为4字节，STRING为长度加内容）：相等的值编码也相同
+std::string_view rowKey(std::string_view row, DataType type) {
+    if (type == DataType::INT) {
+        return row.substr(0, sizeof(int32_t));
+    }
+    uint16_t length;
+    std::memcpy(&length, row.data(), sizeof(length));
+    return row.substr(0, sizeof(length) + length);
+}
+
+// 编码后的行开头的连接列的值
+Value keyValue(std::string_view row, DataType type) {
+    if (type == DataType::INT) {
+        int32_t value;
+        std::memcpy(&value, row.data(), sizeof(value));
+        return value;
+    }
+    uint16_t length;
+    std::memcpy(&length, row.data(), sizeof(length));
+    return std::string(row.substr(sizeof(length), length));
+}
+
+// 连接列的哈希值：每一层分区使用不同的种子，低位用于哈希表的桶，高位用于分区
+uint64_t hashKey(std::string_view key, size_t level) {
+    uint64_t hash = std::hash<std::string_view>()(key) ^ (level * 0x9E3779B97F4A7C15ULL);
+    hash ^= hash >> 33;
+    hash *= 0xFF51AFD7ED558CCDULL;
+    hash ^= hash >> 33;
+    return hash;
+}
+
+size_t partitionOf(uint64_t hash) {
+    return static_cast<size_t>(hash >> 60) % kSpillPartitions;
+}
+
+// 逐行产生连接一侧编码后的行，行在下一次调用next之前有效
+class RowSource {
+public:
+    virtual ~RowSource() = default;
+    virtual bool next(std::string_view& row) = 0;
+};
+
+// 从表的批中读取
+class BatchSource : public RowSource {
+public:
+    explicit BatchSource(std::unique_ptr<BatchOperator> input) : input_(std::move(input)) {}
+    
+    bool next(std::string_view& row) override {
+        while (position_ >= batch_.selection.size()) {
+            if (!input_->next(batch_)) {
+                return false;
+            }
+            position_ = 0;
+        }
+        encodeBatchRow(batch_, batch_.selection[position_++], row_);
+        row = row_;
+        return true;
+    }
+
+private:
+    std::unique_ptr<BatchOperator> input_;
+    RowBatch batch_;
+    size_t position_ = 0;
+    std::string row_;
+};
+
+// 从临时文件中读取
+class SpillSource : public RowSource {
+public:
+    explicit SpillSource(SpillFile& file) : file_(file) { file_.rewind(); }
+    
+    bool next(std::string_view& row) override {
+        if (!file_.next(row_)) {
+            return false;
+        }
+        row = row_;
+        return true;
+    }
+
+private:
+    SpillFile& file_;
+    std::string row_;
+};
+
+// 连接用的哈希表：行依次追加到一块连续的缓冲区中，索引项保存哈希值和行的位置，
+// 全部插入后再按哈希值的低位链接到桶中，探测时先比较哈希值再比较连接列的编码
+class JoinHashTable {
+public:
+    explicit JoinHashTable(DataType keyType) : keyType_(keyType) {}
+    
+    void insert(std::string_view row, uint64_t hash) {
+        entries_.push_back({hash, rows_.size(), static_cast<uint32_t>(row.size()), kNoEntry});
+        rows_.append(row);
+    }
+    
+    // 占用的内存（字节）
+    size_t memoryUsage() const { return rows_.size() + entries_.size() * sizeof(Entry); }
+    
+    // 建立桶：每个桶中的项按插入的顺序排列
+    void build() {
+        size_t bucketCount = 1;
+        while (bucketCount < entries_.size() * 2) {
+            bucketCount <<= 1;
+        }
+        mask_ = bucketCount - 1;
+        buckets_.assign(bucketCount, kNoEntry);
+        for (size_t i = entries_.size(); i-- > 0;) {
+            uint32_t& head = buckets_[entries_[i].hash & mask_];
+            entries_[i].next = head;
+            head = static_cast<uint32_t>(i);
+        }
+    }
+    
+    // 对连接列等于key的每一行调用fn(row)，fn返回false时停止并返回false
+    template <typename Fn>
+    bool probe(std::string_view key, uint64_t hash, Fn&& fn) const {
+        for (uint32_t i = buckets_[hash & mask_]; i != kNoEntry; i = entries_[i].next) {
+            const Entry& entry = entries_[i];
+            if (entry.hash != hash) {
+                continue;
+            }
+            std::string_view row(rows_.data() + entry.offset, entry.length);
+            if (rowKey(row, keyType_) == key && !fn(row)) {
+                return false;
+            }
+        }
+        return true;
+    }
+    
+    // 按插入的顺序访问每一行及其哈希值
+    template <typename Fn>
+    void forEach(Fn&& fn) const {
+        for (const auto& entry : entries_) {
+            fn(std::string_view(rows_.data() + entry.offset, entry.length), entry.hash);
+        }
+    }
+    
+    // 清空，释放占用的内存
+    void clear() {
+        std::string().swap(rows_);
+        std::vector<Entry>().swap(entries_);
+        std::vector<uint32_t>().swap(buckets_);
+    }
+
+private:
+    static constexpr uint32_t kNoEntry = UINT32_MAX;
+    
+    struct Entry {
+        uint64_t hash;
+        size_t offset;
+        uint32_t length;
+        uint32_t next;
+    };
+    
+    DataType keyType_;
+    std::string rows_;
+    std::vector<Entry> entries_;
+    std::vector<uint32_t> buckets_;
+    uint64_t mask_ = 0;
+};
+
+// 一次连接的执行状态：把两侧编码后的行拼成连接后的一行，判断其余条件，投影出输出列
+class JoinRun {
+public:
+    JoinRun(const JoinSide (&sides)[2], size_t rightOffset, const Predicate& residual,
+            const std::vector<size_t>& output, size_t memoryBudget, std::optional<size_t> limit)
+        : sides_(sides), rightOffset_(rightOffset), residual_(residual), output_(output),
+          memoryBudget_(memoryBudget), limit_(limit) {
+        for (size_t side = 0; side < 2; ++side) {
+            const auto& columns = sides[side].table->getColumns();
+            for (size_t column : sides[side].needed) {
+                defs_[side].push_back(columns[column]);
+            }
+        }
+        keyType_ = defs_[0].front().type;
+        row_.resize(rightOffset + sides[1].table->getColumns().size());
+    }
+    
+    // 哈希连接：build一侧建哈希表，逐行用probe一侧探测；返回false表示已取够行数
+    bool hashJoin(RowSource& build, RowSource& probe, size_t buildSide, size_t level) {
+        JoinHashTable table(keyType_);
+        std::string_view row;
+        while (build.next(row)) {
+            table.insert(row, hashKey(rowKey(row, keyType_), level));
+            if (table.memoryUsage() > memoryBudget_ && level < kMaxSpillLevels) {
+                return partitionedJoin(table, build, probe, buildSide, level);
+            }
+        }
+        table.build();
+        
+        while (probe.next(row)) {
+            std::string_view key = rowKey(row, keyType_);
+            bool more = table.probe(key, hashKey(key, level), [&](std::string_view match) {
+                return buildSide == 0 ? emit(match, row) : emit(row, match);
+            });
+            if (!more) {
+                return false;
+            }
+        }
+        return true;
+    }
+    
+    // 索引嵌套循环连接：逐行用外侧的连接列值查找内侧的索引，内侧的行先判断下推的条件
+    bool indexJoin(RowSource& outer, size_t innerSide, size_t index) {
+        const JoinSide& inner = sides_[innerSide];
+        const auto& columns = inner.table->getColumns();
+        RowFilter filter = RowFilter::compile(inner.where, columns);
+        std::string innerRow;
+        std::string_view row;
+        bool more = true;
+        while (more && outer.next(row)) {
+            inner.table->lookupEqual(index, keyValue(row, keyType_), [&](const TupleView& tuple) {
+                if (!more || !filter(tuple)) {
+                    return;
+                }
+                encodeColumns(tuple, inner.needed, columns, innerRow);
+                more = innerSide == 0 ? emit(innerRow, row) : emit(row, innerRow);
+            });
+        }
+        return more;
+    }
+    
+    std::vector<Record>& result() { return result_; }
+
+private:
+    const JoinSide (&sides_)[2];
+    size_t rightOffset_;
+    const Predicate& residual_;
+    const std::vector<size_t>& output_;
+    size_t memoryBudget_;
+    std::optional<size_t> limit_;
+    std::vector<ColumnDef> defs_[2];
+    DataType keyType_ = DataType::INT;
+    Record row_;
+    std::vector<Record> result_;
+    
+    // 哈希表超出内存预算：表中已有的行和build中其余的行按哈希值的高位写入各分区的临时文件，
+    // probe一侧的行同样分区，再逐个分区连接（下一层使用新的哈希种子）
+    bool partitionedJoin(JoinHashTable& table, RowSource& build, RowSource& probe, size_t buildSide,
+                         size_t level) {
+        std::vector<std::unique_ptr<SpillFile>> buildParts;
+        std::vector<std::unique_ptr<SpillFile>> probeParts;
+        for (size_t i = 0; i < kSpillPartitions; ++i) {
+            buildParts.push_back(std::make_unique<SpillFile>());
+            probeParts.push_back(std::make_unique<SpillFile>());
+        }
+        
+        table.forEach([&](std::string_view row, uint64_t hash) {
+            buildParts[partitionOf(hash)]->append(row);
+        });
+        table.clear();
+        std::string_view row;
+        while (build.next(row)) {
+            buildParts[partitionOf(hashKey(rowKey(row, keyType_), level))]->append(row);
+        }
+        while (probe.next(row)) {
+            probeParts[partitionOf(hashKey(rowKey(row, keyType_), level))]->append(row);
+        }
+        
+        for (size_t i = 0; i < kSpillPartitions; ++i) {
+            if (buildParts[i]->getRowCount() == 0 || probeParts[i]->getRowCount() == 0) {
+                continue;
+            }
+            SpillSource buildRows(*buildParts[i]);
+            SpillSource probeRows(*probeParts[i]);
+            if (!hashJoin(buildRows, probeRows, buildSide, level + 1)) {
+                return false;
+            }
+            buildParts[i].reset();
+            probeParts[i].reset();
+        }
+        return true;
+    }
+    
+    // 输出左右两侧的一对行；返回false表示已取够行数
+    bool emit(std::string_view left, std::string_view right) {
+        Record values[2] = {decodeTuple(left, defs_[0]), decodeTuple(right, defs_[1])};
+        for (size_t side = 0; side < 2; ++side) {
+            size_t offset = side == 0 ? 0 : rightOffset_;
+            for (size_t i = 0; i < values[side].size(); ++i) {
+                row_[offset + sides_[side].needed[i]] = std::move(values[side][i]);
+            }
+        }
+        if (residual_.getKind() != Predicate::Kind::NONE && !residual_.matches(row_)) {
+            return true;
+        }
+        
+        Record projected;
+        projected.reserve(output_.size());
+        for (size_t column : output_) {
+            projected.push_back(row_[column]);
+        }
+        result_.push_back(std::move(projected));
+        return !limit_ || result_.size() < *limit_;
+    }
+};
+
+} // namespace
+
+JoinExecutor::JoinExecutor(Table& left, size_t leftKey, Table& right, size_t rightKey, const Predicate& where,
+                           const std::vector<size_t>& output)
+    : output_(output), rightOffset_(left.getColumns().size()) {
+    sides_[0].table = &left;
+    sides_[0].key = leftKey;
+    sides_[1].table = &right;
+    sides_[1].key = rightKey;
+    size_t columnCount = rightOffset_ + right.getColumns().size();
+    size_t keys[2] = {leftKey, rightOffset_ + rightKey};
+    
+    // 按合取项拆分条件：只涉及一侧的下推到该侧，连接列上的比较同时加到另一侧的连接列上
+    std::vector<Predicate> conjuncts;
+    if (where.getKind() == Predicate::Kind::AND) {
+        conjuncts = where.getChildren();
+    } else if (where.getKind() != Predicate::Kind::NONE) {
+        conjuncts.push_back(where);
+    }
+    std::vector<Predicate> pushed[2];
+    std::vector<Predicate> residual;
+    for (const auto& conjunct : conjuncts) {
+        size_t side;
+        if (usesOnly(conjunct, 0, rightOffset_)) {
+            side = 0;
+        } else if (usesOnly(conjunct, rightOffset_, columnCount)) {
+            side = 1;
+        } else {
+            residual.push_back(conjunct);
+            continue;
+        }
+        pushed[side].push_back(side == 0 ? conjunct : shiftColumns(conjunct, rightOffset_));
+        if (conjunct.getKind() == Predicate::Kind::COMPARE && conjunct.getColumn() == keys[side]) {
+            pushed[1 - side].push_back(Predicate::compare(sides_[1 - side].key, conjunct.getOp(), conjunct.getValue()));
+        }
+    }
+    residual_ = Predicate::combine(Predicate::Kind::AND, std::move(residual));
+    
+    // 每一侧需要取出的列：连接列、输出列和连接后判断的条件中用到的列，按连接后的位置去重
+    std::vector<size_t> used = output;
+    residual_.collectColumns(used);
+    for (size_t side = 0; side < 2; ++side) {
+        JoinSide& entry = sides_[side];
+        entry.where = Predicate::combine(Predicate::Kind::AND, std::move(pushed[side]));
+        entry.where.reorder(entry.table->getStats());
+        entry.needed.push_back(entry.key);
+        size_t begin = side == 0 ? 0 : rightOffset_;
+        size_t end = side == 0 ? rightOffset_ : columnCount;
+        for (size_t column : used) {
+            if (column >= begin && column < end &&
+                std::find(entry.needed.begin(), entry.needed.end(), column - begin) == entry.needed.end()) {
+                entry.needed.push_back(column - begin);
+            }
+        }
+    }
+}
+
+double JoinExecutor::rowBytes(size_t side) const {
+    const auto& columns = sides_[side].table->getColumns();
+    double bytes = 32;
+    for (size_t column : sides_[side].needed) {
+        bytes += columns[column].type == DataType::INT ? sizeof(int32_t) : sizeof(uint16_t) + kEstimatedStringLength;
+    }
+    return bytes;
+}
+
+std::vector<JoinPlan> JoinExecutor::candidatePlans(size_t memoryBudget) {
+    double rows[2];
+    double distinct[2];
+    for (size_t side = 0; side < 2; ++side) {
+        JoinSide& entry = sides_[side];
+        // 连接的两侧按批读取表中的行，不使用只读索引的路径（全表扫描总是可用）
+        for (const auto& path : Planner::candidatePaths(*entry.table, entry.where, entry.needed)) {
+            if (!path.covering) {
+                entry.path = path;
+                break;
+            }
+        }
+        rows[side] = entry.path.rows;
+        distinct[side] = std::max(1.0, std::min(entry.table->getStats().getColumn(entry.key).distinct, rows[side]));
+    }
+    
+    // 连接列的值在不同值较少的一侧中都能找到：结果行数 = 两侧行数之积 / 较多的不同值个数
+    double joinRows = rows[0] * rows[1] / std::max(distinct[0], distinct[1]);
+    std::vector<JoinPlan> plans;
+    
+    // 哈希连接：两侧各读取一次，在估计行数较少的一侧上建哈希表；超出内存预算时两侧的行都要写出再读回
+    JoinPlan hash;
+    hash.method = JoinMethod::HASH;
+    hash.inner = rows[0] < rows[1] ? 0 : 1;
+    hash.rows = joinRows;
+    hash.cost = sides_[0].path.cost + sides_[1].path.cost + (rows[0] + rows[1]) * kCpuHashCost;
+    double buildBytes = rows[hash.inner] * rowBytes(hash.inner);
+    if (buildBytes > static_cast<double>(memoryBudget)) {
+        hash.spill = true;
+        double probeBytes = rows[1 - hash.inner] * rowBytes(1 - hash.inner);
+        hash.cost += (buildBytes + probeBytes) / kPageSize * kSpillPageCost;
+    }
+    plans.push_back(hash);
+    
+    // 索引嵌套循环连接：外侧读取一次，每一行在内侧连接列上的索引中查找一次并回表读取匹配的行
+    for (size_t inner = 0; inner < 2; ++inner) {
+        const JoinSide& entry = sides_[inner];
+        Table& table = *entry.table;
+        double matches = static_cast<double>(table.getRowCount()) /
+                         std::max(1.0, table.getStats().getColumn(entry.key).distinct);
+        for (size_t i = 0; i < table.getIndexCount(); ++i) {
+            if (table.getIndexDef(i).columns.front() != entry.key || !table.supportsLookup(i, 1, Operator::EQUAL)) {
+                continue;
+            }
+            JoinPlan plan;
+            plan.method = JoinMethod::INDEX_NESTED_LOOP;
+            plan.inner = inner;
+            plan.index = i;
+            plan.rows = joinRows;
+            plan.cost = sides_[1 - inner].path.cost + rows[1 - inner] * Planner::probeCost(table, i, matches);
+            plans.push_back(plan);
+        }
+    }
+    
+    // 代价相同时哈希连接优先
+    std::stable_sort(plans.begin(), plans.end(), [](const JoinPlan& a, const JoinPlan& b) {
+        return a.cost < b.cost;
+    });
+    return plans;
+}
+
+std::vector<Record> JoinExecutor::execute(const JoinPlan& plan, size_t memoryBudget,
+                                          std::optional<size_t> limit) {
+    try {
+        if (limit == size_t{0}) {
+            return {};
+        }
+        JoinRun run(sides_, rightOffset_, residual_, output_, memoryBudget, limit);
+        const JoinSide& outer = sides_[1 - plan.inner];
+        BatchSource outerRows(outer.table->selectBatches(outer.where, outer.needed, outer.path));
+        if (plan.method == JoinMethod::INDEX_NESTED_LOOP) {
+            run.indexJoin(outerRows, plan.inner, plan.index);
+        } else {
+            const JoinSide& inner = sides_[plan.inner];
+            BatchSource innerRows(inner.table->selectBatches(inner.where, inner.needed, inner.path));
+            run.hashJoin(innerRows, outerRows, plan.inner, 0);
+        }
+        return std::move(run.result());
+    } catch (const std::exception& e) {
+        std::cerr << "连接查询失败: " << e.what() << std::endl;
+        return {};
+    }
+}
+
+std::string JoinExecutor::describe(const JoinPlan& plan) const {
+    const JoinSide& inner = sides_[plan.inner];
+    if (plan.method == JoinMethod::HASH) {
+        return "哈希连接，在 " + inner.table->getName() + " 上建哈希表" + (plan.spill ? "（分区写出到临时文件）" : "");
+    }
+    AccessPath probe;
+    probe.method = AccessMethod::INDEX_PROBE;
+    IndexLookup lookup;
+    lookup.index = plan.index;
+    lookup.prefix = {Value()};
+    probe.lookups.push_back(lookup);
+    return "索引嵌套循环连接，逐行在 " + inner.table->getName() + " 上" + Planner::describe(*inner.table, probe);
+}
+
+} // namespace minidb
@@ -0,0 +1,139 @@
+#include "../include/Page.h"
+#include <cstring>
+#include <vector>
+#include <algorithm>
+
+namespace minidb {
+
+void SlottedPage::init() {
+    std::memset(data_, 0, kPageSize);
+    header()->freeEnd = static_cast<uint16_t>(kPageSize);
+}
+
+size_t SlottedPage::freeSpace() const {
+    size_t directoryEnd = sizeof(Header) + header()->slotCount * sizeof(Slot);
+    return header()->freeEnd - directoryEnd;
+}
+
+size_t SlottedPage::usedSpace() const {
+    size_t used = 0;
+    for (uint16_t i = 0; i < header()->slotCount; ++i) {
+        used += slots()[i].length;
+    }
+    return used;
+}
+
+size_t SlottedPage::reclaimableSpace() const {
+    size_t directoryEnd = sizeof(Header) + header()->slotCount * sizeof(Slot);
+    return kPageSize - directoryEnd - usedSpace();
+}
+
+bool SlottedPage::canInsert(size_t length) const {
+    return length > 0 && length + sizeof(Slot) <= reclaimableSpace();
+}
+
+std::optional<uint16_t> SlottedPage::insert(std::string_view tuple) {
+    uint16_t slot = header()->slotCount;
+    if (!insertAt(slot, tuple)) {
+        return std::nullopt;
+    }
+    return slot;
+}
+
+bool SlottedPage::insertAt(uint16_t slot, std::string_view tuple) {
+    if (slot != header()->slotCount || !canInsert(tuple.size())) {
+        return false;
+    }
+    
+    // 连续空间不够时先整理碎片
+    if (freeSpace() < tuple.size() + sizeof(Slot)) {
+        compact();
+    }
+    
+    uint16_t offset = static_cast<uint16_t>(header()->freeEnd - tuple.size());
+    std::memcpy(data_ + offset, tuple.data(), tuple.size());
+    
+    ++header()->slotCount;
+    slots()[slot] = {offset, static_cast<uint16_t>(tuple.size())};
+    header()->freeEnd = offset;
+    ++header()->liveCount;
+    return true;
+}
+
+std::optional<std::string_view> SlottedPage::get(uint16_t slot) const {
+    if (slot >= header()->slotCount || slots()[slot].length == 0) {
+        return std::nullopt;
+    }
+    const Slot& entry = slots()[slot];
+    return std::string_view(data_ + entry.offset, entry.length);
+}
+
+bool SlottedPage::erase(uint16_t slot) {
+    if (slot >= header()->slotCount || slots()[slot].length == 0) {
+        return false;
+    }
+    // 只标记槽为已删除，槽号保持不变，空间在整理时回收
+    slots()[slot] = {0, 0};
+    --header()->liveCount;
+    return true;
+}
+
+bool SlottedPage::canUpdate(uint16_t slot, size_t length, size_t reserved) const {
+    if (slot >= header()->slotCount || slots()[slot].length == 0 || length == 0) {
+        return false;
+    }
+    return length <= slots()[slot].length ||
+           length + reserved <= reclaimableSpace() + slots()[slot].length;
+}
+
+bool SlottedPage::update(uint16_t slot, std::string_view tuple) {
+    if (!canUpdate(slot, tuple.size())) {
+        return false;
+    }
+    
+    Slot& entry = slots()[slot];
+    
+    // 新元组不比旧元组长时直接原地覆盖
+    if (tuple.size() <= entry.length) {
+        std::memcpy(data_ + entry.offset, tuple.data(), tuple.size());
+        entry.length = static_cast<uint16_t>(tuple.size());
+        return true;
+    }
+    
+    // 否则先释放旧元组，必要时整理碎片，再写到数据区前端
+    entry = {0, 0};
+    if (freeSpace() < tuple.size()) {
+        compact();
+    }
+    uint16_t offset = static_cast<uint16_t>(header()->freeEnd - tuple.size());
+    std::memcpy(data_ + offset, tuple.data(), tuple.size());
+    slots()[slot] = {offset, static_cast<uint16_t>(tuple.size())};
+    header()->freeEnd = offset;
+    return true;
+}
+
+void SlottedPage::compact() {
+    // 把存活元组按原偏移从大到小重新紧凑地排列到页尾
+    std::vector<uint16_t> order;
+    order.reserve(header()->slotCount);
+    for (uint16_t i = 0; i < header()->slotCount; ++i) {
+        if (slots()[i].length > 0) {
+            order.push_back(i);
+        }
+    }
+    std::sort(order.begin(), order.end(), [this](uint16_t a, uint16_t b) {
+        return slots()[a].offset > slots()[b].offset;
+    });
+    
+    uint16_t freeEnd = static_cast<uint16_t>(kPageSize);
+    for (uint16_t slot : order) {
+        Slot& entry = slots()[slot];
+        freeEnd = static_cast<uint16_t>(freeEnd - entry.length);
+        // 目标位置不小于原位置，按偏移从大到小移动不会覆盖未移动的数据
+        std::memmove(data_ + freeEnd, data_ + entry.offset, entry.length);
+        entry.offset = freeEnd;
+    }
+    header()->freeEnd = freeEnd;
+}
+
+} // namespace minidb
\ No newline at end of file
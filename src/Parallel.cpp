@@ -0,0 +1,108 @@
+#include "../include/Parallel.h"
+
+namespace minidb {
+
+namespace {
+
+// 当前线程是否正在执行某个序号，此时再次调用run不再分给其他线程
+thread_local bool runningTask = false;
+
+} // namespace
+
+WorkerPool& WorkerPool::getInstance() {
+    static WorkerPool instance;
+    return instance;
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    for (auto& thread : threads_) {
+        thread.join();
+    }
+}
+
+bool WorkerPool::insideTask() {
+    return runningTask;
+}
+
+void WorkerPool::run(size_t threads, const std::function<void(size_t worker)>& task) {
+    bool stopping;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping = stopping_;
+    }
+    
+    if (threads <= 1 || runningTask || stopping) {
+        for (size_t worker = 0; worker < threads; ++worker) {
+            task(worker);
+        }
+        return;
+    }
+    
+    // 同一时间只执行一个任务
+    std::lock_guard<std::mutex> running(runMutex_);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        while (threads_.size() + 1 < threads) {
+            threads_.emplace_back(&WorkerPool::loop, this);
+        }
+        task_ = &task;
+        nextWorker_ = 1;
+        workerCount_ = threads;
+        pending_ = threads;
+        error_ = nullptr;
+    }
+    wake_.notify_all();
+    
+    execute(0);
+    std::exception_ptr error;
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        done_.wait(lock, [this] { return pending_ == 0; });
+        task_ = nullptr;
+        std::swap(error, error_);
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+void WorkerPool::loop() {
+    while (true) {
+        size_t worker;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            wake_.wait(lock, [this] { return stopping_ || (task_ && nextWorker_ < workerCount_); });
+            if (stopping_) {
+                return;
+            }
+            worker = nextWorker_++;
+        }
+        execute(worker);
+    }
+}
+
+void WorkerPool::execute(size_t worker) {
+    bool outer = runningTask;
+    runningTask = true;
+    try {
+        (*task_)(worker);
+    } catch (...) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!error_) {
+            error_ = std::current_exception();
+        }
+    }
+    runningTask = outer;
+    
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (--pending_ == 0) {
+        done_.notify_all();
+    }
+}
+
+} // namespace minidb
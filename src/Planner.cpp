@@ -0,0 +1,404 @@
+#include "../include/Planner.h"
+#include <algorithm>
+#include <cmath>
+#include <map>
+
+namespace minidb {
+
+namespace {
+
+// 顺序读一页的代价（代价单位）
+constexpr double kSeqPageCost = 1.0;
+
+// 随机读一页的代价：下降索引、按行号回表。表文件通过mmap读取，页通常已在内存中，
+// 随机读只比顺序读略贵
+constexpr double kRandomPageCost = 1.2;
+
+// 处理一行或一个索引项的代价
+constexpr double kCpuTupleCost = 0.01;
+constexpr double kCpuIndexEntryCost = 0.005;
+
+// B+树每页的索引项数（也作为内部节点的扇出）
+constexpr double kIndexEntriesPerPage = 100;
+
+// 排序时比较一次的代价
+constexpr double kCpuCompareCost = 0.002;
+
+// 排序时估计的STRING列的平均长度
+constexpr double kEstimatedStringLength = 16;
+
+// 一次索引查找的估计：满足查找条件的行数，以及在索引中查找的代价（不含回表）
+struct LookupEstimate {
+    IndexLookup lookup;
+    double rows = 0;
+    double cost = 0;
+};
+
+// 条件的合取项中的比较，按列分组；条件本身是比较时只有这一个
+std::map<size_t, std::vector<const Predicate*>> conjunctComparisons(const Predicate& where) {
+    std::map<size_t, std::vector<const Predicate*>> groups;
+    if (where.getKind() == Predicate::Kind::COMPARE) {
+        groups[where.getColumn()].push_back(&where);
+    } else if (where.getKind() == Predicate::Kind::AND) {
+        for (const auto& child : where.getChildren()) {
+            if (child.getKind() == Predicate::Kind::COMPARE) {
+                groups[child.getColumn()].push_back(&child);
+            }
+        }
+    }
+    return groups;
+}
+
+// 同一列上的第一个等值条件，没有时返回nullptr
+const Predicate* findEqual(const std::vector<const Predicate*>& comparisons) {
+    for (const Predicate* comparison : comparisons) {
+        if (comparison->getOp() == Operator::EQUAL) {
+            return comparison;
+        }
+    }
+    return nullptr;
+}
+
+// 合并同一列上的范围条件，取最紧的下界和上界放入查找；没有范围条件时返回false
+bool mergeRange(const std::vector<const Predicate*>& comparisons, IndexLookup& lookup) {
+    const Predicate* lower = nullptr;
+    const Predicate* upper = nullptr;
+    for (const Predicate* comparison : comparisons) {
+        const Value& value = comparison->getValue();
+        switch (comparison->getOp()) {
+            case Operator::GREATER_THAN:
+            case Operator::GREATER_EQUAL:
+                if (!lower || compareValues(value, lower->getValue(), Operator::GREATER_THAN) ||
+                    (value == lower->getValue() && comparison->getOp() == Operator::GREATER_THAN)) {
+                    lower = comparison;
+                }
+                break;
+            case Operator::LESS_THAN:
+            case Operator::LESS_EQUAL:
+                if (!upper || compareValues(value, upper->getValue(), Operator::LESS_THAN) ||
+                    (value == upper->getValue() && comparison->getOp() == Operator::LESS_THAN)) {
+                    upper = comparison;
+                }
+                break;
+            case Operator::EQUAL:
+            case Operator::NOT_EQUAL:
+                break;
+        }
+    }
+    if (lower) {
+        lookup.lowerOp = lower->getOp();
+        lookup.lower = lower->getValue();
+    }
+    if (upper) {
+        lookup.upperOp = upper->getOp();
+        lookup.upper = upper->getValue();
+    }
+    return lower || upper;
+}
+
+// 查找条件的选择率：等值前缀各列的选择率相乘，再乘以下一列上范围的选择率（区间的两端按相互重叠计算）
+double lookupSelectivity(const TableStats& stats, const IndexDef& def, const IndexLookup& lookup) {
+    double selectivity = 1;
+    for (size_t i = 0; i < lookup.prefix.size(); ++i) {
+        selectivity *= stats.selectivity(def.columns[i], Operator::EQUAL, lookup.prefix[i]);
+    }
+    if (lookup.hasRange()) {
+        size_t column = def.columns[lookup.prefix.size()];
+        double range = lookup.lowerOp ? stats.selectivity(column, *lookup.lowerOp, lookup.lower) : 1;
+        if (lookup.upperOp) {
+            range = std::max(0.0, range + stats.selectivity(column, *lookup.upperOp, lookup.upper) - 1);
+        }
+        selectivity *= range;
+    }
+    return selectivity;
+}
+
+// 第index个索引是否支持该查找
+bool supportsLookup(Table& table, size_t index, const IndexLookup& lookup) {
+    size_t keyColumns = lookup.keyColumns();
+    return (lookup.hasRange() || table.supportsLookup(index, keyColumns, Operator::EQUAL)) &&
+           (!lookup.lowerOp || table.supportsLookup(index, keyColumns, *lookup.lowerOp)) &&
+           (!lookup.upperOp || table.supportsLookup(index, keyColumns, *lookup.upperOp));
+}
+
+// 按行号回表读取rows行：同一页上的行只算一次随机读
+double fetchCost(double rows, double pages) {
+    return std::min(rows, pages) * kRandomPageCost + rows * kCpuTupleCost;
+}
+
+// 在索引中查找的代价（不含回表）：下降到叶子（哈希索引直接定位到桶），再顺序读取满足条件的matches个索引项
+double indexCost(Table& table, size_t index, double matches) {
+    double rows = static_cast<double>(table.getRowCount());
+    double height = std::max(1.0, std::ceil(std::log(std::max(rows, 2.0)) / std::log(kIndexEntriesPerPage)));
+    if (table.getIndexDef(index).type == IndexType::HASH) {
+        return kRandomPageCost + matches * kCpuIndexEntryCost;
+    }
+    return height * kRandomPageCost + std::ceil(matches / kIndexEntriesPerPage) * kSeqPageCost +
+           matches * kCpuIndexEntryCost;
+}
+
+// 每个索引上的查找：按索引列的顺序取合取项中的等值条件作为前缀，直到某一列没有等值条件，
+// 该列上的范围条件作为前缀之后的范围。(a, b)上的索引对 a = 1 and b = 2 用两列一起查找
+std::vector<LookupEstimate> estimateLookups(Table& table, const Predicate& where) {
+    const TableStats& stats = table.getStats();
+    double rows = static_cast<double>(table.getRowCount());
+    auto groups = conjunctComparisons(where);
+    
+    std::vector<LookupEstimate> estimates;
+    for (size_t i = 0; i < table.getIndexCount(); ++i) {
+        const IndexDef& def = table.getIndexDef(i);
+        IndexLookup lookup;
+        lookup.index = i;
+        for (size_t column : def.columns) {
+            auto it = groups.find(column);
+            if (it == groups.end()) {
+                break;
+            }
+            if (const Predicate* equal = findEqual(it->second)) {
+                lookup.prefix.push_back(equal->getValue());
+                continue;
+            }
+            mergeRange(it->second, lookup);
+            break;
+        }
+        
+        // 索引不支持时（哈希索引只支持给出所有列的等值查找），依次去掉范围和前缀的最后一列
+        while (lookup.keyColumns() > 0 && !supportsLookup(table, i, lookup)) {
+            if (lookup.hasRange()) {
+                lookup.lowerOp.reset();
+                lookup.upperOp.reset();
+            } else {
+                lookup.prefix.pop_back();
+            }
+        }
+        if (lookup.keyColumns() == 0) {
+            continue;
+        }
+        double matches = rows * lookupSelectivity(stats, def, lookup);
+        estimates.push_back({lookup, matches, indexCost(table, i, matches)});
+    }
+    return estimates;
+}
+
+// 索引的名字，用于EXPLAIN
+std::string indexName(const Table& table, size_t index) {
+    const IndexDef& def = table.getIndexDef(index);
+    std::string name = def.name.empty() ? "主键索引" : def.name;
+    if (def.type == IndexType::HASH) {
+        name += "（哈希）";
+    }
+    return name;
+}
+
+} // namespace
+
+std::vector<AccessPath> Planner::candidatePaths(Table& table, const Predicate& where,
+                                                const std::vector<size_t>& needed) {
+    double rows = static_cast<double>(table.getRowCount());
+    double pages = static_cast<double>(table.getPageCount());
+    
+    // 全表扫描：读取区域映射不能跳过的页，并判断其中每一行
+    AccessPath scan;
+    scan.method = AccessMethod::FULL_SCAN;
+    if (where.getKind() == Predicate::Kind::NONE) {
+        scan.rows = rows;
+        scan.cost = pages * kSeqPageCost + rows * kCpuTupleCost;
+        return {scan};
+    }
+    
+    double matches = rows * where.selectivity(table.getStats());
+    double scanned = static_cast<double>(table.pagesToScan(where));
+    double scannedRows = pages > 0 ? rows * scanned / pages : rows;
+    scan.rows = matches;
+    scan.cost = scanned * kSeqPageCost + scannedRows * kCpuTupleCost;
+    std::vector<AccessPath> paths{scan};
+    
+    // 需要返回的列和条件中的列都在索引中时可以只读索引
+    std::vector<size_t> used = needed;
+    where.collectColumns(used);
+    
+    // 单个索引：合取项中索引前几列的等值条件和下一列的范围，其余条件在读出的行上判断。
+    // 同时记下以每一列开头的代价最低的查找，用于求交集
+    std::vector<LookupEstimate> estimates = estimateLookups(table, where);
+    std::map<size_t, LookupEstimate> cheapest;
+    for (const auto& estimate : estimates) {
+        const IndexDef& def = table.getIndexDef(estimate.lookup.index);
+        AccessPath path;
+        path.method = estimate.lookup.hasRange() ? AccessMethod::INDEX_RANGE_SCAN : AccessMethod::INDEX_PROBE;
+        path.lookups = {estimate.lookup};
+        path.covering = !needed.empty() && def.covers(used);
+        path.rows = matches;
+        path.cost = estimate.cost + (path.covering ? 0 : fetchCost(estimate.rows, pages));
+        paths.push_back(path);
+        
+        auto it = cheapest.find(def.columns.front());
+        if (it == cheapest.end() || estimate.cost < it->second.cost) {
+            cheapest[def.columns.front()] = estimate;
+        }
+    }
+    
+    // 索引交集：从选择率最低的查找开始，依次加入以其他列开头的查找，只回表读取行号的交集
+    std::vector<LookupEstimate> columns;
+    for (const auto& [column, estimate] : cheapest) {
+        columns.push_back(estimate);
+    }
+    std::sort(columns.begin(), columns.end(), [](const LookupEstimate& a, const LookupEstimate& b) {
+        return a.rows < b.rows;
+    });
+    if (columns.size() >= 2 && rows > 0) {
+        AccessPath path;
+        path.method = AccessMethod::INDEX_INTERSECTION;
+        path.rows = matches;
+        double lookupCost = columns.front().cost;
+        double fraction = columns.front().rows / rows;
+        path.lookups.push_back(columns.front().lookup);
+        
+        // 已加入的多列查找限定过的列，以这些列开头的查找不再加入
+        std::vector<size_t> constrained;
+        auto addConstrained = [&](const IndexLookup& lookup) {
+            const IndexDef& def = table.getIndexDef(lookup.index);
+            constrained.insert(constrained.end(), def.columns.begin(), def.columns.begin() + lookup.keyColumns());
+        };
+        addConstrained(columns.front().lookup);
+        for (size_t i = 1; i < columns.size(); ++i) {
+            size_t leading = table.getIndexDef(columns[i].lookup.index).columns.front();
+            if (std::find(constrained.begin(), constrained.end(), leading) != constrained.end()) {
+                continue;
+            }
+            addConstrained(columns[i].lookup);
+            lookupCost += columns[i].cost;
+            fraction *= columns[i].rows / rows;
+            path.lookups.push_back(columns[i].lookup);
+            path.cost = lookupCost + fetchCost(rows * fraction, pages);
+            paths.push_back(path);
+        }
+    }
+    
+    // 索引并集：析取式的每个析取项都能用索引查找时，只回表读取行号的并集
+    std::vector<const Predicate*> disjunctions;
+    if (where.getKind() == Predicate::Kind::OR) {
+        disjunctions.push_back(&where);
+    } else if (where.getKind() == Predicate::Kind::AND) {
+        for (const auto& child : where.getChildren()) {
+            if (child.getKind() == Predicate::Kind::OR) {
+                disjunctions.push_back(&child);
+            }
+        }
+    }
+    for (const Predicate* disjunction : disjunctions) {
+        AccessPath path;
+        path.method = AccessMethod::INDEX_UNION;
+        path.rows = matches;
+        double lookupCost = 0;
+        double missed = 1;
+        for (const auto& child : disjunction->getChildren()) {
+            // 每个析取项使用估计总代价最低的查找
+            const LookupEstimate* best = nullptr;
+            std::vector<LookupEstimate> options = estimateLookups(table, child);
+            for (const auto& option : options) {
+                if (!best || option.cost + fetchCost(option.rows, pages) < best->cost + fetchCost(best->rows, pages)) {
+                    best = &option;
+                }
+            }
+            if (!best) {
+                path.lookups.clear();
+                break;
+            }
+            lookupCost += best->cost;
+            missed *= rows > 0 ? 1 - std::min(1.0, best->rows / rows) : 1;
+            path.lookups.push_back(best->lookup);
+        }
+        if (!path.lookups.empty()) {
+            path.cost = lookupCost + fetchCost(rows * (1 - missed), pages);
+            paths.push_back(path);
+        }
+    }
+    
+    // 代价相同时保持原来的顺序：全表扫描、单个索引、交集、并集
+    std::stable_sort(paths.begin(), paths.end(), [](const AccessPath& a, const AccessPath& b) {
+        return a.cost < b.cost;
+    });
+    return paths;
+}
+
+AccessPath Planner::choosePath(Table& table, const Predicate& where, const std::vector<size_t>& needed) {
+    return candidatePaths(table, where, needed).front();
+}
+
+double Planner::probeCost(Table& table, size_t index, double matches) {
+    return indexCost(table, index, matches) + fetchCost(matches, static_cast<double>(table.getPageCount()));
+}
+
+double Planner::orderedScanCost(Table& table, size_t index, double entries) {
+    return indexCost(table, index, entries) + entries * (kRandomPageCost + kCpuTupleCost);
+}
+
+double Planner::sortCost(const std::vector<DataType>& types, double rows, size_t memoryBudget,
+                         std::optional<size_t> limit) {
+    double kept = limit ? std::min(rows, static_cast<double>(*limit)) : rows;
+    double cost = rows * std::log2(std::max(kept, 2.0)) * kCpuCompareCost;
+    if (limit) {
+        return cost;
+    }
+    
+    // 内存中的一行：记录本身和各列的值，STRING列另有内容
+    double rowBytes = sizeof(Record) + sizeof(uint64_t);
+    for (DataType type : types) {
+        rowBytes += sizeof(Value) + (type == DataType::STRING ? kEstimatedStringLength : 0);
+    }
+    double bytes = rows * rowBytes;
+    if (bytes > static_cast<double>(memoryBudget)) {
+        cost += 2 * bytes / kPageSize * kSeqPageCost;
+    }
+    return cost;
+}
+
+std::string Planner::describe(const Table& table, const AccessPath& path) {
+    std::string text;
+    switch (path.method) {
+        case AccessMethod::FULL_SCAN:
+            return "全表扫描";
+        case AccessMethod::INDEX_PROBE:
+            text = "索引查找 ";
+            break;
+        case AccessMethod::INDEX_RANGE_SCAN:
+            text = "索引范围扫描 ";
+            break;
+        case AccessMethod::INDEX_INTERSECTION:
+            text = "索引交集 ";
+            break;
+        case AccessMethod::INDEX_UNION:
+            text = "索引并集 ";
+            break;
+    }
+    
+    // 使用的索引，同一个索引只列出一次；用到索引的多列时列出这些列
+    std::vector<size_t> listed;
+    for (const auto& lookup : path.lookups) {
+        if (std::find(listed.begin(), listed.end(), lookup.index) != listed.end()) {
+            continue;
+        }
+        text += (listed.empty() ? "" : ", ") + indexName(table, lookup.index);
+        listed.push_back(lookup.index);
+        if (lookup.keyColumns() > 1) {
+            const IndexDef& def = table.getIndexDef(lookup.index);
+            text += "（按 ";
+            for (size_t i = 0; i < lookup.keyColumns(); ++i) {
+                text += (i == 0 ? "" : ", ") + table.getColumns()[def.columns[i]].name;
+            }
+            text += " 查找）";
+        }
+    }
+    if (path.covering) {
+        text += "，只读索引";
+    }
+    return text;
+}
+
+std::string Planner::describeOrderedScan(const Table& table, size_t index, bool descending) {
+    const IndexDef& def = table.getIndexDef(index);
+    std::string text = def.name.empty() ? "按主键索引" : "按索引 " + def.name + " ";
+    return text + (descending ? "的逆序读取" : "的顺序读取");
+}
+
+} // namespace minidb
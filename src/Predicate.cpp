@@ -0,0 +1,251 @@
+#include "../include/Predicate.h"
+#include <algorithm>
+#include <limits>
+#include <map>
+
+namespace minidb {
+
+namespace {
+
+// 范围条件的下界和上界
+bool isLowerBound(Operator op) {
+    return op == Operator::GREATER_THAN || op == Operator::GREATER_EQUAL;
+}
+
+bool isUpperBound(Operator op) {
+    return op == Operator::LESS_THAN || op == Operator::LESS_EQUAL;
+}
+
+} // namespace
+
+Predicate Predicate::compare(size_t column, Operator op, Value value, size_t slot) {
+    Predicate predicate;
+    predicate.kind_ = Kind::COMPARE;
+    predicate.column_ = column;
+    predicate.op_ = op;
+    predicate.value_ = std::move(value);
+    predicate.slot_ = slot;
+    return predicate;
+}
+
+Predicate Predicate::combine(Kind kind, std::vector<Predicate> children) {
+    // (a and b) and c 展开为 a and b and c，便于重新排列和取出合取项
+    Predicate predicate;
+    predicate.kind_ = kind;
+    for (auto& child : children) {
+        if (child.kind_ == kind) {
+            for (auto& grandchild : child.children_) {
+                predicate.children_.push_back(std::move(grandchild));
+            }
+        } else if (child.kind_ != Kind::NONE) {
+            predicate.children_.push_back(std::move(child));
+        }
+    }
+    if (predicate.children_.empty()) {
+        return Predicate();
+    }
+    if (predicate.children_.size() == 1) {
+        return std::move(predicate.children_.front());
+    }
+    return predicate;
+}
+
+void Predicate::bind(const std::vector<Value>& values) {
+    if (kind_ == Kind::COMPARE) {
+        if (slot_ < values.size()) {
+            value_ = values[slot_];
+        }
+        return;
+    }
+    for (auto& child : children_) {
+        child.bind(values);
+    }
+}
+
+bool Predicate::matches(const TupleView& row) const {
+    switch (kind_) {
+        case Kind::NONE:
+            return true;
+        case Kind::COMPARE:
+            return row.matches(column_, op_, value_);
+        case Kind::AND:
+            for (const auto& child : children_) {
+                if (!child.matches(row)) {
+                    return false;
+                }
+            }
+            return true;
+        case Kind::OR:
+            for (const auto& child : children_) {
+                if (child.matches(row)) {
+                    return true;
+                }
+            }
+            return false;
+    }
+    return false;
+}
+
+bool Predicate::matches(const Record& row) const {
+    switch (kind_) {
+        case Kind::NONE:
+            return true;
+        case Kind::COMPARE:
+            return column_ < row.size() && compareValues(row[column_], value_, op_);
+        case Kind::AND:
+            for (const auto& child : children_) {
+                if (!child.matches(row)) {
+                    return false;
+                }
+            }
+            return true;
+        case Kind::OR:
+            for (const auto& child : children_) {
+                if (child.matches(row)) {
+                    return true;
+                }
+            }
+            return false;
+    }
+    return false;
+}
+
+bool Predicate::canSkip(const ZoneMap& zoneMap, uint32_t pageId) const {
+    switch (kind_) {
+        case Kind::NONE:
+            return false;
+        case Kind::COMPARE:
+            return zoneMap.canSkip(pageId, column_, op_, value_);
+        case Kind::AND:
+            // 任何一个合取项在区域中都不成立
+            for (const auto& child : children_) {
+                if (child.canSkip(zoneMap, pageId)) {
+                    return true;
+                }
+            }
+            return false;
+        case Kind::OR:
+            // 所有析取项在区域中都不成立
+            for (const auto& child : children_) {
+                if (!child.canSkip(zoneMap, pageId)) {
+                    return false;
+                }
+            }
+            return true;
+    }
+    return false;
+}
+
+double Predicate::selectivity(const TableStats& stats) const {
+    switch (kind_) {
+        case Kind::NONE:
+            return 1;
+        case Kind::COMPARE:
+            return stats.selectivity(column_, op_, value_);
+        case Kind::AND: {
+            // 同一列上的下界和上界组成区间，按两端重叠计算，不能当作相互独立
+            std::map<size_t, std::pair<double, double>> ranges;
+            double result = 1;
+            for (const auto& child : children_) {
+                double s = child.selectivity(stats);
+                if (child.kind_ == Kind::COMPARE && isLowerBound(child.op_)) {
+                    auto& range = ranges.try_emplace(child.column_, 1.0, 1.0).first->second;
+                    range.first = std::min(range.first, s);
+                } else if (child.kind_ == Kind::COMPARE && isUpperBound(child.op_)) {
+                    auto& range = ranges.try_emplace(child.column_, 1.0, 1.0).first->second;
+                    range.second = std::min(range.second, s);
+                } else {
+                    result *= s;
+                }
+            }
+            for (const auto& [column, range] : ranges) {
+                result *= std::max(0.0, range.first + range.second - 1);
+            }
+            return result;
+        }
+        case Kind::OR: {
+            double none = 1;
+            for (const auto& child : children_) {
+                none *= 1 - child.selectivity(stats);
+            }
+            return 1 - none;
+        }
+    }
+    return 1;
+}
+
+double Predicate::evaluationCost() const {
+    if (kind_ == Kind::COMPARE) {
+        return std::holds_alternative<int>(value_) ? 1 : 2;
+    }
+    double cost = 0;
+    for (const auto& child : children_) {
+        cost += child.evaluationCost();
+    }
+    return cost;
+}
+
+void Predicate::reorder(const TableStats& stats) {
+    if (kind_ != Kind::AND && kind_ != Kind::OR) {
+        return;
+    }
+    
+    // 按“代价 / 结束求值的概率”从小到大排列，概率为0的子条件排在最后
+    constexpr double kNever = std::numeric_limits<double>::infinity();
+    std::vector<std::pair<double, size_t>> ranks;
+    ranks.reserve(children_.size());
+    for (size_t i = 0; i < children_.size(); ++i) {
+        children_[i].reorder(stats);
+        double s = children_[i].selectivity(stats);
+        double decisive = kind_ == Kind::AND ? 1 - s : s;
+        ranks.emplace_back(decisive > 0 ? children_[i].evaluationCost() / decisive : kNever, i);
+    }
+    std::stable_sort(ranks.begin(), ranks.end(), [](const auto& a, const auto& b) {
+        return a.first < b.first;
+    });
+    
+    std::vector<Predicate> ordered;
+    ordered.reserve(children_.size());
+    for (const auto& [rank, i] : ranks) {
+        ordered.push_back(std::move(children_[i]));
+    }
+    children_ = std::move(ordered);
+}
+
+void Predicate::collectColumns(std::vector<size_t>& columns) const {
+    if (kind_ == Kind::COMPARE) {
+        columns.push_back(column_);
+    }
+    for (const auto& child : children_) {
+        child.collectColumns(columns);
+    }
+}
+
+std::string Predicate::toString(const std::vector<ColumnDef>& columns) const {
+    switch (kind_) {
+        case Kind::NONE:
+            return "";
+        case Kind::COMPARE:
+            return (column_ < columns.size() ? columns[column_].name : "?") + " " +
+                   operatorToString(op_) + " " + valueToString(value_);
+        case Kind::AND:
+        case Kind::OR:
+            break;
+    }
+    
+    // AND中的OR子条件加括号
+    std::string text;
+    for (const auto& child : children_) {
+        if (!text.empty()) {
+            text += kind_ == Kind::AND ? " and " : " or ";
+        }
+        if (kind_ == Kind::AND && child.kind_ == Kind::OR) {
+            text += "(" + child.toString(columns) + ")";
+        } else {
+            text += child.toString(columns);
+        }
+    }
+    return text;
+}
+
+} // namespace minidb
@@ -0,0 +1,973 @@
+#include "../include/PreparedStatement.h"
+#include "../include/DBManager.h"
+#include "../include/Planner.h"
+#include "../include/Join.h"
+#include "../include/Parallel.h"
+#include <sstream>
+#include <iomanip>
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+
+namespace minidb {
+
+namespace {
+
+// 估计的行数达到这个数量时，聚合由多个线程各自累加部分结果
+constexpr double kMinParallelAggregateRows = 64 * 1024;
+
+// NOT 列 op 值 等价于 列 op' 值
+Operator negateOperator(Operator op) {
+    switch (op) {
+        case Operator::EQUAL: return Operator::NOT_EQUAL;
+        case Operator::NOT_EQUAL: return Operator::EQUAL;
+        case Operator::LESS_THAN: return Operator::GREATER_EQUAL;
+        case Operator::GREATER_EQUAL: return Operator::LESS_THAN;
+        case Operator::GREATER_THAN: return Operator::LESS_EQUAL;
+        case Operator::LESS_EQUAL: return Operator::GREATER_THAN;
+    }
+    return op;
+}
+
+// 语句中可以引用的列：单表语句为该表的各列，连接为左表的各列接着右表的各列。
+// 列名可以写成 表名.列名，不带表名的列名只能出现在其中一个表中
+class ColumnScope {
+public:
+    ColumnScope(const Table& table, const Table* joinTable) {
+        tables_.emplace_back(&table, 0);
+        if (joinTable) {
+            tables_.emplace_back(joinTable, table.getColumns().size());
+        }
+    }
+    
+    // 所有列，连接时列名带表名前缀
+    std::vector<ColumnDef> columns() const {
+        std::vector<ColumnDef> result;
+        for (const auto& [table, offset] : tables_) {
+            for (const auto& column : table->getColumns()) {
+                result.push_back(column);
+                if (tables_.size() > 1) {
+                    result.back().name = table->getName() + "." + column.name;
+                }
+            }
+        }
+        return result;
+    }
+    
+    // 按列名找到列位置；列不存在或不明确时返回false，error中为错误信息
+    bool find(const std::string& name, size_t& column, std::string& error) const {
+        size_t dot = name.find('.');
+        std::string tableName = dot == std::string::npos ? "" : name.substr(0, dot);
+        std::string columnName = dot == std::string::npos ? name : name.substr(dot + 1);
+        std::optional<size_t> found;
+        for (const auto& [table, offset] : tables_) {
+            if (!tableName.empty() && table->getName() != tableName) {
+                continue;
+            }
+            if (auto index = table->getColumnIndex(columnName)) {
+                if (found) {
+                    error = "错误：列 " + name + " 不明确";
+                    return false;
+                }
+                found = offset + *index;
+            }
+        }
+        if (!found) {
+            error = "错误：列 " + name + " 不存在";
+            return false;
+        }
+        column = *found;
+        return true;
+    }
+    
+    // 列的类型
+    DataType type(size_t column) const {
+        const auto& [table, offset] = column < tables_.back().second ? tables_.front() : tables_.back();
+        return table->getColumns()[column - offset].type;
+    }
+
+private:
+    // 每个表及其第一列的位置
+    std::vector<std::pair<const Table*, size_t>> tables_;
+};
+
+// 把WHERE条件编译为Predicate：解析列位置，把NOT下推到比较中（negate表示外面有奇数个NOT），
+// 展开BETWEEN和IN；比较的字面量按顺序加入literals，对应列的类型加入types。
+// 列不存在时返回false，error中为错误信息
+bool compileCondition(const Condition& condition, bool negate, const ColumnScope& scope,
+                      std::vector<const Literal*>& literals, std::vector<DataType>& types,
+                      Predicate& predicate, std::string& error) {
+    // 比较：值放入下一个值槽
+    auto compare = [&](size_t column, Operator op, const Literal& literal) {
+        literals.push_back(&literal);
+        types.push_back(scope.type(column));
+        return Predicate::compare(column, negate ? negateOperator(op) : op, 0, literals.size() - 1);
+    };
+    
+    // AND和OR在NOT下互换
+    auto combine = [&](Predicate::Kind kind, std::vector<Predicate> children) {
+        if (negate) {
+            kind = kind == Predicate::Kind::AND ? Predicate::Kind::OR : Predicate::Kind::AND;
+        }
+        return Predicate::combine(kind, std::move(children));
+    };
+    
+    std::optional<size_t> column;
+    if (condition.type == ConditionType::COMPARE || condition.type == ConditionType::BETWEEN ||
+        condition.type == ConditionType::IN) {
+        if (!scope.find(condition.column, column.emplace(), error)) {
+            return false;
+        }
+    }
+    
+    std::vector<Predicate> children;
+    switch (condition.type) {
+        case ConditionType::COMPARE:
+            predicate = compare(*column, condition.op, condition.values.front());
+            return true;
+        case ConditionType::BETWEEN:
+            // 下界 <= 列 <= 上界
+            children.push_back(compare(*column, Operator::GREATER_EQUAL, condition.values[0]));
+            children.push_back(compare(*column, Operator::LESS_EQUAL, condition.values[1]));
+            predicate = combine(Predicate::Kind::AND, std::move(children));
+            return true;
+        case ConditionType::IN:
+            // 等于其中任何一个值
+            for (const auto& value : condition.values) {
+                children.push_back(compare(*column, Operator::EQUAL, value));
+            }
+            predicate = combine(Predicate::Kind::OR, std::move(children));
+            return true;
+        case ConditionType::AND:
+        case ConditionType::OR:
+            for (const auto& child : condition.children) {
+                if (!compileCondition(child, negate, scope, literals, types, children.emplace_back(), error)) {
+                    return false;
+                }
+            }
+            predicate = combine(condition.type == ConditionType::AND ? Predicate::Kind::AND : Predicate::Kind::OR,
+                                std::move(children));
+            return true;
+        case ConditionType::NOT:
+            return compileCondition(condition.children.front(), !negate, scope, literals, types, predicate, error);
+    }
+    return false;
+}
+
+} // namespace
+
+PreparedStatement::PreparedStatement(Statement stmt) : stmt_(std::move(stmt)) {
+    bound_.assign(stmt_.paramCount, false);
+}
+
+SQLResult PreparedStatement::resolve() {
+    SQLType type = stmt_.type;
+    db_.reset();
+    table_.reset();
+    joinTable_.reset();
+    
+    // 获取当前数据库
+    auto db = DBManager::getInstance().getCurrentDatabase();
+    if (!db) {
+        return {type, "错误：未选择数据库", false};
+    }
+    
+    // 获取表
+    auto table = db->getTable(stmt_.name);
+    if (!table) {
+        return {type, "错误：表 " + stmt_.name + " 不存在", false};
+    }
+    const auto& columns = table->getColumns();
+    
+    // 连接的另一个表
+    std::shared_ptr<Table> joinTable;
+    if (!stmt_.joinName.empty()) {
+        joinTable = db->getTable(stmt_.joinName);
+        if (!joinTable) {
+            return {type, "错误：表 " + stmt_.joinName + " 不存在", false};
+        }
+        if (joinTable == table) {
+            return {type, "错误：不支持表与自身连接", false};
+        }
+    }
+    ColumnScope scope(*table, joinTable.get());
+    
+    // ON子句的两列分别属于两个表，类型相同
+    if (joinTable) {
+        size_t first = 0;
+        size_t second = 0;
+        std::string error;
+        if (!scope.find(stmt_.joinLeft, first, error) || !scope.find(stmt_.joinRight, second, error)) {
+            return {type, error, false};
+        }
+        if (first > second) {
+            std::swap(first, second);
+        }
+        if (second < columns.size() || first >= columns.size()) {
+            return {type, "错误：ON 子句必须比较两个表的列", false};
+        }
+        if (scope.type(first) != scope.type(second)) {
+            return {type, "错误：连接列的类型不同", false};
+        }
+        leftKey_ = first;
+        rightKey_ = second - columns.size();
+    }
+    
+    // 按值槽的顺序收集字面量和对应列的类型
+    std::vector<const Literal*> literals;
+    std::vector<DataType> types;
+    if (type == SQLType::INSERT) {
+        if (stmt_.values.empty()) {
+            return {type, "错误：无效的值列表", false};
+        }
+        if (stmt_.values.size() != columns.size()) {
+            return {type, "错误：值的数量与列的数量不匹配", false};
+        }
+        for (size_t i = 0; i < columns.size(); ++i) {
+            literals.push_back(&stmt_.values[i]);
+            types.push_back(columns[i].type);
+        }
+    }
+    
+    if (type == SQLType::UPDATE) {
+        auto setColumn = table->getColumnIndex(stmt_.setName);
+        if (!setColumn) {
+            return {type, "错误：列 " + stmt_.setName + " 不存在", false};
+        }
+        setColumn_ = *setColumn;
+        literals.push_back(&stmt_.setValue);
+        types.push_back(columns[setColumn_].type);
+    }
+    
+    selectColumn_.reset();
+    if (type == SQLType::SELECT && !isAggregate() && stmt_.columns.front() != "*") {
+        std::string error;
+        if (!scope.find(stmt_.columns.front(), selectColumn_.emplace(), error)) {
+            selectColumn_.reset();
+            return {type, error, false};
+        }
+    }
+    
+    // 聚合查询：分组列和聚合函数的列都放入输入列，SELECT列表和ORDER BY中的列必须出现在GROUP BY中
+    aggregateInput_.clear();
+    groupColumns_.clear();
+    groupTypes_.clear();
+    aggregates_.clear();
+    itemColumns_.clear();
+    itemNames_.clear();
+    sortInput_.clear();
+    sortKeys_.clear();
+    if (type == SQLType::SELECT && isAggregate()) {
+        std::vector<ColumnDef> names = scope.columns();
+        auto input = [&](size_t column) {
+            auto it = std::find(aggregateInput_.begin(), aggregateInput_.end(), column);
+            if (it != aggregateInput_.end()) {
+                return static_cast<size_t>(it - aggregateInput_.begin());
+            }
+            aggregateInput_.push_back(column);
+            return aggregateInput_.size() - 1;
+        };
+        
+        std::vector<size_t> groupBy;
+        std::string error;
+        for (const auto& name : stmt_.groupBy) {
+            size_t column = 0;
+            if (!scope.find(name, column, error)) {
+                return {type, error, false};
+            }
+            if (std::find(groupBy.begin(), groupBy.end(), column) == groupBy.end()) {
+                groupBy.push_back(column);
+                groupColumns_.push_back(input(column));
+                groupTypes_.push_back(scope.type(column));
+            }
+        }
+        
+        // 一项在聚合得到的一行中的位置和列名，相同的聚合函数只计算一次
+        auto resolveItem = [&](const SelectItem& item, size_t& position, std::string& name) {
+            size_t column = 0;
+            if (item.column != "*" && !scope.find(item.column, column, error)) {
+                return false;
+            }
+            if (!item.function) {
+                auto it = std::find(groupBy.begin(), groupBy.end(), column);
+                if (it == groupBy.end()) {
+                    error = "错误：列 " + item.column + " 必须出现在 GROUP BY 中";
+                    return false;
+                }
+                position = static_cast<size_t>(it - groupBy.begin());
+                name = names[column].name;
+                return true;
+            }
+            
+            AggregateSpec spec;
+            spec.function = *item.function;
+            std::string argument = "*";
+            if (item.column != "*") {
+                spec.column = input(column);
+                spec.type = scope.type(column);
+                argument = names[column].name;
+            }
+            bool numeric = spec.function == AggregateFunction::SUM || spec.function == AggregateFunction::AVG;
+            if (numeric && spec.type != DataType::INT) {
+                error = std::string("错误：") + aggregateName(spec.function) + " 只能用于 INT 列";
+                return false;
+            }
+            auto same = std::find_if(aggregates_.begin(), aggregates_.end(), [&](const AggregateSpec& other) {
+                return other.function == spec.function && other.column == spec.column;
+            });
+            position = groupBy.size() + static_cast<size_t>(same - aggregates_.begin());
+            name = std::string(aggregateName(spec.function)) + "(" + argument + ")";
+            if (same == aggregates_.end()) {
+                aggregates_.push_back(spec);
+            }
+            return true;
+        };
+        
+        for (const auto& item : stmt_.items) {
+            if (!resolveItem(item, itemColumns_.emplace_back(), itemNames_.emplace_back())) {
+                return {type, error, false};
+            }
+        }
+        for (const auto& order : stmt_.orderBy) {
+            std::string name;
+            if (!resolveItem(order.item, sortKeys_.emplace_back().column, name)) {
+                return {type, error, false};
+            }
+            sortKeys_.back().descending = order.descending;
+        }
+    }
+    
+    // 非聚合查询的ORDER BY：排序的输入为输出列，再加上只在ORDER BY中出现的列
+    if (type == SQLType::SELECT && !isAggregate() && !stmt_.orderBy.empty()) {
+        if (selectColumn_) {
+            sortInput_.push_back(*selectColumn_);
+        } else {
+            for (size_t i = 0; i < scope.columns().size(); ++i) {
+                sortInput_.push_back(i);
+            }
+        }
+        for (const auto& order : stmt_.orderBy) {
+            size_t column = 0;
+            std::string error;
+            if (!scope.find(order.item.column, column, error)) {
+                return {type, error, false};
+            }
+            auto it = std::find(sortInput_.begin(), sortInput_.end(), column);
+            if (it == sortInput_.end()) {
+                it = sortInput_.insert(sortInput_.end(), column);
+            }
+            sortKeys_.push_back({static_cast<size_t>(it - sortInput_.begin()), order.descending});
+        }
+    }
+    
+    // 编译WHERE条件，条件中的值依次放在后面的值槽中
+    Predicate where;
+    if (stmt_.where) {
+        std::string error;
+        if (!compileCondition(*stmt_.where, false, scope, literals, types, where, error)) {
+            return {type, error, false};
+        }
+    }
+    
+    // 转换常量值；已绑定的参数在列类型不变时保留原来的值
+    std::vector<Value> values(literals.size());
+    paramSlots_.assign(stmt_.paramCount, 0);
+    for (size_t slot = 0; slot < literals.size(); ++slot) {
+        const Literal& literal = *literals[slot];
+        if (literal.param >= 0) {
+            size_t param = static_cast<size_t>(literal.param);
+            paramSlots_[param] = slot;
+            if (bound_[param] && slot < types_.size() && types_[slot] == types[slot]) {
+                values[slot] = std::move(values_[slot]);
+            } else {
+                bound_[param] = false;
+            }
+            continue;
+        }
+        try {
+            values[slot] = stringToValue(literal.text, types[slot]);
+        } catch (const std::exception& e) {
+            return {type, "错误：无效的值：" + literal.text, false};
+        }
+    }
+    
+    values_ = std::move(values);
+    types_ = std::move(types);
+    where_ = std::move(where);
+    columns_ = scope.columns();
+    db_ = db;
+    table_ = table;
+    joinTable_ = joinTable;
+    return {type, "", true};
+}
+
+bool PreparedStatement::bind(size_t index, const Value& value) {
+    if (index >= paramSlots_.size()) {
+        return false;
+    }
+    size_t slot = paramSlots_[index];
+    bool isInt = std::holds_alternative<int>(value);
+    if (slot >= types_.size() || isInt != (types_[slot] == DataType::INT)) {
+        return false;
+    }
+    values_[slot] = value;
+    bound_[index] = true;
+    return true;
+}
+
+bool PreparedStatement::bind(size_t index, const std::string& text) {
+    if (index >= paramSlots_.size() || paramSlots_[index] >= types_.size()) {
+        return false;
+    }
+    try {
+        return bind(index, stringToValue(text, types_[paramSlots_[index]]));
+    } catch (const std::exception& e) {
+        return false;
+    }
+}
+
+SQLResult PreparedStatement::prepareToRun(std::shared_ptr<Database>& db, std::shared_ptr<Table>& table) {
+    // 表已被关闭或删除、或切换了数据库时重新解析
+    db = db_.lock();
+    table = table_.lock();
+    bool joinClosed = !stmt_.joinName.empty() && joinTable_.expired();
+    if (!db || !table || joinClosed || db != DBManager::getInstance().getCurrentDatabase()) {
+        SQLResult result = resolve();
+        if (!result.success) {
+            return result;
+        }
+        db = db_.lock();
+        table = table_.lock();
+    }
+    
+    for (size_t i = 0; i < bound_.size(); ++i) {
+        if (!bound_[i]) {
+            return {stmt_.type, "错误：参数 " + std::to_string(i + 1) + " 未绑定", false};
+        }
+    }
+    where_.bind(values_);
+    return {stmt_.type, "", true};
+}
+
+std::vector<AccessPath> PreparedStatement::plan(Table& table) {
+    if (stmt_.type == SQLType::INSERT) {
+        return {};
+    }
+    
+    // SELECT需要返回的列，DELETE和UPDATE只需要行号
+    std::vector<size_t> needed;
+    if (isAggregate()) {
+        needed = aggregateInput_;
+    } else if (!sortInput_.empty()) {
+        needed = sortInput_;
+    } else if (stmt_.type == SQLType::SELECT) {
+        if (selectColumn_) {
+            needed.push_back(*selectColumn_);
+        } else {
+            for (size_t i = 0; i < table.getColumns().size(); ++i) {
+                needed.push_back(i);
+            }
+        }
+    }
+    
+    // 按当前的值重新排列条件的求值顺序
+    where_.reorder(table.getStats());
+    std::vector<AccessPath> paths = Planner::candidatePaths(table, where_, needed);
+    
+    // 聚合和排序按批读取表中的行，不使用只读索引的路径（全表扫描总是可用）
+    if (isAggregate() || !sortKeys_.empty()) {
+        paths.erase(std::remove_if(paths.begin(), paths.end(), [](const AccessPath& path) {
+            return path.covering;
+        }), paths.end());
+    }
+    return paths;
+}
+
+SQLResult PreparedStatement::execute() {
+    SQLType type = stmt_.type;
+    std::shared_ptr<Database> db;
+    std::shared_ptr<Table> table;
+    SQLResult ready = prepareToRun(db, table);
+    if (!ready.success) {
+        return ready;
+    }
+    
+    SQLResult result;
+    if (!stmt_.joinName.empty()) {
+        result = executeJoin(*table, *joinTable_.lock());
+    } else if (type == SQLType::INSERT) {
+        if (table->insert(values_)) {
+            result = {type, "记录插入成功", true};
+        } else {
+            result = {type, "错误：插入记录失败，主键可能重复", false};
+        }
+    } else {
+        AccessPath path = plan(*table).front();
+        if (type == SQLType::DELETE) {
+            int count = table->deleteWhere(where_, path);
+            result = {type, "已删除 " + std::to_string(count) + " 条记录", true};
+        } else if (type == SQLType::UPDATE) {
+            int count = table->updateWhere(setColumn_, values_.front(), where_, path);
+            result = {type, "已更新 " + std::to_string(count) + " 条记录", true};
+        } else {
+            result = executeSelect(*table, path);
+        }
+    }
+    
+    // 写操作之后检查日志大小，必要时写出检查点
+    if (result.success && type != SQLType::SELECT) {
+        db->maybeCheckpoint();
+    }
+    return result;
+}
+
+SQLResult PreparedStatement::explain() {
+    std::shared_ptr<Database> db;
+    std::shared_ptr<Table> table;
+    SQLResult ready = prepareToRun(db, table);
+    if (!ready.success) {
+        return {SQLType::EXPLAIN, ready.message, false};
+    }
+    
+    if (!stmt_.joinName.empty()) {
+        return explainJoin(*table, *joinTable_.lock());
+    }
+    
+    // 先规划，条件按求值顺序显示
+    std::vector<AccessPath> paths = plan(*table);
+    
+    static const char* const kTypeNames[] = {"INSERT", "DELETE", "UPDATE", "SELECT"};
+    size_t typeIndex = static_cast<size_t>(stmt_.type) - static_cast<size_t>(SQLType::INSERT);
+    std::stringstream ss;
+    ss << std::fixed << std::setprecision(2);
+    ss << "查询计划：" << kTypeNames[typeIndex] << " " << stmt_.name;
+    if (where_.getKind() != Predicate::Kind::NONE) {
+        ss << " where " << where_.toString(table->getColumns());
+    }
+    if (!sortKeys_.empty()) {
+        ss << " order by " << describeOrder();
+    }
+    if (stmt_.limit) {
+        ss << " limit " << *stmt_.limit;
+    }
+    if (stmt_.offset > 0) {
+        ss << " offset " << stmt_.offset;
+    }
+    ss << std::endl;
+    
+    if (paths.empty()) {
+        ss << "  -> 插入一行" << std::endl;
+        return {SQLType::EXPLAIN, ss.str(), true};
+    }
+    if (isAggregate()) {
+        ss << "  -> " << describeAggregate() << std::endl;
+        if (countsAllRows()) {
+            return {SQLType::EXPLAIN, ss.str(), true};
+        }
+        ss << "  ";
+    }
+    
+    // 选中的路径（并行扫描时给出工作线程数），以及按代价排列的所有候选路径
+    auto line = [&](const AccessPath& path, size_t threads = 1) {
+        ss << Planner::describe(*table, path);
+        if (threads > 1) {
+            ss << "，" << threads << " 个工作线程";
+        }
+        ss << "  估计行数 " << std::llround(path.rows) << "  代价 " << path.cost << std::endl;
+    };
+    
+    // ORDER BY：按索引的顺序读取时不再使用访问路径，否则排序按访问路径读取的行
+    std::optional<OrderedScan> scan;
+    if (!isAggregate() && !sortKeys_.empty()) {
+        scan = orderedScan(*table, paths.front());
+    }
+    if (scan) {
+        ss << "  -> " << Planner::describeOrderedScan(*table, scan->index, sortKeys_.front().descending);
+        if (auto needed = rowsNeeded()) {
+            ss << "，读够 " << *needed << " 行为止";
+        }
+        ss << "  估计读取 " << std::llround(scan->entries) << " 行  代价 " << scan->cost
+           << "（排序的代价 " << scan->sortCost << "）" << std::endl;
+    } else {
+        if (!isAggregate() && !sortKeys_.empty()) {
+            ss << "  -> 排序 " << describeOrder();
+            if (auto needed = rowsNeeded()) {
+                ss << "，用堆保留前 " << *needed << " 行";
+            }
+            ss << std::endl << "  ";
+        }
+        ss << "  -> ";
+        line(paths.front(), scanThreads(*table, paths.front()));
+    }
+    ss << "候选路径：" << std::endl;
+    for (const auto& path : paths) {
+        ss << "  ";
+        line(path);
+    }
+    return {SQLType::EXPLAIN, ss.str(), true};
+}
+
+SQLResult PreparedStatement::executeSelect(Table& table, const AccessPath& path) {
+    // 查询记录
+    std::vector<Record> result;
+    if (isAggregate()) {
+        result = aggregateResult(aggregate(table, path));
+    } else if (!sortKeys_.empty()) {
+        result = selectSorted(table, path);
+    } else if (where_.getKind() != Predicate::Kind::NONE) {
+        result = table.selectWhere(where_, selectColumn_, path, rowsNeeded());
+        skipOffset(result);
+    } else {
+        result = table.selectAll(selectColumn_, rowsNeeded());
+        skipOffset(result);
+    }
+    return {SQLType::SELECT, formatResult(result), true};
+}
+
+size_t PreparedStatement::scanThreads(const Table& table, const AccessPath& path) const {
+    if (path.method != AccessMethod::FULL_SCAN || !stmt_.joinName.empty()) {
+        return 1;
+    }
+    
+    // 聚合按页块并行扫描；其余查询有LIMIT或排序时顺序扫描，没有条件的删除和更新不需要扫描各列
+    if (!isAggregate()) {
+        bool select = stmt_.type == SQLType::SELECT;
+        if ((select && (stmt_.limit || !sortKeys_.empty())) ||
+            (!select && where_.getKind() == Predicate::Kind::NONE)) {
+            return 1;
+        }
+    }
+    return table.scanThreads(where_);
+}
+
+std::optional<size_t> PreparedStatement::rowsNeeded() const {
+    if (!stmt_.limit) {
+        return std::nullopt;
+    }
+    return *stmt_.limit + stmt_.offset;
+}
+
+std::optional<PreparedStatement::OrderedScan> PreparedStatement::orderedScan(Table& table,
+                                                                             const AccessPath& path) const {
+    if (isAggregate() || !stmt_.joinName.empty() || sortKeys_.empty()) {
+        return std::nullopt;
+    }
+    
+    // 按访问路径读取再排序的代价
+    std::vector<DataType> types;
+    for (size_t column : sortInput_) {
+        types.push_back(columns_[column].type);
+    }
+    double sortCost = path.cost + Planner::sortCost(types, path.rows, DBManager::getInstance().getWorkMemory(),
+                                                    rowsNeeded());
+    
+    // 满足条件的行均匀分布在索引中时，读够需要的行数要读取的索引项数
+    double rows = static_cast<double>(table.getRowCount());
+    double wanted = rowsNeeded() ? std::min(rows, static_cast<double>(*rowsNeeded())) : rows;
+    double entries = path.rows > 0 ? std::min(rows, wanted * rows / path.rows) : rows;
+    
+    std::optional<OrderedScan> best;
+    for (size_t i = 0; i < table.getIndexCount(); ++i) {
+        const IndexDef& def = table.getIndexDef(i);
+        if (!table.supportsOrderedScan(i) || def.columns.size() < sortKeys_.size()) {
+            continue;
+        }
+        bool ordered = true;
+        for (size_t k = 0; k < sortKeys_.size(); ++k) {
+            ordered = ordered && sortInput_[sortKeys_[k].column] == def.columns[k] &&
+                      sortKeys_[k].descending == sortKeys_.front().descending;
+        }
+        double cost = Planner::orderedScanCost(table, i, entries);
+        if (ordered && cost < sortCost && (!best || cost < best->cost)) {
+            best = OrderedScan{i, entries, cost, sortCost};
+        }
+    }
+    return best;
+}
+
+std::vector<Record> PreparedStatement::selectSorted(Table& table, const AccessPath& path) {
+    // 按索引的顺序读取输出列，读够LIMIT + OFFSET行就停止
+    if (auto scan = orderedScan(table, path)) {
+        std::vector<size_t> output(sortInput_.begin(), sortInput_.begin() + outputCount());
+        if (auto rows = table.selectOrdered(where_, output, scan->index, sortKeys_.front().descending, rowsNeeded())) {
+            skipOffset(*rows);
+            return std::move(*rows);
+        }
+    }
+    
+    try {
+        ExternalSorter sorter = makeSorter();
+        std::unique_ptr<BatchOperator> input = table.selectBatches(where_, sortInput_, path);
+        RowBatch batch;
+        while (input->next(batch)) {
+            sorter.add(batch);
+        }
+        std::vector<Record> result = sorter.finish(stmt_.offset);
+        for (auto& row : result) {
+            row.resize(outputCount());
+        }
+        return result;
+    } catch (const std::exception& e) {
+        std::cerr << "排序失败: " << e.what() << std::endl;
+        return {};
+    }
+}
+
+ExternalSorter PreparedStatement::makeSorter() const {
+    std::vector<ColumnDef> columns;
+    for (size_t column : sortInput_) {
+        columns.push_back(columns_[column]);
+    }
+    return ExternalSorter(std::move(columns), sortKeys_, DBManager::getInstance().getWorkMemory(), rowsNeeded());
+}
+
+void PreparedStatement::skipOffset(std::vector<Record>& rows) const {
+    rows.erase(rows.begin(), rows.begin() + static_cast<std::ptrdiff_t>(std::min(stmt_.offset, rows.size())));
+}
+
+std::string PreparedStatement::describeOrder() const {
+    std::string text;
+    for (size_t i = 0; i < sortKeys_.size(); ++i) {
+        size_t column = sortKeys_[i].column;
+        text += i == 0 ? "" : ", ";
+        if (!isAggregate()) {
+            text += columns_[sortInput_[column]].name;
+        } else if (column < groupColumns_.size()) {
+            text += columns_[aggregateInput_[groupColumns_[column]]].name;
+        } else {
+            const AggregateSpec& spec = aggregates_[column - groupColumns_.size()];
+            text += std::string(aggregateName(spec.function)) + "(" +
+                    (spec.column ? columns_[aggregateInput_[*spec.column]].name : "*") + ")";
+        }
+        if (sortKeys_[i].descending) {
+            text += " desc";
+        }
+    }
+    return text;
+}
+
+bool PreparedStatement::countsAllRows() const {
+    return stmt_.joinName.empty() && where_.getKind() == Predicate::Kind::NONE && groupColumns_.empty() &&
+           std::all_of(aggregates_.begin(), aggregates_.end(), [](const AggregateSpec& spec) {
+               return spec.function == AggregateFunction::COUNT;
+           });
+}
+
+std::vector<Record> PreparedStatement::aggregate(Table& table, const AccessPath& path) {
+    // 表中的行数就是COUNT(*)，也是COUNT(列)（没有NULL值）
+    if (countsAllRows()) {
+        Record row(aggregates_.size(), static_cast<int>(table.getRowCount()));
+        return {row};
+    }
+    
+    try {
+        // 全表扫描按页块并行，不论满足条件的行有多少；索引查找得到的行足够多时才分给多个线程
+        size_t workers = DBManager::getInstance().getParallelWorkers();
+        size_t threads = path.method == AccessMethod::FULL_SCAN || path.rows >= kMinParallelAggregateRows ? workers : 1;
+        std::vector<HashAggregator> partials(threads, HashAggregator(groupColumns_, groupTypes_, aggregates_));
+        table.consumeBatches(where_, aggregateInput_, path, threads, [&](size_t worker, const RowBatch& batch) {
+            partials[worker].consume(batch);
+        });
+        for (size_t i = 1; i < partials.size(); ++i) {
+            partials.front().merge(partials[i]);
+        }
+        return partials.front().finish(sortKeys_);
+    } catch (const std::exception& e) {
+        std::cerr << "聚合查询失败: " << e.what() << std::endl;
+        return {};
+    }
+}
+
+std::vector<Record> PreparedStatement::aggregateResult(const std::vector<Record>& groups) const {
+    size_t count = std::min(groups.size(), rowsNeeded().value_or(groups.size()));
+    std::vector<Record> result;
+    result.reserve(count > stmt_.offset ? count - stmt_.offset : 0);
+    for (size_t i = stmt_.offset; i < count; ++i) {
+        Record& row = result.emplace_back();
+        for (size_t column : itemColumns_) {
+            row.push_back(groups[i][column]);
+        }
+    }
+    return result;
+}
+
+std::string PreparedStatement::describeAggregate() const {
+    std::string text = countsAllRows() ? "由表的行数得到" : "哈希聚合";
+    bool first = true;
+    for (size_t i = 0; i < itemNames_.size(); ++i) {
+        if (itemColumns_[i] >= groupColumns_.size()) {
+            text += (first ? " " : ", ") + itemNames_[i];
+            first = false;
+        }
+    }
+    for (size_t i = 0; i < groupColumns_.size(); ++i) {
+        text += (i == 0 ? "，分组列 " : ", ") + columns_[aggregateInput_[groupColumns_[i]]].name;
+    }
+    if (!sortKeys_.empty()) {
+        text += "，结果按 " + describeOrder() + " 排序";
+    }
+    return text;
+}
+
+JoinExecutor PreparedStatement::makeJoin(Table& left, Table& right) const {
+    // 输出列按连接后的位置给出，聚合查询为聚合的输入列
+    std::vector<size_t> output;
+    if (isAggregate()) {
+        output = aggregateInput_;
+    } else if (!sortInput_.empty()) {
+        output = sortInput_;
+    } else if (selectColumn_) {
+        output.push_back(*selectColumn_);
+    } else {
+        for (size_t i = 0; i < columns_.size(); ++i) {
+            output.push_back(i);
+        }
+    }
+    return JoinExecutor(left, leftKey_, right, rightKey_, where_, output);
+}
+
+SQLResult PreparedStatement::executeJoin(Table& left, Table& right) {
+    JoinExecutor join = makeJoin(left, right);
+    size_t memoryBudget = DBManager::getInstance().getWorkMemory();
+    JoinPlan plan = join.candidatePlans(memoryBudget).front();
+    if (!isAggregate() && sortKeys_.empty()) {
+        std::vector<Record> result = join.execute(plan, memoryBudget, rowsNeeded());
+        skipOffset(result);
+        return {SQLType::SELECT, formatResult(result), true};
+    }
+    
+    // 排序连接得到的各行，只保留输出列
+    if (!isAggregate()) {
+        try {
+            ExternalSorter sorter = makeSorter();
+            for (auto& row : join.execute(plan, memoryBudget, std::nullopt)) {
+                sorter.add(std::move(row));
+            }
+            std::vector<Record> result = sorter.finish(stmt_.offset);
+            for (auto& row : result) {
+                row.resize(outputCount());
+            }
+            return {SQLType::SELECT, formatResult(result), true};
+        } catch (const std::exception& e) {
+            std::cerr << "排序失败: " << e.what() << std::endl;
+            return {SQLType::SELECT, formatResult({}), true};
+        }
+    }
+    
+    // 聚合连接得到的各行，ORDER BY和LIMIT作用于聚合的结果
+    HashAggregator aggregator(groupColumns_, groupTypes_, aggregates_);
+    for (const auto& row : join.execute(plan, memoryBudget, std::nullopt)) {
+        aggregator.consume(row);
+    }
+    return {SQLType::SELECT, formatResult(aggregateResult(aggregator.finish(sortKeys_))), true};
+}
+
+SQLResult PreparedStatement::explainJoin(Table& left, Table& right) {
+    JoinExecutor join = makeJoin(left, right);
+    std::vector<JoinPlan> plans = join.candidatePlans(DBManager::getInstance().getWorkMemory());
+    
+    std::stringstream ss;
+    ss << std::fixed << std::setprecision(2);
+    ss << "查询计划：SELECT " << left.getName() << " join " << right.getName() << " on "
+       << columns_[leftKey_].name << " = " << columns_[left.getColumns().size() + rightKey_].name;
+    if (where_.getKind() != Predicate::Kind::NONE) {
+        ss << " where " << where_.toString(columns_);
+    }
+    if (!sortKeys_.empty()) {
+        ss << " order by " << describeOrder();
+    }
+    if (stmt_.limit) {
+        ss << " limit " << *stmt_.limit;
+    }
+    if (stmt_.offset > 0) {
+        ss << " offset " << stmt_.offset;
+    }
+    ss << std::endl;
+    
+    // 选中的计划、两侧的访问路径和连接后判断的条件，以及按代价排列的所有候选计划
+    auto line = [&](const std::string& text, double rows, double cost) {
+        ss << text << "  估计行数 " << std::llround(rows) << "  代价 " << cost << std::endl;
+    };
+    std::string indent = "  ";
+    if (isAggregate()) {
+        ss << indent << "-> " << describeAggregate() << std::endl;
+        indent += "  ";
+    } else if (!sortKeys_.empty()) {
+        ss << indent << "-> 排序 " << describeOrder();
+        if (auto needed = rowsNeeded()) {
+            ss << "，用堆保留前 " << *needed << " 行";
+        }
+        ss << std::endl;
+        indent += "  ";
+    }
+    ss << indent << "-> ";
+    line(join.describe(plans.front()), plans.front().rows, plans.front().cost);
+    for (size_t i = 0; i < 2; ++i) {
+        const JoinSide& side = join.getSide(i);
+        std::string text = indent + "   " + side.table->getName() + "：" + Planner::describe(*side.table, side.path);
+        if (side.where.getKind() != Predicate::Kind::NONE) {
+            text += " where " + side.where.toString(side.table->getColumns());
+        }
+        line(text, side.path.rows, side.path.cost);
+    }
+    if (join.getResidual().getKind() != Predicate::Kind::NONE) {
+        ss << indent << "   连接后判断：" << join.getResidual().toString(columns_) << std::endl;
+    }
+    ss << "候选计划：" << std::endl;
+    for (const auto& plan : plans) {
+        line("  " + join.describe(plan), plan.rows, plan.cost);
+    }
+    return {SQLType::EXPLAIN, ss.str(), true};
+}
+
+std::string PreparedStatement::formatResult(const std::vector<Record>& result) const {
+    std::stringstream ss;
+    ss << "查询结果：" << result.size() << " 条记录" << std::endl;
+    
+    // 如果有结果，显示结果
+    if (!result.empty()) {
+        // 结果的列名：聚合查询为SELECT列表的各项，否则为查询列或所有列
+        std::vector<std::string> names = itemNames_;
+        if (!isAggregate() && selectColumn_) {
+            names.push_back(columns_[*selectColumn_].name);
+        } else if (!isAggregate()) {
+            for (const auto& column : columns_) {
+                names.push_back(column.name);
+            }
+        }
+        
+        // 显示列名和分隔线
+        for (size_t i = 0; i < names.size(); ++i) {
+            ss << names[i];
+            if (i < names.size() - 1) {
+                ss << "\t";
+            }
+        }
+        ss << std::endl;
+        for (size_t i = 0; i < names.size(); ++i) {
+            ss << "--------";
+            if (i < names.size() - 1) {
+                ss << "\t";
+            }
+        }
+        ss << std::endl;
+        
+        // 显示记录
+        for (const auto& record : result) {
+            for (size_t i = 0; i < record.size(); ++i) {
+                if (std::holds_alternative<int>(record[i])) {
+                    ss << std::get<int>(record[i]);
+                } else {
+                    ss << std::get<std::string>(record[i]);
+                }
+                if (i < record.size() - 1) {
+                    ss << "\t";
+                }
+            }
+            ss << std::endl;
+        }
+    }
+    return ss.str();
+}
+
+} // namespace minidb
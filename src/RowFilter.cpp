@@ -0,0 +1,282 @@
+#include "../include/RowFilter.h"
+#include <optional>
+
+namespace minidb {
+
+namespace {
+
+using Node = RowFilter::Node;
+using NodePtr = std::shared_ptr<const Node>;
+
+// 特化的比较或区间
+template <typename Functor>
+struct FunctorNode : Node {
+    Functor functor;
+    
+    explicit FunctorNode(Functor functor) : functor(std::move(functor)) {}
+    
+    bool matches(const TupleView& row) const override { return functor(row); }
+};
+
+// 总是成立（没有条件）或总是不成立（值的类型与列类型不同）
+struct ConstantNode : Node {
+    bool value;
+    
+    explicit ConstantNode(bool value) : value(value) {}
+    
+    bool matches(const TupleView&) const override { return value; }
+};
+
+// AND和OR按子条件的顺序短路求值
+struct AndNode : Node {
+    std::vector<NodePtr> children;
+    
+    bool matches(const TupleView& row) const override {
+        for (const auto& child : children) {
+            if (!child->matches(row)) {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+struct OrNode : Node {
+    std::vector<NodePtr> children;
+    
+    bool matches(const TupleView& row) const override {
+        for (const auto& child : children) {
+            if (child->matches(row)) {
+                return true;
+            }
+        }
+        return false;
+    }
+};
+
+// 每列在元组中的固定偏移：前面都是INT列时可以直接算出，否则为npos
+std::vector<size_t> fixedOffsets(const std::vector<ColumnDef>& columns) {
+    std::vector<size_t> offsets(columns.size(), std::string_view::npos);
+    size_t offset = 0;
+    for (size_t i = 0; i < columns.size(); ++i) {
+        offsets[i] = offset;
+        if (columns[i].type != DataType::INT) {
+            break;
+        }
+        offset += sizeof(int32_t);
+    }
+    return offsets;
+}
+
+// 比较的列存在，并且值的类型与列类型相同
+bool isValidCompare(const Predicate& where, const std::vector<ColumnDef>& columns) {
+    if (where.getKind() != Predicate::Kind::COMPARE || where.getColumn() >= columns.size()) {
+        return false;
+    }
+    bool isInt = std::holds_alternative<int>(where.getValue());
+    return isInt == (columns[where.getColumn()].type == DataType::INT);
+}
+
+bool isLowerBound(Operator op) {
+    return op == Operator::GREATER_THAN || op == Operator::GREATER_EQUAL;
+}
+
+bool isUpperBound(Operator op) {
+    return op == Operator::LESS_THAN || op == Operator::LESS_EQUAL;
+}
+
+// 以编译期常量的形式把列类型和操作符交给fn，运行时的分派只在编译条件时发生一次
+template <typename Fn>
+decltype(auto) withType(DataType type, Fn&& fn) {
+    if (type == DataType::INT) {
+        return fn(std::integral_constant<DataType, DataType::INT>());
+    }
+    return fn(std::integral_constant<DataType, DataType::STRING>());
+}
+
+template <typename Fn>
+decltype(auto) withOperator(Operator op, Fn&& fn) {
+    switch (op) {
+        case Operator::EQUAL:
+            return fn(std::integral_constant<Operator, Operator::EQUAL>());
+        case Operator::NOT_EQUAL:
+            return fn(std::integral_constant<Operator, Operator::NOT_EQUAL>());
+        case Operator::LESS_THAN:
+            return fn(std::integral_constant<Operator, Operator::LESS_THAN>());
+        case Operator::LESS_EQUAL:
+            return fn(std::integral_constant<Operator, Operator::LESS_EQUAL>());
+        case Operator::GREATER_THAN:
+            return fn(std::integral_constant<Operator, Operator::GREATER_THAN>());
+        case Operator::GREATER_EQUAL:
+            break;
+    }
+    return fn(std::integral_constant<Operator, Operator::GREATER_EQUAL>());
+}
+
+// 区间的下界只能是 > 或 >=，上界只能是 < 或 <=
+template <typename Fn>
+decltype(auto) withBounds(Operator lowerOp, Operator upperOp, Fn&& fn) {
+    using GT = std::integral_constant<Operator, Operator::GREATER_THAN>;
+    using GE = std::integral_constant<Operator, Operator::GREATER_EQUAL>;
+    using LT = std::integral_constant<Operator, Operator::LESS_THAN>;
+    using LE = std::integral_constant<Operator, Operator::LESS_EQUAL>;
+    if (lowerOp == Operator::GREATER_THAN) {
+        return upperOp == Operator::LESS_THAN ? fn(GT(), LT()) : fn(GT(), LE());
+    }
+    return upperOp == Operator::LESS_THAN ? fn(GE(), LT()) : fn(GE(), LE());
+}
+
+// 取出比较的值，调用前已检查类型
+template <DataType Type>
+typename ColumnTraits<Type>::Stored storedValue(const Value& value) {
+    if constexpr (Type == DataType::INT) {
+        return std::get<int>(value);
+    } else {
+        return std::get<std::string>(value);
+    }
+}
+
+template <DataType Type, Operator Op>
+CompareFunctor<Type, Op> makeCompare(const Predicate& where, const std::vector<size_t>& offsets) {
+    CompareFunctor<Type, Op> functor;
+    functor.column = where.getColumn();
+    functor.offset = offsets[where.getColumn()];
+    functor.value = storedValue<Type>(where.getValue());
+    return functor;
+}
+
+template <DataType Type, Operator LowerOp, Operator UpperOp>
+RangeFunctor<Type, LowerOp, UpperOp> makeRange(const Predicate& lower, const Predicate& upper,
+                                               const std::vector<size_t>& offsets) {
+    RangeFunctor<Type, LowerOp, UpperOp> functor;
+    functor.column = lower.getColumn();
+    functor.offset = offsets[lower.getColumn()];
+    functor.lower = storedValue<Type>(lower.getValue());
+    functor.upper = storedValue<Type>(upper.getValue());
+    return functor;
+}
+
+// 两个比较是否是同一列上的下界和上界，是时按（下界，上界）的顺序返回
+std::optional<std::pair<const Predicate*, const Predicate*>> asBounds(const Predicate& a, const Predicate& b,
+                                                                      const std::vector<ColumnDef>& columns) {
+    if (!isValidCompare(a, columns) || !isValidCompare(b, columns) || a.getColumn() != b.getColumn()) {
+        return std::nullopt;
+    }
+    if (isLowerBound(a.getOp()) && isUpperBound(b.getOp())) {
+        return std::make_pair(&a, &b);
+    }
+    if (isUpperBound(a.getOp()) && isLowerBound(b.getOp())) {
+        return std::make_pair(&b, &a);
+    }
+    return std::nullopt;
+}
+
+NodePtr compileCompare(const Predicate& where, const std::vector<ColumnDef>& columns,
+                       const std::vector<size_t>& offsets) {
+    if (!isValidCompare(where, columns)) {
+        return std::make_shared<ConstantNode>(false);
+    }
+    return withType(columns[where.getColumn()].type, [&](auto type) {
+        return withOperator(where.getOp(), [&](auto op) -> NodePtr {
+            using Functor = CompareFunctor<decltype(type)::value, decltype(op)::value>;
+            return std::make_shared<FunctorNode<Functor>>(
+                makeCompare<decltype(type)::value, decltype(op)::value>(where, offsets));
+        });
+    });
+}
+
+NodePtr compileRange(const Predicate& lower, const Predicate& upper, const std::vector<ColumnDef>& columns,
+                     const std::vector<size_t>& offsets) {
+    return withType(columns[lower.getColumn()].type, [&](auto type) {
+        return withBounds(lower.getOp(), upper.getOp(), [&](auto lowerOp, auto upperOp) -> NodePtr {
+            constexpr DataType kType = decltype(type)::value;
+            constexpr Operator kLower = decltype(lowerOp)::value;
+            constexpr Operator kUpper = decltype(upperOp)::value;
+            return std::make_shared<FunctorNode<RangeFunctor<kType, kLower, kUpper>>>(
+                makeRange<kType, kLower, kUpper>(lower, upper, offsets));
+        });
+    });
+}
+
+NodePtr compileNode(const Predicate& where, const std::vector<ColumnDef>& columns,
+                    const std::vector<size_t>& offsets) {
+    switch (where.getKind()) {
+        case Predicate::Kind::NONE:
+            return std::make_shared<ConstantNode>(true);
+        case Predicate::Kind::COMPARE:
+            return compileCompare(where, columns, offsets);
+        case Predicate::Kind::OR: {
+            auto node = std::make_shared<OrNode>();
+            for (const auto& child : where.getChildren()) {
+                node->children.push_back(compileNode(child, columns, offsets));
+            }
+            return node;
+        }
+        case Predicate::Kind::AND:
+            break;
+    }
+    
+    // AND中同一列上的下界和上界合并为一个区间，放在两者中靠前的位置
+    const auto& children = where.getChildren();
+    std::vector<bool> merged(children.size(), false);
+    auto node = std::make_shared<AndNode>();
+    for (size_t i = 0; i < children.size(); ++i) {
+        if (merged[i]) {
+            continue;
+        }
+        NodePtr compiled;
+        for (size_t j = i + 1; j < children.size() && !compiled; ++j) {
+            if (merged[j]) {
+                continue;
+            }
+            if (auto bounds = asBounds(children[i], children[j], columns)) {
+                compiled = compileRange(*bounds->first, *bounds->second, columns, offsets);
+                merged[j] = true;
+            }
+        }
+        node->children.push_back(compiled ? compiled : compileNode(children[i], columns, offsets));
+    }
+    if (node->children.size() == 1) {
+        return node->children.front();
+    }
+    return node;
+}
+
+} // namespace
+
+RowFilter RowFilter::compile(const Predicate& where, const std::vector<ColumnDef>& columns) {
+    std::vector<size_t> offsets = fixedOffsets(columns);
+    RowFilter filter;
+    filter.root_ = compileNode(where, columns, offsets);
+    filter.compileTop(where, columns, offsets);
+    return filter;
+}
+
+void RowFilter::compileTop(const Predicate& where, const std::vector<ColumnDef>& columns,
+                           const std::vector<size_t>& offsets) {
+    if (isValidCompare(where, columns)) {
+        withType(columns[where.getColumn()].type, [&](auto type) {
+            withOperator(where.getOp(), [&](auto op) {
+                top_ = makeCompare<decltype(type)::value, decltype(op)::value>(where, offsets);
+            });
+        });
+        return;
+    }
+    
+    const auto& children = where.getChildren();
+    if (where.getKind() != Predicate::Kind::AND || children.size() != 2) {
+        return;
+    }
+    if (auto bounds = asBounds(children[0], children[1], columns)) {
+        const Predicate& lower = *bounds->first;
+        const Predicate& upper = *bounds->second;
+        withType(columns[lower.getColumn()].type, [&](auto type) {
+            withBounds(lower.getOp(), upper.getOp(), [&](auto lowerOp, auto upperOp) {
+                top_ = makeRange<decltype(type)::value, decltype(lowerOp)::value, decltype(upperOp)::value>(
+                    lower, upper, offsets);
+            });
+        });
+    }
+}
+
+} // namespace minidb
@@ -0,0 +1,114 @@
+#include "../include/SQLLexer.h"
+
+namespace minidb {
+
+namespace {
+
+// 空白字符
+bool isSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+// ASCII字母转为小写
+char lowerAscii(char c) {
+    return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+} // namespace
+
+bool Token::is(std::string_view keyword) const {
+    if (type != TokenType::WORD || text.size() != keyword.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < text.size(); ++i) {
+        if (lowerAscii(text[i]) != keyword[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::string SQLLexer::foldCase(std::string_view word) {
+    std::string result(word);
+    for (char& c : result) {
+        c = lowerAscii(c);
+    }
+    return result;
+}
+
+bool SQLLexer::isSymbol(char c) {
+    switch (c) {
+        case '(': case ')': case ',': case '=': case '<': case '>': case '*': case ';': case '?': case '!':
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool SQLLexer::tokenize(std::string_view sql, std::vector<Token>& tokens) {
+    tokens.clear();
+    size_t i = 0;
+    while (i < sql.size()) {
+        char c = sql[i];
+        if (isSpace(c)) {
+            ++i;
+            continue;
+        }
+        
+        if (c == '"' || c == '\'') {
+            // 字符串：到下一个不成对的同种引号为止，保留空格和大小写
+            size_t start = ++i;
+            while (true) {
+                if (i >= sql.size()) {
+                    return false;
+                }
+                if (sql[i] == c) {
+                    if (i + 1 < sql.size() && sql[i + 1] == c) {
+                        i += 2;
+                        continue;
+                    }
+                    break;
+                }
+                ++i;
+            }
+            tokens.push_back({TokenType::STRING, sql.substr(start - 1, i - start + 2)});
+            ++i;
+            continue;
+        }
+        
+        if (isSymbol(c)) {
+            // 两个字符的比较运算符作为一个记号
+            std::string_view pair = sql.substr(i, 2);
+            size_t length = (pair == "<=" || pair == ">=" || pair == "!=" || pair == "<>") ? 2 : 1;
+            tokens.push_back({TokenType::SYMBOL, sql.substr(i, length)});
+            i += length;
+            continue;
+        }
+        
+        // 单词：到空白、符号或引号为止
+        size_t start = i;
+        while (i < sql.size() && !isSpace(sql[i]) && !isSymbol(sql[i]) &&
+               sql[i] != '"' && sql[i] != '\'') {
+            ++i;
+        }
+        tokens.push_back({TokenType::WORD, sql.substr(start, i - start)});
+    }
+    tokens.push_back({TokenType::END, sql.substr(sql.size())});
+    return true;
+}
+
+std::string SQLLexer::unquote(const Token& token) {
+    char quote = token.text.front();
+    std::string_view body = token.text.substr(1, token.text.size() - 2);
+    std::string result;
+    result.reserve(body.size());
+    for (size_t i = 0; i < body.size(); ++i) {
+        result += body[i];
+        if (body[i] == quote) {
+            ++i;
+        }
+    }
+    return result;
+}
+
+} // namespace minidb
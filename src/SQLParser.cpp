@@ -1,10 +1,13 @@
 #include "../include/SQLParser.h"
+#include "../include/SQLLexer.h"
+#include "../include/PreparedStatement.h"
 #include "../include/DBManager.h"
+#include "../include/BufferPool.h"
 #include <iostream>
 #include <sstream>
-#include <regex>
 #include <algorithm>
 #include <cctype>
+#include <unordered_map>
 
 namespace minidb {
 
@@ -16,631 +19,1024 @@ std::string toLower(const std::string& str) {
     return result;
 }
 
-// 辅助函数：去除字符串前后空格
-std::string trim(const std::string& str) {
-    size_t first = str.find_first_not_of(" \t\n\r");
-    if (first == std::string::npos) {
-        return "";
+namespace {
+
+// WHERE条件中括号和NOT的最大嵌套层数
+constexpr size_t kMaxConditionDepth = 64;
+
+// buffer_pool_mb和work_mem_mb允许的最大值
+constexpr size_t kMaxBufferPoolMegabytes = 64 * 1024;
+constexpr size_t kMaxWorkMemoryMegabytes = 64 * 1024;
+
+// parallel_workers最多为硬件线程数的这个倍数
+constexpr size_t kMaxWorkersPerThread = 8;
+
+// 把SET的值解析为1到maxValue之间的整数；有符号、不是整数或超出范围时返回nullopt
+std::optional<size_t> parseSetting(const std::string& value, size_t maxValue) {
+    if (value.empty() || value.size() > 19 ||
+        !std::all_of(value.begin(), value.end(), [](unsigned char c) { return std::isdigit(c); })) {
+        return std::nullopt;
     }
-    size_t last = str.find_last_not_of(" \t\n\r");
-    return str.substr(first, last - first + 1);
+    size_t number = std::stoull(value);
+    if (number == 0 || number > maxValue) {
+        return std::nullopt;
+    }
+    return number;
 }
 
-// 辅助函数：分割字符串
-std::vector<std::string> split(const std::string& str, const std::string& delim) {
-    std::vector<std::string> tokens;
-    size_t prev = 0, pos = 0;
-    do {
-        pos = str.find(delim, prev);
-        if (pos == std::string::npos) {
-            pos = str.length();
+// 语句类型的名称，用于语法错误信息
+const char* statementName(SQLType type) {
+    switch (type) {
+        case SQLType::CREATE_DATABASE: return "CREATE DATABASE";
+        case SQLType::DROP_DATABASE: return "DROP DATABASE";
+        case SQLType::USE_DATABASE: return "USE";
+        case SQLType::CREATE_TABLE: return "CREATE TABLE";
+        case SQLType::DROP_TABLE: return "DROP TABLE";
+        case SQLType::CREATE_INDEX: return "CREATE INDEX";
+        case SQLType::DROP_INDEX: return "DROP INDEX";
+        case SQLType::INSERT: return "INSERT";
+        case SQLType::DELETE: return "DELETE";
+        case SQLType::UPDATE: return "UPDATE";
+        case SQLType::SELECT: return "SELECT";
+        case SQLType::SET: return "SET";
+        case SQLType::CHECKPOINT: return "CHECKPOINT";
+        case SQLType::PREPARE: return "PREPARE";
+        case SQLType::EXECUTE: return "EXECUTE";
+        case SQLType::DEALLOCATE: return "DEALLOCATE";
+        case SQLType::EXPLAIN: return "EXPLAIN";
+        default: return "SQL";
+    }
+}
+
+// 可以预编译的语句类型
+bool isPreparable(SQLType type) {
+    return type == SQLType::INSERT || type == SQLType::DELETE ||
+           type == SQLType::UPDATE || type == SQLType::SELECT;
+}
+
+// 以名字保存的预编译语句
+std::unordered_map<std::string, std::shared_ptr<PreparedStatement>>& preparedStatements() {
+    static std::unordered_map<std::string, std::shared_ptr<PreparedStatement>> statements;
+    return statements;
+}
+
+// 递归下降语法分析器：每条语法规则对应一个方法，不匹配时返回false。
+// 语句类型在读到开头的关键字后立即写入stmt，用于给出对应的语法错误信息
+class StatementParser {
+public:
+    explicit StatementParser(const std::vector<Token>& tokens) : tokens_(tokens) {}
+    
+    // statement := create ... | drop ... | use | insert | delete | update | select | set | checkpoint
+    //            | prepare identifier as statement | execute identifier ['(' [literal {',' literal}] ')']
+    //            | deallocate identifier | explain statement
+    bool parseStatement(Statement& stmt);
+    
+    // 语法错误以外的具体错误信息，为空时使用通用的语法错误信息
+    const std::string& error() const { return error_; }
+    
+    // 已读到的参数（?）个数
+    size_t paramCount() const { return paramCount_; }
+
+private:
+    const std::vector<Token>& tokens_;
+    size_t pos_ = 0;
+    size_t paramCount_ = 0;
+    std::string error_;
+    
+    // 当前记号
+    const Token& peek() const { return tokens_[pos_]; }
+    
+    // 当前记号是指定的关键字时跳过它
+    bool accept(std::string_view keyword) {
+        if (peek().is(keyword)) {
+            ++pos_;
+            return true;
+        }
+        return false;
+    }
+    
+    // 当前记号是指定的符号时跳过它
+    bool accept(char symbol) {
+        if (peek().is(symbol)) {
+            ++pos_;
+            return true;
+        }
+        return false;
+    }
+    
+    // 语句结束，允许一个结尾的分号
+    bool parseEnd() {
+        accept(';');
+        return peek().type == TokenType::END;
+    }
+    
+    // identifier := 由字母、数字和下划线组成的单词
+    bool parseIdentifier(std::string& name);
+    
+    // columnName := identifier ['.' identifier]，带表名前缀的列名在词法分析时就是一个单词
+    bool parseColumnName(std::string& name);
+    
+    // identifierList := '(' identifier {',' identifier} ')'
+    bool parseIdentifierList(std::vector<std::string>& names);
+    
+    // literal := 字符串 | 单词 | '?'
+    bool parseLiteral(Literal& literal);
+    
+    // literalList := '(' [literal {',' literal}] ')'
+    bool parseLiteralList(std::vector<Literal>& literals);
+    
+    // prepare identifier as statement，语句体只能是INSERT、DELETE、UPDATE或SELECT
+    bool parsePrepare(Statement& stmt);
+    
+    // 读取PREPARE或EXPLAIN的语句体
+    bool parseBody(Statement& stmt);
+    
+    // where := [where condition]
+    bool parseWhere(Statement& stmt);
+    
+    // condition := conjunction {or conjunction}
+    bool parseCondition(Condition& condition, size_t depth);
+    
+    // conjunction := negation {and negation}
+    bool parseConjunction(Condition& condition, size_t depth);
+    
+    // negation := not negation | '(' condition ')' | predicate
+    bool parseNegation(Condition& condition, size_t depth);
+    
+    // predicate := columnName (operator literal | [not] between literal and literal | [not] in literalList)，
+    // operator := '=' | '!=' | '<>' | '<' | '<=' | '>' | '>='
+    bool parsePredicate(Condition& condition);
+    
+    // create table name '(' [columnDef {',' columnDef}] ')'，columnDef := identifier identifier [primary]
+    bool parseCreateTable(Statement& stmt);
+    
+    // create index name on table identifierList [using identifier] [include identifierList]
+    bool parseCreateIndex(Statement& stmt);
+    
+    // insert table values literalList
+    bool parseInsert(Statement& stmt);
+    
+    // update table set identifier '=' literal where
+    bool parseUpdate(Statement& stmt);
+    
+    // select ('*' | selectItem {',' selectItem}) from table [[inner] join table on columnName '=' columnName]
+    //   where [group by columnName {',' columnName}] [order by selectItem [asc | desc] {',' ...}]
+    //   [limit 非负整数 [offset 非负整数]]
+    // 没有聚合函数和GROUP BY时SELECT列表只能是*或一列，ORDER BY中也不能有聚合函数
+    bool parseSelect(Statement& stmt);
+    
+    // selectItem := columnName | (count | sum | min | max | avg) '(' ('*' | columnName) ')'，只有COUNT可以用*
+    bool parseSelectItem(SelectItem& item);
+    
+    // 读取LIMIT子句中的行数和OFFSET中跳过的行数
+    bool parseLimit(Statement& stmt);
+    
+    // 读取一个非负整数
+    bool parseCount(size_t& count);
+};
+
+bool StatementParser::parseStatement(Statement& stmt) {
+    if (accept("create")) {
+        if (accept("database")) {
+            stmt.type = SQLType::CREATE_DATABASE;
+            return parseIdentifier(stmt.name) && parseEnd();
+        }
+        if (accept("table")) {
+            stmt.type = SQLType::CREATE_TABLE;
+            return parseCreateTable(stmt);
         }
-        std::string token = str.substr(prev, pos - prev);
-        if (!token.empty()) {
-            tokens.push_back(token);
+        if (accept("index")) {
+            stmt.type = SQLType::CREATE_INDEX;
+            return parseCreateIndex(stmt);
         }
-        prev = pos + delim.length();
-    } while (pos < str.length() && prev < str.length());
-    return tokens;
+        return false;
+    }
+    
+    if (accept("drop")) {
+        if (accept("database")) {
+            stmt.type = SQLType::DROP_DATABASE;
+            return parseIdentifier(stmt.name) && parseEnd();
+        }
+        if (accept("table")) {
+            stmt.type = SQLType::DROP_TABLE;
+            return parseIdentifier(stmt.name) && parseEnd();
+        }
+        if (accept("index")) {
+            stmt.type = SQLType::DROP_INDEX;
+            return parseIdentifier(stmt.indexName) && accept("on") &&
+                   parseIdentifier(stmt.name) && parseEnd();
+        }
+        return false;
+    }
+    
+    if (accept("use")) {
+        stmt.type = SQLType::USE_DATABASE;
+        return parseIdentifier(stmt.name) && parseEnd();
+    }
+    
+    if (accept("insert")) {
+        stmt.type = SQLType::INSERT;
+        return parseInsert(stmt);
+    }
+    
+    if (accept("delete")) {
+        stmt.type = SQLType::DELETE;
+        return parseIdentifier(stmt.name) && parseWhere(stmt) && parseEnd();
+    }
+    
+    if (accept("update")) {
+        stmt.type = SQLType::UPDATE;
+        return parseUpdate(stmt);
+    }
+    
+    if (accept("select")) {
+        stmt.type = SQLType::SELECT;
+        return parseSelect(stmt);
+    }
+    
+    if (accept("set")) {
+        stmt.type = SQLType::SET;
+        return parseIdentifier(stmt.setName) && accept('=') &&
+               parseLiteral(stmt.setValue) && parseEnd();
+    }
+    
+    if (accept("checkpoint")) {
+        stmt.type = SQLType::CHECKPOINT;
+        return parseEnd();
+    }
+    
+    if (accept("prepare")) {
+        stmt.type = SQLType::PREPARE;
+        return parsePrepare(stmt);
+    }
+    
+    if (accept("execute")) {
+        stmt.type = SQLType::EXECUTE;
+        if (!parseIdentifier(stmt.name)) {
+            return false;
+        }
+        return (peek().is('(') ? parseLiteralList(stmt.values) : true) && parseEnd();
+    }
+    
+    if (accept("deallocate")) {
+        stmt.type = SQLType::DEALLOCATE;
+        return parseIdentifier(stmt.name) && parseEnd();
+    }
+    
+    if (accept("explain")) {
+        stmt.type = SQLType::EXPLAIN;
+        return parseBody(stmt);
+    }
+    
+    return false;
 }
 
-SQLResult SQLParser::execute(const std::string& sql) {
-    // 将SQL语句转换为小写（保留字符串字面量的大小写）
-    std::string lowerSql = sql;
-    
-    // 去除前后空格
-    lowerSql = trim(lowerSql);
-    
-    // 确定SQL语句类型
-    if (lowerSql.substr(0, 15) == "create database") {//substr的第二个参数是提取长度
-        return parseCreateDatabase(lowerSql);
-    } else if (lowerSql.substr(0, 13) == "drop database") {
-        return parseDropDatabase(lowerSql);
-    } else if (lowerSql.substr(0, 3) == "use") {
-        return parseUse(lowerSql);
-    } else if (lowerSql.substr(0, 12) == "create table") {
-        return parseCreateTable(lowerSql);
-    } else if (lowerSql.substr(0, 10) == "drop table") {
-        return parseDropTable(lowerSql);
-    } else if (lowerSql.substr(0, 6) == "insert") {
-        return parseInsert(lowerSql);
-    } else if (lowerSql.substr(0, 6) == "delete") {
-        return parseDelete(lowerSql);
-    } else if (lowerSql.substr(0, 6) == "update") {
-        return parseUpdate(lowerSql);
-    } else if (lowerSql.substr(0, 6) == "select") {
-        return parseSelect(lowerSql);
-    } else {
-        return {SQLType::UNKNOWN, "错误：未知的SQL语句", false};
+bool StatementParser::parseIdentifier(std::string& name) {
+    const Token& token = peek();
+    if (token.type != TokenType::WORD) {
+        return false;
     }
+    for (char c : token.text) {
+        if (!std::isalnum(static_cast<unsigned char>(c)) && c != '_') {
+            return false;
+        }
+    }
+    name = SQLLexer::foldCase(token.text);
+    ++pos_;
+    return true;
 }
 
-SQLResult SQLParser::parseCreateDatabase(const std::string& sql) {
-    std::regex pattern(R"(create\s+database\s+(\w+))");
-    std::smatch matches;
+bool StatementParser::parseColumnName(std::string& name) {
+    const Token& token = peek();
+    if (token.type != TokenType::WORD) {
+        return false;
+    }
+    size_t dot = token.text.find('.');
+    if (dot == std::string_view::npos) {
+        return parseIdentifier(name);
+    }
     
-    if (std::regex_search(sql, matches, pattern) && matches.size() > 1) {
-        std::string dbName = matches[1].str();
-        
-        if (!isValidIdentifier(dbName)) {
-            return {SQLType::CREATE_DATABASE, "错误：无效的数据库名", false};
-        }
-        
-        if (DBManager::getInstance().createDatabase(dbName)) {
-            return {SQLType::CREATE_DATABASE, "数据库 " + dbName + " 创建成功", true};
-        } else {
-            return {SQLType::CREATE_DATABASE, "错误：创建数据库失败，数据库可能已存在", false};
+    // 表名和列名都不能为空，也不能再有点号
+    std::string_view table = token.text.substr(0, dot);
+    std::string_view column = token.text.substr(dot + 1);
+    auto isIdentifier = [](std::string_view part) {
+        return !part.empty() && std::all_of(part.begin(), part.end(), [](unsigned char c) {
+            return std::isalnum(c) || c == '_';
+        });
+    };
+    if (!isIdentifier(table) || !isIdentifier(column)) {
+        return false;
+    }
+    name = SQLLexer::foldCase(token.text);
+    ++pos_;
+    return true;
+}
+
+bool StatementParser::parseIdentifierList(std::vector<std::string>& names) {
+    if (!accept('(')) {
+        return false;
+    }
+    do {
+        if (!parseIdentifier(names.emplace_back())) {
+            return false;
         }
+    } while (accept(','));
+    return accept(')');
+}
+
+bool StatementParser::parseLiteral(Literal& literal) {
+    const Token& token = peek();
+    if (token.is('?')) {
+        literal.text.assign(token.text);
+        literal.param = static_cast<int>(paramCount_++);
+    } else if (token.type == TokenType::STRING) {
+        literal.text = SQLLexer::unquote(token);
+        literal.quoted = true;
+    } else if (token.type == TokenType::WORD) {
+        literal.text = SQLLexer::foldCase(token.text);
+        literal.quoted = false;
     } else {
-        return {SQLType::CREATE_DATABASE, "错误：CREATE DATABASE 语法错误", false};
+        return false;
+    }
+    ++pos_;
+    return true;
+}
+
+bool StatementParser::parseLiteralList(std::vector<Literal>& literals) {
+    if (!accept('(')) {
+        return false;
+    }
+    if (accept(')')) {
+        return true;
+    }
+    do {
+        if (!parseLiteral(literals.emplace_back())) {
+            return false;
+        }
+    } while (accept(','));
+    return accept(')');
+}
+
+bool StatementParser::parsePrepare(Statement& stmt) {
+    return parseIdentifier(stmt.name) && accept("as") && parseBody(stmt);
+}
+
+bool StatementParser::parseBody(Statement& stmt) {
+    auto body = std::make_shared<Statement>();
+    bool parsed = parseStatement(*body);
+    if (!parsed || !isPreparable(body->type)) {
+        // 语句体的语法错误按语句体的类型报告
+        if (!parsed && body->type != SQLType::UNKNOWN) {
+            stmt.type = body->type;
+        }
+        return false;
     }
+    body->paramCount = paramCount_;
+    stmt.body = body;
+    return true;
+}
+
+bool StatementParser::parseWhere(Statement& stmt) {
+    if (!accept("where")) {
+        return true;
+    }
+    if (!parseCondition(stmt.where.emplace(), 0)) {
+        error_ = "错误：无效的 WHERE 子句";
+        return false;
+    }
+    return true;
 }
 
-SQLResult SQLParser::parseDropDatabase(const std::string& sql) {
-    std::regex pattern(R"(drop\s+database\s+(\w+))");
-    std::smatch matches;
+bool StatementParser::parseCondition(Condition& condition, size_t depth) {
+    if (!parseConjunction(condition, depth)) {
+        return false;
+    }
+    if (!peek().is("or")) {
+        return true;
+    }
     
-    if (std::regex_search(sql, matches, pattern) && matches.size() > 1) {
-        std::string dbName = matches[1].str();
-        
-        if (DBManager::getInstance().dropDatabase(dbName)) {
-            return {SQLType::DROP_DATABASE, "数据库 " + dbName + " 删除成功", true};
-        } else {
-            return {SQLType::DROP_DATABASE, "错误：删除数据库失败，数据库可能不存在", false};
+    Condition first = std::move(condition);
+    condition = Condition{};
+    condition.type = ConditionType::OR;
+    condition.children.push_back(std::move(first));
+    while (accept("or")) {
+        if (!parseConjunction(condition.children.emplace_back(), depth)) {
+            return false;
         }
-    } else {
-        return {SQLType::DROP_DATABASE, "错误：DROP DATABASE 语法错误", false};
     }
+    return true;
 }
 
-SQLResult SQLParser::parseUse(const std::string& sql) {
-    std::regex pattern(R"(use\s+(\w+))");
-    std::smatch matches;
+bool StatementParser::parseConjunction(Condition& condition, size_t depth) {
+    if (!parseNegation(condition, depth)) {
+        return false;
+    }
+    if (!peek().is("and")) {
+        return true;
+    }
     
-    if (std::regex_search(sql, matches, pattern) && matches.size() > 1) {
-        std::string dbName = matches[1].str();
-        
-        if (DBManager::getInstance().useDatabase(dbName)) {
-            return {SQLType::USE_DATABASE, "数据库 " + dbName + " 切换成功", true};
-        } else {
-            return {SQLType::USE_DATABASE, "错误：切换数据库失败，数据库可能不存在", false};
+    Condition first = std::move(condition);
+    condition = Condition{};
+    condition.type = ConditionType::AND;
+    condition.children.push_back(std::move(first));
+    while (accept("and")) {
+        if (!parseNegation(condition.children.emplace_back(), depth)) {
+            return false;
         }
-    } else {
-        return {SQLType::USE_DATABASE, "错误：USE 语法错误", false};
     }
+    return true;
 }
 
-SQLResult SQLParser::parseCreateTable(const std::string& sql) {
-    std::regex pattern(R"(create\s+table\s+(\w+)\s*\((.*)\))");
-    std::smatch matches;
+bool StatementParser::parseNegation(Condition& condition, size_t depth) {
+    // 限制括号和NOT的嵌套层数，避免递归过深
+    if (depth >= kMaxConditionDepth) {
+        return false;
+    }
+    if (accept("not")) {
+        condition.type = ConditionType::NOT;
+        return parseNegation(condition.children.emplace_back(), depth + 1);
+    }
+    if (accept('(')) {
+        return parseCondition(condition, depth + 1) && accept(')');
+    }
+    return parsePredicate(condition);
+}
+
+bool StatementParser::parsePredicate(Condition& condition) {
+    if (!parseColumnName(condition.column)) {
+        return false;
+    }
     
-    if (std::regex_search(sql, matches, pattern) && matches.size() > 2) {
-        std::string tableName = matches[1].str();
-        std::string columnDefsStr = matches[2].str();
-        
-        if (!isValidIdentifier(tableName)) {
-            return {SQLType::CREATE_TABLE, "错误：无效的表名", false};
+    // 比较运算符
+    static const std::pair<std::string_view, Operator> kOperators[] = {
+        {"=", Operator::EQUAL}, {"!=", Operator::NOT_EQUAL}, {"<>", Operator::NOT_EQUAL},
+        {"<", Operator::LESS_THAN}, {"<=", Operator::LESS_EQUAL},
+        {">", Operator::GREATER_THAN}, {">=", Operator::GREATER_EQUAL}
+    };
+    for (const auto& [symbol, op] : kOperators) {
+        if (peek().isSymbol(symbol)) {
+            ++pos_;
+            condition.type = ConditionType::COMPARE;
+            condition.op = op;
+            return parseLiteral(condition.values.emplace_back());
         }
-        
-        // 获取当前数据库
-        auto db = DBManager::getInstance().getCurrentDatabase();
-        if (!db) {
-            return {SQLType::CREATE_TABLE, "错误：未选择数据库", false};
+    }
+    
+    // [not] between 和 [not] in 写成NOT包着的条件
+    bool negated = accept("not");
+    Condition predicate;
+    predicate.column = condition.column;
+    if (accept("between")) {
+        predicate.type = ConditionType::BETWEEN;
+        predicate.values.resize(2);
+        if (!parseLiteral(predicate.values[0]) || !accept("and") || !parseLiteral(predicate.values[1])) {
+            return false;
         }
-        
-        // 解析列定义
-        auto columns = parseColumnDefs(columnDefsStr);
-        if (columns.empty()) {
-            return {SQLType::CREATE_TABLE, "错误：无效的列定义", false};
+    } else if (accept("in")) {
+        predicate.type = ConditionType::IN;
+        if (!parseLiteralList(predicate.values) || predicate.values.empty()) {
+            return false;
         }
-        
-        // 转换列定义
-        std::vector<ColumnDef> columnDefs;
-        for (const auto& col : columns) {
-            DataType type;
-            try {
-                type = stringToDataType(col.type);
-            } catch (const std::exception& e) {
-                return {SQLType::CREATE_TABLE, "错误：无效的列类型：" + col.type, false};
+    } else {
+        return false;
+    }
+    
+    if (negated) {
+        condition = Condition{};
+        condition.type = ConditionType::NOT;
+        condition.children.push_back(std::move(predicate));
+    } else {
+        condition = std::move(predicate);
+    }
+    return true;
+}
+
+bool StatementParser::parseCreateTable(Statement& stmt) {
+    if (!parseIdentifier(stmt.name) || !accept('(')) {
+        return false;
+    }
+    if (!accept(')')) {
+        do {
+            CreateTableColumn& column = stmt.columnDefs.emplace_back();
+            if (!parseIdentifier(column.name) || !parseIdentifier(column.type)) {
+                return false;
             }
-            
-            if (!isValidIdentifier(col.name)) {
-                return {SQLType::CREATE_TABLE, "错误：无效的列名：" + col.name, false};
+            column.isPrimary = accept("primary");
+        } while (accept(','));
+        if (!accept(')')) {
+            return false;
+        }
+    }
+    return parseEnd();
+}
+
+bool StatementParser::parseCreateIndex(Statement& stmt) {
+    if (!parseIdentifier(stmt.indexName) || !accept("on") ||
+        !parseIdentifier(stmt.name) || !parseIdentifierList(stmt.columns)) {
+        return false;
+    }
+    if (accept("using") && !parseIdentifier(stmt.indexType)) {
+        return false;
+    }
+    if (accept("include") && !parseIdentifierList(stmt.includeColumns)) {
+        return false;
+    }
+    return parseEnd();
+}
+
+bool StatementParser::parseInsert(Statement& stmt) {
+    return parseIdentifier(stmt.name) && accept("values") &&
+           parseLiteralList(stmt.values) && parseEnd();
+}
+
+bool StatementParser::parseUpdate(Statement& stmt) {
+    return parseIdentifier(stmt.name) && accept("set") &&
+           parseIdentifier(stmt.setName) && accept('=') &&
+           parseLiteral(stmt.setValue) && parseWhere(stmt) && parseEnd();
+}
+
+bool StatementParser::parseSelect(Statement& stmt) {
+    std::vector<SelectItem> items;
+    if (accept('*')) {
+        stmt.columns.push_back("*");
+    } else {
+        do {
+            if (!parseSelectItem(items.emplace_back())) {
+                return false;
             }
-            
-            columnDefs.push_back({col.name, type, col.isPrimary});
+        } while (accept(','));
+    }
+    if (!accept("from") || !parseIdentifier(stmt.name)) {
+        return false;
+    }
+    // INNER可以省略
+    if (accept("inner") && !peek().is("join")) {
+        return false;
+    }
+    if (accept("join")) {
+        if (!parseIdentifier(stmt.joinName) || !accept("on") || !parseColumnName(stmt.joinLeft) ||
+            !accept('=') || !parseColumnName(stmt.joinRight)) {
+            return false;
         }
-        
-        // 创建表
-        if (db->createTable(tableName, columnDefs)) {
-            return {SQLType::CREATE_TABLE, "表 " + tableName + " 创建成功", true};
-        } else {
-            return {SQLType::CREATE_TABLE, "错误：创建表失败，表可能已存在", false};
+    }
+    if (!parseWhere(stmt)) {
+        return false;
+    }
+    if (accept("group")) {
+        if (!accept("by")) {
+            return false;
         }
-    } else {
-        return {SQLType::CREATE_TABLE, "错误：CREATE TABLE 语法错误", false};
+        do {
+            if (!parseColumnName(stmt.groupBy.emplace_back())) {
+                return false;
+            }
+        } while (accept(','));
+    }
+    if (accept("order")) {
+        if (!accept("by")) {
+            return false;
+        }
+        do {
+            OrderItem& order = stmt.orderBy.emplace_back();
+            if (!parseSelectItem(order.item)) {
+                return false;
+            }
+            if (accept("desc")) {
+                order.descending = true;
+            } else {
+                accept("asc");
+            }
+        } while (accept(','));
     }
+    if ((accept("limit") && !parseLimit(stmt)) || !parseEnd()) {
+        return false;
+    }
+    
+    // 有聚合函数或GROUP BY时保留整个SELECT列表，否则只能查询一列
+    bool aggregate = !stmt.groupBy.empty() || std::any_of(items.begin(), items.end(), [](const SelectItem& item) {
+        return item.function.has_value();
+    });
+    bool orderByAggregate = std::any_of(stmt.orderBy.begin(), stmt.orderBy.end(), [](const OrderItem& order) {
+        return order.item.function.has_value();
+    });
+    if (orderByAggregate && !aggregate) {
+        error_ = "错误：ORDER BY 中的聚合函数只能用于聚合查询";
+        return false;
+    }
+    if (aggregate && !stmt.columns.empty()) {
+        error_ = "错误：聚合查询不能使用 *";
+        return false;
+    }
+    if (aggregate) {
+        stmt.items = std::move(items);
+    } else if (items.size() == 1) {
+        stmt.columns.push_back(std::move(items.front().column));
+    } else if (!items.empty()) {
+        error_ = "错误：只能查询一列或 *";
+        return false;
+    }
+    return true;
 }
 
-SQLResult SQLParser::parseDropTable(const std::string& sql) {
-    std::regex pattern(R"(drop\s+table\s+(\w+))");
-    std::smatch matches;
+bool StatementParser::parseSelectItem(SelectItem& item) {
+    static const std::pair<std::string_view, AggregateFunction> kFunctions[] = {
+        {"count", AggregateFunction::COUNT},
+        {"sum", AggregateFunction::SUM},
+        {"min", AggregateFunction::MIN},
+        {"max", AggregateFunction::MAX},
+        {"avg", AggregateFunction::AVG}
+    };
     
-    if (std::regex_search(sql, matches, pattern) && matches.size() > 1) {
-        std::string tableName = matches[1].str();
-        
-        // 获取当前数据库
-        auto db = DBManager::getInstance().getCurrentDatabase();
-        if (!db) {
-            return {SQLType::DROP_TABLE, "错误：未选择数据库", false};
+    // 函数名后面紧跟左括号时才是聚合函数，否则是同名的列
+    if (peek().type == TokenType::WORD && tokens_[pos_ + 1].is('(')) {
+        for (const auto& [name, function] : kFunctions) {
+            if (peek().is(name)) {
+                item.function = function;
+                break;
+            }
         }
-        
-        // 删除表
-        if (db->dropTable(tableName)) {
-            return {SQLType::DROP_TABLE, "表 " + tableName + " 删除成功", true};
-        } else {
-            return {SQLType::DROP_TABLE, "错误：删除表失败，表可能不存在", false};
+    }
+    if (!item.function) {
+        return parseColumnName(item.column);
+    }
+    pos_ += 2;
+    if (item.function == AggregateFunction::COUNT && accept('*')) {
+        item.column = "*";
+    } else if (!parseColumnName(item.column)) {
+        return false;
+    }
+    return accept(')');
+}
+
+bool StatementParser::parseLimit(Statement& stmt) {
+    if (!parseCount(stmt.limit.emplace())) {
+        return false;
+    }
+    return !accept("offset") || parseCount(stmt.offset);
+}
+
+bool StatementParser::parseCount(size_t& count) {
+    const Token& token = peek();
+    if (token.type != TokenType::WORD || token.text.empty() || token.text.size() > 9) {
+        return false;
+    }
+    count = 0;
+    for (char c : token.text) {
+        if (!std::isdigit(static_cast<unsigned char>(c))) {
+            return false;
         }
+        count = count * 10 + static_cast<size_t>(c - '0');
+    }
+    ++pos_;
+    return true;
+}
+
+} // namespace
+
+SQLResult SQLParser::execute(const std::string& sql) {
+    Statement stmt;
+    std::string error;
+    if (!parse(sql, stmt, error)) {
+        return {stmt.type, error, false};
+    }
+    
+    // 一次性执行的INSERT、DELETE、UPDATE和SELECT也按预编译语句执行，不复制语法树
+    if (isPreparable(stmt.type)) {
+        return PreparedStatement(std::move(stmt)).execute();
+    }
+    return execute(stmt);
+}
+
+bool SQLParser::parse(std::string_view sql, Statement& stmt, std::string& error) {
+    std::vector<Token> tokens;
+    tokens.reserve(32);
+    if (!SQLLexer::tokenize(sql, tokens)) {
+        error = "错误：字符串缺少结束引号";
+        return false;
+    }
+    
+    StatementParser parser(tokens);
+    if (parser.parseStatement(stmt)) {
+        stmt.paramCount = parser.paramCount();
+        return true;
+    }
+    
+    if (stmt.type == SQLType::UNKNOWN) {
+        error = "错误：未知的SQL语句";
+    } else if (!parser.error().empty()) {
+        error = parser.error();
     } else {
-        return {SQLType::DROP_TABLE, "错误：DROP TABLE 语法错误", false};
+        error = std::string("错误：") + statementName(stmt.type) + " 语法错误";
     }
+    return false;
 }
 
-SQLResult SQLParser::parseInsert(const std::string& sql) {
-    std::regex pattern(R"(insert\s+(\w+)\s+values\s*\((.*)\))");
-    std::smatch matches;
+SQLResult SQLParser::execute(const Statement& stmt) {
+    switch (stmt.type) {
+        case SQLType::CREATE_DATABASE: return executeCreateDatabase(stmt);
+        case SQLType::DROP_DATABASE: return executeDropDatabase(stmt);
+        case SQLType::USE_DATABASE: return executeUse(stmt);
+        case SQLType::CREATE_TABLE: return executeCreateTable(stmt);
+        case SQLType::DROP_TABLE: return executeDropTable(stmt);
+        case SQLType::CREATE_INDEX: return executeCreateIndex(stmt);
+        case SQLType::DROP_INDEX: return executeDropIndex(stmt);
+        case SQLType::INSERT:
+        case SQLType::DELETE:
+        case SQLType::UPDATE:
+        case SQLType::SELECT: return PreparedStatement(stmt).execute();
+        case SQLType::SET: return executeSet(stmt);
+        case SQLType::CHECKPOINT: return executeCheckpoint(stmt);
+        case SQLType::PREPARE: return executePrepare(stmt);
+        case SQLType::EXECUTE: return executeExecute(stmt);
+        case SQLType::DEALLOCATE: return executeDeallocate(stmt);
+        case SQLType::EXPLAIN: return executeExplain(stmt);
+        default:
+            return {SQLType::UNKNOWN, "错误：未知的SQL语句", false};
+    }
+}
+
+std::shared_ptr<PreparedStatement> SQLParser::prepare(std::string_view sql, std::string& error) {
+    Statement stmt;
+    if (!parse(sql, stmt, error)) {
+        return nullptr;
+    }
+    if (!isPreparable(stmt.type)) {
+        error = "错误：只能预编译 INSERT、DELETE、UPDATE 和 SELECT 语句";
+        return nullptr;
+    }
     
-    if (std::regex_search(sql, matches, pattern) && matches.size() > 2) {
-        std::string tableName = matches[1].str();
-        std::string valueStr = matches[2].str();
-        
-        // 获取当前数据库
-        auto db = DBManager::getInstance().getCurrentDatabase();
-        if (!db) {
-            return {SQLType::INSERT, "错误：未选择数据库", false};
-        }
-        
-        // 获取表
-        auto table = db->getTable(tableName);
-        if (!table) {
-            return {SQLType::INSERT, "错误：表 " + tableName + " 不存在", false};
-        }
-        
-        // 解析值列表
-        auto valueList = parseValues(valueStr);
-        if (valueList.empty()) {
-            return {SQLType::INSERT, "错误：无效的值列表", false};
-        }
-        
-        // 获取表的列定义
-        const auto& columns = table->getColumns();
-        if (valueList.size() != columns.size()) {
-            return {SQLType::INSERT, "错误：值的数量与列的数量不匹配", false};
-        }
-        
-        // 转换值类型
-        std::vector<Value> values;
-        for (size_t i = 0; i < valueList.size(); ++i) {
-            try {
-                values.push_back(stringToValue(valueList[i], columns[i].type));
-            } catch (const std::exception& e) {
-                return {SQLType::INSERT, "错误：无效的值：" + valueList[i], false};
-            }
-        }
-        
-        // 插入记录
-        if (table->insert(values)) {
-            return {SQLType::INSERT, "记录插入成功", true};
-        } else {
-            return {SQLType::INSERT, "错误：插入记录失败，主键可能重复", false};
-        }
+    auto prepared = std::make_shared<PreparedStatement>(std::move(stmt));
+    SQLResult result = prepared->resolve();
+    if (!result.success) {
+        error = result.message;
+        return nullptr;
+    }
+    return prepared;
+}
+
+SQLResult SQLParser::executeCreateDatabase(const Statement& stmt) {
+    const std::string& dbName = stmt.name;
+    
+    if (!isValidIdentifier(dbName)) {
+        return {SQLType::CREATE_DATABASE, "错误：无效的数据库名", false};
+    }
+    
+    if (DBManager::getInstance().createDatabase(dbName)) {
+        return {SQLType::CREATE_DATABASE, "数据库 " + dbName + " 创建成功", true};
     } else {
-        return {SQLType::INSERT, "错误：INSERT 语法错误", false};
+        return {SQLType::CREATE_DATABASE, "错误：创建数据库失败，数据库可能已存在", false};
     }
 }
 
-SQLResult SQLParser::parseDelete(const std::string& sql) {
-    std::regex patternWithWhere(R"(delete\s+(\w+)\s+where\s+(.*))");
-    std::regex patternWithoutWhere(R"(delete\s+(\w+))");
-    std::smatch matches;
+SQLResult SQLParser::executeDropDatabase(const Statement& stmt) {
+    const std::string& dbName = stmt.name;
     
-    std::string tableName;
-    std::string whereClause;
-    bool hasWhere = false;
+    if (DBManager::getInstance().dropDatabase(dbName)) {
+        return {SQLType::DROP_DATABASE, "数据库 " + dbName + " 删除成功", true};
+    } else {
+        return {SQLType::DROP_DATABASE, "错误：删除数据库失败，数据库可能不存在", false};
+    }
+}
+
+SQLResult SQLParser::executeUse(const Statement& stmt) {
+    const std::string& dbName = stmt.name;
     
-    if (std::regex_search(sql, matches, patternWithWhere) && matches.size() > 2) {
-        tableName = matches[1].str();
-        whereClause = matches[2].str();
-        hasWhere = true;
-    } else if (std::regex_search(sql, matches, patternWithoutWhere) && matches.size() > 1) {
-        tableName = matches[1].str();
-        hasWhere = false;
+    if (DBManager::getInstance().useDatabase(dbName)) {
+        return {SQLType::USE_DATABASE, "数据库 " + dbName + " 切换成功", true};
     } else {
-        return {SQLType::DELETE, "错误：DELETE 语法错误", false};
+        return {SQLType::USE_DATABASE, "错误：切换数据库失败，数据库可能不存在", false};
+    }
+}
+
+SQLResult SQLParser::executeCreateTable(const Statement& stmt) {
+    const std::string& tableName = stmt.name;
+    
+    if (!isValidIdentifier(tableName)) {
+        return {SQLType::CREATE_TABLE, "错误：无效的表名", false};
     }
     
     // 获取当前数据库
     auto db = DBManager::getInstance().getCurrentDatabase();
     if (!db) {
-        return {SQLType::DELETE, "错误：未选择数据库", false};
+        return {SQLType::CREATE_TABLE, "错误：未选择数据库", false};
     }
     
-    // 获取表
-    auto table = db->getTable(tableName);
-    if (!table) {
-        return {SQLType::DELETE, "错误：表 " + tableName + " 不存在", false};
+    if (stmt.columnDefs.empty()) {
+        return {SQLType::CREATE_TABLE, "错误：无效的列定义", false};
     }
     
-    int count = 0;
-    if (hasWhere) {
-        // 解析WHERE子句
-        auto whereResult = parseWhereClause(whereClause);
-        if (!whereResult.has_value()) {
-            return {SQLType::DELETE, "错误：无效的 WHERE 子句", false};
-        }
-        
-        auto [colName, op, valueStr] = whereResult.value();
-        
-        // 获取列类型
-        auto columns = table->getColumns();
-        int colIndex = -1;
-        for (size_t i = 0; i < columns.size(); ++i) {
-            if (columns[i].name == colName) {
-                colIndex = static_cast<int>(i);
-                break;
-            }
-        }
-        
-        if (colIndex == -1) {
-            return {SQLType::DELETE, "错误：列 " + colName + " 不存在", false};
-        }
-        
-        DataType colType = columns[colIndex].type;
-        
-        // 转换值类型
-        Value value;
+    // 转换列定义
+    std::vector<ColumnDef> columnDefs;
+    for (const auto& col : stmt.columnDefs) {
+        DataType type;
         try {
-            value = stringToValue(valueStr, colType);
+            type = stringToDataType(col.type);
         } catch (const std::exception& e) {
-            return {SQLType::DELETE, "错误：无效的值：" + valueStr, false};
+            return {SQLType::CREATE_TABLE, "错误：无效的列类型：" + col.type, false};
         }
         
-        // 删除记录
-        count = table->deleteWhere(colName, op, value);
-    } else {
-        // 删除所有记录
-        count = table->deleteWhere("", Operator::EQUAL, 0);
+        if (!isValidIdentifier(col.name)) {
+            return {SQLType::CREATE_TABLE, "错误：无效的列名：" + col.name, false};
+        }
+        
+        columnDefs.push_back({col.name, type, col.isPrimary});
     }
     
-    return {SQLType::DELETE, "已删除 " + std::to_string(count) + " 条记录", true};
+    // 创建表
+    if (db->createTable(tableName, columnDefs)) {
+        return {SQLType::CREATE_TABLE, "表 " + tableName + " 创建成功", true};
+    } else {
+        return {SQLType::CREATE_TABLE, "错误：创建表失败，表可能已存在", false};
+    }
 }
 
-SQLResult SQLParser::parseUpdate(const std::string& sql) {
-    std::regex pattern(R"(update\s+(\w+)\s+set\s+(\w+)\s*=\s*([^,\s]+)(?:\s+where\s+(.*))?)", std::regex::icase);
-    std::smatch matches;
+SQLResult SQLParser::executeDropTable(const Statement& stmt) {
+    const std::string& tableName = stmt.name;
     
-    if (std::regex_search(sql, matches, pattern) && matches.size() > 3) {
-        std::string tableName = matches[1].str();
-        std::string setColName = matches[2].str();
-        std::string setValueStr = matches[3].str();
-        std::string whereClause = matches.size() > 4 ? matches[4].str() : "";
-        bool hasWhere = !whereClause.empty();
-        
-        // 获取当前数据库
-        auto db = DBManager::getInstance().getCurrentDatabase();
-        if (!db) {
-            return {SQLType::UPDATE, "错误：未选择数据库", false};
-        }
-        
-        // 获取表
-        auto table = db->getTable(tableName);
-        if (!table) {
-            return {SQLType::UPDATE, "错误：表 " + tableName + " 不存在", false};
-        }
-        
-        // 获取设置列的类型
-        auto columns = table->getColumns();
-        int setColIndex = -1;
-        for (size_t i = 0; i < columns.size(); ++i) {
-            if (columns[i].name == setColName) {
-                setColIndex = static_cast<int>(i);
-                break;
-            }
-        }
-        
-        if (setColIndex == -1) {
-            return {SQLType::UPDATE, "错误：列 " + setColName + " 不存在", false};
-        }
-        
-        DataType setColType = columns[setColIndex].type;
-        
-        // 转换设置值类型
-        Value setValue;
-        try {
-            setValue = stringToValue(setValueStr, setColType);
-        } catch (const std::exception& e) {
-            return {SQLType::UPDATE, "错误：无效的值：" + setValueStr, false};
-        }
-        
-        int count = 0;
-        if (hasWhere) {
-            // 解析WHERE子句
-            auto whereResult = parseWhereClause(whereClause);
-            if (!whereResult.has_value()) {
-                return {SQLType::UPDATE, "错误：无效的 WHERE 子句", false};
-            }
-            
-            auto [whereColName, op, whereValueStr] = whereResult.value();
-            
-            // 获取WHERE列的类型
-            int whereColIndex = -1;
-            for (size_t i = 0; i < columns.size(); ++i) {
-                if (columns[i].name == whereColName) {
-                    whereColIndex = static_cast<int>(i);
-                    break;
-                }
-            }
-            
-            if (whereColIndex == -1) {
-                return {SQLType::UPDATE, "错误：列 " + whereColName + " 不存在", false};
-            }
-            
-            DataType whereColType = columns[whereColIndex].type;
-            
-            // 转换WHERE值类型
-            Value whereValue;
-            try {
-                whereValue = stringToValue(whereValueStr, whereColType);
-            } catch (const std::exception& e) {
-                return {SQLType::UPDATE, "错误：无效的值：" + whereValueStr, false};
-            }
-            
-            // 更新记录
-            count = table->updateWhere(setColName, setValue, whereColName, op, whereValue);
-        } else {
-            // 更新所有记录
-            count = table->updateWhere(setColName, setValue, "", Operator::EQUAL, 0);
-        }
-        
-        return {SQLType::UPDATE, "已更新 " + std::to_string(count) + " 条记录", true};
+    // 获取当前数据库
+    auto db = DBManager::getInstance().getCurrentDatabase();
+    if (!db) {
+        return {SQLType::DROP_TABLE, "错误：未选择数据库", false};
+    }
+    
+    // 删除表
+    if (db->dropTable(tableName)) {
+        return {SQLType::DROP_TABLE, "表 " + tableName + " 删除成功", true};
     } else {
-        return {SQLType::UPDATE, "错误：UPDATE 语法错误", false};
+        return {SQLType::DROP_TABLE, "错误：删除表失败，表可能不存在", false};
     }
 }
 
-SQLResult SQLParser::parseSelect(const std::string& sql) {
-    std::regex patternWithWhere(R"(select\s+(\S+)\s+from\s+(\w+)\s+where\s+(.*))", std::regex::icase);
-    std::regex patternWithoutWhere(R"(select\s+(\S+)\s+from\s+(\w+))", std::regex::icase);
-    std::smatch matches;
+SQLResult SQLParser::executeCreateIndex(const Statement& stmt) {
+    const std::string& indexName = stmt.indexName;
     
-    std::string selectCol;
-    std::string tableName;
-    std::string whereClause;
-    bool hasWhere = false;
+    if (!isValidIdentifier(indexName)) {
+        return {SQLType::CREATE_INDEX, "错误：无效的索引名", false};
+    }
     
-    if (std::regex_search(sql, matches, patternWithWhere) && matches.size() > 3) {
-        selectCol = matches[1].str();
-        tableName = matches[2].str();
-        whereClause = matches[3].str();
-        hasWhere = true;
-    } else if (std::regex_search(sql, matches, patternWithoutWhere) && matches.size() > 2) {
-        selectCol = matches[1].str();
-        tableName = matches[2].str();
-        hasWhere = false;
-    } else {
-        return {SQLType::SELECT, "错误：SELECT 语法错误", false};
+    // 索引类型：默认为B+树，USING HASH时为哈希索引
+    IndexType type = IndexType::BTREE;
+    std::string typeName = toLower(stmt.indexType);
+    if (typeName == "hash") {
+        type = IndexType::HASH;
+    } else if (!typeName.empty() && typeName != "btree") {
+        return {SQLType::CREATE_INDEX, "错误：无效的索引类型：" + stmt.indexType, false};
     }
     
     // 获取当前数据库
     auto db = DBManager::getInstance().getCurrentDatabase();
     if (!db) {
-        return {SQLType::SELECT, "错误：未选择数据库", false};
+        return {SQLType::CREATE_INDEX, "错误：未选择数据库", false};
     }
     
-    // 获取表
-    auto table = db->getTable(tableName);
-    if (!table) {
-        return {SQLType::SELECT, "错误：表 " + tableName + " 不存在", false};
+    // 创建索引，多列索引按列出的顺序比较；INCLUDE中的列只保存在索引中
+    if (db->createIndex(stmt.name, indexName, stmt.columns, type, stmt.includeColumns)) {
+        return {SQLType::CREATE_INDEX, "索引 " + indexName + " 创建成功", true};
+    } else {
+        return {SQLType::CREATE_INDEX, "错误：创建索引失败，表或列可能不存在，或索引已存在", false};
     }
+}
+
+SQLResult SQLParser::executeDropIndex(const Statement& stmt) {
+    const std::string& indexName = stmt.indexName;
     
-    // 获取表的列定义
-    const auto& columns = table->getColumns();
+    // 获取当前数据库
+    auto db = DBManager::getInstance().getCurrentDatabase();
+    if (!db) {
+        return {SQLType::DROP_INDEX, "错误：未选择数据库", false};
+    }
     
-    std::vector<Record> result;
-    if (hasWhere) {
-        // 解析WHERE子句
-        auto whereResult = parseWhereClause(whereClause);
-        if (!whereResult.has_value()) {
-            return {SQLType::SELECT, "错误：无效的 WHERE 子句", false};
-        }
-        
-        auto [colName, op, valueStr] = whereResult.value();
-        
-        // 获取列类型
-        int colIndex = -1;
-        for (size_t i = 0; i < columns.size(); ++i) {
-            if (columns[i].name == colName) {
-                colIndex = static_cast<int>(i);
-                break;
-            }
-        }
-        
-        if (colIndex == -1) {
-            return {SQLType::SELECT, "错误：列 " + colName + " 不存在", false};
-        }
-        
-        DataType colType = columns[colIndex].type;
-        
-        // 转换值类型
-        Value value;
-        try {
-            value = stringToValue(valueStr, colType);
-        } catch (const std::exception& e) {
-            return {SQLType::SELECT, "错误：无效的值：" + valueStr, false};
-        }
-        
-        // 查询记录
-        result = table->selectWhere(colName, op, value, selectCol);
+    // 删除索引
+    if (db->dropIndex(stmt.name, indexName)) {
+        return {SQLType::DROP_INDEX, "索引 " + indexName + " 删除成功", true};
     } else {
-        // 查询所有记录
-        result = table->selectAll(selectCol);
-    }
-    
-    // 构建结果消息
-    std::stringstream ss;
-    ss << "查询结果：" << result.size() << " 条记录" << std::endl;
-    
-    // 如果有结果，显示结果
-    if (!result.empty()) {
-        // 显示列名
-        if (selectCol == "*") {
-            for (size_t i = 0; i < columns.size(); ++i) {
-                ss << columns[i].name;
-                if (i < columns.size() - 1) {
-                    ss << "\t";
-                }
-            }
+        return {SQLType::DROP_INDEX, "错误：删除索引失败，索引可能不存在", false};
+    }
+}
+
+SQLResult SQLParser::executeSet(const Statement& stmt) {
+    const std::string& name = stmt.setName;
+    const std::string& value = stmt.setValue.text;
+    
+    if (name == "wal_sync") {
+        // 设置日志刷盘策略
+        WALSyncMode mode;
+        if (value == "off") {
+            mode = WALSyncMode::OFF;
+        } else if (value == "normal") {
+            mode = WALSyncMode::NORMAL;
+        } else if (value == "full") {
+            mode = WALSyncMode::FULL;
         } else {
-            ss << selectCol;
+            return {SQLType::SET, "错误：wal_sync 只能为 off、normal 或 full", false};
         }
-        ss << std::endl;
-        
-        // 显示分隔线
-        if (selectCol == "*") {
-            for (size_t i = 0; i < columns.size(); ++i) {
-                ss << "--------";
-                if (i < columns.size() - 1) {
-                    ss << "\t";
-                }
-            }
-        } else {
-            ss << "--------";
+        DBManager::getInstance().setWalSyncMode(mode);
+        return {SQLType::SET, "wal_sync 已设置为 " + value, true};
+    }
+    
+    if (name == "buffer_pool_mb") {
+        // 设置缓冲池内存预算
+        auto megabytes = parseSetting(value, kMaxBufferPoolMegabytes);
+        if (!megabytes) {
+            return {SQLType::SET, "错误：buffer_pool_mb 必须为 1 到 " + std::to_string(kMaxBufferPoolMegabytes) +
+                                  " 之间的整数", false};
         }
-        ss << std::endl;
-        
-        // 显示记录
-        for (const auto& record : result) {
-            for (size_t i = 0; i < record.size(); ++i) {
-                if (std::holds_alternative<int>(record[i])) {
-                    ss << std::get<int>(record[i]);
-                } else {
-                    ss << std::get<std::string>(record[i]);
-                }
-                if (i < record.size() - 1) {
-                    ss << "\t";
-                }
-            }
-            ss << std::endl;
+        BufferPool::getInstance().setCapacity(*megabytes * 1024 * 1024 / kPageSize);
+        return {SQLType::SET, "buffer_pool_mb 已设置为 " + value, true};
+    }
+    
+    if (name == "work_mem_mb") {
+        // 设置查询执行的内存预算
+        auto megabytes = parseSetting(value, kMaxWorkMemoryMegabytes);
+        if (!megabytes) {
+            return {SQLType::SET, "错误：work_mem_mb 必须为 1 到 " + std::to_string(kMaxWorkMemoryMegabytes) +
+                                  " 之间的整数", false};
         }
+        DBManager::getInstance().setWorkMemory(*megabytes * 1024 * 1024);
+        return {SQLType::SET, "work_mem_mb 已设置为 " + value, true};
     }
     
-    return {SQLType::SELECT, ss.str(), true};
-}
-
-std::optional<std::tuple<std::string, Operator, std::string>> SQLParser::parseWhereClause(const std::string& whereClause) {
-    std::regex pattern(R"((\w+)\s*([=<>])\s*([^,\s]+))");
-    std::smatch matches;
+    if (name == "parallel_workers") {
+        // 设置一个查询最多使用的工作线程数，1表示不并行
+        auto workers = parseSetting(value, kMaxWorkersPerThread * hardwareThreads());
+        if (!workers) {
+            return {SQLType::SET, "错误：parallel_workers 必须为正整数，且不超过硬件线程数的 " +
+                                  std::to_string(kMaxWorkersPerThread) + " 倍", false};
+        }
+        DBManager::getInstance().setParallelWorkers(*workers);
+        return {SQLType::SET, "parallel_workers 已设置为 " + value, true};
+    }
     
-    if (std::regex_search(whereClause, matches, pattern) && matches.size() > 3) {
-        std::string colName = matches[1].str();
-        std::string op = matches[2].str();
-        std::string value = matches[3].str();
-        
-        return std::make_tuple(colName, stringToOperator(op), value);
+    if (name == "mmap_reads") {
+        // 设置只读访问是否直接读取文件映射区
+        if (value != "on" && value != "off") {
+            return {SQLType::SET, "错误：mmap_reads 只能为 on 或 off", false};
+        }
+        BufferPool::getInstance().setMmapReads(value == "on");
+        return {SQLType::SET, "mmap_reads 已设置为 " + value, true};
     }
     
-    return std::nullopt;
+    return {SQLType::SET, "错误：未知的设置项：" + name, false};
 }
 
-std::vector<std::string> SQLParser::parseValues(const std::string& values) {
-    std::vector<std::string> result;
-    std::string current;
-    bool inQuotes = false;
+SQLResult SQLParser::executeCheckpoint(const Statement& stmt) {
+    (void)stmt;
     
-    for (size_t i = 0; i < values.length(); ++i) {
-        char c = values[i];
-        
-        if (c == '"') {
-            inQuotes = !inQuotes;
-            if (!inQuotes) {
-                // 引号结束，添加当前字符串到结果
-                result.push_back(current);
-                current.clear();
-            }
-        } else if (c == ',' && !inQuotes) {
-            // 逗号分隔符，如果不在引号内，则添加当前字符串到结果
-            if (!current.empty()) {
-                result.push_back(current);
-                current.clear();
-            }
-        } else if (!inQuotes && (c == ' ' || c == '\t')) {
-            // 忽略引号外的空白字符
-            continue;
-        } else {
-            // 添加字符到当前字符串
-            current += c;
-        }
+    // 获取当前数据库
+    auto db = DBManager::getInstance().getCurrentDatabase();
+    if (!db) {
+        return {SQLType::CHECKPOINT, "错误：未选择数据库", false};
     }
     
-    // 添加最后一个字符串（如果有）
-    if (!current.empty()) {
-        result.push_back(current);
+    if (db->checkpoint()) {
+        return {SQLType::CHECKPOINT, "检查点写出成功", true};
+    } else {
+        return {SQLType::CHECKPOINT, "错误：写出检查点失败", false};
+    }
+}
+
+SQLResult SQLParser::executePrepare(const Statement& stmt) {
+    // 预编译时就解析表和列，表或列不存在时直接报错
+    auto prepared = std::make_shared<PreparedStatement>(*stmt.body);
+    SQLResult result = prepared->resolve();
+    if (!result.success) {
+        return {SQLType::PREPARE, result.message, false};
     }
     
-    return result;
+    // 同名的预编译语句被替换
+    preparedStatements()[stmt.name] = prepared;
+    return {SQLType::PREPARE, "语句 " + stmt.name + " 预编译成功", true};
 }
 
-std::vector<CreateTableColumn> SQLParser::parseColumnDefs(const std::string& columnDefs) {
-    std::vector<CreateTableColumn> result;
-    std::regex pattern(R"((\w+)\s+(\w+)(?:\s+primary)?)");
-    std::sregex_iterator it(columnDefs.begin(), columnDefs.end(), pattern);
-    std::sregex_iterator end;
+SQLResult SQLParser::executeExecute(const Statement& stmt) {
+    auto it = preparedStatements().find(stmt.name);
+    if (it == preparedStatements().end()) {
+        return {SQLType::EXECUTE, "错误：预编译语句 " + stmt.name + " 不存在", false};
+    }
+    PreparedStatement& prepared = *it->second;
     
-    while (it != end) {
-        std::smatch match = *it;
-        if (match.size() > 2) {
-            std::string name = match[1].str();
-            std::string type = match[2].str();
-            bool isPrimary = match.str().find("primary") != std::string::npos;
-            
-            result.push_back({name, type, isPrimary});
+    // 绑定参数
+    if (stmt.values.size() != prepared.getParamCount()) {
+        return {SQLType::EXECUTE, "错误：参数的数量与预编译语句不匹配", false};
+    }
+    for (size_t i = 0; i < stmt.values.size(); ++i) {
+        if (stmt.values[i].param >= 0 || !prepared.bind(i, stmt.values[i].text)) {
+            return {SQLType::EXECUTE, "错误：无效的值：" + stmt.values[i].text, false};
         }
-        ++it;
     }
     
-    return result;
+    return prepared.execute();
 }
 
-Operator SQLParser::stringToOperator(const std::string& op) {
-    if (op == "=") {
-        return Operator::EQUAL;
-    } else if (op == "<") {
-        return Operator::LESS_THAN;
-    } else if (op == ">") {
-        return Operator::GREATER_THAN;
-    } else {
-        throw std::invalid_argument("无效的操作符：" + op);
+SQLResult SQLParser::executeDeallocate(const Statement& stmt) {
+    if (preparedStatements().erase(stmt.name) == 0) {
+        return {SQLType::DEALLOCATE, "错误：预编译语句 " + stmt.name + " 不存在", false};
     }
+    return {SQLType::DEALLOCATE, "预编译语句 " + stmt.name + " 已释放", true};
+}
+
+SQLResult SQLParser::executeExplain(const Statement& stmt) {
+    return PreparedStatement(*stmt.body).explain();
 }
 
 DataType SQLParser::stringToDataType(const std::string& type) {
@@ -654,13 +1050,6 @@ DataType SQLParser::stringToDataType(const std::string& type) {
     }
 }
 
-std::string SQLParser::extractQuotedString(const std::string& str) {
-    if (str.size() >= 2 && str.front() == '"' && str.back() == '"') {
-        return str.substr(1, str.size() - 2);
-    }
-    return str;
-}
-
 bool SQLParser::isValidIdentifier(const std::string& identifier) {
     if (identifier.empty()) {
         return false;
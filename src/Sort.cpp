@@ -0,0 +1,206 @@
+#include "../include/Sort.h"
+#include "../include/HeapFile.h"
+#include <algorithm>
+
+namespace minidb {
+
+namespace {
+
+// 比较两个同类型的值
+template <typename T>
+int compareValue(const T& a, const T& b) {
+    return a < b ? -1 : (b < a ? 1 : 0);
+}
+
+// 批中第i行与一行按排序键比较，含义与compareRows相同
+int compareBatchRow(const RowBatch& batch, uint16_t i, const Record& row, const std::vector<SortKey>& keys) {
+    for (const auto& key : keys) {
+        const ColumnVector& column = batch.columns[key.column];
+        int cmp = column.type == DataType::INT
+            ? compareValue(column.ints[i], static_cast<int32_t>(std::get<int>(row[key.column])))
+            : compareValue(column.strings[i], std::string_view(std::get<std::string>(row[key.column])));
+        if (cmp != 0) {
+            return key.descending ? -cmp : cmp;
+        }
+    }
+    return 0;
+}
+
+// 批中第i行转换为记录
+Record batchRecord(const RowBatch& batch, uint16_t i) {
+    Record row;
+    row.reserve(batch.columns.size());
+    for (const auto& column : batch.columns) {
+        if (column.type == DataType::INT) {
+            row.emplace_back(static_cast<int>(column.ints[i]));
+        } else {
+            row.emplace_back(std::string(column.strings[i]));
+        }
+    }
+    return row;
+}
+
+} // namespace
+
+int compareRows(const Record& a, const Record& b, const std::vector<SortKey>& keys) {
+    for (const auto& key : keys) {
+        int cmp = compareValue(a[key.column], b[key.column]);
+        if (cmp != 0) {
+            return key.descending ? -cmp : cmp;
+        }
+    }
+    return 0;
+}
+
+ExternalSorter::ExternalSorter(std::vector<ColumnDef> columns, std::vector<SortKey> keys, size_t memoryBudget,
+                               std::optional<size_t> limit)
+    : columns_(std::move(columns)), keys_(std::move(keys)), memoryBudget_(memoryBudget), limit_(limit),
+      useHeap_(limit.has_value()) {}
+
+void ExternalSorter::add(Record row) {
+    if (useHeap_) {
+        push(std::move(row));
+        return;
+    }
+    memoryUsage_ += rowBytes(row);
+    entries_.push_back({std::move(row), sequence_++});
+    if (memoryUsage_ > memoryBudget_) {
+        spill();
+    }
+}
+
+void ExternalSorter::add(const RowBatch& batch) {
+    for (uint16_t i : batch.selection) {
+        // 堆已满时，不排在堆顶前面的行不会进入结果（键相等时后加入的行排在后面）
+        if (useHeap_ && entries_.size() >= *limit_ &&
+            (*limit_ == 0 || compareBatchRow(batch, i, entries_.front().row, keys_) >= 0)) {
+            ++sequence_;
+            continue;
+        }
+        add(batchRecord(batch, i));
+    }
+}
+
+void ExternalSorter::push(Record row) {
+    auto after = [this](const Entry& a, const Entry& b) { return entryBefore(a, b); };
+    Entry entry{std::move(row), sequence_++};
+    if (entries_.size() < *limit_) {
+        memoryUsage_ += rowBytes(entry.row);
+        entries_.push_back(std::move(entry));
+        std::push_heap(entries_.begin(), entries_.end(), after);
+    } else if (*limit_ > 0 && entryBefore(entry, entries_.front())) {
+        std::pop_heap(entries_.begin(), entries_.end(), after);
+        memoryUsage_ += rowBytes(entry.row);
+        memoryUsage_ -= rowBytes(entries_.back().row);
+        entries_.back() = std::move(entry);
+        std::push_heap(entries_.begin(), entries_.end(), after);
+    }
+    
+    // limit行放不进内存预算：堆中的行作为第一个有序段写出，之后的行与没有limit时一样累积和写出。
+    // 被堆丢弃的行排在已加入的limit行之后，不会进入结果；finish归并出limit行后停止
+    if (memoryUsage_ > memoryBudget_) {
+        useHeap_ = false;
+        spill();
+    }
+}
+
+std::vector<Record> ExternalSorter::finish(size_t offset) {
+    std::sort(entries_.begin(), entries_.end(), [this](const Entry& a, const Entry& b) {
+        return entryBefore(a, b);
+    });
+    size_t count = limit_ ? std::min(*limit_, static_cast<size_t>(sequence_)) : static_cast<size_t>(sequence_);
+    std::vector<Record> result;
+    result.reserve(count > offset ? count - offset : 0);
+    
+    // 没有写出时内存中的行就是全部结果
+    if (runs_.empty()) {
+        for (size_t i = offset; i < entries_.size(); ++i) {
+            result.push_back(std::move(entries_[i].row));
+        }
+        entries_.clear();
+        return result;
+    }
+    
+    // 多路归并：每个有序段和内存中的行各为一路，heads中为各路的当前行。
+    // 堆中为还有行的各路，按当前行排列；当前行相等时序号小的一路（先加入的行）在前
+    size_t sources = runs_.size() + 1;
+    std::vector<Record> heads(sources);
+    size_t memoryPosition = 0;
+    std::string encoded;
+    auto advance = [&](size_t source) {
+        if (source < runs_.size()) {
+            if (!runs_[source]->next(encoded)) {
+                return false;
+            }
+            heads[source] = decodeTuple(encoded, columns_);
+            return true;
+        }
+        if (memoryPosition >= entries_.size()) {
+            return false;
+        }
+        heads[source] = std::move(entries_[memoryPosition++].row);
+        return true;
+    };
+    auto after = [&](size_t a, size_t b) {
+        int cmp = compareRows(heads[a], heads[b], keys_);
+        return cmp > 0 || (cmp == 0 && a > b);
+    };
+    
+    std::vector<size_t> heap;
+    for (size_t source = 0; source < sources; ++source) {
+        if (source < runs_.size()) {
+            runs_[source]->rewind();
+        }
+        if (advance(source)) {
+            heap.push_back(source);
+        }
+    }
+    std::make_heap(heap.begin(), heap.end(), after);
+    
+    size_t produced = 0;
+    while (!heap.empty() && produced < count) {
+        std::pop_heap(heap.begin(), heap.end(), after);
+        size_t source = heap.back();
+        if (produced++ >= offset) {
+            result.push_back(std::move(heads[source]));
+        }
+        if (advance(source)) {
+            std::push_heap(heap.begin(), heap.end(), after);
+        } else {
+            heap.pop_back();
+        }
+    }
+    entries_.clear();
+    runs_.clear();
+    return result;
+}
+
+bool ExternalSorter::entryBefore(const Entry& a, const Entry& b) const {
+    int cmp = compareRows(a.row, b.row, keys_);
+    return cmp < 0 || (cmp == 0 && a.sequence < b.sequence);
+}
+
+void ExternalSorter::spill() {
+    std::sort(entries_.begin(), entries_.end(), [this](const Entry& a, const Entry& b) {
+        return entryBefore(a, b);
+    });
+    auto run = std::make_unique<SpillFile>();
+    for (const auto& entry : entries_) {
+        run->append(encodeTuple(entry.row, columns_));
+    }
+    runs_.push_back(std::move(run));
+    entries_.clear();
+    memoryUsage_ = 0;
+}
+
+size_t ExternalSorter::rowBytes(const Record& row) {
+    size_t bytes = sizeof(Entry) + row.size() * sizeof(Value);
+    for (const auto& value : row) {
+        if (const auto* text = std::get_if<std::string>(&value)) {
+            bytes += text->size();
+        }
+    }
+    return bytes;
+}
+
+} // namespace minidb
@@ -0,0 +1,59 @@
+#include "../include/SpillFile.h"
+#include <atomic>
+#include <stdexcept>
+#include <unistd.h>
+
+namespace minidb {
+
+namespace {
+
+// 同一进程中的临时文件编号
+std::atomic<uint64_t> nextSpillId{0};
+
+} // namespace
+
+SpillFile::SpillFile() {
+    path_ = std::filesystem::temp_directory_path() /
+            ("minidb-" + std::to_string(::getpid()) + "-" + std::to_string(nextSpillId++) + ".spill");
+    file_.open(path_, std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!file_) {
+        throw std::runtime_error("无法创建临时文件 " + path_.string());
+    }
+}
+
+SpillFile::~SpillFile() {
+    file_.close();
+    std::error_code error;
+    std::filesystem::remove(path_, error);
+}
+
+void SpillFile::append(std::string_view row) {
+    uint32_t length = static_cast<uint32_t>(row.size());
+    file_.write(reinterpret_cast<const char*>(&length), sizeof(length));
+    file_.write(row.data(), static_cast<std::streamsize>(row.size()));
+    if (!file_) {
+        throw std::runtime_error("写入临时文件失败");
+    }
+    ++rowCount_;
+    byteCount_ += sizeof(length) + row.size();
+}
+
+void SpillFile::rewind() {
+    file_.flush();
+    file_.clear();
+    file_.seekg(0);
+}
+
+bool SpillFile::next(std::string& row) {
+    uint32_t length;
+    if (!file_.read(reinterpret_cast<char*>(&length), sizeof(length))) {
+        return false;
+    }
+    row.resize(length);
+    if (!file_.read(row.data(), length)) {
+        throw std::runtime_error("读取临时文件失败");
+    }
+    return true;
+}
+
+} // namespace minidb
@@ -1,15 +1,71 @@
 #include "../include/Table.h"
+#include "../include/RowFilter.h"
+#include "../include/DBManager.h"
 #include <iostream>
 #include <fstream>
 #include <algorithm>
+#include <iterator>
 #include <sstream>
 
 namespace minidb {
 
-Table::Table(const std::string& name, const std::string& dbName, 
+// 已删除行数超过存活行数的该比例且不少于最小行数时整理表文件
+constexpr size_t kCompactionRatio = 4;
+constexpr size_t kCompactionMinRows = 256;
+
+// 统计信息的抽样行数，以及触发重新抽样的最少修改行数
+constexpr size_t kStatsSampleRows = 4096;
+constexpr size_t kStatsMinModifiedRows = 100;
+
+// 全表扫描至少要读取的页数，页更少时不并行
+constexpr uint32_t kMinParallelScanPages = 128;
+
+namespace {
+
+// 索引查找在索引上的比较：键的前几列与lowerKey按lowerOp比较，有upperKey时还要与它按upperOp比较
+struct LookupBounds {
+    IndexKey lowerKey;
+    Operator lowerOp = Operator::EQUAL;
+    std::optional<IndexKey> upperKey;
+    Operator upperOp = Operator::LESS_EQUAL;
+};
+
+// 只有等值前缀时按前缀等值查找。前缀后一列的范围只有一边时，另一边由前缀本身限定：
+// 只有下界时上界为“前缀 <= prefix”，只有上界时下界为“前缀 >= prefix”
+LookupBounds lookupBounds(const IndexLookup& lookup) {
+    LookupBounds bounds;
+    bounds.lowerKey = lookup.prefix;
+    if (!lookup.hasRange()) {
+        return bounds;
+    }
+    if (lookup.lowerOp) {
+        bounds.lowerKey.push_back(lookup.lower);
+        bounds.lowerOp = *lookup.lowerOp;
+    } else if (lookup.prefix.empty()) {
+        // 没有前缀也没有下界：直接按上界查找
+        bounds.lowerKey = {lookup.upper};
+        bounds.lowerOp = *lookup.upperOp;
+        return bounds;
+    } else {
+        bounds.lowerOp = Operator::GREATER_EQUAL;
+    }
+    if (lookup.upperOp) {
+        bounds.upperKey = lookup.prefix;
+        bounds.upperKey->push_back(lookup.upper);
+        bounds.upperOp = *lookup.upperOp;
+    } else if (!lookup.prefix.empty()) {
+        bounds.upperKey = lookup.prefix;
+    }
+    return bounds;
+}
+
+} // namespace
+
+Table::Table(const std::string& name, const std::string& dbName,
              const std::vector<ColumnDef>& columns)
-    : name_(name), dbName_(dbName), columns_(columns), 
-      tablePath_("./data/" + dbName + "/" + name + ".dat") {
+    : name_(name), dbName_(dbName), columns_(columns),
+      tablePath_("./data/" + dbName + "/" + name + ".dat"),
+      indexPath_("./data/" + dbName + "/" + name + ".idx") {
     
     // 查找主键列
     for (size_t i = 0; i < columns_.size(); ++i) {
@@ -18,11 +74,13 @@ Table::Table(const std::string& name, const std::string& dbName,
             break;
         }
     }
+    
+    heap_ = std::make_unique<HeapFile>(tablePath_);
+    zoneMap_ = std::make_unique<ZoneMap>("./data/" + dbName + "/" + name + ".zmap", columns_);
 }
 
 Table::~Table() {
-    // 保存表数据
-    saveData();
+    // 表数据由数据库在检查点时统一写出
 }
 
 bool Table::insert(const std::vector<Value>& values) {
@@ -43,89 +101,72 @@ bool Table::insert(const std::vector<Value>& values) {
             }
         }
         
-        // 检查主键唯一性（如果有主键）
+        // 所有索引键都必须能放入索引
+        if (!supportsKeys(values)) {
+            std::cerr << "插入记录失败: 索引键过长" << std::endl;
+            return false;
+        }
+        
+        // 检查主键唯一性（如果有主键），布隆过滤器判断一定不存在时不访问索引和表文件
         if (primaryKeyCol_.has_value()) {
-            const Value& pkValue = values[primaryKeyCol_.value()];
-            
-            // 使用索引查找（如果有索引）
-            if (index_) {
-                std::vector<size_t> result = index_->find(pkValue, Operator::EQUAL);
-                if (!result.empty()) {
-                    return false;  // 主键已存在
-                }
-            } else {
-                // 没有索引，线性扫描
-                for (size_t i = 0; i < records_.size(); ++i) {
-                    if (compareValues(records_[i][primaryKeyCol_.value()], pkValue, Operator::EQUAL)) {
-                        return false;  // 主键已存在
-                    }
-                }
+            size_t pkCol = primaryKeyCol_.value();
+            const Value& pkValue = values[pkCol];
+            IndexLookup lookup;
+            lookup.prefix = {pkValue};
+            AccessPath primaryPath;
+            primaryPath.method = AccessMethod::INDEX_PROBE;
+            primaryPath.lookups.push_back(lookup);
+            if (!findRows(Predicate::compare(pkCol, Operator::EQUAL, pkValue), primaryPath).empty()) {
+                return false;  // 主键已存在
             }
         }
         
-        // 添加记录
-        size_t rowId = records_.size();
-        records_.push_back(values);
-        
-        // 更新索引（如果有主键）
-        if (primaryKeyCol_.has_value() && index_) {
-            index_->insert(values[primaryKeyCol_.value()], rowId);
+        // 选择插入位置
+        std::string tuple = encodeTuple(values, columns_);
+        auto rowId = heap_->reserveInsert(tuple.size());
+        if (!rowId.has_value()) {
+            std::cerr << "插入记录失败: 记录超过单页容量" << std::endl;
+            return false;
         }
         
-        // 保存表数据
-        saveData();
+        // 先写日志，再修改数据页
+        WALRecord logRecord;
+        logRecord.type = WALRecordType::INSERT;
+        logRecord.row = values;
+        logRecord.rowIds = {rowId.value()};
+        if (!logChange(logRecord)) {
+            return false;
+        }
         
-        return true;
+        // 添加记录
+        return insertRow(rowId.value(), values, tuple, logRecord.lsn);
     } catch (const std::exception& e) {
         std::cerr << "插入记录失败: " << e.what() << std::endl;
         return false;
     }
 }
 
-int Table::deleteWhere(const std::string& colName, Operator op, const Value& value) {
+int Table::deleteWhere(const Predicate& where, const AccessPath& path) {
     try {
-        // 获取列索引
-        auto colIndex = getColumnIndex(colName);
-        if (!colIndex.has_value()) {
-            return 0;
-        }
-        
         // 查找要删除的记录
-        std::vector<size_t> deleteIndices;
-        
-        // 使用索引查找（如果可以）
-        if (colIndex == primaryKeyCol_ && index_ && op == Operator::EQUAL) {
-            deleteIndices = index_->find(value, op);
-        } else {
-            // 线性扫描
-            for (size_t i = 0; i < records_.size(); ++i) {
-                if (matchCondition(records_[i], colIndex.value(), op, value)) {
-                    deleteIndices.push_back(i);
-                }
-            }
-        }
+        bool all = where.getKind() == Predicate::Kind::NONE;
+        std::vector<RowId> deleteIndices = all ? allRows() : findRows(where, path);
         
         // 如果没有找到匹配的记录，返回0
         if (deleteIndices.empty()) {
             return 0;
         }
         
-        // 从大到小排序索引，以便正确删除
-        std::sort(deleteIndices.begin(), deleteIndices.end(), std::greater<size_t>());
-        
-        // 删除记录
-        for (size_t idx : deleteIndices) {
-            // 如果有索引，先从索引中删除
-            if (primaryKeyCol_.has_value() && index_) {
-                index_->remove(records_[idx][primaryKeyCol_.value()]);
-            }
-            
-            // 删除记录
-            records_.erase(records_.begin() + idx);
+        // 先写日志，再修改数据页
+        WALRecord logRecord;
+        logRecord.type = WALRecordType::DELETE;
+        logRecord.rowIds = deleteIndices;
+        if (!logChange(logRecord)) {
+            return 0;
         }
         
-        // 保存表数据
-        saveData();
+        // 删除记录
+        eraseRows(deleteIndices, logRecord.lsn);
         
         // 返回删除的记录数
         return static_cast<int>(deleteIndices.size());
@@ -135,14 +176,9 @@ int Table::deleteWhere(const std::string& colName, Operator op, const Value& val
     }
 }
 
-int Table::updateWhere(const std::string& setColName, const Value& setValue, 
-                        const std::string& whereColName, Operator op, const Value& whereValue) {
+int Table::updateWhere(size_t setCol, const Value& setValue, const Predicate& where, const AccessPath& path) {
     try {
-        // 获取列索引
-        auto setColIndex = getColumnIndex(setColName);
-        auto whereColIndex = getColumnIndex(whereColName);
-        
-        if (!setColIndex.has_value() || !whereColIndex.has_value()) {
+        if (setCol >= columns_.size()) {
             return 0;
         }
         
@@ -150,97 +186,198 @@ int Table::updateWhere(const std::string& setColName, const Value& setValue,
         bool isInt = std::holds_alternative<int>(setValue);
         bool isString = std::holds_alternative<std::string>(setValue);
         
-        if ((columns_[setColIndex.value()].type == DataType::INT && !isInt) ||
-            (columns_[setColIndex.value()].type == DataType::STRING && !isString)) {
+        if ((columns_[setCol].type == DataType::INT && !isInt) ||
+            (columns_[setCol].type == DataType::STRING && !isString)) {
             return 0;
         }
         
         // 查找要更新的记录
-        std::vector<size_t> updateIndices;
-        
-        // 使用索引查找（如果可以）
-        if (whereColIndex == primaryKeyCol_ && index_ && op == Operator::EQUAL) {
-            updateIndices = index_->find(whereValue, op);
-        } else {
-            // 线性扫描
-            for (size_t i = 0; i < records_.size(); ++i) {
-                if (matchCondition(records_[i], whereColIndex.value(), op, whereValue)) {
-                    updateIndices.push_back(i);
-                }
-            }
-        }
+        bool all = where.getKind() == Predicate::Kind::NONE;
+        std::vector<RowId> updateIndices = all ? allRows() : findRows(where, path);
         
         // 如果没有找到匹配的记录，返回0
         if (updateIndices.empty()) {
             return 0;
         }
         
-        // 更新记录
-        for (size_t idx : updateIndices) {
-            // 如果更新的是主键列，需要先从索引中删除旧值
-            if (setColIndex == primaryKeyCol_ && index_) {
-                index_->remove(records_[idx][setColIndex.value()]);
+        // 更新后在原页放不下的行需要移动，其余行原地更新。同一页上变长的行共用页中的空闲空间，
+        // grown记下每页已经分给前面各行的字节数
+        std::vector<RowId> inPlace;
+        std::vector<std::pair<RowId, Record>> moved;
+        std::unordered_map<uint32_t, size_t> grown;
+        for (RowId rowId : updateIndices) {
+            std::optional<Record> record;
+            size_t oldSize = 0;
+            heap_->read(rowId, [&](std::string_view tuple) {
+                record = decodeTuple(tuple, columns_);
+                oldSize = tuple.size();
+            });
+            if (!record.has_value()) {
+                continue;
             }
+            (*record)[setCol] = setValue;
             
-            // 更新记录
-            records_[idx][setColIndex.value()] = setValue;
+            // 更新后的行必须能放入所有索引，否则不做任何修改
+            if (!supportsKeys(*record)) {
+                std::cerr << "更新记录失败: 索引键过长" << std::endl;
+                return 0;
+            }
+            size_t newSize = encodeTuple(*record, columns_).size();
             
-            // 如果更新的是主键列，需要重新添加到索引
-            if (setColIndex == primaryKeyCol_ && index_) {
-                index_->insert(setValue, idx);
+            // 每行必须放在一个数据页中，任何一行放不下时整条语句不做修改，也不写日志
+            if (newSize > HeapFile::maxTupleSize()) {
+                std::cerr << "更新记录失败: 记录超过单页容量" << std::endl;
+                return 0;
+            }
+            size_t& reserved = grown[rowIdPage(rowId)];
+            if (heap_->canUpdate(rowId, newSize, reserved)) {
+                inPlace.push_back(rowId);
+                reserved += newSize > oldSize ? newSize - oldSize : 0;
+            } else {
+                moved.emplace_back(rowId, std::move(*record));
             }
         }
         
-        // 保存表数据
-        saveData();
+        int count = 0;
+        if (!inPlace.empty()) {
+            // 先写日志，再修改数据页
+            WALRecord logRecord;
+            logRecord.type = WALRecordType::UPDATE;
+            logRecord.rowIds = inPlace;
+            logRecord.column = setCol;
+            logRecord.value = setValue;
+            if (!logChange(logRecord)) {
+                return 0;
+            }
+            
+            // 更新记录
+            count = static_cast<int>(assignRows(inPlace, setCol, setValue, logRecord.lsn));
+        }
+        
+        for (const auto& [rowId, record] : moved) {
+            if (moveRow(rowId, record)) {
+                ++count;
+            }
+        }
         
         // 返回更新的记录数
-        return static_cast<int>(updateIndices.size());
+        return count;
     } catch (const std::exception& e) {
         std::cerr << "更新记录失败: " << e.what() << std::endl;
         return 0;
     }
 }
 
-std::vector<Record> Table::selectWhere(const std::string& colName, 
-                                     Operator op, const Value& value, 
-                                     const std::string& selectCol) {
+std::vector<Record> Table::selectWhere(const Predicate& where, std::optional<size_t> selectCol,
+                                     const AccessPath& path, std::optional<size_t> limit) {
     try {
-        // 获取列索引
-        auto colIndex = getColumnIndex(colName);
-        auto selectColIndex = getColumnIndex(selectCol);
-        
-        if (!colIndex.has_value() || (!selectColIndex.has_value() && selectCol != "*")) {
+        if (selectCol && *selectCol >= columns_.size()) {
             return {};
         }
         
-        // 查找匹配的记录
-        std::vector<size_t> matchIndices;
-        
-        // 使用索引查找（如果可以）
-        if (colIndex == primaryKeyCol_ && index_ && op == Operator::EQUAL) {
-            matchIndices = index_->find(value, op);
-        } else {
-            // 线性扫描
-            for (size_t i = 0; i < records_.size(); ++i) {
-                if (matchCondition(records_[i], colIndex.value(), op, value)) {
-                    matchIndices.push_back(i);
-                }
+        // 需要返回的列，以及还要判断条件的列
+        std::vector<size_t> needed;
+        if (!selectCol) {
+            for (size_t i = 0; i < columns_.size(); ++i) {
+                needed.push_back(i);
             }
+        } else {
+            needed.push_back(*selectCol);
         }
+        std::vector<size_t> used = needed;
+        where.collectColumns(used);
         
-        // 提取结果
+        // 主键值一定不存在时直接返回
         std::vector<Record> result;
-        for (size_t idx : matchIndices) {
-            if (selectCol == "*") {
-                // 返回所有列
-                result.push_back(records_[idx]);
+        if (definitelyAbsent(where) || limit == size_t{0}) {
+            return result;
+        }
+        
+        // 只读索引：只用一个索引，需要的列和条件列都在索引键或包含列中，不访问表文件
+        const TableIndex* entry = nullptr;
+        if (path.covering && path.lookups.size() == 1 && path.method != AccessMethod::FULL_SCAN) {
+            entry = lookupIndex(path.lookups.front());
+        }
+        if (entry && entry->def.covers(used)) {
+            const IndexDef& def = entry->def;
+            const IndexLookup& lookup = path.lookups.front();
+            // 够了limit行就停止索引查找，不再访问后面的项
+            auto visitor = [&](size_t, const IndexKey& key, const Record& included) {
+                Record row(columns_.size());
+                for (size_t i = 0; i < def.columns.size() && i < key.size(); ++i) {
+                    row[def.columns[i]] = key[i];
+                }
+                for (size_t i = 0; i < def.include.size() && i < included.size(); ++i) {
+                    row[def.include[i]] = included[i];
+                }
+                if (!where.matches(row)) {
+                    return true;
+                }
+                Record projected;
+                projected.reserve(needed.size());
+                for (size_t column : needed) {
+                    projected.push_back(std::move(row[column]));
+                }
+                result.push_back(std::move(projected));
+                return !limit || result.size() < *limit;
+            };
+            LookupBounds bounds = lookupBounds(lookup);
+            if (bounds.upperKey) {
+                entry->index->scanRange(bounds.lowerKey, bounds.lowerOp, *bounds.upperKey, bounds.upperOp, visitor);
             } else {
-                // 返回指定列
-                result.push_back({records_[idx][selectColIndex.value()]});
+                entry->index->scan(bounds.lowerKey, bounds.lowerOp, visitor);
             }
+            return result;
         }
         
+        // 按计划器选出的索引查找得到候选行，再判断整个条件
+        if (auto rowIds = lookupRows(path)) {
+            // 条件只编译一次，逐行判断时没有类型和操作符的分派
+            RowFilter::compile(where, columns_).dispatch([&](const auto& matches) {
+                for (RowId rowId : *rowIds) {
+                    if (limit && result.size() >= *limit) {
+                        break;
+                    }
+                    heap_->read(rowId, [&](std::string_view tuple) {
+                        TupleView row(tuple, columns_);
+                        if (!matches(row)) {
+                            return;
+                        }
+                        if (!selectCol) {
+                            // 返回所有列
+                            result.push_back(row.toRecord());
+                        } else {
+                            // 返回指定列
+                            result.push_back({row.getValue(*selectCol)});
+                        }
+                    });
+                }
+            });
+            return result;
+        }
+        
+        // 并行线性扫描：各页块的结果分别保存，再按页块的顺序拼接。有LIMIT时顺序扫描，读够就停止
+        size_t threads = limit ? 1 : scanThreads(where);
+        if (threads > 1) {
+            std::vector<std::vector<Record>> morsels(getMorselCount());
+            scanMorsels(where, needed, threads, [&](size_t, size_t morsel, const RowBatch& batch) {
+                batch.appendRecords(morsels[morsel]);
+            });
+            for (auto& rows : morsels) {
+                std::move(rows.begin(), rows.end(), std::back_inserter(result));
+            }
+            return result;
+        }
+        
+        // 线性扫描：按批读取需要的列和条件列，在列向量上判断条件，再投影出需要返回的列
+        std::unique_ptr<BatchOperator> plan = std::make_unique<ProjectOperator>(scanPipeline(where, used), needed);
+        if (limit) {
+            plan = std::make_unique<LimitOperator>(std::move(plan), *limit);
+        }
+        RowBatch batch;
+        while (plan->next(batch)) {
+            batch.appendRecords(result);
+        }
         return result;
     } catch (const std::exception& e) {
         std::cerr << "查询记录失败: " << e.what() << std::endl;
@@ -248,34 +385,115 @@ std::vector<Record> Table::selectWhere(const std::string& colName,
     }
 }
 
-std::vector<Record> Table::selectAll(const std::string& selectCol) {
+std::vector<Record> Table::selectAll(std::optional<size_t> selectCol, std::optional<size_t> limit) {
+    // 没有条件时只能全表扫描
+    return selectWhere(Predicate(), selectCol, AccessPath(), limit);
+}
+
+std::optional<std::vector<Record>> Table::selectOrdered(const Predicate& where, const std::vector<size_t>& needed,
+                                                        size_t index, bool descending, std::optional<size_t> limit) {
+    if (!supportsOrderedScan(index)) {
+        return std::nullopt;
+    }
     try {
-        // 获取列索引
-        std::optional<size_t> selectColIndex;
-        if (selectCol != "*") {
-            selectColIndex = getColumnIndex(selectCol);
-            if (!selectColIndex.has_value()) {
-                return {};
-            }
-        }
-        
-        // 提取结果
         std::vector<Record> result;
-        for (const auto& record : records_) {
-            if (selectCol == "*") {
-                // 返回所有列
-                result.push_back(record);
-            } else {
-                // 返回指定列
-                result.push_back({record[selectColIndex.value()]});
-            }
+        if (definitelyAbsent(where) || limit == size_t{0}) {
+            return result;
         }
         
+        // 按索引的顺序逐行回表，够了limit行就停止扫描
+        bool scanned = false;
+        RowFilter::compile(where, columns_).dispatch([&](const auto& matches) {
+            scanned = indexes_[index].index->scanOrdered(descending, [&](size_t rowId) {
+                heap_->read(rowId, [&](std::string_view tuple) {
+                    TupleView row(tuple, columns_);
+                    if (!matches(row)) {
+                        return;
+                    }
+                    Record& projected = result.emplace_back();
+                    projected.reserve(needed.size());
+                    for (size_t column : needed) {
+                        projected.push_back(row.getValue(column));
+                    }
+                });
+                return !limit || result.size() < *limit;
+            });
+        });
+        if (!scanned) {
+            return std::nullopt;
+        }
         return result;
     } catch (const std::exception& e) {
         std::cerr << "查询记录失败: " << e.what() << std::endl;
-        return {};
+        return std::vector<Record>();
+    }
+}
+
+std::unique_ptr<BatchOperator> Table::selectBatches(const Predicate& where, const std::vector<size_t>& needed,
+                                                   const AccessPath& path) {
+    std::vector<size_t> used = needed;
+    where.collectColumns(used);
+    
+    // 索引查找得到的候选行按行号顺序读取，再在批上判断整个条件；主键值一定不存在时没有候选行
+    std::unique_ptr<BatchOperator> rows;
+    if (definitelyAbsent(where)) {
+        rows = std::make_unique<FetchOperator>(*heap_, columns_, used, std::vector<RowId>());
+    } else if (auto rowIds = lookupRows(path)) {
+        std::sort(rowIds->begin(), rowIds->end());
+        rows = std::make_unique<FilterOperator>(
+            std::make_unique<FetchOperator>(*heap_, columns_, used, std::move(*rowIds)), where);
+    } else {
+        rows = scanPipeline(where, used);
     }
+    return std::make_unique<ProjectOperator>(std::move(rows), needed);
+}
+
+void Table::consumeBatches(const Predicate& where, const std::vector<size_t>& needed, const AccessPath& path,
+                           size_t threads, const std::function<void(size_t worker, const RowBatch& batch)>& consume) {
+    // 全表扫描时各工作线程自己读页、解码和过滤，不经过调用线程
+    bool scan = path.method == AccessMethod::FULL_SCAN && !definitelyAbsent(where);
+    threads = scan ? std::min(threads, scanThreads(where)) : threads;
+    if (scan && threads > 1) {
+        scanMorsels(where, needed, threads, [&](size_t worker, size_t, const RowBatch& batch) {
+            consume(worker, batch);
+        });
+        return;
+    }
+    std::unique_ptr<BatchOperator> input = selectBatches(where, needed, path);
+    parallelConsume(*input, threads, consume);
+}
+
+size_t Table::scanThreads(const Predicate& where) const {
+    uint32_t pages = pagesToScan(where);
+    if (pages < kMinParallelScanPages) {
+        return 1;
+    }
+    size_t morsels = (pages + kMorselPages - 1) / kMorselPages;
+    return std::max<size_t>(1, std::min(DBManager::getInstance().getParallelWorkers(), morsels));
+}
+
+bool Table::lookupEqual(size_t index, const Value& key, const std::function<void(const TupleView&)>& visitor) {
+    if (index >= indexes_.size()) {
+        return false;
+    }
+    IndexLookup lookup;
+    lookup.index = index;
+    lookup.prefix = {key};
+    const TableIndex* entry = lookupIndex(lookup);
+    if (!entry) {
+        return false;
+    }
+    
+    // 主键值一定不存在时不需要查找
+    if (entry->def.columns.front() == primaryKeyCol_ && !primaryKeys_.mayContain(key)) {
+        return true;
+    }
+    for (RowId rowId : runLookup(*entry, lookup)) {
+        heap_->read(rowId, [&](std::string_view tuple) {
+            visitor(TupleView(tuple, columns_));
+        });
+    }
+    return true;
 }
 
 bool Table::loadData() {
@@ -285,185 +503,520 @@ bool Table::loadData() {
             return false;
         }
         
-        // 打开表文件
+        // 旧格式的表文件先转换为堆文件
+        if (!HeapFile::isHeapFile(tablePath_) && !importLegacyData()) {
+            return false;
+        }
+        
+        // 只读取元数据页，数据页在访问时才读入缓冲池
+        std::vector<IndexDef> indexDefs;
+        if (!heap_->open(columns_, indexDefs, checkpointLsn_)) {
+            return false;
+        }
+        
+        // 设置主键列索引
+        primaryKeyCol_.reset();
+        for (size_t i = 0; i < columns_.size(); ++i) {
+            if (columns_[i].isPrimary) {
+                primaryKeyCol_ = i;
+                break;
+            }
+        }
+        
+        // 打开主键索引（如果有主键）和二级索引，只读取元数据页，节点在查找时才读入
+        indexes_.clear();
+        if (primaryKeyCol_.has_value()) {
+            indexDefs.insert(indexDefs.begin(), IndexDef{"", {primaryKeyCol_.value()}, IndexType::BTREE, {}});
+        }
+        std::vector<Index*> stale;
+        for (auto& def : indexDefs) {
+            bool valid = !def.columns.empty();
+            for (size_t column : def.columns) {
+                valid = valid && column < columns_.size();
+            }
+            if (!valid) {
+                continue;
+            }
+            auto index = makeIndex(def);
+            if (!index->load()) {
+                stale.push_back(index.get());
+            }
+            indexes_.push_back({std::move(def), std::move(index)});
+        }
+        
+        // 无法加载的索引统一用一次扫描重建
+        if (!stale.empty()) {
+            rebuildIndexes(stale);
+        }
+        
+        // 区域映射同样在无法加载时重建
+        if (!zoneMap_->load()) {
+            rebuildZoneMap();
+        }
+        
+        // 主键过滤器不保存，每次加载时重建
+        rebuildPrimaryKeyFilter();
+        
+        return true;
+    } catch (const std::exception& e) {
+        std::cerr << "加载表数据失败: " << e.what() << std::endl;
+        return false;
+    }
+}
+
+bool Table::saveData() {
+    try {
+        // 确保表目录存在
+        std::filesystem::path dbPath("./data/" + dbName_);
+        if (!std::filesystem::exists(dbPath)) {
+            std::filesystem::create_directory(dbPath);
+        }
+        
+        // 新建的表先创建堆文件
+        if (!heap_->isOpen() && !heap_->create(columns_)) {
+            return false;
+        }
+        
+        // 写入元数据页，然后写回所有脏页并落盘
+        if (!heap_->writeHeader(columns_, secondaryIndexDefs(), checkpointLsn_) || !heap_->flush()) {
+            return false;
+        }
+        
+        // 保存所有索引，只写回修改过的节点
+        for (const auto& entry : indexes_) {
+            if (!entry.index->save()) {
+                return false;
+            }
+        }
+        
+        return zoneMap_->save();
+    } catch (const std::exception& e) {
+        std::cerr << "保存表数据失败: " << e.what() << std::endl;
+        return false;
+    }
+}
+
+bool Table::importLegacyData() {
+    try {
+        // 打开旧表文件
         std::ifstream tableFile(tablePath_, std::ios::binary);
         if (!tableFile.is_open()) {
             return false;
         }
         
-        // 读取列定义数量
+        // 旧格式没有文件头，开头直接是列定义数量
         size_t columnCount;
         tableFile.read(reinterpret_cast<char*>(&columnCount), sizeof(columnCount));
         
         // 读取列定义
-        columns_.clear();
+        std::vector<ColumnDef> columns;
         for (size_t i = 0; i < columnCount; ++i) {
-            // 读取列名长度
             size_t nameLength;
             tableFile.read(reinterpret_cast<char*>(&nameLength), sizeof(nameLength));
             
-            // 读取列名
             std::string name(nameLength, '\0');
             tableFile.read(&name[0], nameLength);
             
-            // 读取列类型
             int typeValue;
             tableFile.read(reinterpret_cast<char*>(&typeValue), sizeof(typeValue));
-            DataType type = static_cast<DataType>(typeValue);
             
-            // 读取是否为主键
             bool isPrimary;
             tableFile.read(reinterpret_cast<char*>(&isPrimary), sizeof(isPrimary));
             
-            // 添加列定义
-            columns_.push_back({name, type, isPrimary});
-            
-            // 如果是主键，设置主键列索引
-            if (isPrimary) {
-                primaryKeyCol_ = i;
-            }
+            columns.push_back({name, static_cast<DataType>(typeValue), isPrimary});
         }
         
-        // 读取记录数量
-        size_t recordCount;
-        tableFile.read(reinterpret_cast<char*>(&recordCount), sizeof(recordCount));
-        
-        // 读取记录
-        records_.clear();
-        for (size_t i = 0; i < recordCount; ++i) {
-            Record record;
+        // 写入临时堆文件，完成后替换旧表文件
+        std::filesystem::path tmpPath = tablePath_;
+        tmpPath += ".tmp";
+        std::filesystem::remove(tmpPath);
+        bool oversized = false;
+        {
+            HeapFile heap(tmpPath);
+            if (!heap.create(columns)) {
+                return false;
+            }
             
-            // 读取每列的值
-            for (size_t j = 0; j < columnCount; ++j) {
-                if (columns_[j].type == DataType::INT) {
-                    // 读取整数值
-                    int value;
-                    tableFile.read(reinterpret_cast<char*>(&value), sizeof(value));
-                    record.push_back(value);
-                } else {
-                    // 读取字符串值
-                    size_t strLength;
-                    tableFile.read(reinterpret_cast<char*>(&strLength), sizeof(strLength));
-                    
-                    std::string value(strLength, '\0');
-                    tableFile.read(&value[0], strLength);
-                    record.push_back(value);
+            // 逐行读取并写入
+            size_t recordCount;
+            tableFile.read(reinterpret_cast<char*>(&recordCount), sizeof(recordCount));
+            for (size_t i = 0; i < recordCount; ++i) {
+                Record record;
+                for (size_t j = 0; j < columnCount; ++j) {
+                    if (columns[j].type == DataType::INT) {
+                        int value;
+                        tableFile.read(reinterpret_cast<char*>(&value), sizeof(value));
+                        record.emplace_back(value);
+                    } else {
+                        size_t strLength;
+                        tableFile.read(reinterpret_cast<char*>(&strLength), sizeof(strLength));
+                        
+                        std::string value(strLength, '\0');
+                        tableFile.read(&value[0], strLength);
+                        record.emplace_back(std::move(value));
+                    }
+                }
+                
+                // 堆文件中每行必须放在一个数据页中：旧格式中更长的行不能转换，保留旧表文件并报告错误，不丢弃该行
+                std::string tuple = encodeTuple(record, columns);
+                if (tuple.size() > HeapFile::maxTupleSize()) {
+                    std::cerr << "转换旧表文件失败: 第 " << i + 1 << " 行编码后为 " << tuple.size()
+                              << " 字节，超过单页容量 " << HeapFile::maxTupleSize() << " 字节" << std::endl;
+                    oversized = true;
+                    break;
+                }
+                auto rowId = heap.reserveInsert(tuple.size());
+                if (!rowId.has_value() || !heap.insertAt(rowId.value(), tuple, 0)) {
+                    return false;
                 }
             }
             
-            records_.push_back(record);
+            if (!oversized && (!heap.writeHeader(columns, {}, 0) || !heap.flush())) {
+                return false;
+            }
         }
-        
-        // 关闭文件
         tableFile.close();
-        
-        // 加载索引（如果有主键）
-        if (primaryKeyCol_.has_value()) {
-            createIndex();
-            
-            std::filesystem::path indexPath("./data/" + dbName_ + "/" + name_ + ".idx");
-            if (std::filesystem::exists(indexPath) && index_) {
-                index_->load(indexPath);
-            } else {
-                // 重建索引
-                for (size_t i = 0; i < records_.size(); ++i) {
-                    index_->insert(records_[i][primaryKeyCol_.value()], i);
-                }
-            }
+        if (oversized) {
+            std::filesystem::remove(tmpPath);
+            return false;
         }
         
+        std::filesystem::rename(tmpPath, tablePath_);
+        
+        // 旧索引中的行号是记录下标，已经失效
+        std::filesystem::remove(indexPath_);
+        
         return true;
     } catch (const std::exception& e) {
-        std::cerr << "加载表数据失败: " << e.what() << std::endl;
+        std::cerr << "转换旧表文件失败: " << e.what() << std::endl;
         return false;
     }
 }
 
-bool Table::saveData() const {
+bool Table::createIndex() {
+    bool hasPrimaryIndex = !indexes_.empty() && indexes_.front().def.name.empty();
+    if (primaryKeyCol_.has_value() && !hasPrimaryIndex) {
+        IndexDef def{"", {primaryKeyCol_.value()}, IndexType::BTREE, {}};
+        auto index = makeIndex(def);
+        Index* target = index.get();
+        indexes_.insert(indexes_.begin(), {def, std::move(index)});
+        
+        // 为现有记录创建索引
+        rebuildIndexes({target});
+        
+        return true;
+    }
+    return false;
+}
+
+bool Table::createIndex(const std::string& indexName, const std::vector<std::string>& colNames, IndexType type,
+                        const std::vector<std::string>& includeNames) {
     try {
-        // 确保表目录存在
-        std::filesystem::path dbPath("./data/" + dbName_);
-        if (!std::filesystem::exists(dbPath)) {
-            std::filesystem::create_directory(dbPath);
+        // 检查列是否存在，索引键和包含列中的列都不能重复
+        std::vector<size_t> colIndices;
+        std::vector<size_t> includeIndices;
+        auto resolve = [&](const std::vector<std::string>& names, std::vector<size_t>& indices) {
+            for (const auto& colName : names) {
+                auto colIndex = getColumnIndex(colName);
+                if (!colIndex.has_value() ||
+                    std::find(colIndices.begin(), colIndices.end(), colIndex.value()) != colIndices.end() ||
+                    std::find(includeIndices.begin(), includeIndices.end(), colIndex.value()) != includeIndices.end()) {
+                    return false;
+                }
+                indices.push_back(colIndex.value());
+            }
+            return true;
+        };
+        if (!resolve(colNames, colIndices) || !resolve(includeNames, includeIndices) ||
+            colIndices.empty() || indexName.empty()) {
+            return false;
         }
         
-        // 打开表文件
-        std::ofstream tableFile(tablePath_, std::ios::binary | std::ios::trunc);
-        if (!tableFile.is_open()) {
+        // 哈希索引不保存包含列
+        if (type == IndexType::HASH && !includeIndices.empty()) {
+            std::cerr << "创建索引失败: 哈希索引不支持包含列" << std::endl;
             return false;
         }
         
-        // 写入列定义数量
-        size_t columnCount = columns_.size();
-        tableFile.write(reinterpret_cast<const char*>(&columnCount), sizeof(columnCount));
-        
-        // 写入列定义
-        for (const auto& column : columns_) {
-            // 写入列名长度
-            size_t nameLength = column.name.length();
-            tableFile.write(reinterpret_cast<const char*>(&nameLength), sizeof(nameLength));
-            
-            // 写入列名
-            tableFile.write(column.name.c_str(), nameLength);
-            
-            // 写入列类型
-            int typeValue = static_cast<int>(column.type);
-            tableFile.write(reinterpret_cast<const char*>(&typeValue), sizeof(typeValue));
-            
-            // 写入是否为主键
-            tableFile.write(reinterpret_cast<const char*>(&column.isPrimary), sizeof(column.isPrimary));
-        }
-        
-        // 写入记录数量
-        size_t recordCount = records_.size();
-        tableFile.write(reinterpret_cast<const char*>(&recordCount), sizeof(recordCount));
-        
-        // 写入记录
-        for (const auto& record : records_) {
-            // 写入每列的值
-            for (size_t i = 0; i < columnCount; ++i) {
-                if (columns_[i].type == DataType::INT) {
-                    // 写入整数值
-                    int value = std::get<int>(record[i]);
-                    tableFile.write(reinterpret_cast<const char*>(&value), sizeof(value));
-                } else {
-                    // 写入字符串值
-                    std::string value = std::get<std::string>(record[i]);
-                    size_t strLength = value.length();
-                    tableFile.write(reinterpret_cast<const char*>(&strLength), sizeof(strLength));
-                    tableFile.write(value.c_str(), strLength);
-                }
+        // 检查索引名是否已存在
+        for (const auto& entry : indexes_) {
+            if (entry.def.name == indexName) {
+                return false;
             }
         }
         
-        // 关闭文件
-        tableFile.close();
-        
-        // 保存索引（如果有）
-        if (primaryKeyCol_.has_value() && index_) {
-            std::filesystem::path indexPath("./data/" + dbName_ + "/" + name_ + ".idx");
-            index_->save(indexPath);
+        // 现有记录的键都必须能放入索引
+        IndexDef def{indexName, std::move(colIndices), type, std::move(includeIndices)};
+        auto index = makeIndex(def);
+        bool supported = true;
+        heap_->scan([&](RowId, std::string_view tuple) {
+            TupleView row(tuple, columns_);
+            if (supported && !index->supportsKey(makeKey(def.columns, row), makeKey(def.include, row))) {
+                supported = false;
+            }
+        });
+        if (!supported) {
+            std::cerr << "创建索引失败: 索引键过长" << std::endl;
+            return false;
         }
         
+        // 为现有记录创建索引，索引定义在下一次检查点写入元数据页
+        Index* target = index.get();
+        indexes_.push_back({std::move(def), std::move(index)});
+        rebuildIndexes({target});
+        dirty_ = true;
         return true;
     } catch (const std::exception& e) {
-        std::cerr << "保存表数据失败: " << e.what() << std::endl;
+        std::cerr << "创建索引失败: " << e.what() << std::endl;
         return false;
     }
 }
 
-bool Table::createIndex() {
-    if (primaryKeyCol_.has_value() && !index_) {
-        index_ = std::make_unique<BTreeIndex>();
-        
-        // 为现有记录创建索引
-        for (size_t i = 0; i < records_.size(); ++i) {
-            index_->insert(records_[i][primaryKeyCol_.value()], i);
+bool Table::dropIndex(const std::string& indexName) {
+    try {
+        auto it = std::find_if(indexes_.begin(), indexes_.end(), [&](const TableIndex& entry) {
+            return !indexName.empty() && entry.def.name == indexName;
+        });
+        if (it == indexes_.end()) {
+            return false;
         }
         
+        // 先关闭索引文件并丢弃缓冲池中的页，再删除文件
+        std::filesystem::path path = indexPath(it->def);
+        indexes_.erase(it);
+        std::filesystem::remove(path);
+        dirty_ = true;
         return true;
+    } catch (const std::exception& e) {
+        std::cerr << "删除索引失败: " << e.what() << std::endl;
+        return false;
     }
-    return false;
+}
+
+void Table::rebuildIndexes() {
+    std::vector<Index*> targets;
+    for (const auto& entry : indexes_) {
+        targets.push_back(entry.index.get());
+    }
+    rebuildIndexes(targets);
+}
+
+void Table::rebuildIndexes(const std::vector<Index*>& targets) {
+    std::vector<const TableIndex*> rebuilt;
+    for (const auto& entry : indexes_) {
+        if (std::find(targets.begin(), targets.end(), entry.index.get()) != targets.end()) {
+            rebuilt.push_back(&entry);
+        }
+    }
+    if (rebuilt.empty()) {
+        return;
+    }
+    
+    // 扫描一次表文件，取出每个索引的所有项，再逐个批量建立索引
+    std::vector<std::vector<IndexBuildEntry>> entries(rebuilt.size());
+    heap_->scan([&](RowId rowId, std::string_view tuple) {
+        TupleView row(tuple, columns_);
+        for (size_t i = 0; i < rebuilt.size(); ++i) {
+            const IndexDef& def = rebuilt[i]->def;
+            entries[i].push_back({makeKey(def.columns, row), rowId, makeKey(def.include, row)});
+        }
+    });
+    
+    for (size_t i = 0; i < rebuilt.size(); ++i) {
+        rebuilt[i]->index->build(entries[i]);
+        std::vector<IndexBuildEntry>().swap(entries[i]);
+    }
+}
+
+void Table::rebuildPrimaryKeyFilter() {
+    // 预留一倍空间，之后的插入不会马上触发重建
+    primaryKeys_.reset(heap_->getRowCount() * 2);
+    if (!primaryKeyCol_.has_value()) {
+        return;
+    }
+    heap_->scan([&](RowId, std::string_view tuple) {
+        primaryKeys_.add(TupleView(tuple, columns_).getValue(primaryKeyCol_.value()));
+    });
+}
+
+void Table::rebuildZoneMap() {
+    zoneMap_->clear();
+    heap_->scan([&](RowId rowId, std::string_view tuple) {
+        zoneMap_->insert(rowId, TupleView(tuple, columns_));
+    });
+}
+
+const Table::TableIndex* Table::lookupIndex(const IndexLookup& lookup) const {
+    if (lookup.index >= indexes_.size()) {
+        return nullptr;
+    }
+    const TableIndex& entry = indexes_[lookup.index];
+    size_t keyColumns = lookup.keyColumns();
+    if (keyColumns == 0 || keyColumns > entry.def.columns.size()) {
+        return nullptr;
+    }
+    
+    // 值的类型与列类型不同时任何行都不满足条件，交给扫描处理
+    auto typeMatches = [&](size_t position, const Value& value) {
+        bool isInt = columns_[entry.def.columns[position]].type == DataType::INT;
+        return std::holds_alternative<int>(value) == isInt;
+    };
+    for (size_t i = 0; i < lookup.prefix.size(); ++i) {
+        if (!typeMatches(i, lookup.prefix[i])) {
+            return nullptr;
+        }
+    }
+    size_t next = lookup.prefix.size();
+    if ((lookup.lowerOp && !typeMatches(next, lookup.lower)) || (lookup.upperOp && !typeMatches(next, lookup.upper))) {
+        return nullptr;
+    }
+    
+    // 等值前缀和区间的两端都要支持
+    if ((!lookup.hasRange() && !entry.index->supportsLookup(keyColumns, Operator::EQUAL)) ||
+        (lookup.lowerOp && !entry.index->supportsLookup(keyColumns, *lookup.lowerOp)) ||
+        (lookup.upperOp && !entry.index->supportsLookup(keyColumns, *lookup.upperOp))) {
+        return nullptr;
+    }
+    return &entry;
+}
+
+std::vector<RowId> Table::runLookup(const TableIndex& entry, const IndexLookup& lookup) {
+    LookupBounds bounds = lookupBounds(lookup);
+    if (bounds.upperKey) {
+        return entry.index->findRange(bounds.lowerKey, bounds.lowerOp, *bounds.upperKey, bounds.upperOp);
+    }
+    return entry.index->find(bounds.lowerKey, bounds.lowerOp);
+}
+
+std::optional<std::vector<RowId>> Table::lookupRows(const AccessPath& path) {
+    if (path.method == AccessMethod::FULL_SCAN || path.lookups.empty()) {
+        return std::nullopt;
+    }
+    std::vector<const TableIndex*> entries;
+    for (const auto& lookup : path.lookups) {
+        const TableIndex* entry = lookupIndex(lookup);
+        if (!entry) {
+            return std::nullopt;
+        }
+        entries.push_back(entry);
+    }
+    
+    if (path.method == AccessMethod::INDEX_INTERSECTION) {
+        // 依次与每个查找的结果求交集，结果为空时不再查找
+        std::vector<RowId> result = runLookup(*entries.front(), path.lookups.front());
+        std::sort(result.begin(), result.end());
+        for (size_t i = 1; i < entries.size() && !result.empty(); ++i) {
+            std::vector<RowId> rows = runLookup(*entries[i], path.lookups[i]);
+            std::sort(rows.begin(), rows.end());
+            std::vector<RowId> common;
+            std::set_intersection(result.begin(), result.end(), rows.begin(), rows.end(),
+                                  std::back_inserter(common));
+            result = std::move(common);
+        }
+        return result;
+    }
+    
+    if (path.method == AccessMethod::INDEX_UNION) {
+        // 合并所有查找的结果并去掉重复的行号
+        std::vector<RowId> result;
+        for (size_t i = 0; i < entries.size(); ++i) {
+            std::vector<RowId> rows = runLookup(*entries[i], path.lookups[i]);
+            result.insert(result.end(), rows.begin(), rows.end());
+        }
+        std::sort(result.begin(), result.end());
+        result.erase(std::unique(result.begin(), result.end()), result.end());
+        return result;
+    }
+    
+    return runLookup(*entries.front(), path.lookups.front());
+}
+
+bool Table::supportsLookup(size_t i, size_t keyColumns, Operator op) const {
+    return i < indexes_.size() && indexes_[i].index->supportsLookup(keyColumns, op);
+}
+
+const TableStats& Table::getStats() {
+    if (!stats_.isBuilt() || modifiedRows_ > std::max<size_t>(stats_.getRowCount() / 10, kStatsMinModifiedRows)) {
+        rebuildStats();
+    }
+    return stats_;
+}
+
+void Table::rebuildStats() {
+    // 每隔stride页抽取一页，样本约为kStatsSampleRows行
+    size_t stride = std::max<size_t>(1, heap_->getRowCount() / kStatsSampleRows);
+    std::vector<std::vector<Value>> samples(columns_.size());
+    heap_->scan([&](uint32_t pageId) { return (pageId - 1) % stride != 0; },
+                [&](RowId, std::string_view tuple) {
+        TupleView row(tuple, columns_);
+        for (size_t i = 0; i < columns_.size(); ++i) {
+            samples[i].push_back(row.getValue(i));
+        }
+    });
+    stats_.build(samples, heap_->getRowCount());
+    modifiedRows_ = 0;
+}
+
+uint32_t Table::pagesToScan(const Predicate& where) const {
+    uint32_t pageCount = heap_->getDataPageCount();
+    uint32_t pages = 0;
+    for (uint32_t first = 1; first <= pageCount; first += ZoneMap::kZonePages) {
+        if (!where.canSkip(*zoneMap_, first)) {
+            pages += std::min<uint32_t>(ZoneMap::kZonePages, pageCount - first + 1);
+        }
+    }
+    return pages;
+}
+
+std::unique_ptr<Index> Table::makeIndex(const IndexDef& def) const {
+    if (def.type == IndexType::HASH) {
+        return std::make_unique<HashIndex>(indexPath(def), def.columns.size());
+    }
+    return std::make_unique<BTreeIndex>(indexPath(def));
+}
+
+bool Table::supportsKeys(const Record& values) const {
+    for (const auto& entry : indexes_) {
+        if (!entry.index->supportsKey(makeKey(entry.def.columns, values), makeKey(entry.def.include, values))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+IndexKey Table::makeKey(const std::vector<size_t>& columns, const TupleView& row) const {
+    IndexKey key;
+    key.reserve(columns.size());
+    for (size_t column : columns) {
+        key.push_back(row.getValue(column));
+    }
+    return key;
+}
+
+IndexKey Table::makeKey(const std::vector<size_t>& columns, const Record& values) const {
+    IndexKey key;
+    key.reserve(columns.size());
+    for (size_t column : columns) {
+        key.push_back(values[column]);
+    }
+    return key;
+}
+
+std::filesystem::path Table::indexPath(const IndexDef& def) const {
+    if (def.name.empty()) {
+        return indexPath_;
+    }
+    return "./data/" + dbName_ + "/" + name_ + "." + def.name + ".idx";
+}
+
+std::vector<IndexDef> Table::secondaryIndexDefs() const {
+    std::vector<IndexDef> defs;
+    for (const auto& entry : indexes_) {
+        if (!entry.def.name.empty()) {
+            defs.push_back(entry.def);
+        }
+    }
+    return defs;
 }
 
 std::optional<size_t> Table::getColumnIndex(const std::string& colName) const {
@@ -475,8 +1028,370 @@ std::optional<size_t> Table::getColumnIndex(const std::string& colName) const {
     return std::nullopt;
 }
 
-bool Table::matchCondition(const Record& record, size_t colIndex, Operator op, const Value& value) const {
-    return compareValues(record[colIndex], value, op);
+void Table::setWAL(std::shared_ptr<WAL> wal) {
+    wal_ = std::move(wal);
+    heap_->setWAL(wal_);
+}
+
+bool Table::applyLogRecord(const WALRecord& record) {
+    // 已包含在表文件中的修改不再重放
+    if (record.lsn <= checkpointLsn_) {
+        return false;
+    }
+    
+    // 重放期间不维护索引，结束后统一重建
+    recovering_ = true;
+    
+    // 数据页的LSN不小于记录的LSN时说明该页已经包含这条修改，会被跳过
+    switch (record.type) {
+        case WALRecordType::INSERT:
+            if (!record.rowIds.empty()) {
+                insertRow(record.rowIds.front(), record.row, encodeTuple(record.row, columns_), record.lsn);
+            }
+            break;
+        case WALRecordType::DELETE:
+            eraseRows(record.rowIds, record.lsn);
+            break;
+        case WALRecordType::UPDATE:
+            assignRows(record.rowIds, record.column, record.value, record.lsn);
+            break;
+    }
+    
+    return true;
+}
+
+void Table::finishRecovery() {
+    recovering_ = false;
+    heap_->recount();
+    rebuildIndexes();
+    rebuildZoneMap();
+    rebuildPrimaryKeyFilter();
+    dirty_ = true;
+}
+
+bool Table::checkpoint(uint64_t lsn) {
+    uint64_t previousLsn = checkpointLsn_;
+    checkpointLsn_ = lsn;
+    if (!saveData()) {
+        checkpointLsn_ = previousLsn;
+        return false;
+    }
+    dirty_ = false;
+    
+    // 整理后行号会改变，只能在检查点时进行：此后重放的日志都在lsn之后
+    if (needsCompaction() && !compact(lsn)) {
+        std::cerr << "整理表 " << name_ << " 失败" << std::endl;
+    }
+    return true;
+}
+
+bool Table::needsCompaction() const {
+    size_t deleted = heap_->getDeletedCount();
+    return deleted >= kCompactionMinRows && deleted * kCompactionRatio >= heap_->getRowCount();
+}
+
+bool Table::compact(uint64_t lsn) {
+    try {
+        // 把存活行写入临时文件，新文件的检查点LSN为lsn，之前的日志不会重放到新行号上
+        std::filesystem::path tmpPath = tablePath_;
+        tmpPath += ".tmp";
+        std::filesystem::remove(tmpPath);
+        {
+            HeapFile heap(tmpPath);
+            if (!heap.create(columns_)) {
+                return false;
+            }
+            
+            bool ok = true;
+            heap_->scan([&](RowId, std::string_view tuple) {
+                auto rowId = heap.reserveInsert(tuple.size());
+                if (!ok || !rowId.has_value() || !heap.insertAt(rowId.value(), tuple, 0)) {
+                    ok = false;
+                }
+            });
+            
+            if (!ok || !heap.writeHeader(columns_, secondaryIndexDefs(), lsn) || !heap.flush()) {
+                std::filesystem::remove(tmpPath);
+                return false;
+            }
+        }
+        
+        // 旧索引和区域映射中的行号即将失效，先清空，崩溃后加载时会重建
+        for (const auto& entry : indexes_) {
+            if (!entry.index->clear()) {
+                return false;
+            }
+        }
+        zoneMap_->clear();
+        
+        // 关闭旧表文件（页已在检查点写回），替换为新文件
+        heap_.reset();
+        std::filesystem::rename(tmpPath, tablePath_);
+        heap_ = std::make_unique<HeapFile>(tablePath_);
+        std::vector<IndexDef> indexDefs;
+        if (!heap_->open(columns_, indexDefs, checkpointLsn_)) {
+            return false;
+        }
+        heap_->setWAL(wal_);
+        
+        // 按新行号重建并保存索引和区域映射
+        rebuildIndexes();
+        rebuildZoneMap();
+        for (const auto& entry : indexes_) {
+            entry.index->save();
+        }
+        return zoneMap_->save();
+    } catch (const std::exception& e) {
+        std::cerr << "整理表失败: " << e.what() << std::endl;
+        return false;
+    }
+}
+
+bool Table::logChange(WALRecord& record) {
+    record.tableName = name_;
+    if (wal_ && !wal_->append(record)) {
+        return false;
+    }
+    return true;
+}
+
+bool Table::insertRow(RowId rowId, const Record& values, std::string_view tuple, uint64_t lsn) {
+    if (!heap_->insertAt(rowId, tuple, lsn)) {
+        return false;
+    }
+    ++modifiedRows_;
+    
+    // 更新所有索引、区域映射和主键过滤器
+    if (!recovering_) {
+        for (const auto& entry : indexes_) {
+            entry.index->insert(makeKey(entry.def.columns, values), rowId, makeKey(entry.def.include, values));
+        }
+        zoneMap_->insert(rowId, values);
+        if (primaryKeyCol_.has_value()) {
+            primaryKeys_.add(values[primaryKeyCol_.value()]);
+            if (primaryKeys_.needsRebuild()) {
+                rebuildPrimaryKeyFilter();
+            }
+        }
+    }
+    
+    dirty_ = true;
+    return true;
+}
+
+void Table::eraseRows(const std::vector<RowId>& rowIds, uint64_t lsn) {
+    bool maintainIndex = !recovering_ && !indexes_.empty();
+    modifiedRows_ += rowIds.size();
+    
+    for (RowId rowId : rowIds) {
+        // 如果有索引，先取出各个索引键
+        std::vector<IndexKey> keys;
+        if (maintainIndex) {
+            heap_->read(rowId, [&](std::string_view tuple) {
+                TupleView row(tuple, columns_);
+                for (const auto& entry : indexes_) {
+                    keys.push_back(makeKey(entry.def.columns, row));
+                }
+            });
+        }
+        
+        // 删除记录，然后从索引中删除
+        if (!heap_->erase(rowId, lsn) || recovering_) {
+            continue;
+        }
+        if (keys.size() == indexes_.size()) {
+            for (size_t i = 0; i < indexes_.size(); ++i) {
+                indexes_[i].index->remove(keys[i], rowId);
+            }
+        }
+        zoneMap_->erase(rowId);
+        if (primaryKeyCol_.has_value()) {
+            primaryKeys_.markRemoved();
+        }
+    }
+    
+    dirty_ = true;
+}
+
+size_t Table::assignRows(const std::vector<RowId>& rowIds, size_t colIndex, const Value& value, uint64_t lsn) {
+    if (colIndex >= columns_.size()) {
+        return 0;
+    }
+    modifiedRows_ += rowIds.size();
+    
+    size_t written = 0;
+    for (RowId rowId : rowIds) {
+        auto record = heap_->get(rowId, columns_);
+        if (!record.has_value()) {
+            continue;
+        }
+        
+        // 更新记录
+        Record oldRecord = *record;
+        (*record)[colIndex] = value;
+        if (!heap_->update(rowId, encodeTuple(*record, columns_), lsn)) {
+            continue;
+        }
+        ++written;
+        
+        // 键或包含列中有该列的索引需要用新项替换旧项，区域映射放宽范围，新的主键值加入主键过滤器
+        if (!recovering_) {
+            for (const auto& entry : indexes_) {
+                if (entry.def.covers({colIndex})) {
+                    entry.index->remove(makeKey(entry.def.columns, oldRecord), rowId);
+                    entry.index->insert(makeKey(entry.def.columns, *record), rowId,
+                                        makeKey(entry.def.include, *record));
+                }
+            }
+            zoneMap_->update(rowId, *record);
+            if (colIndex == primaryKeyCol_) {
+                primaryKeys_.markRemoved();
+                primaryKeys_.add(value);
+            }
+        }
+    }
+    
+    dirty_ = true;
+    return written;
+}
+
+bool Table::moveRow(RowId rowId, const Record& values) {
+    // 删除旧位置的行
+    WALRecord deleteRecord;
+    deleteRecord.type = WALRecordType::DELETE;
+    deleteRecord.rowIds = {rowId};
+    if (!logChange(deleteRecord)) {
+        return false;
+    }
+    eraseRows(deleteRecord.rowIds, deleteRecord.lsn);
+    
+    // 在新位置插入更新后的行
+    std::string tuple = encodeTuple(values, columns_);
+    auto newRowId = heap_->reserveInsert(tuple.size());
+    if (!newRowId.has_value()) {
+        std::cerr << "更新记录失败: 记录超过单页容量" << std::endl;
+        return false;
+    }
+    
+    WALRecord insertRecord;
+    insertRecord.type = WALRecordType::INSERT;
+    insertRecord.row = values;
+    insertRecord.rowIds = {newRowId.value()};
+    if (!logChange(insertRecord)) {
+        return false;
+    }
+    return insertRow(newRowId.value(), values, tuple, insertRecord.lsn);
+}
+
+bool Table::definitelyAbsent(const Predicate& where) const {
+    switch (where.getKind()) {
+        case Predicate::Kind::COMPARE:
+            return where.getOp() == Operator::EQUAL && where.getColumn() == primaryKeyCol_ &&
+                   !primaryKeys_.mayContain(where.getValue());
+        case Predicate::Kind::AND:
+            // 任何一个合取项要求的主键值不存在
+            for (const auto& child : where.getChildren()) {
+                if (definitelyAbsent(child)) {
+                    return true;
+                }
+            }
+            return false;
+        case Predicate::Kind::OR:
+            // 每个析取项要求的主键值都不存在
+            for (const auto& child : where.getChildren()) {
+                if (!definitelyAbsent(child)) {
+                    return false;
+                }
+            }
+            return true;
+        case Predicate::Kind::NONE:
+            return false;
+    }
+    return false;
+}
+
+std::vector<RowId> Table::findRows(const Predicate& where, const AccessPath& path) {
+    // 主键值一定不存在时不需要查找
+    if (definitelyAbsent(where)) {
+        return {};
+    }
+    
+    // 使用计划器选出的索引得到候选行，再判断整个条件
+    std::vector<RowId> result;
+    if (auto rowIds = lookupRows(path)) {
+        RowFilter::compile(where, columns_).dispatch([&](const auto& matches) {
+            for (RowId rowId : *rowIds) {
+                heap_->read(rowId, [&](std::string_view tuple) {
+                    if (matches(TupleView(tuple, columns_))) {
+                        result.push_back(rowId);
+                    }
+                });
+            }
+        });
+        return result;
+    }
+    
+    // 线性扫描：只读取条件中用到的列；并行时各页块的行号分别保存，再按页块的顺序拼接
+    std::vector<size_t> used;
+    where.collectColumns(used);
+    if (size_t threads = scanThreads(where); threads > 1) {
+        std::vector<std::vector<RowId>> morsels(getMorselCount());
+        scanMorsels(where, {}, threads, [&](size_t, size_t morsel, const RowBatch& batch) {
+            for (uint16_t i : batch.selection) {
+                morsels[morsel].push_back(batch.rowIds[i]);
+            }
+        });
+        for (const auto& rowIds : morsels) {
+            result.insert(result.end(), rowIds.begin(), rowIds.end());
+        }
+        return result;
+    }
+    auto plan = scanPipeline(where, used);
+    RowBatch batch;
+    while (plan->next(batch)) {
+        for (uint16_t i : batch.selection) {
+            result.push_back(batch.rowIds[i]);
+        }
+    }
+    return result;
+}
+
+std::vector<RowId> Table::allRows() {
+    std::vector<RowId> result;
+    heap_->scan([&](RowId rowId, std::string_view) {
+        result.push_back(rowId);
+    });
+    return result;
+}
+
+void Table::scanMorsels(const Predicate& where, const std::vector<size_t>& needed, size_t threads,
+                        const std::function<void(size_t worker, size_t morsel, const RowBatch& batch)>& consume) {
+    std::vector<size_t> used = needed;
+    where.collectColumns(used);
+    std::function<bool(uint32_t)> skipPage;
+    if (where.getKind() != Predicate::Kind::NONE) {
+        skipPage = [this, &where](uint32_t pageId) {
+            return where.canSkip(*zoneMap_, pageId);
+        };
+    }
+    MorselScan scan(*heap_, columns_, used, skipPage);
+    scan.run(threads, [&](std::unique_ptr<BatchOperator> rows) -> std::unique_ptr<BatchOperator> {
+        if (where.getKind() != Predicate::Kind::NONE) {
+            rows = std::make_unique<FilterOperator>(std::move(rows), where);
+        }
+        return std::make_unique<ProjectOperator>(std::move(rows), needed);
+    }, consume);
+}
+
+std::unique_ptr<BatchOperator> Table::scanPipeline(const Predicate& where, const std::vector<size_t>& columns) {
+    if (where.getKind() == Predicate::Kind::NONE) {
+        return std::make_unique<ScanOperator>(*heap_, columns_, columns);
+    }
+    auto skipPage = [this, &where](uint32_t pageId) {
+        return where.canSkip(*zoneMap_, pageId);
+    };
+    auto scan = std::make_unique<ScanOperator>(*heap_, columns_, columns, skipPage);
+    return std::make_unique<FilterOperator>(std::move(scan), where);
 }
 
-} // namespace minidb 
\ No newline at end of file
+} // namespace minidb
\ No newline at end of file
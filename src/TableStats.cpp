@@ -0,0 +1,109 @@
+#include "../include/TableStats.h"
+#include <algorithm>
+
+namespace minidb {
+
+namespace {
+
+// 每列保存的分位点个数（包括最小值和最大值）
+constexpr size_t kHistogramBounds = 101;
+
+// 没有统计信息时的默认选择率
+constexpr double kDefaultEqualSelectivity = 0.005;
+constexpr double kDefaultRangeSelectivity = 1.0 / 3;
+
+// 值的升序比较
+bool lessValue(const Value& left, const Value& right) {
+    return compareValues(left, right, Operator::LESS_THAN);
+}
+
+} // namespace
+
+void TableStats::build(std::vector<std::vector<Value>>& samples, size_t rowCount) {
+    columns_.assign(samples.size(), ColumnStats{});
+    rowCount_ = rowCount;
+    built_ = true;
+    
+    for (size_t i = 0; i < samples.size(); ++i) {
+        std::vector<Value>& sample = samples[i];
+        if (sample.empty()) {
+            continue;
+        }
+        std::sort(sample.begin(), sample.end(), lessValue);
+        
+        // 样本中不同值的个数和只出现一次的值的个数
+        double n = static_cast<double>(sample.size());
+        double distinct = 0;
+        double singletons = 0;
+        for (size_t begin = 0; begin < sample.size();) {
+            size_t end = begin + 1;
+            while (end < sample.size() && sample[end] == sample[begin]) {
+                ++end;
+            }
+            distinct += 1;
+            singletons += (end - begin == 1) ? 1 : 0;
+            begin = end;
+        }
+        
+        // Haas和Stokes的Duj1估计：样本中只出现一次的值越多，表中没有被抽到的值就越多。
+        // 样本就是全表时结果等于样本中不同值的个数
+        double total = std::max(static_cast<double>(rowCount), n);
+        ColumnStats& column = columns_[i];
+        column.distinct = std::max(1.0, n * distinct / (n - singletons + singletons * n / total));
+        
+        // 等间隔取出分位点
+        size_t boundCount = std::min(sample.size(), kHistogramBounds);
+        column.bounds.reserve(boundCount);
+        for (size_t k = 0; k < boundCount; ++k) {
+            size_t pos = boundCount == 1 ? 0 : k * (sample.size() - 1) / (boundCount - 1);
+            column.bounds.push_back(sample[pos]);
+        }
+    }
+}
+
+double TableStats::selectivity(size_t colIndex, Operator op, const Value& value) const {
+    if (!built_ || colIndex >= columns_.size() || columns_[colIndex].bounds.empty()) {
+        switch (op) {
+            case Operator::EQUAL:
+                return kDefaultEqualSelectivity;
+            case Operator::NOT_EQUAL:
+                return 1 - kDefaultEqualSelectivity;
+            default:
+                return kDefaultRangeSelectivity;
+        }
+    }
+    
+    // 值的类型与列类型不同时任何行都不满足条件
+    const ColumnStats& column = columns_[colIndex];
+    const std::vector<Value>& bounds = column.bounds;
+    if (value.index() != bounds.front().index()) {
+        return 0;
+    }
+    
+    double size = static_cast<double>(bounds.size());
+    double below = static_cast<double>(std::lower_bound(bounds.begin(), bounds.end(), value, lessValue) - bounds.begin());
+    double notAbove = static_cast<double>(std::upper_bound(bounds.begin(), bounds.end(), value, lessValue) - bounds.begin());
+    
+    // 超出样本的范围时认为没有等于该值的行；跨越多个分位点的值是高频值
+    double equal = 0;
+    if (notAbove > 0 && below < size) {
+        equal = std::max(1.0 / column.distinct, (notAbove - below) / size);
+    }
+    switch (op) {
+        case Operator::EQUAL:
+            return equal;
+        case Operator::NOT_EQUAL:
+            return 1 - equal;
+        case Operator::LESS_THAN:
+            return below / size;
+        case Operator::GREATER_THAN:
+            return (size - notAbove) / size;
+        case Operator::LESS_EQUAL:
+            return std::min(1.0, below / size + equal);
+        case Operator::GREATER_EQUAL:
+            return std::min(1.0, (size - notAbove) / size + equal);
+    }
+    return 1;
+}
+
+} // namespace minidb
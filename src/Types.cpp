@@ -1,4 +1,5 @@
 #include "../include/Types.h"
+#include <algorithm>
 
 namespace minidb {
 
@@ -20,6 +21,19 @@ std::string valueToString(const Value& value) {
     }
 }
 
+// 操作符的SQL写法
+std::string operatorToString(Operator op) {
+    switch (op) {
+        case Operator::EQUAL: return "=";
+        case Operator::LESS_THAN: return "<";
+        case Operator::GREATER_THAN: return ">";
+        case Operator::LESS_EQUAL: return "<=";
+        case Operator::GREATER_EQUAL: return ">=";
+        case Operator::NOT_EQUAL: return "!=";
+    }
+    return "?";
+}
+
 // 比较两个Value
 bool compareValues(const Value& left, const Value& right, Operator op) {
     if (std::holds_alternative<int>(left) && std::holds_alternative<int>(right)) {
@@ -30,19 +44,35 @@ bool compareValues(const Value& left, const Value& right, Operator op) {
             case Operator::EQUAL: return leftInt == rightInt;
             case Operator::LESS_THAN: return leftInt < rightInt;
             case Operator::GREATER_THAN: return leftInt > rightInt;
+            case Operator::LESS_EQUAL: return leftInt <= rightInt;
+            case Operator::GREATER_EQUAL: return leftInt >= rightInt;
+            case Operator::NOT_EQUAL: return leftInt != rightInt;
         }
     } else if (std::holds_alternative<std::string>(left) && std::holds_alternative<std::string>(right)) {
-        std::string leftStr = std::get<std::string>(left);
-        std::string rightStr = std::get<std::string>(right);
+        const std::string& leftStr = std::get<std::string>(left);
+        const std::string& rightStr = std::get<std::string>(right);
         
         switch (op) {
             case Operator::EQUAL: return leftStr == rightStr;
             case Operator::LESS_THAN: return leftStr < rightStr;
             case Operator::GREATER_THAN: return leftStr > rightStr;
+            case Operator::LESS_EQUAL: return leftStr <= rightStr;
+            case Operator::GREATER_EQUAL: return leftStr >= rightStr;
+            case Operator::NOT_EQUAL: return leftStr != rightStr;
         }
     }
     
     return false;
 }
 
+bool IndexDef::covers(const std::vector<size_t>& needed) const {
+    for (size_t column : needed) {
+        if (std::find(columns.begin(), columns.end(), column) == columns.end() &&
+            std::find(include.begin(), include.end(), column) == include.end()) {
+            return false;
+        }
+    }
+    return true;
+}
+
 } // namespace minidb 
\ No newline at end of file
@@ -0,0 +1,422 @@
+#include "../include/WAL.h"
+#include <iostream>
+#include <fstream>
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace minidb {
+
+namespace {
+
+// 日志文件头：魔数 + 起始LSN
+constexpr char kWalMagic[8] = {'M', 'D', 'B', 'W', 'A', 'L', '0', '1'};
+constexpr size_t kWalHeaderSize = sizeof(kWalMagic) + sizeof(uint64_t);
+
+// 每条记录的帧头：负载长度 + CRC32
+constexpr size_t kFrameHeaderSize = sizeof(uint32_t) * 2;
+
+// NORMAL模式下的刷盘间隔
+constexpr auto kNormalSyncInterval = std::chrono::seconds(1);
+
+uint32_t crc32(const char* data, size_t length) {
+    static uint32_t table[256] = {0};
+    static bool initialized = false;
+    if (!initialized) {
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; ++k) {
+                c = (c & 1) ? (0xEDB88320u ^ (c >> 1)) : (c >> 1);
+            }
+            table[i] = c;
+        }
+        initialized = true;
+    }
+    
+    uint32_t crc = 0xFFFFFFFFu;
+    for (size_t i = 0; i < length; ++i) {
+        crc = table[(crc ^ static_cast<uint8_t>(data[i])) & 0xFF] ^ (crc >> 8);
+    }
+    return crc ^ 0xFFFFFFFFu;
+}
+
+template<typename T>
+void put(std::string& buffer, T value) {
+    buffer.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+void putValue(std::string& buffer, const Value& value) {
+    if (std::holds_alternative<int>(value)) {
+        put<uint8_t>(buffer, 0);
+        put<int32_t>(buffer, std::get<int>(value));
+    } else {
+        const std::string& str = std::get<std::string>(value);
+        put<uint8_t>(buffer, 1);
+        put<uint32_t>(buffer, static_cast<uint32_t>(str.size()));
+        buffer.append(str);
+    }
+}
+
+// 带边界检查的负载读取器
+class Reader {
+public:
+    Reader(const char* data, size_t length) : data_(data), length_(length) {}
+    
+    template<typename T>
+    bool get(T& value) {
+        if (pos_ + sizeof(T) > length_) {
+            return false;
+        }
+        std::memcpy(&value, data_ + pos_, sizeof(T));
+        pos_ += sizeof(T);
+        return true;
+    }
+    
+    bool getBytes(std::string& out, size_t count) {
+        if (pos_ + count > length_) {
+            return false;
+        }
+        out.assign(data_ + pos_, count);
+        pos_ += count;
+        return true;
+    }
+    
+    bool getValue(Value& value) {
+        uint8_t tag;
+        if (!get(tag)) {
+            return false;
+        }
+        if (tag == 0) {
+            int32_t intValue;
+            if (!get(intValue)) {
+                return false;
+            }
+            value = intValue;
+            return true;
+        }
+        if (tag != 1) {
+            return false;
+        }
+        uint32_t strLength;
+        std::string str;
+        if (!get(strLength) || !getBytes(str, strLength)) {
+            return false;
+        }
+        value = std::move(str);
+        return true;
+    }
+    
+    bool atEnd() const { return pos_ == length_; }
+
+private:
+    const char* data_;
+    size_t length_;
+    size_t pos_ = 0;
+};
+
+bool writeAll(int fd, const char* data, size_t length) {
+    while (length > 0) {
+        ssize_t written = ::write(fd, data, length);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += written;
+        length -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+std::string encodeRecord(const WALRecord& record) {
+    std::string payload;
+    put<uint64_t>(payload, record.lsn);
+    put<uint8_t>(payload, static_cast<uint8_t>(record.type));
+    put<uint16_t>(payload, static_cast<uint16_t>(record.tableName.size()));
+    payload.append(record.tableName);
+    
+    // 受影响的行号（INSERT为插入位置）
+    put<uint32_t>(payload, static_cast<uint32_t>(record.rowIds.size()));
+    for (size_t rowId : record.rowIds) {
+        put<uint64_t>(payload, rowId);
+    }
+    
+    switch (record.type) {
+        case WALRecordType::INSERT:
+            put<uint32_t>(payload, static_cast<uint32_t>(record.row.size()));
+            for (const auto& value : record.row) {
+                putValue(payload, value);
+            }
+            break;
+        case WALRecordType::DELETE:
+            break;
+        case WALRecordType::UPDATE:
+            put<uint32_t>(payload, static_cast<uint32_t>(record.column));
+            putValue(payload, record.value);
+            break;
+    }
+    
+    std::string frame;
+    frame.reserve(kFrameHeaderSize + payload.size());
+    put<uint32_t>(frame, static_cast<uint32_t>(payload.size()));
+    put<uint32_t>(frame, crc32(payload.data(), payload.size()));
+    frame.append(payload);
+    return frame;
+}
+
+bool decodeRecord(const char* data, size_t length, WALRecord& record) {
+    Reader reader(data, length);
+    
+    uint8_t type;
+    uint16_t nameLength;
+    if (!reader.get(record.lsn) || !reader.get(type) ||
+        !reader.get(nameLength) || !reader.getBytes(record.tableName, nameLength)) {
+        return false;
+    }
+    record.type = static_cast<WALRecordType>(type);
+    
+    // 受影响的行号
+    uint32_t rowIdCount;
+    if (!reader.get(rowIdCount)) {
+        return false;
+    }
+    record.rowIds.resize(rowIdCount);
+    for (auto& rowId : record.rowIds) {
+        uint64_t id;
+        if (!reader.get(id)) {
+            return false;
+        }
+        rowId = static_cast<size_t>(id);
+    }
+    
+    switch (record.type) {
+        case WALRecordType::INSERT: {
+            uint32_t count;
+            if (!reader.get(count)) {
+                return false;
+            }
+            record.row.resize(count);
+            for (auto& value : record.row) {
+                if (!reader.getValue(value)) {
+                    return false;
+                }
+            }
+            break;
+        }
+        case WALRecordType::DELETE:
+            break;
+        case WALRecordType::UPDATE: {
+            uint32_t column;
+            if (!reader.get(column) || !reader.getValue(record.value)) {
+                return false;
+            }
+            record.column = column;
+            break;
+        }
+        default:
+            return false;
+    }
+    
+    return reader.atEnd();
+}
+
+} // namespace
+
+WAL::WAL(const std::filesystem::path& logPath)
+    : logPath_(logPath), lastSync_(std::chrono::steady_clock::now()) {
+}
+
+WAL::~WAL() {
+    sync();
+    close();
+}
+
+bool WAL::open() {
+    if (fd_ >= 0) {
+        return true;
+    }
+    
+    fd_ = ::open(logPath_.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (fd_ < 0) {
+        std::cerr << "打开日志文件失败: " << logPath_ << std::endl;
+        return false;
+    }
+    
+    // 新文件需要先写入文件头
+    off_t end = ::lseek(fd_, 0, SEEK_END);
+    if (end <= 0) {
+        return writeHeader();
+    }
+    fileSize_ = static_cast<size_t>(end);
+    return true;
+}
+
+void WAL::close() {
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+}
+
+bool WAL::writeHeader() {
+    std::string header(kWalMagic, sizeof(kWalMagic));
+    put<uint64_t>(header, nextLsn_);
+    if (!writeAll(fd_, header.data(), header.size())) {
+        std::cerr << "写入日志文件头失败: " << logPath_ << std::endl;
+        return false;
+    }
+    fileSize_ = header.size();
+    unsynced_ = true;
+    return true;
+}
+
+bool WAL::append(WALRecord& record) {
+    try {
+        if (!open()) {
+            return false;
+        }
+        
+        record.lsn = nextLsn_;
+        std::string frame = encodeRecord(record);
+        if (!writeAll(fd_, frame.data(), frame.size())) {
+            std::cerr << "写入日志失败: " << logPath_ << std::endl;
+            return false;
+        }
+        
+        ++nextLsn_;
+        fileSize_ += frame.size();
+        unsynced_ = true;
+        
+        // 按刷盘策略决定是否立即落盘
+        if (syncMode_ == WALSyncMode::FULL) {
+            return sync();
+        }
+        if (syncMode_ == WALSyncMode::NORMAL &&
+            std::chrono::steady_clock::now() - lastSync_ >= kNormalSyncInterval) {
+            return sync();
+        }
+        return true;
+    } catch (const std::exception& e) {
+        std::cerr << "写入日志失败: " << e.what() << std::endl;
+        return false;
+    }
+}
+
+bool WAL::sync() {
+    if (fd_ < 0 || !unsynced_) {
+        return true;
+    }
+    if (::fdatasync(fd_) != 0) {
+        std::cerr << "日志刷盘失败: " << logPath_ << std::endl;
+        return false;
+    }
+    unsynced_ = false;
+    lastSync_ = std::chrono::steady_clock::now();
+    return true;
+}
+
+bool WAL::replay(const std::function<void(const WALRecord&)>& apply) {
+    try {
+        if (!std::filesystem::exists(logPath_)) {
+            return true;
+        }
+        
+        // 一次性读入整个日志文件
+        std::ifstream logFile(logPath_, std::ios::binary);
+        if (!logFile.is_open()) {
+            return false;
+        }
+        std::string data((std::istreambuf_iterator<char>(logFile)), std::istreambuf_iterator<char>());
+        logFile.close();
+        
+        if (data.size() < kWalHeaderSize || std::memcmp(data.data(), kWalMagic, sizeof(kWalMagic)) != 0) {
+            // 文件头不完整，视为空日志
+            close();
+            std::filesystem::resize_file(logPath_, 0);
+            fileSize_ = 0;
+            return true;
+        }
+        
+        uint64_t baseLsn;
+        std::memcpy(&baseLsn, data.data() + sizeof(kWalMagic), sizeof(baseLsn));
+        advanceLsn(baseLsn);
+        
+        // 逐条重放，遇到不完整或校验失败的记录即停止
+        size_t offset = kWalHeaderSize;
+        while (offset + kFrameHeaderSize <= data.size()) {
+            uint32_t payloadLength;
+            uint32_t checksum;
+            std::memcpy(&payloadLength, data.data() + offset, sizeof(payloadLength));
+            std::memcpy(&checksum, data.data() + offset + sizeof(payloadLength), sizeof(checksum));
+            
+            const char* payload = data.data() + offset + kFrameHeaderSize;
+            if (offset + kFrameHeaderSize + payloadLength > data.size() ||
+                crc32(payload, payloadLength) != checksum) {
+                break;
+            }
+            
+            WALRecord record;
+            if (!decodeRecord(payload, payloadLength, record)) {
+                break;
+            }
+            
+            apply(record);
+            advanceLsn(record.lsn + 1);
+            offset += kFrameHeaderSize + payloadLength;
+        }
+        
+        // 截掉崩溃时写了一半的尾部记录
+        if (offset < data.size()) {
+            std::cerr << "日志尾部存在不完整记录，已丢弃 " << (data.size() - offset) << " 字节" << std::endl;
+            close();
+            std::filesystem::resize_file(logPath_, offset);
+        }
+        fileSize_ = offset;
+        
+        return true;
+    } catch (const std::exception& e) {
+        std::cerr << "重放日志失败: " << e.what() << std::endl;
+        return false;
+    }
+}
+
+bool WAL::truncate() {
+    try {
+        close();
+        
+        fd_ = ::open(logPath_.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0644);
+        if (fd_ < 0) {
+            std::cerr << "清空日志文件失败: " << logPath_ << std::endl;
+            return false;
+        }
+        
+        // 新文件头记录下一个LSN，保证LSN跨检查点单调递增
+        if (!writeHeader()) {
+            return false;
+        }
+        return sync();
+    } catch (const std::exception& e) {
+        std::cerr << "清空日志文件失败: " << e.what() << std::endl;
+        return false;
+    }
+}
+
+void WAL::advanceLsn(uint64_t lsn) {
+    if (lsn > nextLsn_) {
+        nextLsn_ = lsn;
+    }
+}
+
+bool syncFile(const std::filesystem::path& path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    bool ok = ::fsync(fd) == 0;
+    ::close(fd);
+    return ok;
+}
+
+} // namespace minidb
\ No newline at end of file
@@ -0,0 +1,253 @@
+#include "../include/ZoneMap.h"
+#include "../include/WAL.h"
+#include <iostream>
+#include <fstream>
+#include <cstring>
+#include <algorithm>
+
+namespace minidb {
+
+namespace {
+
+// 文件布局：文件头之后依次是每个区域（行数，删除行数，每个INT列的最小值和最大值）
+constexpr uint64_t kZoneFileMagic = 0x31454E4F5A42444Dull; // "MDBZONE1"
+constexpr uint32_t kZoneFileVersion = 1;
+constexpr size_t kMagicOffset = 0;
+constexpr size_t kVersionOffset = 8;
+constexpr size_t kCleanOffset = 12;
+constexpr size_t kZoneCountOffset = 16;
+constexpr size_t kIntColumnCountOffset = 24;
+constexpr size_t kHeaderSize = 32;
+
+} // namespace
+
+ZoneMap::ZoneMap(const std::filesystem::path& path, const std::vector<ColumnDef>& columns)
+    : path_(path), columns_(columns) {
+    resolveColumns();
+}
+
+void ZoneMap::insert(RowId rowId, const Record& values) {
+    markModified();
+    Zone& zone = zoneFor(rowId);
+    ++zone.rows;
+    for (size_t slot = 0; slot < intColumns_.size(); ++slot) {
+        widen(zone, slot, std::get<int>(values[intColumns_[slot]]));
+    }
+}
+
+void ZoneMap::insert(RowId rowId, const TupleView& row) {
+    markModified();
+    Zone& zone = zoneFor(rowId);
+    ++zone.rows;
+    for (size_t slot = 0; slot < intColumns_.size(); ++slot) {
+        widen(zone, slot, row.getInt(intColumns_[slot]));
+    }
+}
+
+void ZoneMap::update(RowId rowId, const Record& values) {
+    markModified();
+    Zone& zone = zoneFor(rowId);
+    for (size_t slot = 0; slot < intColumns_.size(); ++slot) {
+        widen(zone, slot, std::get<int>(values[intColumns_[slot]]));
+    }
+}
+
+void ZoneMap::erase(RowId rowId) {
+    markModified();
+    ++zoneFor(rowId).deleted;
+}
+
+bool ZoneMap::canSkip(uint32_t pageId, size_t colIndex, Operator op, const Value& value) const {
+    size_t zoneIndex = pageId == 0 ? zones_.size() : (pageId - 1) / kZonePages;
+    if (zoneIndex >= zones_.size()) {
+        return false;
+    }
+    
+    // 区域中的行都已删除
+    const Zone& zone = zones_[zoneIndex];
+    if (zone.deleted >= zone.rows) {
+        return true;
+    }
+    
+    // 只记录INT列；值的类型不同时任何行都不满足条件
+    if (colIndex >= slots_.size() || slots_[colIndex] == kNoSlot) {
+        return false;
+    }
+    if (!std::holds_alternative<int>(value)) {
+        return true;
+    }
+    
+    int32_t target = std::get<int>(value);
+    int32_t min = zone.min[slots_[colIndex]];
+    int32_t max = zone.max[slots_[colIndex]];
+    switch (op) {
+        case Operator::EQUAL: return target < min || target > max;
+        case Operator::LESS_THAN: return min >= target;
+        case Operator::GREATER_THAN: return max <= target;
+        case Operator::LESS_EQUAL: return min > target;
+        case Operator::GREATER_EQUAL: return max < target;
+        case Operator::NOT_EQUAL: return min == target && max == target;
+    }
+    return false;
+}
+
+void ZoneMap::clear() {
+    zones_.clear();
+    resolveColumns();
+    markModified();
+}
+
+bool ZoneMap::save() {
+    try {
+        if (!modified_) {
+            return true;
+        }
+        
+        std::filesystem::path tmpPath = path_;
+        tmpPath += ".tmp";
+        {
+            std::ofstream file(tmpPath, std::ios::binary | std::ios::trunc);
+            if (!file.is_open()) {
+                return false;
+            }
+            
+            // 写入文件头（已保存标记为1）
+            char header[kHeaderSize] = {};
+            uint64_t zoneCount = zones_.size();
+            uint32_t intColumnCount = static_cast<uint32_t>(intColumns_.size());
+            std::memcpy(header + kMagicOffset, &kZoneFileMagic, sizeof(kZoneFileMagic));
+            std::memcpy(header + kVersionOffset, &kZoneFileVersion, sizeof(kZoneFileVersion));
+            std::memcpy(header + kZoneCountOffset, &zoneCount, sizeof(zoneCount));
+            std::memcpy(header + kIntColumnCountOffset, &intColumnCount, sizeof(intColumnCount));
+            header[kCleanOffset] = 1;
+            file.write(header, sizeof(header));
+            
+            for (const auto& zone : zones_) {
+                file.write(reinterpret_cast<const char*>(&zone.rows), sizeof(zone.rows));
+                file.write(reinterpret_cast<const char*>(&zone.deleted), sizeof(zone.deleted));
+                file.write(reinterpret_cast<const char*>(zone.min.data()), zone.min.size() * sizeof(int32_t));
+                file.write(reinterpret_cast<const char*>(zone.max.data()), zone.max.size() * sizeof(int32_t));
+            }
+            
+            if (!file) {
+                return false;
+            }
+        }
+        
+        // 新文件落盘后再替换旧文件
+        if (!syncFile(tmpPath)) {
+            return false;
+        }
+        std::filesystem::rename(tmpPath, path_);
+        modified_ = false;
+        return true;
+    } catch (const std::exception& e) {
+        std::cerr << "保存区域映射失败: " << e.what() << std::endl;
+        return false;
+    }
+}
+
+bool ZoneMap::load() {
+    try {
+        std::ifstream file(path_, std::ios::binary);
+        if (!file.is_open()) {
+            return false;
+        }
+        
+        // 上次修改后没有保存的区域映射可能漏掉了新的行，需要重建
+        char header[kHeaderSize];
+        uint64_t magic;
+        uint32_t version;
+        uint64_t zoneCount;
+        uint32_t intColumnCount;
+        if (!file.read(header, sizeof(header))) {
+            return false;
+        }
+        std::memcpy(&magic, header + kMagicOffset, sizeof(magic));
+        std::memcpy(&version, header + kVersionOffset, sizeof(version));
+        std::memcpy(&zoneCount, header + kZoneCountOffset, sizeof(zoneCount));
+        std::memcpy(&intColumnCount, header + kIntColumnCountOffset, sizeof(intColumnCount));
+        
+        resolveColumns();
+        if (magic != kZoneFileMagic || version != kZoneFileVersion || header[kCleanOffset] == 0 ||
+            intColumnCount != intColumns_.size()) {
+            return false;
+        }
+        
+        std::vector<Zone> zones(static_cast<size_t>(zoneCount));
+        for (auto& zone : zones) {
+            zone.min.resize(intColumnCount);
+            zone.max.resize(intColumnCount);
+            file.read(reinterpret_cast<char*>(&zone.rows), sizeof(zone.rows));
+            file.read(reinterpret_cast<char*>(&zone.deleted), sizeof(zone.deleted));
+            file.read(reinterpret_cast<char*>(zone.min.data()), intColumnCount * sizeof(int32_t));
+            file.read(reinterpret_cast<char*>(zone.max.data()), intColumnCount * sizeof(int32_t));
+        }
+        if (!file) {
+            return false;
+        }
+        
+        zones_ = std::move(zones);
+        modified_ = false;
+        return true;
+    } catch (const std::exception& e) {
+        std::cerr << "加载区域映射失败: " << e.what() << std::endl;
+        return false;
+    }
+}
+
+void ZoneMap::resolveColumns() {
+    intColumns_.clear();
+    slots_.assign(columns_.size(), kNoSlot);
+    for (size_t i = 0; i < columns_.size(); ++i) {
+        if (columns_[i].type == DataType::INT) {
+            slots_[i] = intColumns_.size();
+            intColumns_.push_back(i);
+        }
+    }
+}
+
+ZoneMap::Zone& ZoneMap::zoneFor(RowId rowId) {
+    uint32_t pageId = rowIdPage(rowId);
+    size_t zoneIndex = pageId == 0 ? 0 : (pageId - 1) / kZonePages;
+    while (zones_.size() <= zoneIndex) {
+        // 空区域的最小值大于最大值，任何条件都不满足
+        Zone zone;
+        zone.min.assign(intColumns_.size(), INT32_MAX);
+        zone.max.assign(intColumns_.size(), INT32_MIN);
+        zones_.push_back(std::move(zone));
+    }
+    return zones_[zoneIndex];
+}
+
+void ZoneMap::widen(Zone& zone, size_t slot, int32_t value) {
+    zone.min[slot] = std::min(zone.min[slot], value);
+    zone.max[slot] = std::max(zone.max[slot], value);
+}
+
+void ZoneMap::markModified() {
+    if (modified_) {
+        return;
+    }
+    modified_ = true;
+    
+    // 已有的文件先标记为未保存并落盘，崩溃后加载时会重建；标记失败时删除文件，效果相同
+    std::error_code error;
+    if (!std::filesystem::exists(path_, error)) {
+        return;
+    }
+    bool marked = false;
+    {
+        std::fstream file(path_, std::ios::binary | std::ios::in | std::ios::out);
+        if (file.is_open()) {
+            file.seekp(kCleanOffset);
+            file.put(0);
+            marked = static_cast<bool>(file);
+        }
+    }
+    if (!marked || !syncFile(path_)) {
+        std::filesystem::remove(path_, error);
+    }
+}
+
+} // namespace minidb
@@ -44,14 +44,24 @@ int main() {
     // 主循环
     while (true) {
         printPrompt();
-        std::getline(std::cin, line);
+        if (!std::getline(std::cin, line)) {
+            // 输入结束（例如从文件重定向执行脚本）
+            std::cout << std::endl;
+            break;
+        }
         
         // 去除前后空格
-        line.erase(0, line.find_first_not_of(" \t"));
+        line.erase(0, line.find_first_not_of(" \t\r"));
+        line.erase(line.find_last_not_of(" \t\r") + 1);
         if (line.empty()) {
             continue;
         }
         
+        // 跳过注释行
+        if (line.rfind("--", 0) == 0) {
+            continue;
+        }
+        
         // 退出命令
         if (line == "exit" || line == "quit") {
             std::cout << "再见！" << std::endl;
@@ -0,0 +1,54 @@
+#include "../include/DBManager.h"
+#include "../include/SQLParser.h"
+#include <cstdio>
+#include <string>
+
+using namespace minidb;
+
+// 退出时的检查点在共享线程池上重建索引：表中删除的行足够多，析构DBManager时压缩表，
+// B+树索引的批量构建按parallel_workers个线程并行排序。线程池先于数据库析构时进程会一直等待而无法退出，
+// make test在超时后判为失败
+
+namespace {
+
+// 表的行数，每个排序线程至少分到kMinParallelSortSize个索引项
+constexpr int kRows = 4 * static_cast<int>(kMinParallelSortSize);
+
+// 删除的行数，超过行数的四分之一时检查点压缩表
+constexpr int kDeleted = kRows / 4 + 1;
+
+bool run(const std::string& sql) {
+    SQLResult result = SQLParser::execute(sql);
+    if (!result.success) {
+        std::printf("%s: %s\n", sql.c_str(), result.message.c_str());
+    }
+    return result.success;
+}
+
+} // namespace
+
+int main() {
+    DBManager& manager = DBManager::getInstance();
+    if (!manager.initDataDirectory() || !manager.loadDatabases()) {
+        std::printf("初始化数据目录失败\n");
+        return 1;
+    }
+    
+    if (!run("create database shutdown") || !run("use shutdown") ||
+        !run("create table t (id int primary, v int)") || !run("set parallel_workers = 4")) {
+        return 1;
+    }
+    for (int i = 0; i < kRows; ++i) {
+        if (!run("insert t values(" + std::to_string(i) + ", " + std::to_string(i % 1000) + ")")) {
+            return 1;
+        }
+    }
+    // 先写出检查点，删除之后日志不会大到在语句结束时触发检查点，压缩留到退出时
+    if (!run("create index iv on t(v)") || !run("checkpoint") || !run("delete t where id < " + std::to_string(kDeleted)) ||
+        !run("select id from t where v = 7")) {
+        return 1;
+    }
+    
+    // 返回后由静态对象的析构写出检查点
+    return 0;
+}
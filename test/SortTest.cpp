@@ -0,0 +1,52 @@
+#include "../include/Sort.h"
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace minidb;
+
+// 有LIMIT的排序在limit行放不进内存预算时写出有序段，归并出limit行后停止；
+// 结果必须与预算足够时用堆得到的结果相同，键相等的行保持加入的顺序
+
+namespace {
+
+constexpr size_t kRows = 5000;
+constexpr size_t kLimit = 300;
+constexpr size_t kOffset = 20;
+
+std::vector<Record> sortRows(const std::vector<Record>& rows, size_t memoryBudget, size_t& runs) {
+    std::vector<ColumnDef> columns = {{"k", DataType::INT}, {"s", DataType::STRING}};
+    ExternalSorter sorter(columns, {{0, true}}, memoryBudget, kLimit + kOffset);
+    for (const auto& row : rows) {
+        sorter.add(row);
+    }
+    runs = sorter.getRunCount();
+    return sorter.finish(kOffset);
+}
+
+} // namespace
+
+int main() {
+    // 排序键只有100个不同值，第二列记下加入的顺序
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<int> dist(0, 99);
+    std::vector<Record> rows;
+    for (size_t i = 0; i < kRows; ++i) {
+        rows.push_back({dist(rng), "row" + std::to_string(i)});
+    }
+    
+    size_t heapRuns = 0;
+    size_t spillRuns = 0;
+    std::vector<Record> expected = sortRows(rows, 64 * 1024 * 1024, heapRuns);
+    std::vector<Record> spilled = sortRows(rows, 4 * 1024, spillRuns);
+    if (heapRuns != 0 || spillRuns == 0) {
+        std::printf("有序段数不对：%zu %zu\n", heapRuns, spillRuns);
+        return 1;
+    }
+    if (expected.size() != kLimit || spilled != expected) {
+        std::printf("写出有序段后的结果与堆排序不同\n");
+        return 1;
+    }
+    return 0;
+}
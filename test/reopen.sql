@@ -0,0 +1,20 @@
+-- 在新的进程中重新打开test.sql留下的archive库：目录只读取表名，表文件在首次访问时才打开
+use archive;
+
+-- 退出前写入的行
+select id from score where points < 50;
+
+-- 从磁盘读取的索引、区域映射和布隆过滤器
+select id from score where points < 0;
+select id from score where points > 100;
+select id from score where id = 99;
+insert score values(3, "dup", 0, "");
+
+-- 关闭后重新打开的表保留了全部修改
+select * from cold1;
+
+-- 删除数据库
+drop database archive;
+
+-- 退出
+exit